@@ -16,7 +16,7 @@
 /* Required Includes ********************************************************/
 
 #include "fit_types.h"
-#include "internal.h"
+#include "fit.h"
 #include "mem_read.h"
 
 /* Constants ****************************************************************/
@@ -25,6 +25,18 @@
 
 /* Types ********************************************************************/
 
+// Context for streaming Abreast DM hash. Data can be passed in pieces of any
+// length; incomplete block is buffered till next update or final.
+typedef struct fit_abreast_dm_ctx {
+    // Current hash value (Gi || Hi).
+    uint8_t     m_hash[ABREAST_DM_HASH_SIZE];
+    // Buffered data not yet hashed (less than one block).
+    uint8_t     m_block[ABREAST_DM_CIPHER_BLOCK_SIZE];
+    uint8_t     m_buflen;
+    // Length of all data passed in so far; used for length encoding.
+    uint16_t    m_total;
+} fit_abreast_dm_ctx_t;
+
 /* Function Prototypes ******************************************************/
 
 void AES256_AbreastDmHash_Finalize(uint8_t* Hash);
@@ -32,6 +44,9 @@ void AES256_AbreastDmHash_UpdateBlk(uint8_t* pDataIn, uint8_t* Hash);
 void AES256_AbreastDmHash_Update(uint8_t* pDataIn, uint16_t NbOfBlocks, uint8_t* Hash);
 void AES256_AbreastDmHash_Init(uint8_t* Hash);
 fit_status_t fit_get_AbreastDM_Hash(fit_pointer_t *msg, uint8_t * hash);
+void fit_abreast_dm_start(fit_abreast_dm_ctx_t *ctx);
+void fit_abreast_dm_update(fit_abreast_dm_ctx_t *ctx, fit_pointer_t *msg);
+void fit_abreast_dm_final(fit_abreast_dm_ctx_t *ctx, uint8_t *hash);
 
 
 #endif // __FIT_ABREAST_DM_H__
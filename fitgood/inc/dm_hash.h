@@ -21,12 +21,32 @@
 
 /* Types ********************************************************************/
 
+// Context for streaming davies meyer hash. Data can be passed in pieces of any
+// length; incomplete block is buffered till next update or final.
+typedef struct fit_dm_hash_ctx {
+    // Current hash value (Hi).
+    uint8_t     m_hash[DM_CIPHER_BLOCK_SIZE];
+    // Buffered data not yet hashed (less than one block).
+    uint8_t     m_block[DM_CIPHER_BLOCK_SIZE];
+    uint8_t     m_buflen;
+    // Length of all data passed in so far; used for length encoding.
+    uint16_t    m_total;
+} fit_dm_hash_ctx_t;
+
 /* Function Prototypes ******************************************************/
 
 // This function will be used to get the davies meyer hash of the data passed in.
 fit_status_t fit_davies_meyer_hash(fit_pointer_t *pdata, uint8_t *dmhash);
+// This function will perform one step (one 128 bit block) of davies meyer hash.
+fit_status_t fit_dm_hash_block(uint8_t *hash, uint8_t *block);
 // This function will be used to pad the data to make its length be an even multiple
 // of the block size and include a length encoding
 void fit_dm_hash_init(uint8_t *pdata, uint16_t *pdatalen, uint16_t msgfulllen);
+// This function will initialize context for streaming davies meyer hash.
+void fit_dm_hash_start(fit_dm_hash_ctx_t *ctx);
+// This function will update streaming davies meyer hash with data of any length.
+fit_status_t fit_dm_hash_update(fit_dm_hash_ctx_t *ctx, fit_pointer_t *pdata);
+// This function will pad buffered data and calculate final davies meyer hash.
+fit_status_t fit_dm_hash_final(fit_dm_hash_ctx_t *ctx, uint8_t *dmhash);
 
 #endif // __FIT_DM_HASH_H__
@@ -27,6 +27,7 @@
 #define FIT_UID_LEN                 32
 #define FIT_MAX_FIELD_SIZE          32
 #define FIT_DM_HASH_SIZE            16
+#define FIT_MERKLE_HASH_SIZE        32
 
 /**IN parameter*/
 #define IN
@@ -132,6 +133,13 @@ typedef struct context {
             fit_get_info_callback m_callback_fn;
             // Requested data format.
             void *m_get_info_data;
+            // Tags for which callback is called. See FIT_TAG_MASK
+            uint32_t m_tag_mask;
+#ifdef FIT_USE_INFO_TLV
+            // Objects and arrays ending at or before this address are skipped
+            // (output resumed by fit_licenf_get_info_tlv); NULL to parse all.
+            uint8_t *m_resume;
+#endif
 
         } m_getinfodata;
 
@@ -237,6 +245,12 @@ typedef struct {
     fitlicensedata      lic;
     // Structure containing license signature data.
     fitsignaturedata    *signature;
+    // Parsing position: current product, license model (product part) and feature.
+    // Kept here (not in get info callback) so that licenses can be parsed into
+    // different fitv2cdata at the same time.
+    fitproductdata      *cur_prod;
+    fitprodpartdata     *cur_prod_part;
+    fitfeaturedata      *cur_feat;
 } fitv2cdata;
 
 /* Macro Functions **********************************************************/
@@ -34,6 +34,7 @@ typedef struct aes {
 
 void aes_encrypt(aes_state_t* aes, uint8_t* input, uint8_t* output, const uint8_t* key, uint8_t *state);
 fit_status_t aes_setup(aes_state_t* aes, const uint8_t *key, uint16_t keylen, uint8_t *skey);
+fit_status_t aes_encrypt_key(const uint8_t *key, uint16_t keylen, const uint8_t *input, uint8_t *output);
 void add_round_key(uint8_t *state, const uint8_t *key, uint16_t round);
 void sub_bytes(uint8_t *state);
 void shift_rows(uint8_t *state);
@@ -0,0 +1,51 @@
+/****************************************************************************\
+**
+** fit_aesni.h
+**
+** Contains declaration for macros and functions used in AES-NI (x86) based
+** implementation of AES algorithm. Used for host builds only; enabled by
+** FIT_USE_AESNI and selected at run time if processor supports AES instructions.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifndef __FIT_AESNI_H__
+#define __FIT_AESNI_H__
+
+/* Required Includes ********************************************************/
+#include "fit_aes.h"
+
+/* Constants ****************************************************************/
+
+// AES-NI backend is only compiled for x86 targets; on other targets portable
+// implementation is used even if FIT_USE_AESNI is defined.
+#if defined(FIT_USE_AESNI) && (defined(__x86_64__) || defined(__i386__) || \
+    defined(_M_X64) || defined(_M_IX86))
+#define FIT_AESNI_AVAILABLE
+#endif
+
+#ifdef FIT_AESNI_AVAILABLE
+
+// Maximum number of lanes encrypted at a time by fit_aesni_encrypt_lanes.
+#define FIT_AESNI_MAX_LANES         8
+
+/* Function Prototypes ******************************************************/
+
+// This function will return TRUE if processor supports AES instructions.
+uint8_t fit_aesni_supported(void);
+// This function will produce round keys (same layout as aes_setup) using AES instructions.
+void fit_aesni_setup(aes_state_t* aes, const uint8_t *key, uint8_t *skey);
+// This function will encrypt one block using AES instructions.
+void fit_aesni_encrypt(aes_state_t* aes, const uint8_t* input, uint8_t* output, const uint8_t* skey);
+// This function will encrypt one block per lane, each lane with its own key, with
+// rounds of all lanes interleaved.
+void fit_aesni_encrypt_lanes(uint16_t keylen,
+                             uint8_t lanes,
+                             const uint8_t *keys,
+                             const uint8_t *input,
+                             uint8_t *output);
+
+#endif // #ifdef FIT_AESNI_AVAILABLE
+
+#endif // __FIT_AESNI_H__
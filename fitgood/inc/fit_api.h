@@ -55,14 +55,135 @@
 #define FIT_LIMIT_TAG_ID                    FIT_COUNTER_TAG_ID + 1
 #define FIT_SOFT_LIMIT_TAG_ID               FIT_LIMIT_TAG_ID + 1
 #define FIT_IS_FIELD_TAG_ID                 FIT_SOFT_LIMIT_TAG_ID + 1
+#define FIT_SEGMENT_HASH_TAG_ID             FIT_IS_FIELD_TAG_ID + 1
 
 // Please Update FIT_END_TAG_ID when adding new tag id's at bottom of list.
-#define FIT_END_TAG_ID                      FIT_IS_FIELD_TAG_ID + 1
+#define FIT_END_TAG_ID                      FIT_SEGMENT_HASH_TAG_ID + 1
+
+// Bit corresponding to tag id in tag mask passed to fit_licenf_get_info_filtered.
+// Masks of tags are or-ed together e.g.
+// FIT_TAG_MASK(FIT_START_DATE_TAG_ID) | FIT_TAG_MASK(FIT_END_DATE_TAG_ID)
+#define FIT_TAG_MASK(tagid)                 ((uint32_t)1 << (tagid))
+
+// Tag mask has one bit per tag id, so all tag ids must be less than 32. Array size
+// is negative (compilation fails) if tags added above do not fit.
+typedef char fit_tag_mask_size_check_t[(FIT_END_TAG_ID <= 32) ? 1 : -1];
+
+// Tag mask selecting all tags (same as fit_licenf_get_info).
+#define FIT_ALL_TAGS_MASK                   0xFFFFFFFFUL
+
+#ifdef FIT_USE_INFO_TLV
+// Binary (TLV) license information written by fit_licenf_get_info_tlv is:
+//      version byte (FIT_INFO_TLV_VERSION)
+//      records; record header byte is (type << FIT_INFO_TLV_TYPE_SHIFT) | tag id
+//          FIT_INFO_TLV_UINT  --> value as varint (7 bits per byte, low bits first,
+//                                 top bit set if more bytes follow)
+//          FIT_INFO_TLV_BYTES --> length as varint followed by data bytes
+//      end byte (FIT_INFO_TLV_END)
+// Only field values are written, in license order; objects and arrays are implied
+// by tags e.g. product ID starts new product and product part ID new product part.
+#define FIT_INFO_TLV_VERSION                1
+#define FIT_INFO_TLV_END                    0
+#define FIT_INFO_TLV_TYPE_SHIFT             5
+#define FIT_INFO_TLV_TAG_MASK               0x1F
+#define FIT_INFO_TLV_UINT                   0
+#define FIT_INFO_TLV_BYTES                  1
+#endif // #ifdef FIT_USE_INFO_TLV
 
 /* Forward Declarations *****************************************************/
 
 /* Types ********************************************************************/
 
+// Statistics of license validation cache.
+typedef struct fit_cache_stats {
+    // Number of license validation requests (validate and consume).
+    uint32_t m_requests;
+    // Number of complete license validations i.e. with rsa signature check.
+    uint32_t m_rsa_checks;
+    // Number of failed validations remembered in negative cache.
+    uint32_t m_fail_stored;
+    // Number of requests answered from negative cache i.e. without rsa signature check.
+    uint32_t m_fail_hits;
+} fit_cache_stats_t;
+
+#ifdef FIT_USE_MBEDTLS_ARENA
+// Statistics of arena used by mbedtls during license verification.
+typedef struct fit_arena_stats {
+    // Size of arena in bytes (FIT_ARENA_SIZE rounded up to allocation unit).
+    uint32_t m_size;
+    // Highest arena offset ever used in bytes i.e. required arena size.
+    uint32_t m_peak;
+    // Bytes currently allocated.
+    uint32_t m_in_use;
+    // Number of allocations.
+    uint32_t m_allocs;
+    // Number of allocations that failed as arena was full.
+    uint32_t m_failures;
+} fit_arena_stats_t;
+#endif // #ifdef FIT_USE_MBEDTLS_ARENA
+
+// Product entry of flat license information.
+typedef struct fit_info_product {
+    // Product ID.
+    uint32_t m_prodid;
+    // Index of first product part (in parts table) and number of product parts.
+    uint16_t m_first_part;
+    uint16_t m_part_count;
+} fit_info_product_t;
+
+// Product part entry of flat license information.
+typedef struct fit_info_part {
+    // Product Part ID.
+    uint32_t m_partid;
+    // Start and end date for time based licenses (0 if not present).
+    uint32_t m_startdate;
+    uint32_t m_enddate;
+    // Index of product (in products table) this part belongs to.
+    uint16_t m_product;
+    // Index of first feature ID (in features table) and number of features.
+    uint16_t m_first_feature;
+    uint16_t m_feature_count;
+    // License model. See enum licensetype
+    uint8_t  m_lictype;
+    // Tells whether features are perpetual or not.
+    uint8_t  m_perpetual;
+} fit_info_part_t;
+
+// Flat license information filled by fit_licenf_get_info_flat. Tables are placed
+// in caller supplied arena and linked by indexes instead of pointers.
+typedef struct fit_info_flat {
+    // Licgen and LM version, signature algorithm id.
+    uint16_t m_licgen_version;
+    uint16_t m_lm_version;
+    uint16_t m_algid;
+    // License container ID and vendor ID.
+    uint32_t m_container_id;
+    uint32_t m_vendorid;
+    // Unique license identifier (FIT_UID_LEN bytes).
+    uint8_t  m_uid[32];
+    // Number of entries in each table.
+    uint16_t m_product_count;
+    uint16_t m_part_count;
+    uint16_t m_feature_count;
+    // Products, product parts and feature IDs tables (in arena).
+    fit_info_product_t  *m_products;
+    fit_info_part_t     *m_parts;
+    uint32_t            *m_features;
+} fit_info_flat_t;
+
+#ifdef FIT_USE_INFO_TLV
+// Output position of fit_licenf_get_info_tlv kept by caller between calls; all
+// zero to start the output.
+typedef struct fit_info_tlv_pos {
+    // Bytes accepted by sink in total.
+    uint32_t m_offset;
+    // License field of record from which output is continued and offset of that
+    // record in output; NULL to continue from start of output.
+    uint8_t  *m_field;
+    uint32_t m_field_offset;
+} fit_info_tlv_pos_t;
+#endif // #ifdef FIT_USE_INFO_TLV
+
 /* Function Prototypes ******************************************************/
 
 #ifdef __cplusplus
@@ -85,12 +206,63 @@ fit_status_t fit_licenf_get_info(fit_pointer_t* license,
                                  fit_get_info_callback callback_fn,
                                  void *context);
 
+// This function is same as fit_licenf_get_info, but callback function is called
+// only for tags selected by tag mask. Objects and arrays containing no selected
+// tag are not parsed at all, so they are not checked for malformed data either.
+fit_status_t fit_licenf_get_info_filtered(fit_pointer_t* license,
+                                          uint32_t tag_mask,
+                                          fit_get_info_callback callback_fn,
+                                          void *context);
+
+// This function will get license information as flat tables placed in caller supplied
+// arena. If arena is NULL, only size of arena required is returned.
+fit_status_t fit_licenf_get_info_flat(fit_pointer_t* license,
+                                      fit_info_flat_t *info,
+                                      uint8_t *arena,
+                                      uint16_t *size);
+
+#ifdef FIT_USE_INFO_TLV
+// This function will write license information for tags selected by tag mask in
+// binary (TLV) format to sink function. Returns FIT_INFO_SINK_BUSY if sink did not
+// accept all data; calling it again with same position resumes the output.
+fit_status_t fit_licenf_get_info_tlv(fit_pointer_t* license,
+                                     uint32_t tag_mask,
+                                     fit_info_sink_t sink,
+                                     void *context,
+                                     fit_info_tlv_pos_t *pos);
+#endif // #ifdef FIT_USE_INFO_TLV
+
 // This function is used to validate following:
 //      1. RSA signature of new license.
 //      2. New license node lock verification.
 fit_status_t fit_licenf_validate_license(fit_pointer_t *license,
                                          fit_pointer_t *key);
 
+// This function will parse rsa public key once, so it can be used to validate many
+// licenses by fit_licenf_validate_licenses.
+fit_status_t fit_licenf_prepare_key(fit_rsa_key_handle_t *handle,
+                                    fit_pointer_t *key);
+
+// This function will release memory allocated by fit_licenf_prepare_key.
+void fit_licenf_release_key(fit_rsa_key_handle_t *handle);
+
+// This function is used to validate number of licenses against same prepared rsa
+// public key. Validation status of each license is returned in results array.
+fit_status_t fit_licenf_validate_licenses(fit_pointer_t *licenses,
+                                          uint16_t count,
+                                          fit_rsa_key_handle_t *handle,
+                                          fit_status_t *results);
+
+// This function will get the statistics of license validation cache.
+fit_status_t fit_licenf_get_cache_stats(fit_cache_stats_t *stats,
+                                        uint8_t reset);
+
+#ifdef FIT_USE_MBEDTLS_ARENA
+// This function will get usage statistics of arena used by mbedtls.
+fit_status_t fit_licenf_get_arena_stats(fit_arena_stats_t *stats,
+                                        uint8_t reset);
+#endif
+
 // This function used for getting information about sentinel fit core versioning information
 fit_status_t fit_licenf_get_version(uint8_t* major_version,
                                     uint8_t* minor_version,
@@ -0,0 +1,53 @@
+/****************************************************************************\
+**
+** fit_arena.h
+**
+** Contains declaration for static arena allocator used by mbedtls (through
+** MBEDTLS_PLATFORM_CALLOC_MACRO/MBEDTLS_PLATFORM_FREE_MACRO) when FIT_USE_MBEDTLS_ARENA
+** is defined, so license verification does not use heap at all. Arena is reset
+** wholesale once outermost verification scope (fit_arena_enter/fit_arena_leave) is
+** left. Arena is not thread safe.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifndef __FIT_ARENA_H__
+#define __FIT_ARENA_H__
+
+#ifdef FIT_USE_MBEDTLS_ARENA
+
+/* Required Includes ********************************************************/
+#include <stddef.h>
+#include "fit_types.h"
+
+/* Constants ****************************************************************/
+
+// Size of arena in bytes. Default covers 2048 bit key verified by mbedtls (about
+// 4.5KB); use peak reported by fit_licenf_get_arena_stats to size it exactly.
+#ifndef FIT_ARENA_SIZE
+#define FIT_ARENA_SIZE          5120
+#endif
+
+// If FIT_USE_ARENA_PER_THREAD is defined then every thread has its own arena (and
+// statistics) in thread local storage, so licenses can be verified by several
+// threads at the same time; required if contexts are used by concurrent threads
+// (FIT_USE_CONCURRENT_CTX, see fit_ctx.h).
+
+/* Function Prototypes ******************************************************/
+
+// Allocator functions used by mbedtls (see mbedtls/config.h). Memory is taken
+// from arena within verification scope and from heap outside of it.
+void *fit_arena_calloc(size_t n, size_t size);
+void fit_arena_free(void *ptr);
+
+// This function will enter verification scope. Scopes can be nested.
+void fit_arena_enter(void);
+
+// This function will leave verification scope; arena is reset once outermost
+// scope is left.
+void fit_arena_leave(void);
+
+#endif // #ifdef FIT_USE_MBEDTLS_ARENA
+
+#endif // __FIT_ARENA_H__
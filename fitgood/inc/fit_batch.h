@@ -0,0 +1,73 @@
+/****************************************************************************\
+**
+** fit_batch.h
+**
+** Contains declaration for batch license validation on host (back office). Number
+** of licenses is validated against one rsa public key by pool of worker threads;
+** each worker has its own FIT core context and prepared key, and takes work from
+** other workers once its own share of licenses is done (work stealing).
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifndef __FIT_BATCH_H__
+#define __FIT_BATCH_H__
+
+#ifdef FIT_USE_BATCH_VALIDATE
+
+/* Required Includes ********************************************************/
+#include "fit_types.h"
+#include "fit_status.h"
+
+/* Constants ****************************************************************/
+
+// Maximum number of worker threads.
+#ifndef FIT_BATCH_MAX_THREADS
+#define FIT_BATCH_MAX_THREADS           64
+#endif
+
+// Number of licenses worker takes from its own share at a time.
+#ifndef FIT_BATCH_CHUNK
+#define FIT_BATCH_CHUNK                 8
+#endif
+
+/* Types ********************************************************************/
+
+// Statistics of batch validation.
+typedef struct fit_batch_stats {
+    // Number of worker threads used.
+    uint16_t    m_threads;
+    // Number of licenses that passed validation.
+    uint32_t    m_valid;
+    // Number of licenses that failed validation.
+    uint32_t    m_failed;
+    // Number of times worker took licenses from share of other worker.
+    uint32_t    m_steals;
+#ifdef FIT_USE_MULTI_BUFFER_HASH
+    // Number of licenses hashed by multi-buffer hash engine ahead of validation.
+    uint32_t    m_prehashed;
+#endif
+} fit_batch_stats_t;
+
+/* Function Prototypes ******************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// This function will validate licenses against rsa public key on worker threads.
+fit_status_t fit_batch_validate(fit_pointer_t *licenses,
+                                uint32_t count,
+                                fit_pointer_t *key,
+                                uint16_t threads,
+                                fit_status_t *results,
+                                fit_batch_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // #ifdef FIT_USE_BATCH_VALIDATE
+
+#endif // __FIT_BATCH_H__
@@ -0,0 +1,157 @@
+/****************************************************************************\
+**
+** fit_crypto.h
+**
+** Contains declaration for structures, constants and functions of crypto provider
+** interface. Block encryption, hash update/final and rsa public operations are
+** submitted as jobs to the crypto provider, which completes them synchronously
+** (software provider) or later (e.g. hardware accelerator with DMA). Completion
+** is reported by job state and optional callback.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifndef __FIT_CRYPTO_H__
+#define __FIT_CRYPTO_H__
+
+#ifdef FIT_USE_CRYPTO_PROVIDER
+
+/* Required Includes ********************************************************/
+#include "fit_types.h"
+
+/* Constants ****************************************************************/
+
+// Operations supported by crypto provider.
+enum fit_crypto_op {
+    /** Encrypt one 16 byte block with AES 128/256 key */
+    FIT_CRYPTO_OP_AES_ENCRYPT       = 1,
+    /** Update hash value with 16 byte blocks of data */
+    FIT_CRYPTO_OP_HASH_UPDATE,
+    /** Pad last block of data (at most 16 bytes) and finalize hash value */
+    FIT_CRYPTO_OP_HASH_FINAL,
+    /** RSA public operation (signature ^ E mod N) */
+    FIT_CRYPTO_OP_RSA_PUBLIC,
+};
+
+// Hash algorithms supported by hash operations.
+enum fit_crypto_hash {
+    /** Davies Meyer hash (AES 128); hash value is 16 bytes */
+    FIT_CRYPTO_HASH_DM              = 1,
+    /** Abreast DM hash (AES 256); hash value is 32 bytes */
+    FIT_CRYPTO_HASH_ABREAST_DM,
+};
+
+// States of crypto job.
+enum fit_crypto_job_state {
+    /** Job not submitted */
+    FIT_CRYPTO_JOB_IDLE             = 0,
+    /** Job submitted and not yet completed */
+    FIT_CRYPTO_JOB_PENDING,
+    /** Job completed, see m_status for result */
+    FIT_CRYPTO_JOB_DONE,
+};
+
+/* Types ********************************************************************/
+
+typedef struct fit_crypto_job fit_crypto_job_t;
+typedef struct fit_crypto_provider fit_crypto_provider_t;
+
+// Prototype of job completion callback. Can be called from interrupt or thread
+// context of the provider.
+typedef void (*fit_crypto_done_callback_t)(fit_crypto_job_t *job);
+
+// Caller owned crypto job. Job (and all buffers it refers to) should not be changed
+// or released till job is not completed. All data is accessed directly by address,
+// so it should be memory mapped (RAM or flash).
+struct fit_crypto_job {
+    // Operation. See enum fit_crypto_op
+    uint8_t                     m_op;
+    // Hash algorithm for hash operations. See enum fit_crypto_hash
+    uint8_t                     m_alg;
+    // Job state. See enum fit_crypto_job_state
+    volatile uint8_t            m_state;
+    // Result of operation once job is completed.
+    fit_status_t                m_status;
+    // AES key and its length (AES_128_KEY_LENGTH or AES_256_KEY_LENGTH).
+    const uint8_t               *m_key;
+    uint16_t                    m_keylen;
+    // Prepared rsa public key for rsa public operation.
+    fit_rsa_key_t               *m_rsakey;
+    // Input data: AES block (16 bytes), data to be hashed (multiple of 16 bytes for
+    // update, at most 16 bytes for final) or signature (RSA_SIG_SIZE bytes).
+    const uint8_t               *m_input;
+    uint16_t                    m_length;
+    // Length of complete hashed message; used by hash final for length encoding.
+    uint16_t                    m_total;
+    // Output data: AES block, hash value (input and output of hash operations) or
+    // result of rsa public operation (RSA_SIG_SIZE bytes).
+    uint8_t                     *m_output;
+    // Provider the job is submitted to; NULL for provider selected by fit_crypto_select.
+    fit_crypto_provider_t       *m_provider;
+    // Optional completion callback and caller data.
+    fit_crypto_done_callback_t  m_callback;
+    void                        *m_user;
+};
+
+// Crypto provider. Submit functions should accept the job and either complete it
+// before return or later; in both cases fit_crypto_complete is called on completion.
+// Functions set to NULL are performed by software provider. Provider is owned by
+// FIT core context (see fit_ctx_set_crypto_provider).
+struct fit_crypto_provider {
+    fit_status_t    (*m_aes_encrypt)(void *ctx, fit_crypto_job_t *job);
+    fit_status_t    (*m_hash_update)(void *ctx, fit_crypto_job_t *job);
+    fit_status_t    (*m_hash_final)(void *ctx, fit_crypto_job_t *job);
+    fit_status_t    (*m_rsa_public)(void *ctx, fit_crypto_job_t *job);
+    // Drives completion of pending jobs; NULL if jobs are completed by interrupt
+    // or provider thread.
+    void            (*m_poll)(void *ctx);
+    // Called by fit_crypto_wait while job is pending, so waiting task can give up
+    // the CPU (e.g. yield to scheduler or sleep till interrupt); NULL to keep polling.
+    void            (*m_yield)(void *ctx);
+    // Provider specific data passed to all functions above.
+    void            *m_ctx;
+};
+
+/* Function Prototypes ******************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// This function will set crypto provider of default context (NULL for software
+// provider). See fit_ctx_set_crypto_provider.
+void fit_crypto_set_provider(fit_crypto_provider_t *provider);
+
+// This function will select crypto provider for jobs of calling thread that are not
+// bound to provider; returns provider selected before.
+fit_crypto_provider_t *fit_crypto_select(fit_crypto_provider_t *provider);
+
+// This function will submit the job to its crypto provider.
+fit_status_t fit_crypto_submit(fit_crypto_job_t *job);
+
+// This function will check the job for completion. Returns FIT_CRYPTO_PENDING till
+// job is not completed, then result of job.
+fit_status_t fit_crypto_poll(fit_crypto_job_t *job);
+
+// This function will wait till job is completed and return its result.
+fit_status_t fit_crypto_wait(fit_crypto_job_t *job);
+
+// This function will perform the job in software (synchronously) and return its
+// result. Job state is not changed. Can be used by providers to perform jobs.
+fit_status_t fit_crypto_execute(fit_crypto_job_t *job);
+
+// This function should be called by providers when job is completed.
+void fit_crypto_complete(fit_crypto_job_t *job, fit_status_t status);
+
+// This function will calculate hash of data by selected crypto provider and wait
+// for the result.
+fit_status_t fit_crypto_hash(uint8_t alg, fit_pointer_t *msg, uint8_t *hash);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // #ifdef FIT_USE_CRYPTO_PROVIDER
+
+#endif // __FIT_CRYPTO_H__
@@ -0,0 +1,73 @@
+/****************************************************************************\
+**
+** fit_crypto_pool.h
+**
+** Contains declaration for thread pool crypto provider. Used on host (POSIX)
+** builds as stand-in for asynchronous crypto hardware: jobs are queued and
+** completed by worker threads, optionally after simulated device latency.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifndef __FIT_CRYPTO_POOL_H__
+#define __FIT_CRYPTO_POOL_H__
+
+#if defined(FIT_USE_CRYPTO_PROVIDER) && defined(FIT_USE_CRYPTO_POOL)
+
+/* Required Includes ********************************************************/
+#include <pthread.h>
+#include "fit_crypto.h"
+
+/* Constants ****************************************************************/
+
+// Maximum number of worker threads.
+#ifndef FIT_CRYPTO_POOL_MAX_THREADS
+#define FIT_CRYPTO_POOL_MAX_THREADS     8
+#endif
+
+// Maximum number of jobs waiting for worker thread.
+#ifndef FIT_CRYPTO_POOL_QUEUE_SIZE
+#define FIT_CRYPTO_POOL_QUEUE_SIZE      32
+#endif
+
+/* Types ********************************************************************/
+
+// Thread pool crypto provider.
+typedef struct fit_crypto_pool {
+    // Provider to be passed to fit_ctx_set_crypto_provider.
+    fit_crypto_provider_t   m_provider;
+    // Worker threads.
+    pthread_t               m_threads[FIT_CRYPTO_POOL_MAX_THREADS];
+    uint8_t                 m_nthreads;
+    // Set when worker threads should exit.
+    uint8_t                 m_stop;
+    // Simulated latency of every job in microseconds.
+    uint32_t                m_latency;
+    // Queue of submitted jobs protected by m_lock.
+    pthread_mutex_t         m_lock;
+    pthread_cond_t          m_cond;
+    fit_crypto_job_t        *m_queue[FIT_CRYPTO_POOL_QUEUE_SIZE];
+    uint16_t                m_head;
+    uint16_t                m_count;
+} fit_crypto_pool_t;
+
+/* Function Prototypes ******************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// This function will start worker threads and initialize the provider.
+fit_status_t fit_crypto_pool_init(fit_crypto_pool_t *pool, uint8_t threads, uint32_t latency);
+
+// This function will stop worker threads. Pending jobs are completed first.
+void fit_crypto_pool_free(fit_crypto_pool_t *pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // #if defined(FIT_USE_CRYPTO_PROVIDER) && defined(FIT_USE_CRYPTO_POOL)
+
+#endif // __FIT_CRYPTO_POOL_H__
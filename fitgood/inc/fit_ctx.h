@@ -0,0 +1,185 @@
+/****************************************************************************\
+**
+** fit_ctx.h
+**
+** Contains declaration for FIT core context and functions taking it. Context owns
+** all mutable state of FIT core (license validation cache, persistent rsa key,
+** crypto provider and platform callbacks), so licenses can be validated and
+** consumed concurrently by different tasks/threads, each using its own context.
+** Functions without context parameter use default context (see fit_ctx_default).
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifndef __FIT_CTX_H__
+#define __FIT_CTX_H__
+
+/* Required Includes ********************************************************/
+#include "fit_types.h"
+#include "fit.h"
+#include "fit_shared_cache.h"
+#include "fit_mbhash.h"
+#include "fit_merkle.h"
+#include "fit_crypto.h"
+
+/* Constants ****************************************************************/
+
+// FIT_USE_CONCURRENT_CTX is to be defined if contexts are used by concurrent
+// threads; batch validation and shared cache imply it. The little state kept
+// outside of contexts (crypto provider selected for validation, tracking of
+// segment hash reads) is per thread then, and mbedtls arena must be built per
+// thread (FIT_USE_ARENA_PER_THREAD). Processor feature checks (AES-NI, SHA-NI,
+// MULX) are cached process wide; they are read and written atomically and give
+// the same result in every thread.
+#if defined(FIT_USE_BATCH_VALIDATE) || defined(FIT_USE_SHARED_CACHE)
+#ifndef FIT_USE_CONCURRENT_CTX
+#define FIT_USE_CONCURRENT_CTX
+#endif
+#endif
+
+/* Types ********************************************************************/
+
+// Structure for caching RSA validation data. It caches the hash of license
+// string using Davies Meyer hash function.
+typedef struct {
+    uint8_t m_rsa_check_done;
+    uint8_t m_dm_hash[FIT_DM_HASH_SIZE];
+    // Davies Meyer hash of key bytes license above was validated with; cached
+    // license is accepted only for same key bytes.
+    uint8_t m_key_hash[FIT_DM_HASH_SIZE];
+    // Negative cache: status of last license that failed validation for reason that
+    // does not change (see fit_is_cacheable_failure), hash of its complete binary and
+    // hash of key bytes used for validation. Kept apart from validated license above.
+    fit_status_t m_fail_status;
+    uint8_t m_fail_hash[FIT_DM_HASH_SIZE];
+    uint8_t m_fail_key[FIT_DM_HASH_SIZE];
+    // Cache statistics.
+    fit_cache_stats_t m_stats;
+#ifdef FIT_USE_TRUSTED_STORAGE
+    // Set if license below was validated at storage generation m_generation.
+    uint8_t m_trusted;
+    uint32_t m_generation;
+    uint8_t *m_license;
+    uint16_t m_length;
+#endif // #ifdef FIT_USE_TRUSTED_STORAGE
+#ifdef FIT_USE_SEGMENTED_HASH
+    // Algorithm used for signing the license and root of its hash tree.
+    uint8_t m_algid;
+    uint8_t m_root[FIT_MERKLE_HASH_SIZE];
+#endif // #ifdef FIT_USE_SEGMENTED_HASH
+} fit_cache_data;
+
+// FIT core context. Initialized by fit_ctx_init; one context must not be used by
+// two tasks/threads at the same time.
+typedef struct fit_ctx {
+    // License validation cache.
+    fit_cache_data          m_cache;
+    // Callback for getting current time (unix); NULL if there is no clock.
+    fit_cb_time_get_t       m_time_get;
+    // Callback for getting generation number of trusted storage; NULL if not used.
+    fit_cb_generation_get_t m_generation_get;
+    // RSA key of last license validation and storage generation at which its bytes
+    // were hashed (see fit_ctx_get_key). Key is kept parsed across validations if
+    // FIT_USE_PERSISTENT_KEY is defined.
+    fit_rsa_key_handle_t    m_key;
+    uint8_t                 m_key_init;
+    uint32_t                m_key_generation;
+#ifdef FIT_USE_SHARED_CACHE
+    // Validation cache shared with other contexts (NULL if not attached), its
+    // snapshot last copied out and sequence number of that snapshot. Snapshot is
+    // kept apart from m_cache and checked only if license is not found there.
+    fit_shared_cache_t      *m_shared;
+    fit_cache_snapshot_t    m_shared_snapshot;
+    uint32_t                m_shared_seq;
+#endif // #ifdef FIT_USE_SHARED_CACHE
+#ifdef FIT_USE_MULTI_BUFFER_HASH
+    // Hashes of license being validated calculated ahead by multi-buffer hash
+    // engine (see fit_ctx_set_hashes); NULL if none.
+    const fit_mb_license_hashes_t *m_hashes;
+#endif // #ifdef FIT_USE_MULTI_BUFFER_HASH
+#ifdef FIT_USE_SEGMENTED_HASH
+    // Segment hashes of last license whose hash tree root was calculated.
+    fit_merkle_data_t       m_merkle;
+#endif // #ifdef FIT_USE_SEGMENTED_HASH
+#ifdef FIT_USE_CRYPTO_PROVIDER
+    // Crypto provider used for license validation; NULL for software provider.
+    fit_crypto_provider_t   *m_crypto;
+#endif // #ifdef FIT_USE_CRYPTO_PROVIDER
+} fit_ctx_t;
+
+/* Function Prototypes ******************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// This function will initialize context with empty cache and default (hwdep.h)
+// platform callbacks.
+void fit_ctx_init(fit_ctx_t *ctx);
+
+// This function will release resources (persistent rsa key) held by context.
+void fit_ctx_free(fit_ctx_t *ctx);
+
+// This function will return default context used by functions without context
+// parameter.
+fit_ctx_t *fit_ctx_default(void);
+
+// This function will set callback for getting current time (unix).
+void fit_ctx_set_time_callback(fit_ctx_t *ctx, fit_cb_time_get_t callback_fn);
+
+// This function will set callback for getting generation number of trusted storage.
+void fit_ctx_set_generation_callback(fit_ctx_t *ctx, fit_cb_generation_get_t callback_fn);
+
+#ifdef FIT_USE_SHARED_CACHE
+// This function will attach context to validation cache shared by contexts.
+void fit_ctx_set_shared_cache(fit_ctx_t *ctx, fit_shared_cache_t *shared);
+#endif // #ifdef FIT_USE_SHARED_CACHE
+
+#ifdef FIT_USE_MULTI_BUFFER_HASH
+// This function will pass hashes calculated by fit_mb_hash_licenses to validation.
+void fit_ctx_set_hashes(fit_ctx_t *ctx, const fit_mb_license_hashes_t *hashes);
+#endif // #ifdef FIT_USE_MULTI_BUFFER_HASH
+
+#ifdef FIT_USE_CRYPTO_PROVIDER
+// This function will set crypto provider used for license validation with context.
+void fit_ctx_set_crypto_provider(fit_ctx_t *ctx, fit_crypto_provider_t *provider);
+#endif // #ifdef FIT_USE_CRYPTO_PROVIDER
+
+// This function will return rsa key structure of context for key passed in; key is
+// hashed again only if different key is passed in or storage generation changed.
+fit_rsa_key_t *fit_ctx_get_key(fit_ctx_t *ctx, fit_pointer_t *key);
+
+// This function will release parsed key of context after license validation, unless
+// FIT_USE_PERSISTENT_KEY keeps it parsed.
+void fit_ctx_release_key(fit_ctx_t *ctx);
+
+// Same as fit_licenf_consume_license, using passed in context.
+fit_status_t fit_licenf_consume_license_ctx(fit_ctx_t *ctx,
+                                            fit_pointer_t* license,
+                                            uint16_t feature_id,
+                                            void* state_buffer,
+                                            fit_pointer_t* key);
+
+// Same as fit_licenf_validate_license, using passed in context.
+fit_status_t fit_licenf_validate_license_ctx(fit_ctx_t *ctx,
+                                             fit_pointer_t *license,
+                                             fit_pointer_t *key);
+
+// Same as fit_licenf_validate_licenses, using passed in context.
+fit_status_t fit_licenf_validate_licenses_ctx(fit_ctx_t *ctx,
+                                              fit_pointer_t *licenses,
+                                              uint16_t count,
+                                              fit_rsa_key_handle_t *handle,
+                                              fit_status_t *results);
+
+// Same as fit_licenf_get_cache_stats, for cache of passed in context.
+fit_status_t fit_licenf_get_cache_stats_ctx(fit_ctx_t *ctx,
+                                            fit_cache_stats_t *stats,
+                                            uint8_t reset);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __FIT_CTX_H__
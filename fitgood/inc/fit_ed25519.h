@@ -0,0 +1,106 @@
+/****************************************************************************\
+**
+** fit_ed25519.h
+**
+** Contains declaration for constants and functions used in Ed25519 (RFC 8032)
+** license signature verification. Signed message is Abreast DM hash of license
+** part, same as for rsa signature; signature is 64 bytes and public key is 32
+** bytes, so much less data is read from license/key storage than for RSA-2048.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifndef __FIT_ED25519_H__
+#define __FIT_ED25519_H__
+
+#ifdef FIT_USE_ED25519
+
+/* Required Includes ********************************************************/
+#include "fit_types.h"
+#include "fit_status.h"
+
+/* Constants ****************************************************************/
+
+// Size of Ed25519 signature (encoded point R || scalar S) in bytes.
+#define FIT_ED25519_SIG_SIZE            64
+
+// Size of Ed25519 public key (encoded point A) in bytes.
+#define FIT_ED25519_KEY_SIZE            32
+
+/* Types ********************************************************************/
+
+// Field element mod 2^255 - 19; 16 limbs of (about) 16 bits, least significant
+// first. Limbs are signed, as result of subtraction is not normalized.
+typedef int32_t fit_fe_t[16];
+
+// Point in extended coordinates (x = X/Z, y = Y/Z, x*y = T/Z).
+typedef struct {
+    fit_fe_t    m_x;
+    fit_fe_t    m_y;
+    fit_fe_t    m_z;
+    fit_fe_t    m_t;
+} fit_ge_t;
+
+// Context of resumable Ed25519 verification. Holds everything needed to continue
+// double and add pass computing [S]B + [h](-A), so it can be split into steps.
+typedef struct fit_ed25519_ctx {
+    // Signature R || S.
+    uint8_t     m_sig[FIT_ED25519_SIG_SIZE];
+    // h = SHA-512(R || A || M) mod L.
+    uint8_t     m_h[32];
+    // Negated public key -A, base point B and B - A.
+    fit_ge_t    m_a;
+    fit_ge_t    m_b;
+    fit_ge_t    m_ab;
+    // Accumulated result of scalar bits processed so far.
+    fit_ge_t    m_p;
+    // Next scalar bit to be processed; -1 when all bits are processed.
+    int16_t     m_bit;
+} fit_ed25519_ctx_t;
+
+/* Function Prototypes ******************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// This function will verify Ed25519 signature of message (in RAM) against
+// public key (in RAM).
+fit_status_t fit_ed25519_verify(const uint8_t *sig,
+                                const uint8_t *pubkey,
+                                const uint8_t *msg,
+                                uint16_t msglen);
+
+// This function will check signature and public key and hash the message; the
+// rest of verification is done by fit_ed25519_verify_step.
+fit_status_t fit_ed25519_verify_start(fit_ed25519_ctx_t *ctx,
+                                      const uint8_t *sig,
+                                      const uint8_t *pubkey,
+                                      const uint8_t *msg,
+                                      uint16_t msglen);
+
+// This function will process at most budget scalar bits of started verification.
+// Returns FIT_VERIFY_IN_PROGRESS till verification is not completed.
+fit_status_t fit_ed25519_verify_step(fit_ed25519_ctx_t *ctx, uint16_t *budget);
+
+// Same as fit_ed25519_verify_start for license signature and public key read
+// through their fit_pointer read functions.
+fit_status_t fit_ed25519_start_signature(fit_ed25519_ctx_t *ctx,
+                                         fit_pointer_t *signature,
+                                         uint8_t *msg,
+                                         fit_pointer_t *key);
+
+// This function is to validate Ed25519 signature of license hash against public
+// key. Signature and key are read through their fit_pointer read functions.
+fit_status_t fit_validate_ed25519_signature(fit_pointer_t *signature,
+                                            uint8_t *msg,
+                                            fit_pointer_t *key);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // #ifdef FIT_USE_ED25519
+
+#endif // __FIT_ED25519_H__
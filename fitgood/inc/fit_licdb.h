@@ -0,0 +1,157 @@
+/****************************************************************************\
+**
+** fit_licdb.h
+**
+** Contains declaration for packed license database used by host (back office)
+** tools instead of one file per license. Database file is:
+**      header (fit_licdb_header_t)
+**      records, each aligned to FIT_LICDB_ALIGN bytes:
+**          record header (fit_licdb_record_t) followed by record data
+**          license record --> index entry of license followed by license binary
+**          index record   --> index entries of all licenses, sorted by UID and
+**                             container ID
+** Records are only appended: new licenses and new index are written at end of file
+** and header is updated last, so file stays consistent if append is interrupted.
+** Index records other than the one in header are not used; they are left out when
+** database is copied to new file (fit_licdb tool, compact command).
+**
+** Reader maps the file, so licenses are used in place (fit_pointer_t into mapping)
+** and lookup by UID is binary search in index. Enabled by FIT_USE_LICENSE_DB
+** (POSIX hosts only). All values are in byte order of the host that wrote the file.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifndef __FIT_LICDB_H__
+#define __FIT_LICDB_H__
+
+#ifdef FIT_USE_LICENSE_DB
+
+/* Required Includes ********************************************************/
+#include <stddef.h>
+#include "fit_types.h"
+#include "fit_status.h"
+#include "fit.h"
+
+/* Constants ****************************************************************/
+
+// Magic value at start of database file and format version.
+#define FIT_LICDB_MAGIC                 "FITLICDB"
+#define FIT_LICDB_MAGIC_LEN             8
+#define FIT_LICDB_VERSION               1
+
+// Written as is; reader rejects file written by host of other byte order.
+#define FIT_LICDB_BYTE_ORDER            0x01020304UL
+
+// Alignment of records (and so of license binaries) in file.
+#define FIT_LICDB_ALIGN                 8
+
+// Container ID matching any container in fit_licdb_find.
+#define FIT_LICDB_ANY_CONTAINER         0xFFFFFFFFUL
+
+// Record types.
+enum fit_licdb_record_type {
+    /** Index entry of license followed by license binary */
+    FIT_LICDB_RECORD_LICENSE        = 1,
+    /** Index entries sorted by UID and container ID */
+    FIT_LICDB_RECORD_INDEX,
+};
+
+// Access pattern passed to fit_licdb_open (used as hint for paging).
+enum fit_licdb_access {
+    /** Random lookups (fit_licdb_find/fit_licdb_get) */
+    FIT_LICDB_LOOKUP                = 0,
+    /** Scan of all licenses in file order (fit_licdb_next) */
+    FIT_LICDB_SCAN,
+};
+
+/* Types ********************************************************************/
+
+// Database file header.
+typedef struct fit_licdb_header {
+    uint8_t     m_magic[FIT_LICDB_MAGIC_LEN];
+    uint32_t    m_version;
+    uint32_t    m_byte_order;
+    // Number of entries in index record.
+    uint32_t    m_count;
+    uint32_t    m_reserved;
+    // File offset of index record (0 if database is empty) and end of last record
+    // (next record is appended there).
+    uint64_t    m_index;
+    uint64_t    m_end;
+    uint8_t     m_pad[24];
+} fit_licdb_header_t;
+
+// Header of every record.
+typedef struct fit_licdb_record {
+    // Record type. See enum fit_licdb_record_type
+    uint32_t    m_type;
+    // Length of record data (without padding).
+    uint32_t    m_length;
+} fit_licdb_record_t;
+
+// Index entry of one license.
+typedef struct fit_licdb_entry {
+    // Unique license identifier (FIT_UID_TAG_ID) and license container ID.
+    uint8_t     m_uid[FIT_UID_LEN];
+    uint32_t    m_container_id;
+    // Length of license binary and its file offset.
+    uint32_t    m_length;
+    uint64_t    m_offset;
+} fit_licdb_entry_t;
+
+// Opened (mapped) database. Values of header are taken when database is opened,
+// so licenses appended later are seen only after it is opened again.
+typedef struct fit_licdb {
+    const uint8_t           *m_map;
+    size_t                  m_size;
+    // Index (in mapping), number of its entries and end of last record.
+    const fit_licdb_entry_t *m_index;
+    uint32_t                m_count;
+    uint64_t                m_end;
+} fit_licdb_t;
+
+/* Function Prototypes ******************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// This function will map database file for reading.
+fit_status_t fit_licdb_open(fit_licdb_t *db, const char *path, uint8_t access);
+
+// This function will unmap database.
+void fit_licdb_close(fit_licdb_t *db);
+
+// This function will get license by its position in index (0 to m_count - 1).
+fit_status_t fit_licdb_get(fit_licdb_t *db,
+                           uint32_t index,
+                           fit_pointer_t *license,
+                           const fit_licdb_entry_t **entry);
+
+// This function will find license by UID (and container ID) in index.
+fit_status_t fit_licdb_find(fit_licdb_t *db,
+                            const uint8_t *uid,
+                            uint32_t container_id,
+                            uint32_t *index);
+
+// This function will get next license in file order (for scans).
+fit_status_t fit_licdb_next(fit_licdb_t *db,
+                            uint64_t *pos,
+                            fit_pointer_t *license,
+                            const fit_licdb_entry_t **entry);
+
+// This function will append licenses to database file (created if missing).
+fit_status_t fit_licdb_append(const char *path,
+                              fit_pointer_t *licenses,
+                              uint32_t count,
+                              fit_status_t *results);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // #ifdef FIT_USE_LICENSE_DB
+
+#endif // __FIT_LICDB_H__
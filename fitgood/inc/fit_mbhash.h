@@ -0,0 +1,92 @@
+/****************************************************************************\
+**
+** fit_mbhash.h
+**
+** Contains declaration for multi-buffer hash engine used on host (back office).
+** Davies Meyer and Abreast DM hash of one message is strictly sequential, as every
+** block is used as AES key of next step; engine hashes number of independent
+** messages at a time (one per lane), so AES instructions of different lanes are
+** interleaved. Enabled by FIT_USE_MULTI_BUFFER_HASH; lanes are interleaved only if
+** AES-NI backend (FIT_USE_AESNI) is available, otherwise they are hashed one after
+** another by portable AES implementation.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifndef __FIT_MBHASH_H__
+#define __FIT_MBHASH_H__
+
+#ifdef FIT_USE_MULTI_BUFFER_HASH
+
+/* Required Includes ********************************************************/
+#include "fit_types.h"
+#include "fit.h"
+
+/* Constants ****************************************************************/
+
+// Number of messages hashed at a time (1 to 8).
+#ifndef FIT_MB_LANES
+#define FIT_MB_LANES                    4
+#endif
+
+#if FIT_MB_LANES < 1 || FIT_MB_LANES > 8
+#error "FIT_MB_LANES must be from 1 to 8"
+#endif
+
+// Largest hash value (Abreast DM) produced by engine.
+#define FIT_MB_HASH_SIZE                32
+
+// Hash algorithms supported by multi-buffer engine.
+enum fit_mb_hash_alg {
+    /** Davies Meyer hash (AES 128); hash value is FIT_DM_HASH_SIZE bytes */
+    FIT_MB_HASH_DM                  = 1,
+    /** Abreast DM hash (AES 256); hash value is FIT_MB_HASH_SIZE bytes */
+    FIT_MB_HASH_ABREAST_DM,
+};
+
+/* Types ********************************************************************/
+
+// Hashes of one license calculated ahead of its validation, i.e. hashes that
+// fit_check_license_validation would otherwise calculate itself.
+typedef struct fit_mb_license_hashes {
+    // Part of license covered by signature and its Abreast DM hash; read_byte is
+    // NULL if license is not signed by AES algorithm (or could not be parsed).
+    fit_pointer_t   m_signed;
+    uint8_t         m_abreast[FIT_MB_HASH_SIZE];
+    // License data (parsed length) and its Davies Meyer hash; read_byte is NULL if
+    // license could not be parsed.
+    fit_pointer_t   m_license;
+    uint8_t         m_dm[FIT_DM_HASH_SIZE];
+} fit_mb_license_hashes_t;
+
+/* Function Prototypes ******************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// This function will calculate hash of number of messages, FIT_MB_LANES at a time.
+fit_status_t fit_mb_hash(uint8_t alg,
+                         fit_pointer_t *msgs,
+                         uint32_t count,
+                         uint8_t *hashes);
+
+// This function will calculate hashes needed for validation of number of licenses.
+fit_status_t fit_mb_hash_licenses(fit_pointer_t *licenses,
+                                  uint32_t count,
+                                  fit_mb_license_hashes_t *hashes);
+
+// This function will look up hash of data in hashes calculated ahead of validation.
+uint8_t fit_mb_hash_lookup(const fit_mb_license_hashes_t *hashes,
+                           uint8_t alg,
+                           fit_pointer_t *data,
+                           uint8_t *hash);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // #ifdef FIT_USE_MULTI_BUFFER_HASH
+
+#endif // __FIT_MBHASH_H__
@@ -0,0 +1,84 @@
+/****************************************************************************\
+**
+** fit_merkle.h
+**
+** Contains declaration for constants and functions used in segmented (Merkle)
+** license hashing. License part is divided into fixed size segments and signed
+** value is root of hash tree over segment hashes, so each segment can be
+** authenticated separately. State of last verified license is kept in FIT core
+** context (fit_merkle_data_t), so contexts can verify licenses independently.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifndef __FIT_MERKLE_H__
+#define __FIT_MERKLE_H__
+
+#ifdef FIT_USE_SEGMENTED_HASH
+
+/* Required Includes ********************************************************/
+#include "fit_types.h"
+#include "mem_read.h"
+#include "fit.h"
+
+/* Constants ****************************************************************/
+
+// Size of one license segment in bytes. Last segment can be shorter. Must match
+// the value used by license generator.
+#ifndef FIT_MERKLE_SEGMENT_SIZE
+#define FIT_MERKLE_SEGMENT_SIZE         256
+#endif
+
+// Maximum number of segments supported (not more than 128).
+#ifndef FIT_MERKLE_MAX_SEGMENTS
+#define FIT_MERKLE_MAX_SEGMENTS         64
+#endif
+
+// Maximum depth of hash tree for FIT_MERKLE_MAX_SEGMENTS segments.
+#define FIT_MERKLE_MAX_DEPTH            8
+
+// Byte hashed ahead of segment data (leaf) and of two child hashes (node), so leaf
+// and node hashes can never be interchanged. Must match the license generator.
+#define FIT_MERKLE_LEAF_PREFIX          0x00
+#define FIT_MERKLE_NODE_PREFIX          0x01
+
+/* Types ********************************************************************/
+
+// Segment hashes of last verified license and list of segments read while tracking.
+typedef struct fit_merkle_data {
+    // License part covered by hash tree.
+    fit_pointer_t               m_licpart;
+    // Segment hashes present in license.
+    fit_pointer_t               m_leaves;
+    // Read function of license being tracked.
+    fit_read_byte_callback_t    m_read_byte;
+    // Bitmap of segments read since tracking is started.
+    uint8_t                     m_touched[(FIT_MERKLE_MAX_SEGMENTS+7)/8];
+} fit_merkle_data_t;
+
+/* Function Prototypes ******************************************************/
+
+// This function will calculate root of hash tree over segment hashes present in
+// license and remember the segment hashes for later segment verification.
+fit_status_t fit_merkle_get_root(fit_merkle_data_t *merkle,
+                                 fit_pointer_t *license,
+                                 fit_pointer_t *licpart,
+                                 uint8_t *root);
+
+// This function will verify license segments that cover the data range passed in.
+fit_status_t fit_merkle_verify_range(fit_merkle_data_t *merkle,
+                                     uint8_t *data,
+                                     uint16_t length);
+
+// This function will start tracking of license reads done through returned pointer.
+void fit_merkle_track_start(fit_merkle_data_t *merkle,
+                            fit_pointer_t *license,
+                            fit_pointer_t *tracked);
+
+// This function will verify all license segments read since fit_merkle_track_start.
+fit_status_t fit_merkle_track_verify(fit_merkle_data_t *merkle);
+
+#endif // #ifdef FIT_USE_SEGMENTED_HASH
+
+#endif // __FIT_MERKLE_H__
@@ -0,0 +1,82 @@
+/****************************************************************************\
+**
+** fit_mont.h
+**
+** Contains declaration for constants and functions of fixed size Montgomery
+** arithmetic used by rsa public operation with small public exponent (e.g. 3 or
+** 65537). Enabled by FIT_USE_RSA_SMALL_EXP.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifndef __FIT_MONT_H__
+#define __FIT_MONT_H__
+
+/* Required Includes ********************************************************/
+#include "fit_types.h"
+#include "mbedtls/bignum.h"
+
+/* Constants ****************************************************************/
+
+// Montgomery arithmetic needs double width limb product (mbedtls_t_udbl); if not
+// available mbedtls exponentiation is used even if FIT_USE_RSA_SMALL_EXP is defined.
+#if defined(FIT_USE_RSA_SMALL_EXP) && defined(MBEDTLS_HAVE_UDBL)
+#define FIT_MONT_AVAILABLE
+#endif
+
+#ifdef FIT_MONT_AVAILABLE
+
+// FIT_USE_MONT_ASM selects tuned multiply-accumulate kernel using MULX/ADX on
+// x86-64; it is used if processor supports these instructions (checked at run
+// time) and not turned off by fit_mont_use_asm. Portable kernel is used otherwise.
+#if defined(FIT_USE_MONT_ASM) && defined(MBEDTLS_HAVE_INT64) && \
+    (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+#define FIT_MONT_MULX_AVAILABLE
+#endif
+
+// Size of modulus in bytes; same as RSA_SIG_SIZE.
+#define FIT_MONT_SIZE           256
+
+// Number of limbs of modulus (and of all Montgomery numbers).
+#define FIT_MONT_LIMBS          (FIT_MONT_SIZE / sizeof(mbedtls_mpi_uint))
+
+// Maximum length of public exponent in bits handled by fit_mont_exp_small
+// (65537 is 17 bits long).
+#define FIT_MONT_MAX_EXP_BITS   17
+
+/* Types ********************************************************************/
+
+// Montgomery constants of rsa public key; set up once per key by fit_mont_setup.
+typedef struct fit_mont_ctx {
+    // Modulus (FIT_MONT_LIMBS limbs); refers to limbs of parsed or raw key.
+    const mbedtls_mpi_uint  *m_n;
+    // R^2 mod N, used to convert numbers to Montgomery form.
+    mbedtls_mpi_uint        m_rr[FIT_MONT_LIMBS];
+    // -N^-1 mod 2^(limb bits).
+    mbedtls_mpi_uint        m_mm;
+    // Public exponent and its length in bits.
+    mbedtls_mpi_uint        m_e;
+    uint8_t                 m_ebits;
+} fit_mont_ctx_t;
+
+/* Function Prototypes ******************************************************/
+
+// This function will set up Montgomery constants for rsa public key with small
+// public exponent (at most FIT_MONT_MAX_EXP_BITS bits). Precomputed constants are
+// used if passed in (rr not NULL).
+fit_status_t fit_mont_setup(fit_mont_ctx_t *ctx,
+                            const mbedtls_mpi *N,
+                            const mbedtls_mpi *E,
+                            const mbedtls_mpi_uint *rr,
+                            mbedtls_mpi_uint mm);
+
+// This function will perform rsa public operation (input ^ E mod N).
+fit_status_t fit_mont_exp_small(const fit_mont_ctx_t *ctx, const uint8_t *input, uint8_t *output);
+
+// This function will turn tuned kernel on or off and return TRUE if it is used.
+uint8_t fit_mont_use_asm(uint8_t enable);
+
+#endif // #ifdef FIT_MONT_AVAILABLE
+
+#endif // __FIT_MONT_H__
@@ -0,0 +1,78 @@
+/**
+* Sentinel Fit RSA Public Key (raw format)
+*
+* Generated by tools/fit_rawkey from public key of fit_pubkey.h; do not edit.
+*
+* Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+*
+*/
+#ifndef __FIT_PUBKEY_RAW_H__
+#define __FIT_PUBKEY_RAW_H__
+
+#include "fit_rsa.h"
+
+static const fit_rsa_raw_key_t fit_pubkey_raw = {
+    FIT_RSA_RAW_KEY_MAGIC,
+    FIT_RSA_RAW_KEY_RR,
+    { 0 },
+    // -N^-1 mod 2^64
+    {
+        0xF0, 0xD0, 0x3E, 0xB0, 0xE5, 0xC6, 0x90, 0x89
+    },
+    // Public exponent
+    {
+        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03
+    },
+    // Modulus
+    {
+        0x9B, 0xDF, 0x46, 0xBF, 0xC6, 0x30, 0x5B, 0x84, 0xDA, 0x09, 0x62, 0xFE,
+        0x0C, 0xC0, 0x18, 0xC5, 0x43, 0x0F, 0x4A, 0xA7, 0xF8, 0x17, 0x21, 0x05,
+        0xB4, 0xA6, 0x76, 0xB8, 0x9C, 0x3E, 0x2E, 0xD7, 0x66, 0xFE, 0x38, 0x7A,
+        0x5D, 0x98, 0x17, 0xE4, 0x45, 0x92, 0x8C, 0xF2, 0x10, 0x22, 0x0D, 0x75,
+        0xD4, 0x0B, 0xFD, 0xD0, 0x87, 0x47, 0x24, 0x40, 0xEE, 0x54, 0x7A, 0x56,
+        0x32, 0xBB, 0x84, 0xD1, 0x9A, 0x16, 0x8A, 0x42, 0xDB, 0x7F, 0x98, 0xFA,
+        0x49, 0xCC, 0x57, 0x6E, 0xD1, 0x45, 0x7C, 0x53, 0x7E, 0xFE, 0xD7, 0x4D,
+        0x93, 0xED, 0xD5, 0x64, 0xF3, 0x86, 0x7C, 0x1C, 0xB6, 0xFF, 0xD8, 0xC7,
+        0x4A, 0x98, 0x58, 0x03, 0xFC, 0xD2, 0xFB, 0x9C, 0xF1, 0x97, 0xEE, 0x98,
+        0x02, 0x65, 0x06, 0x2D, 0x58, 0xB6, 0xC9, 0x93, 0xF9, 0xE3, 0xA7, 0xCC,
+        0x5B, 0x32, 0x91, 0x9C, 0x2C, 0x49, 0x22, 0x1A, 0x0C, 0x5D, 0x74, 0xE6,
+        0xDB, 0x63, 0x19, 0xF1, 0xBD, 0x8A, 0xCC, 0xB0, 0xA7, 0x41, 0xF9, 0xBB,
+        0xF8, 0x7E, 0x31, 0xB5, 0x3B, 0xD0, 0x4B, 0x94, 0x47, 0xD5, 0xA7, 0xE2,
+        0x62, 0x41, 0x9F, 0xD9, 0x54, 0x06, 0x3D, 0x9B, 0x2B, 0x24, 0x81, 0xA1,
+        0xFA, 0xF7, 0x3C, 0x79, 0x59, 0xBD, 0x41, 0x45, 0x11, 0x03, 0xFF, 0x52,
+        0x4E, 0x70, 0x87, 0xDF, 0x4F, 0x5E, 0x5C, 0x42, 0x2F, 0x4C, 0x08, 0xF9,
+        0x72, 0xC4, 0x1F, 0x75, 0x95, 0xCB, 0x6F, 0xF3, 0xCB, 0x1C, 0xDB, 0x70,
+        0xE9, 0xB2, 0x03, 0xBC, 0x67, 0xDE, 0xB8, 0xCF, 0xDE, 0xCD, 0xF9, 0x2B,
+        0xAC, 0x67, 0x50, 0xDB, 0x56, 0x19, 0x5C, 0x70, 0xD9, 0x4C, 0x4F, 0xF0,
+        0x50, 0x16, 0x85, 0x65, 0x3A, 0x8E, 0xA2, 0xF4, 0xAF, 0xF6, 0x5F, 0x61,
+        0x94, 0x53, 0xEC, 0x13, 0x78, 0x51, 0x61, 0x58, 0x3F, 0x72, 0x5B, 0x7D,
+        0xF1, 0x40, 0x1A, 0x47
+    },
+    // R^2 mod N
+    {
+        0x38, 0x51, 0x1B, 0xC6, 0x54, 0x79, 0xC7, 0x75, 0x93, 0xB9, 0xD1, 0xCE,
+        0x3C, 0x04, 0x9D, 0x9F, 0x34, 0x38, 0x68, 0xC5, 0xE9, 0xCE, 0x67, 0x5C,
+        0x64, 0x5E, 0xBB, 0x5B, 0xD0, 0xF2, 0xF8, 0x70, 0x7D, 0xC9, 0x9C, 0xEE,
+        0x27, 0x9D, 0x47, 0x1B, 0xDD, 0xA4, 0x9A, 0xF7, 0x52, 0x23, 0x01, 0x79,
+        0x30, 0xFF, 0x5E, 0x93, 0x06, 0x84, 0x8A, 0xA8, 0xB0, 0xD7, 0x71, 0x2B,
+        0x99, 0xC0, 0xB5, 0x2B, 0x00, 0x22, 0x6E, 0x1D, 0x75, 0x7F, 0x27, 0x96,
+        0x99, 0xF1, 0x9E, 0x8F, 0xC2, 0xCD, 0xDA, 0xD2, 0x6B, 0x51, 0x75, 0xCA,
+        0x51, 0xC3, 0x1A, 0xA1, 0x54, 0xBF, 0xB6, 0x56, 0x87, 0xFC, 0x1B, 0x06,
+        0x1A, 0xB9, 0x3D, 0x43, 0xD5, 0x24, 0xBA, 0xD5, 0x7F, 0x53, 0xD5, 0x44,
+        0x02, 0x24, 0x48, 0x79, 0xD8, 0xED, 0x6B, 0x5C, 0xAE, 0xAC, 0x91, 0x81,
+        0xDE, 0x46, 0x58, 0x00, 0x16, 0xC1, 0x12, 0x9B, 0x61, 0x1A, 0x58, 0x75,
+        0xE2, 0x48, 0x1E, 0x3E, 0x6B, 0x42, 0x46, 0x53, 0xD9, 0xFE, 0x28, 0xD3,
+        0x4B, 0x5A, 0xDA, 0x2F, 0x4C, 0x87, 0xC9, 0x90, 0xE9, 0xBD, 0x67, 0x43,
+        0xE5, 0x84, 0x98, 0x46, 0x6C, 0xB5, 0xE9, 0x94, 0xA2, 0xB1, 0x4F, 0x33,
+        0xB6, 0x65, 0x8A, 0x74, 0x63, 0x0A, 0xC5, 0x98, 0xCC, 0x5E, 0x4D, 0x7E,
+        0xBC, 0xAD, 0x15, 0x82, 0xC2, 0x97, 0xF1, 0x5F, 0x4E, 0x01, 0xD8, 0xAD,
+        0xFC, 0x18, 0x56, 0xE2, 0x64, 0x40, 0xA9, 0x50, 0x5B, 0x1D, 0x51, 0x55,
+        0xED, 0x29, 0x4C, 0x0B, 0x13, 0x7B, 0xA8, 0x77, 0x11, 0xD2, 0xCA, 0xD0,
+        0xBD, 0x7A, 0x22, 0x42, 0xFA, 0x16, 0xA1, 0x4D, 0xA4, 0x58, 0xFD, 0x95,
+        0x8D, 0xF1, 0x75, 0xB5, 0x18, 0x52, 0xF5, 0x98, 0x0F, 0x3D, 0xDC, 0xB9,
+        0xF6, 0x7A, 0xE3, 0x31, 0x88, 0x5E, 0x84, 0xA1, 0xE6, 0xB3, 0x15, 0xEC,
+        0xB8, 0xFF, 0xA3, 0x2F
+    }
+};
+
+#endif // __FIT_PUBKEY_RAW_H__
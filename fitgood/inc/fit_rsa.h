@@ -14,18 +14,114 @@
 
 /* Required Includes ********************************************************/
 #include "fit_types.h"
+#include "fit.h"
 #include "mem_read.h"
+#include "mbedtls/pk.h"
+#include "fit_mont.h"
+#include "fit_arena.h"
 
 /* Constants ****************************************************************/
 #define RSA_SIG_SIZE            256
+#define FIT_RSA_HASH_SIZE       32
+
+// Identifies rsa public key in raw (pre-parsed) format i.e. fit_rsa_raw_key_t.
+#define FIT_RSA_RAW_KEY_MAGIC   { 'F', 'I', 'R', 'K' }
+
+// Flags of raw public key.
+#define FIT_RSA_RAW_KEY_RR      0x01    // R^2 mod N and -N^-1 are present
+
+// Size of (at most 64 bit) public exponent and of Montgomery constant -N^-1 of raw
+// public key in bytes.
+#define FIT_RSA_RAW_E_SIZE      8
+#define FIT_RSA_RAW_MM_SIZE     8
+
+// Number of limbs of modulus and public exponent kept in rsa key structure once
+// key is loaded (see fit_rsa_key_prepare).
+#define FIT_RSA_N_LIMBS         (RSA_SIG_SIZE / sizeof(mbedtls_mpi_uint))
+#define FIT_RSA_E_LIMBS         (FIT_RSA_RAW_E_SIZE / sizeof(mbedtls_mpi_uint))
 
 /* Types ********************************************************************/
 
+// RSA public key in raw (pre-parsed) format as generated by tools/fit_rawkey. Key
+// is not parsed (no ASN.1 parsing or memory allocation); it contains no pointers
+// and all numbers are big endian byte strings, so it does not depend on limb size
+// and is read through read_byte callback from any kind of memory. Pass it to FIT
+// API as fit_pointer_t with data pointing to this structure and length equal to
+// sizeof(fit_rsa_raw_key_t).
+typedef struct fit_rsa_raw_key {
+    // Should be FIT_RSA_RAW_KEY_MAGIC.
+    uint8_t     m_magic[4];
+    // See FIT_RSA_RAW_KEY_RR.
+    uint8_t     m_flags;
+    uint8_t     m_reserved[3];
+    // Precomputed Montgomery constant -N^-1 mod 2^64 (for 32 bit limbs its low half
+    // is used).
+    uint8_t     m_mm[FIT_RSA_RAW_MM_SIZE];
+    // Public exponent and modulus.
+    uint8_t     m_e[FIT_RSA_RAW_E_SIZE];
+    uint8_t     m_n[RSA_SIG_SIZE];
+    // Precomputed R^2 mod N; R is 2 to the power of bit size of modulus.
+    uint8_t     m_rr[RSA_SIG_SIZE];
+} fit_rsa_raw_key_t;
+
+// RSA public key as passed by caller along with its parsed form. Key is parsed on
+// first use only, so same key can be used to verify any number of licenses. Type
+// name fit_rsa_key_t is declared in fit_types.h.
+struct fit_rsa_key {
+    // RSA public key (PEM or raw format) as passed by caller.
+    fit_pointer_t       m_key;
+    // TRUE once m_pk contains parsed public key.
+    uint8_t             m_parsed;
+    // TRUE if key is loaded into m_nbuf/m_ebuf (raw key, or PEM key detached from
+    // arena); m_pk then refers to m_rsa.
+    uint8_t             m_raw;
+    // TRUE if m_rsa.RN refers to precomputed R^2 mod N in m_rrbuf (never freed).
+    uint8_t             m_raw_rr;
+    // TRUE once m_hash contains Davies Meyer hash of key bytes (see fit_rsa_key_hash).
+    uint8_t             m_hashed;
+    uint8_t             m_hash[FIT_DM_HASH_SIZE];
+    // Parsed rsa public key.
+    mbedtls_pk_context  m_pk;
+    // RSA context for loaded key; modulus and exponent refer to m_nbuf/m_ebuf.
+    mbedtls_rsa_context m_rsa;
+    // Modulus, public exponent and R^2 mod N of loaded key; least significant
+    // limb first.
+    mbedtls_mpi_uint    m_nbuf[FIT_RSA_N_LIMBS];
+    mbedtls_mpi_uint    m_ebuf[FIT_RSA_E_LIMBS];
+    mbedtls_mpi_uint    m_rrbuf[FIT_RSA_N_LIMBS];
+#ifdef FIT_MONT_AVAILABLE
+    // TRUE if public exponent is small and m_mont is set up (see fit_rsa_public).
+    uint8_t             m_small_exp;
+    fit_mont_ctx_t      m_mont;
+#endif
+};
+
+// Prepared key is kept in caller owned fit_rsa_key_handle_t (see fit_types.h); it
+// fails to compile here if FIT_RSA_KEY_SIZE is too small for key structure.
+typedef char fit_rsa_key_size_check_t[(sizeof(fit_rsa_key_t) <= FIT_RSA_KEY_SIZE) ? 1 : -1];
+
+// Gets rsa key structure kept in storage of fit_rsa_key_handle_t.
+#define FIT_RSA_KEY(handle)     ((fit_rsa_key_t *)(void *)(handle))
+
 /* Function Prototypes ******************************************************/
 
 fit_status_t fit_validate_rsa_signature(fit_pointer_t *signature,
                                         uint8_t       *hash,
-                                        fit_pointer_t *key);
+                                        fit_rsa_key_t *rsakey);
+
+void fit_rsa_key_init(fit_rsa_key_t *rsakey, fit_pointer_t *key);
+
+fit_status_t fit_rsa_key_prepare(fit_rsa_key_t *rsakey);
+
+void fit_rsa_key_free(fit_rsa_key_t *rsakey);
+
+fit_status_t fit_rsa_key_hash(fit_rsa_key_t *rsakey, uint8_t *hash);
+
+fit_status_t fit_rsa_parse_key(mbedtls_pk_context *pk, fit_pointer_t *key);
+
+fit_status_t fit_rsa_check_encoding(const uint8_t *em, const uint8_t *hash);
+
+fit_status_t fit_rsa_public(fit_rsa_key_t *rsakey, const uint8_t *input, uint8_t *output);
 
 #endif // __FIT_RSA_H__
 
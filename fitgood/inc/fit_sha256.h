@@ -0,0 +1,57 @@
+/****************************************************************************\
+**
+** fit_sha256.h
+**
+** Contains declaration for constants and functions used in SHA-256 license
+** digest (SHA256_ALGID). Digest is calculated by mbedtls SHA-256, with block
+** compression function replaced (MBEDTLS_SHA256_PROCESS_ALT) by unrolled
+** portable implementation or SHA instructions (x86 SHA-NI, FIT_USE_SHANI).
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifndef __FIT_SHA256_H__
+#define __FIT_SHA256_H__
+
+#ifdef FIT_USE_SHA256_DIGEST
+
+/* Required Includes ********************************************************/
+#include "fit_types.h"
+#include "fit_status.h"
+#include "mbedtls/sha256.h"
+
+/* Constants ****************************************************************/
+
+// Size of SHA-256 digest and block in bytes.
+#define FIT_SHA256_HASH_SIZE            32
+#define FIT_SHA256_BLOCK_SIZE           64
+
+// SHA-NI backend is only compiled for x86 targets; on other targets unrolled
+// portable implementation is used even if FIT_USE_SHANI is defined.
+#if defined(FIT_USE_SHANI) && (defined(__x86_64__) || defined(__i386__) || \
+    defined(_M_X64) || defined(_M_IX86))
+#define FIT_SHANI_AVAILABLE
+#endif
+
+/* Function Prototypes ******************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifdef FIT_SHANI_AVAILABLE
+// This function will return TRUE if processor supports SHA instructions.
+uint8_t fit_shani_supported(void);
+#endif
+
+// This function will calculate SHA-256 digest of (memory mapped) data.
+fit_status_t fit_sha256_digest(fit_pointer_t *msg, uint8_t *hash);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // #ifdef FIT_USE_SHA256_DIGEST
+
+#endif // __FIT_SHA256_H__
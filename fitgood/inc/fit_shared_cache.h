@@ -0,0 +1,100 @@
+/****************************************************************************\
+**
+** fit_shared_cache.h
+**
+** Contains declaration for license validation cache shared by FIT core contexts
+** (FIT_USE_SHARED_CACHE). Result of successful license validation is published
+** as snapshot protected by sequence lock: readers (consume/validate calls on any
+** context attached to shared cache) never take a lock, they only retry the copy
+** if snapshot was being written at the same time. Snapshot is written in place,
+** so there is no old snapshot to reclaim.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifndef __FIT_SHARED_CACHE_H__
+#define __FIT_SHARED_CACHE_H__
+
+#ifdef FIT_USE_SHARED_CACHE
+
+/* Required Includes ********************************************************/
+#include "fit_types.h"
+#include "fit.h"
+
+/* Constants ****************************************************************/
+
+// Number of attempts to read consistent snapshot before reader gives up and does
+// its own license validation.
+#ifndef FIT_SHARED_CACHE_RETRIES
+#define FIT_SHARED_CACHE_RETRIES        16
+#endif
+
+/* Types ********************************************************************/
+
+// Result of successful license validation i.e. data needed to skip rsa signature
+// check of same license validated with same key.
+typedef struct fit_cache_snapshot {
+    // Set if snapshot contains validated license.
+    uint8_t         m_valid;
+#ifdef FIT_USE_TRUSTED_STORAGE
+    // Set if license below was validated at storage generation m_generation.
+    uint8_t         m_trusted;
+    uint16_t        m_length;
+    uint32_t        m_generation;
+    uint8_t         *m_license;
+#endif // #ifdef FIT_USE_TRUSTED_STORAGE
+    // Davies Meyer hash of key bytes used for validation.
+    uint8_t         m_key_hash[FIT_DM_HASH_SIZE];
+    // Davies Meyer hash of validated license.
+    uint8_t         m_dm_hash[FIT_DM_HASH_SIZE];
+#ifdef FIT_USE_SEGMENTED_HASH
+    // Algorithm used for signing the license and root of its hash tree.
+    uint8_t         m_algid;
+    uint8_t         m_root[FIT_MERKLE_HASH_SIZE];
+#endif // #ifdef FIT_USE_SEGMENTED_HASH
+} fit_cache_snapshot_t;
+
+// Snapshot as seen by sequence lock i.e. copied word by word with atomic loads
+// and stores.
+typedef union fit_cache_snapshot_words {
+    fit_cache_snapshot_t    m_snapshot;
+    uint32_t                m_words[(sizeof(fit_cache_snapshot_t) + 3) / 4];
+} fit_cache_snapshot_words_t;
+
+// Shared license validation cache. Initialized by fit_shared_cache_init and then
+// attached to any number of contexts by fit_ctx_set_shared_cache.
+typedef struct fit_shared_cache {
+    // Sequence number; odd while snapshot is being written.
+    uint32_t                    m_seq;
+    // Writer lock; only one context publishes at a time.
+    uint32_t                    m_lock;
+    // Last published snapshot.
+    fit_cache_snapshot_words_t  m_data;
+} fit_shared_cache_t;
+
+/* Function Prototypes ******************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// This function will initialize shared cache with no validated license.
+void fit_shared_cache_init(fit_shared_cache_t *shared);
+
+// This function will copy consistent snapshot out of shared cache without locking.
+uint8_t fit_shared_cache_read(fit_shared_cache_t *shared,
+                              fit_cache_snapshot_t *snapshot,
+                              uint32_t *seq);
+
+// This function will publish new snapshot, unless other context is publishing.
+uint8_t fit_shared_cache_publish(fit_shared_cache_t *shared,
+                                 const fit_cache_snapshot_t *snapshot);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // #ifdef FIT_USE_SHARED_CACHE
+
+#endif // __FIT_SHARED_CACHE_H__
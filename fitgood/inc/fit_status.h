@@ -168,6 +168,30 @@ enum fit_error_codes
     /* RSA Verification failed error */
     FIT_RSA_VERIFY_FAILED,
 
+    /** License verification not yet completed; more steps are required */
+    FIT_VERIFY_IN_PROGRESS,
+
+    /** Crypto job submitted to crypto provider is not yet completed */
+    FIT_CRYPTO_PENDING,
+
+    /** Ed25519 signature verification failed */
+    FIT_ED25519_VERIFY_FAILED,
+
+    /** Sink did not accept all license information; call again to resume */
+    FIT_INFO_SINK_BUSY,
+
+    /** License database file could not be read or written */
+    FIT_LICDB_IO_ERROR,
+
+    /** License database file is corrupt or of other format version */
+    FIT_LICDB_INVALID,
+
+    /** License not found in license database */
+    FIT_LICDB_NOT_FOUND,
+
+    /** License already present in license database */
+    FIT_LICDB_DUPLICATE,
+
 };
 
 /**
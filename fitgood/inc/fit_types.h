@@ -23,6 +23,19 @@
 #define TRUE            1
 #define FALSE           0
 
+// Size in bytes of storage for rsa public key prepared for license validation (see
+// fit_rsa_key_handle_t). Covers 2048 bit key with 32 or 64 bit limbs; it is checked
+// against actual key structure at build time (fit_rsa.h), so it may be defined to
+// bigger value if mbedtls is configured differently (e.g. MBEDTLS_THREADING_C).
+#ifdef FIT_USE_RSA_SMALL_EXP
+#define FIT_RSA_KEY_MONT_SIZE   (256 + 8 * sizeof(void *))
+#else
+#define FIT_RSA_KEY_MONT_SIZE   0
+#endif
+#ifndef FIT_RSA_KEY_SIZE
+#define FIT_RSA_KEY_SIZE        (2 * 256 + 16 + 56 * sizeof(void *) + FIT_RSA_KEY_MONT_SIZE)
+#endif
+
 /* Types ********************************************************************/
 
 // !!! an int normally is 16bits on 8bit machines, so stuff below doesn't 
@@ -49,6 +62,8 @@ typedef unsigned long long int  uint64_t;
 
 typedef uint32_t (*fit_cb_time_get_t)(void);
 
+typedef uint32_t (*fit_cb_generation_get_t)(void);
+
 typedef uint8_t (*fit_read_byte_callback_t)(const void *address);
 
 typedef struct fit_pointer_t
@@ -61,12 +76,31 @@ typedef struct fit_pointer_t
 
 /* Forward Declarations *****************************************************/
 
+// RSA public key prepared for license validation. It is defined in fit_rsa.h and
+// used by FIT core only.
+typedef struct fit_rsa_key fit_rsa_key_t;
+
+// Caller owned storage for rsa public key prepared by fit_licenf_prepare_key. API
+// users handle it as opaque type; it can be allocated statically or on stack
+// without knowing layout of fit_rsa_key_t.
+typedef union fit_rsa_key_handle {
+    uint8_t     m_storage[FIT_RSA_KEY_SIZE];
+    uint64_t    m_align;
+    void        *m_ptr;
+} fit_rsa_key_handle_t;
+
 // Prototype of a get_info callback function.
 typedef fit_status_t (*fit_get_info_callback)(uint8_t tagid,
                                               fit_pointer_t *pdata,
                                               uint16_t length,
                                               void *context);
 
+// Prototype of a sink function receiving encoded license information. Returns number
+// of bytes accepted; accepting less than length stops encoding (backpressure).
+typedef uint16_t (*fit_info_sink_t)(void *context,
+                                    const uint8_t *data,
+                                    uint16_t length);
+
 // Prototype of a get fingerprint/deviceid data callback function.
 typedef fit_status_t (*fit_fp_callback)(uint8_t *rawdata,
                                         uint16_t *datalen);
@@ -0,0 +1,161 @@
+/****************************************************************************\
+**
+** fit_verify.h
+**
+** Contains declaration for structures, constants and functions used in resumable
+** (time sliced) license verification. Verification work is split into steps of
+** bounded size, so it can be interleaved with other work by cooperative schedulers.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifndef __FIT_VERIFY_H__
+#define __FIT_VERIFY_H__
+
+/* Required Includes ********************************************************/
+#include "fit_types.h"
+#include "mem_read.h"
+#include "abreast_dm.h"
+#include "dm_hash.h"
+#include "fit_crypto.h"
+#include "fit_ed25519.h"
+#include "fit_ctx.h"
+
+/* Constants ****************************************************************/
+
+// Default number of operations performed by one call of fit_verify_step when
+// budget passed in is zero. One operation is hashing of one 16 byte block, one
+// modular squaring/multiplication, one bit of Ed25519 double and add pass or one
+// parsing pass over the license. Ed25519 point decoding (start) and encoding
+// (end) of the pass are one operation each, though each costs about as much as
+// 16 bits of the pass.
+#ifndef FIT_VERIFY_STEP_BUDGET
+#define FIT_VERIFY_STEP_BUDGET          8
+#endif
+
+// Size in bytes of storage for rsa public key, operands of rsa public operation and
+// SHA-256 context kept in verification context (fit_verify_rsa_t in fit_verify.c).
+// Their mbedtls types are not exposed to callers; size is checked at build time.
+#ifdef FIT_USE_SHA256_DIGEST
+#define FIT_VERIFY_SHA256_SIZE          112
+#else
+#define FIT_VERIFY_SHA256_SIZE          0
+#endif
+#define FIT_VERIFY_RSA_SIZE             (FIT_RSA_KEY_SIZE + 6 * sizeof(void *) + \
+                                         FIT_VERIFY_SHA256_SIZE)
+
+// States of resumable license verification.
+enum fit_verify_state {
+    /** Verification not started */
+    FIT_VERIFY_STATE_IDLE           = 0,
+    /** Get signature and license part covered by signature */
+    FIT_VERIFY_STATE_LOCATE,
+    /** Calculate Abreast DM hash of license part */
+    FIT_VERIFY_STATE_ABREAST_HASH,
+    /** Parse rsa public key (or start Ed25519 signature verification) */
+    FIT_VERIFY_STATE_KEY,
+    /** Ed25519 double and add pass and comparison of result with R */
+    FIT_VERIFY_STATE_ED25519,
+    /** RSA public operation on signature */
+    FIT_VERIFY_STATE_RSA_EXP,
+    /** Compare result of rsa public operation with PKCS#1 v1.5 encoded hash */
+    FIT_VERIFY_STATE_RSA_CHECK,
+    /** Validate license fields */
+    FIT_VERIFY_STATE_PARSE,
+    /** Calculate Davies Meyer hash of license for license cache */
+    FIT_VERIFY_STATE_DM_HASH,
+    /** Node locking verification */
+    FIT_VERIFY_STATE_NODE_LOCK,
+    /** Verification completed, see m_status for result */
+    FIT_VERIFY_STATE_DONE,
+};
+
+/* Types ********************************************************************/
+
+// Caller owned context for resumable license verification. All state needed to
+// continue verification is kept here, so many verifications can be in progress
+// at the same time.
+typedef struct fit_verify_ctx {
+    // Current state. See enum fit_verify_state
+    uint8_t             m_state;
+    // Set if multiplication is pending for current exponent bit.
+    uint8_t             m_mul;
+    // Current exponent bit of rsa public operation.
+    int16_t             m_bit;
+    // Hashing position i.e. offset of next block to be hashed.
+    uint16_t            m_offset;
+    // Length of license data covered by Davies Meyer hash.
+    uint16_t            m_dmlength;
+#if defined(FIT_USE_ED25519) || defined(FIT_USE_SHA256_DIGEST)
+    // Signature algorithm of license (AES_ALGID, ED25519_ALGID or SHA256_ALGID).
+    uint8_t             m_algid;
+#endif
+    // Result of verification once state is FIT_VERIFY_STATE_DONE.
+    fit_status_t        m_status;
+    // FIT core context whose license validation cache is updated with result.
+    fit_ctx_t          *m_fitctx;
+    // License to be verified.
+    fit_pointer_t       m_license;
+    // License part covered by signature and signature itself.
+    fit_pointer_t       m_licpart;
+    fit_pointer_t       m_signature;
+    // Abreast DM hash (or SHA-256 digest) of license part.
+    uint8_t             m_hash[ABREAST_DM_HASH_SIZE];
+    // Davies Meyer hash of license.
+    uint8_t             m_dmhash[FIT_DM_HASH_SIZE];
+    // RSA public key (parsed in FIT_VERIFY_STATE_KEY), signature and accumulator for
+    // rsa public operation and SHA-256 context for licenses signed over SHA-256
+    // digest. See fit_verify_rsa_t.
+    union {
+        uint8_t         m_storage[FIT_VERIFY_RSA_SIZE];
+        uint64_t        m_align;
+        void            *m_ptr;
+    }                   m_rsa;
+#ifdef FIT_USE_ED25519
+    // State of Ed25519 signature verification.
+    fit_ed25519_ctx_t   m_ed25519;
+#endif
+#ifdef FIT_USE_MBEDTLS_ARENA
+    // TRUE while context holds arena scope entered by fit_verify_start.
+    uint8_t             m_scope;
+#endif
+#ifdef FIT_USE_CRYPTO_PROVIDER
+    // Hash job submitted to crypto provider.
+    fit_crypto_job_t    m_job;
+#else
+    // Streaming hash contexts of license part and license.
+    fit_abreast_dm_ctx_t    m_abreast;
+    fit_dm_hash_ctx_t       m_dm;
+#endif
+} fit_verify_ctx_t;
+
+/* Function Prototypes ******************************************************/
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// This function will initialize the context for resumable license verification.
+fit_status_t fit_verify_start(fit_verify_ctx_t *ctx,
+                              fit_pointer_t *license,
+                              fit_pointer_t *key);
+
+// Same as fit_verify_start; result is written into cache of passed in FIT core context.
+fit_status_t fit_verify_start_ctx(fit_ctx_t *fitctx,
+                                  fit_verify_ctx_t *ctx,
+                                  fit_pointer_t *license,
+                                  fit_pointer_t *key);
+
+// This function will perform next step (at most budget operations) of license
+// verification. Returns FIT_VERIFY_IN_PROGRESS till verification is not completed.
+fit_status_t fit_verify_step(fit_verify_ctx_t *ctx, uint16_t budget);
+
+// This function will release resources of verification context without completing it.
+void fit_verify_abort(fit_verify_ctx_t *ctx);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // __FIT_VERIFY_H__
@@ -66,6 +66,64 @@ EXTERNC uint32_t FIT_TIME_INIT(void);
 
 EXTERNC void FIT_TIMESET (uint32_t settime);
 
+/*
+ * Trusted storage specific defines
+ *
+ * FIT_STORAGE_GENERATION_GET should return generation number of the storage that
+ * keeps the license. Storage backend must increment it on every write to the
+ * license region, so unchanged generation means unchanged license data.
+ */
+#ifdef FIT_USE_TRUSTED_STORAGE
+#define FIT_STORAGE_GENERATION_GET  fit_storage_generation_get
+
+EXTERNC uint32_t FIT_STORAGE_GENERATION_GET(void);
+
+#else
+#define FIT_STORAGE_GENERATION_GET  NULL
+#endif
+
+/*
+ * Atomic operations used by shared license validation cache (FIT_USE_SHARED_CACHE)
+ *
+ * Operate on 32 bit words. Defaults use GCC/Clang builtins; port can define its
+ * own (e.g. for cores without exclusive load/store) before including this file.
+ */
+#ifdef FIT_USE_SHARED_CACHE
+#ifndef FIT_ATOMIC_LOAD
+#if defined(__GNUC__)
+#define FIT_ATOMIC_LOAD(p)          __atomic_load_n((p), __ATOMIC_RELAXED)
+#define FIT_ATOMIC_LOAD_ACQ(p)      __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define FIT_ATOMIC_STORE(p, v)      __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#define FIT_ATOMIC_STORE_REL(p, v)  __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#define FIT_ATOMIC_FENCE_ACQ()      __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define FIT_ATOMIC_FENCE_REL()      __atomic_thread_fence(__ATOMIC_RELEASE)
+// Returns non zero if lock word was free and is now taken.
+#define FIT_ATOMIC_TRYLOCK(p)       (__atomic_exchange_n((p), 1, __ATOMIC_ACQUIRE) == 0)
+#define FIT_ATOMIC_UNLOCK(p)        __atomic_store_n((p), 0, __ATOMIC_RELEASE)
+#else
+#error "FIT_USE_SHARED_CACHE requires FIT_ATOMIC_* definitions for this compiler"
+#endif
+#endif // #ifndef FIT_ATOMIC_LOAD
+#endif // #ifdef FIT_USE_SHARED_CACHE
+
+/*
+ * Access to results of processor feature checks (AES-NI, SHA-NI, MULX/ADX)
+ *
+ * Result is kept in a byte shared by all tasks/threads. Check gives same result
+ * in each of them, so racing first calls only need the byte to be accessed
+ * atomically; no ordering is required.
+ */
+#ifndef FIT_CPU_STATE_LOAD
+#if defined(__GNUC__)
+#define FIT_CPU_STATE_LOAD(p)       __atomic_load_n((p), __ATOMIC_RELAXED)
+#define FIT_CPU_STATE_STORE(p, v)   __atomic_store_n((p), (v), __ATOMIC_RELAXED)
+#elif defined(_MSC_VER)
+// Byte accesses are atomic on x86/x64, the only targets doing these checks.
+#define FIT_CPU_STATE_LOAD(p)       (*(volatile uint8_t *)(p))
+#define FIT_CPU_STATE_STORE(p, v)   (*(volatile uint8_t *)(p) = (v))
+#endif
+#endif // #ifndef FIT_CPU_STATE_LOAD
+
 /* Types ********************************************************************/
 
 /* Function Prototypes ******************************************************/
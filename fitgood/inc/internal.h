@@ -17,6 +17,8 @@
 #include "consume.h"
 #include "get_info.h"
 #include "mem_read.h"
+#include "fit_rsa.h"
+#include "fit_ctx.h"
 
 #ifdef __cplusplus
 #define EXTERNC extern "C"
@@ -41,6 +43,12 @@
 
 // Algorithms used in sentinel fit core.
 #define AES_ALGID          1
+// Segmented (Merkle) hash of license, see fit_merkle.c
+#define MERKLE_ALGID       2
+// Ed25519 signature over Abreast DM hash of license, see fit_ed25519.c
+#define ED25519_ALGID      3
+// RSA signature over SHA-256 digest of license, see fit_sha256.c
+#define SHA256_ALGID       4
 
 // Sentinel fit license schema data types.
 enum wire_type {
@@ -78,13 +86,6 @@ fit_status_t fit_get_data_address(fit_pointer_t *pdata,
 
 /* Types ********************************************************************/
 
-// Global structure for caching RSA validation data. It caches the hash of license
-// string using Davies Meyer hash function.
-typedef struct {
-    uint8_t m_rsa_check_done;
-    uint8_t m_dm_hash[FIT_DM_HASH_SIZE];
-} fit_cache_data;
-
 // Hard coded level and index values for sentinel fit licenses (as per sproto schema)
 #define STRUCT_V2C_LEVEL                0
 #define LICENSE_FIELD                   0
@@ -98,6 +99,7 @@ typedef struct {
 #define STRUCT_SIGNATURE_LEVEL          1
 #define ALGORITHM_ID_FIELD              2
 #define RSA_SIGNATURE_FIELD             3
+#define SEGMENT_HASH_FIELD              4
 
 // Header data at level 2
 #define STRUCT_HEADER_LEVEL             2
@@ -217,11 +219,14 @@ fit_status_t fit_get_device_fpblob(fit_fingerprint_t* fp,
 fit_status_t fit_testgetinfodata(fit_pointer_t *licenseData, uint8_t *pgetinfo,
                                  uint16_t *getinfolen);
 // This function will return the current time in unix.
-fit_status_t fit_getunixtime(uint32_t *unixtime);
+fit_status_t fit_getunixtime(fit_ctx_t *ctx, uint32_t *unixtime);
 // This function is used for validating licensing data
-fit_status_t fit_verify_license(fit_pointer_t *license,
-                                fit_pointer_t *key,
+fit_status_t fit_verify_license(fit_ctx_t *ctx,
+                                fit_pointer_t *license,
+                                fit_rsa_key_t *key,
                                 uint8_t check_cache);
+// This function is used for checking node locking information present in license.
+fit_status_t fit_check_node_lock(fit_pointer_t *license);
 
 void getfingerprintdata(fit_pointer_t *fpdata, fit_fingerprint_t *fpstruct);
 void fit_memcpy(uint8_t *dst, uint8_t *src, uint16_t srclen);
@@ -24,8 +24,17 @@
 /* Constants ****************************************************************/
 #define FIT_READ_BYTE_RAM          fit_read_ram_u8
 
+// Host tools read many licenses out of one buffer or mapping; reads of license
+// are bounded to that license, see fit_read_set_bounds.
+#if defined(FIT_USE_BATCH_VALIDATE) || defined(FIT_USE_LICENSE_DB)
+#define FIT_READ_BYTE_BOUNDED      fit_read_bounded_u8
+#endif
+
 /* Forward Declarations *****************************************************/
 EXTERNC uint8_t  FIT_READ_BYTE_RAM  (const uint8_t *p);
+#ifdef FIT_READ_BYTE_BOUNDED
+EXTERNC uint8_t  FIT_READ_BYTE_BOUNDED  (const uint8_t *p);
+#endif
 
 /* Types ********************************************************************/
 
@@ -75,4 +84,20 @@ uint16_t read_word(const uint8_t* address,
 uint32_t read_dword(const uint8_t* address,
                     fit_read_byte_callback_t clbk_read_byte);
 
+#ifdef FIT_READ_BYTE_BOUNDED
+/**
+ *
+ * fit_read_set_bounds
+ *
+ * Sets data read by FIT_READ_BYTE_BOUNDED (of calling thread if contexts are used
+ * by concurrent threads). Bytes outside of it read as zero.
+ *
+ * @param   start --> Start address of data (e.g. license being parsed).
+ *
+ * @param   length --> Length of data; zero makes every read return zero.
+ *
+ */
+void fit_read_set_bounds(const uint8_t *start, uint32_t length);
+#endif // #ifdef FIT_READ_BYTE_BOUNDED
+
 #endif /* __FIT_MEM_READ_H__ */
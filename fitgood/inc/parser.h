@@ -18,6 +18,8 @@
 #include "fit.h"
 #include "stddef.h"
 #include "mem_read.h"
+#include "fit_rsa.h"
+#include "fit_ctx.h"
 
 /* Constants ****************************************************************/
 
@@ -49,8 +51,17 @@ fit_status_t fit_parse_array(uint8_t level,
                              void *context);
 
 // This function will be used to validate rsa signature value present in license binary
-fit_status_t fit_check_license_validation(fit_pointer_t* license,
-                                          fit_pointer_t* rsakey);
+fit_status_t fit_check_license_validation(fit_ctx_t *ctx,
+                                          fit_pointer_t* license,
+                                          fit_rsa_key_t* rsakey);
+
+// This function will get the algorithm id used for signing the license data.
+fit_status_t fit_get_signature_algid(fit_pointer_t *license, uint8_t *algid);
+
+// This function will get the RSA signature and license data covered by it.
+fit_status_t fit_get_signed_data(fit_pointer_t *license,
+                                 fit_pointer_t *licpart,
+                                 fit_pointer_t *signature);
 
 
 #endif /* __FIT_PARSER_H__ */
@@ -18,6 +18,9 @@
 
 /* Constants ****************************************************************/
 
+// Maximum number of threads of multithreaded tests.
+#define FIT_UNIT_TEST_MAX_THREADS   8
+
 /* Forward Declarations *****************************************************/
 
 /* Types ********************************************************************/
@@ -40,6 +43,32 @@ fit_status_t fit_unit_test_parse_lic_level(fit_pointer_t *licenseData);
 fit_status_t fit_unit_test_wire_protocol(fit_pointer_t *licenseData);
 fit_status_t fit_unit_test_aes_algorithm(void);
 fit_status_t fit_unit_test_dm_algorithm(void);
+#ifdef FIT_USE_SHA256_DIGEST
+fit_status_t fit_unit_test_sha256_algorithm(void);
+#endif
+#ifdef FIT_USE_ED25519
+fit_status_t fit_unit_test_ed25519_algorithm(void);
+#endif
+#if defined(FIT_USE_CRYPTO_PROVIDER) && defined(FIT_USE_CRYPTO_POOL)
+fit_status_t fit_unit_test_crypto_overlap(uint32_t *serial_us, uint32_t *overlap_us);
+#endif
+#ifdef FIT_USE_RSA_SMALL_EXP
+fit_status_t fit_unit_test_mont_bench(uint32_t *mpi_ops, uint32_t *portable_ops, uint32_t *asm_ops);
+#endif
+#ifdef FIT_USE_SHARED_CACHE
+fit_status_t fit_unit_test_shared_cache_bench(fit_pointer_t *license,
+                                              fit_pointer_t *key,
+                                              uint8_t threads,
+                                              uint32_t *locked_rate,
+                                              uint32_t *shared_rate,
+                                              uint32_t *shared_rsa);
+#endif
+#ifdef FIT_USE_BATCH_VALIDATE
+fit_status_t fit_unit_test_batch_bounds(fit_pointer_t *license, fit_pointer_t *key);
+#endif
+#ifdef FIT_USE_LICENSE_DB
+fit_status_t fit_unit_test_licdb_append(fit_pointer_t *license);
+#endif
 
 
 #endif /* __FIT_UNIT_TEST_H__ */
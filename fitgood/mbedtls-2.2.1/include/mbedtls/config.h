@@ -110,6 +110,9 @@
  * Enable this layer to allow use of alternative memory allocators.
  */
 //#define MBEDTLS_PLATFORM_MEMORY
+#if defined(FIT_USE_MBEDTLS_ARENA)
+#define MBEDTLS_PLATFORM_MEMORY
+#endif
 
 /**
  * \def MBEDTLS_PLATFORM_NO_STD_FUNCTIONS
@@ -268,6 +271,9 @@
 //#define MBEDTLS_RIPEMD160_PROCESS_ALT
 //#define MBEDTLS_SHA1_PROCESS_ALT
 //#define MBEDTLS_SHA256_PROCESS_ALT
+#if defined(FIT_USE_SHA256_DIGEST)
+#define MBEDTLS_SHA256_PROCESS_ALT
+#endif
 //#define MBEDTLS_SHA512_PROCESS_ALT
 //#define MBEDTLS_DES_SETKEY_ALT
 //#define MBEDTLS_DES_CRYPT_ECB_ALT
@@ -2457,6 +2463,14 @@
 /* MBEDTLS_PLATFORM_XXX_MACRO and MBEDTLS_PLATFORM_XXX_ALT cannot both be defined */
 //#define MBEDTLS_PLATFORM_CALLOC_MACRO        calloc /**< Default allocator macro to use, can be undefined */
 //#define MBEDTLS_PLATFORM_FREE_MACRO            free /**< Default free macro to use, can be undefined */
+#if defined(FIT_USE_MBEDTLS_ARENA)
+/* Sentinel Fit: all allocations are served from static arena (see fit_arena.h) */
+#include <stddef.h>
+void *fit_arena_calloc( size_t n, size_t size );
+void fit_arena_free( void *ptr );
+#define MBEDTLS_PLATFORM_CALLOC_MACRO   fit_arena_calloc
+#define MBEDTLS_PLATFORM_FREE_MACRO     fit_arena_free
+#endif
 //#define MBEDTLS_PLATFORM_EXIT_MACRO            exit /**< Default exit macro to use, can be undefined */
 //#define MBEDTLS_PLATFORM_FPRINTF_MACRO      fprintf /**< Default fprintf macro to use, can be undefined */
 //#define MBEDTLS_PLATFORM_PRINTF_MACRO        printf /**< Default printf macro to use, can be undefined */
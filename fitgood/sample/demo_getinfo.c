@@ -176,14 +176,6 @@ fit_status_t fit_getlicensedata_cb (uint8_t tagid,
 {
     fit_status_t status             = FIT_STATUS_OK;
     fitv2cdata *v2c               = (fitv2cdata *)context;
-    // cur_prod will be pointer to current product ID.
-    static fitproductdata *cur_prod = NULL;
-    // There can be multiple features per product in V2C. cur_feat will be pointer to
-    // current feature ID.
-    static fitfeaturedata *cur_feat = NULL;
-    // There can be multiple license model define in V2C. cur_prod_part will be pointer to
-    // current license model
-    static fitprodpartdata *cur_prod_part = NULL;
     fit_pointer_t fitptr = {0};
 
     fitptr.read_byte = pdata->read_byte;
@@ -198,12 +190,12 @@ fit_status_t fit_getlicensedata_cb (uint8_t tagid,
     // Get the information based on tag id.
     switch(tagid) {
 
-    // Start of license data. Here we can re-initialized static variables.
+    // Start of license data. Here we can re-initialized parsing position.
     case FIT_LICENSE_TAG_ID:
         DBG(FIT_TRACE_INFO, "FIT_LICENSE_TAG_ID\n");
-        cur_prod = NULL;
-        cur_feat = NULL;
-        cur_prod_part = NULL;
+        v2c->cur_prod = NULL;
+        v2c->cur_feat = NULL;
+        v2c->cur_prod_part = NULL;
         fit_memset(dynamic_memory, 0, DYNAMIC_MEMORY_SIZE);
         break;
 
@@ -348,12 +340,12 @@ fit_status_t fit_getlicensedata_cb (uint8_t tagid,
             status = FIT_STATUS_ERROR;
         else
         {
-            cur_prod = (fitproductdata *)&(v2c->lic.cont->vendor->prod);
+            v2c->cur_prod = (fitproductdata *)&(v2c->lic.cont->vendor->prod);
             // get the product id.
             if (length == PFIELD_SIZE)
-                cur_prod->prodid = read_word(pdata->data, pdata->read_byte)/2 -1;
+                v2c->cur_prod->prodid = read_word(pdata->data, pdata->read_byte)/2 -1;
             else if (length == PARRAY_SIZE)
-                cur_prod->prodid = read_dword(pdata->data, pdata->read_byte);
+                v2c->cur_prod->prodid = read_dword(pdata->data, pdata->read_byte);
             status = FIT_CONTINUE_PARSE;
         }
         break;
@@ -361,14 +353,14 @@ fit_status_t fit_getlicensedata_cb (uint8_t tagid,
     // tag for version regex.
     case FIT_VERSION_REGEX_TAG_ID:
         DBG(FIT_TRACE_INFO, "FIT_VERSION_REGEX_TAG_ID\n");
-        if (v2c->lic.cont == NULL || v2c->lic.cont->vendor == NULL || cur_prod == NULL)
+        if (v2c->lic.cont == NULL || v2c->lic.cont->vendor == NULL || v2c->cur_prod == NULL)
             status = FIT_STATUS_ERROR;
         else
         {
             fitptr.data = pdata->data;
             fitptr.length = FIT_UID_LEN;	
             // to change FIT_UID_LEN
-            fitptr_memcpy((uint8_t *)cur_prod->verregex, &fitptr);
+            fitptr_memcpy((uint8_t *)v2c->cur_prod->verregex, &fitptr);
             status = FIT_CONTINUE_PARSE;
         }
         break;
@@ -380,7 +372,7 @@ fit_status_t fit_getlicensedata_cb (uint8_t tagid,
 
     case FIT_PRODUCT_PART_ID_TAG_ID:
         DBG(FIT_TRACE_INFO, "FIT_PRODUCT_PART_ID_TAG_ID\n");
-        if (cur_prod == NULL)
+        if (v2c->cur_prod == NULL)
             status = FIT_STATUS_ERROR;
         else
         {
@@ -388,7 +380,7 @@ fit_status_t fit_getlicensedata_cb (uint8_t tagid,
             // product part in the license.
             // If not NULL, create a linked list of product part id's (first product 
             // part at head of linked list)
-            fitprodpartdata *prodpart = cur_prod->prodpart;
+            fitprodpartdata *prodpart = v2c->cur_prod->prodpart;
             fitprodpartdata *lastprodpart = NULL;
             if (prodpart == NULL)
             {
@@ -397,7 +389,7 @@ fit_status_t fit_getlicensedata_cb (uint8_t tagid,
                     // Return FIT_INSUFFICIENT_MEMORY if memory was not sufficient
                     return FIT_INSUFFICIENT_MEMORY;
                 else
-                    cur_prod->prodpart = prodpart;
+                    v2c->cur_prod->prodpart = prodpart;
             }
             else
             {
@@ -419,14 +411,14 @@ fit_status_t fit_getlicensedata_cb (uint8_t tagid,
             if (status == FIT_STATUS_OK)
             {
                 prodpart->next = NULL;
-                // cur_prod will contain pointer to current product id in license data.
-                cur_prod_part = prodpart;
+                // v2c->cur_prod will contain pointer to current product id in license data.
+                v2c->cur_prod_part = prodpart;
 
                 // get the product id.
                 if (length == PFIELD_SIZE)
-                    cur_prod_part->partid = read_word(pdata->data, pdata->read_byte)/2 -1;
+                    v2c->cur_prod_part->partid = read_word(pdata->data, pdata->read_byte)/2 -1;
                 else if (length == PARRAY_SIZE)
-                    cur_prod_part->partid = read_dword(pdata->data, pdata->read_byte);
+                    v2c->cur_prod_part->partid = read_dword(pdata->data, pdata->read_byte);
 
                 status = FIT_CONTINUE_PARSE;
             }
@@ -437,15 +429,15 @@ fit_status_t fit_getlicensedata_cb (uint8_t tagid,
     // tag for license properties
     case FIT_LIC_PROP_TAG_ID:
         DBG(FIT_TRACE_INFO, "FIT_LIC_PROP_TAG_ID\n");
-        if (cur_prod_part == NULL)
+        if (v2c->cur_prod_part == NULL)
             status = FIT_STATUS_ERROR;
         else
         {
             // Initialize the license properties members (to avoid garbage values)
-            cur_prod_part->properties.feat = NULL;
-            cur_prod_part->properties.enddate = 0;
-            cur_prod_part->properties.startdate = 0;
-            cur_prod_part->properties.perpetual = 0;
+            v2c->cur_prod_part->properties.feat = NULL;
+            v2c->cur_prod_part->properties.enddate = 0;
+            v2c->cur_prod_part->properties.startdate = 0;
+            v2c->cur_prod_part->properties.perpetual = 0;
 
             status = FIT_CONTINUE_PARSE;
         }
@@ -458,13 +450,13 @@ fit_status_t fit_getlicensedata_cb (uint8_t tagid,
     // tag for feature id.
     case FIT_FEATURE_TAG_ID:
     {
-        if (cur_prod_part == NULL)
+        if (v2c->cur_prod_part == NULL)
             status = FIT_STATUS_ERROR;
         else
         {
             // Get pointer to first feature id in product. If NULL, means this is first feature in the product.
             // If not NULL, create a linked list of features id's (first feature at head of linked list)
-            fitfeaturedata *features = cur_prod_part->properties.feat;
+            fitfeaturedata *features = v2c->cur_prod_part->properties.feat;
             fitfeaturedata *lastfeat = NULL;
             if (features == NULL)
             {
@@ -473,7 +465,7 @@ fit_status_t fit_getlicensedata_cb (uint8_t tagid,
                     // Return FIT_INSUFFICIENT_MEMORY if memory was not sufficient
                     return FIT_INSUFFICIENT_MEMORY;
                 else
-                    cur_prod_part->properties.feat = features;
+                    v2c->cur_prod_part->properties.feat = features;
             }
             else
             {
@@ -492,16 +484,16 @@ fit_status_t fit_getlicensedata_cb (uint8_t tagid,
                     lastfeat->next = features;
             }
 
-            // cur_feat will contain pointer to current feature id in license data.
+            // v2c->cur_feat will contain pointer to current feature id in license data.
             if (status == FIT_STATUS_OK)
             {
                 features->next = NULL;
-                cur_feat = features;
+                v2c->cur_feat = features;
                 // get the feature id.
                 if (length == PFIELD_SIZE)
-                    cur_feat->featid = read_word(pdata->data, pdata->read_byte)/2 - 1;
+                    v2c->cur_feat->featid = read_word(pdata->data, pdata->read_byte)/2 - 1;
                 else if (length == PARRAY_SIZE)
-                    cur_feat->featid = read_dword(pdata->data, pdata->read_byte);
+                    v2c->cur_feat->featid = read_dword(pdata->data, pdata->read_byte);
                 status = FIT_CONTINUE_PARSE;
             }
         }
@@ -510,49 +502,49 @@ fit_status_t fit_getlicensedata_cb (uint8_t tagid,
 
     // tag for perpatual license
     case FIT_PERPETUAL_TAG_ID:
-        if (cur_prod_part == NULL)
+        if (v2c->cur_prod_part == NULL)
             status = FIT_STATUS_ERROR;
         else
         {
             // check whether license is perpetual or not.
-            cur_prod_part->properties.perpetual = pdata->read_byte(pdata->data)/2 - 1;
-            cur_prod_part->lictype = FIT_LIC_PERPETUAL;
+            v2c->cur_prod_part->properties.perpetual = pdata->read_byte(pdata->data)/2 - 1;
+            v2c->cur_prod_part->lictype = FIT_LIC_PERPETUAL;
             status = FIT_CONTINUE_PARSE;
         }
         break;
 
     // tag for start date.
     case FIT_START_DATE_TAG_ID:
-        if (cur_prod_part == NULL)
+        if (v2c->cur_prod_part == NULL)
             status = FIT_STATUS_ERROR;
         else
         {
             // Get the start date value.
-            cur_prod_part->properties.startdate = read_dword(pdata->data, pdata->read_byte);
+            v2c->cur_prod_part->properties.startdate = read_dword(pdata->data, pdata->read_byte);
             status = FIT_CONTINUE_PARSE;
         }
         break;
 
     // tag for end date.
     case FIT_END_DATE_TAG_ID:
-        if (cur_prod_part == NULL)
+        if (v2c->cur_prod_part == NULL)
             status = FIT_STATUS_ERROR;
         else
         {
             // Get the end date value.
-            cur_prod_part->properties.enddate = read_dword(pdata->data, pdata->read_byte);
-            cur_prod_part->lictype = FIT_LIC_EXPIRATION_BASED;
+            v2c->cur_prod_part->properties.enddate = read_dword(pdata->data, pdata->read_byte);
+            v2c->cur_prod_part->lictype = FIT_LIC_EXPIRATION_BASED;
             status = FIT_CONTINUE_PARSE;
         }
         break;
 
     case FIT_DURATION_FROM_FIRST_USE_TAG_ID:
-        if (cur_prod_part == NULL)
+        if (v2c->cur_prod_part == NULL)
             status = FIT_STATUS_ERROR;
         else
         {
             // Get the end date value.
-            cur_prod_part->lictype = FIT_LIC_TIME_BASED;
+            v2c->cur_prod_part->lictype = FIT_LIC_TIME_BASED;
             status = FIT_CONTINUE_PARSE;
         }
         break;
@@ -702,6 +694,69 @@ void printlicensedata (void *context)
     DBG(FIT_TRACE_INFO, "*** End License Data ****************************************************\n");
 }
 
+#ifdef FIT_USE_INFO_TLV
+
+// Get info buffer filled by fit_info_buffer_sink.
+typedef struct fit_info_buffer {
+    uint8_t *m_data;
+    uint16_t m_size;
+    uint16_t m_len;
+} fit_info_buffer_t;
+
+/**
+ *
+ * fit_info_buffer_sink
+ *
+ * Sink function of fit_licenf_get_info_tlv; copies data into get info buffer and
+ * accepts only as much as fits in it.
+ *
+ */
+static uint16_t fit_info_buffer_sink(void *context, const uint8_t *data, uint16_t length)
+{
+    fit_info_buffer_t *buffer = (fit_info_buffer_t *)context;
+
+    if (length > buffer->m_size - buffer->m_len)
+        length = buffer->m_size - buffer->m_len;
+    fit_memcpy(buffer->m_data + buffer->m_len, (uint8_t *)data, length);
+    buffer->m_len += length;
+
+    return length;
+}
+
+/**
+ *
+ * fit_testgetinfodata
+ *
+ * This function will test get license info API. License information (except rsa
+ * signature) is written to passed in buffer in binary TLV format, see
+ * FIT_INFO_TLV_VERSION. Output can be decoded by tools/fit_info_dec.c
+ *
+ */
+fit_status_t fit_testgetinfodata(fit_pointer_t *licenseData, uint8_t *pgetinfo, uint16_t *getinfolen)
+{
+    fit_status_t status         = FIT_STATUS_OK;
+    fit_info_buffer_t buffer    = {0};
+    fit_info_tlv_pos_t pos      = {0};
+
+    if(pgetinfo == NULL || getinfolen == NULL)
+        return FIT_INSUFFICIENT_MEMORY;
+
+    buffer.m_data = pgetinfo;
+    buffer.m_size = *getinfolen;
+    status = fit_licenf_get_info_tlv(licenseData,
+        FIT_ALL_TAGS_MASK & ~FIT_TAG_MASK(FIT_RSA_SIG_TAG_ID),
+        fit_info_buffer_sink, &buffer, &pos);
+    *getinfolen = buffer.m_len;
+
+    // Buffer is full; a sink sending data out would call fit_licenf_get_info_tlv
+    // again with same position once there is room.
+    if (status == FIT_INFO_SINK_BUSY)
+        status = FIT_INSUFFICIENT_MEMORY;
+
+    return status;
+}
+
+#else
 
 uint16_t write_get_info_buffer(uint16_t *current_offset, uint16_t buffer_length,
                                uint8_t *buffer, const char *format, ...)
@@ -872,3 +927,5 @@ fit_status_t fit_testgetinfodata(fit_pointer_t *licenseData, uint8_t *pgetinfo,
     return status;
 }
 
+#endif // #ifdef FIT_USE_INFO_TLV
+
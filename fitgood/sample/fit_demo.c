@@ -20,6 +20,9 @@
 #include "mbedtls/platform.h"
 #include "mbedtls/pk.h"
 #include "fit_pubkey.h"
+#ifdef FIT_USE_RAW_PUBKEY_ONLY
+#include "fit_pubkey_raw.h"
+#endif
 
 /*
  * Below samples of the current license models supported. You should uncomment the one 
@@ -158,8 +161,13 @@ int main(void)
     fitptrlic.length = sizeof(license);
     fitptrlic.read_byte = (fit_read_byte_callback_t) READ_BYTE_RAM;
 
+#ifdef FIT_USE_RAW_PUBKEY_ONLY
+    fitptrkey.data = (uint8_t *) &fit_pubkey_raw;
+    fitptrkey.length = sizeof(fit_rsa_raw_key_t);
+#else
     fitptrkey.data = (uint8_t *) pubkey;
     fitptrkey.length = sizeof(pubkey);
+#endif
     fitptrkey.read_byte = (fit_read_byte_callback_t) READ_BYTE_RAM;
 
     status = fit_licenf_consume_license(&fitptrlic, 1, &context, &fitptrkey);
@@ -185,12 +193,12 @@ int main(void)
      * Test RTC i.e. see if interupt for incrementing unix time is working or not.
      */
     DBG(FIT_TRACE_INFO, "\nTest case: RTC interupt ---------\n");
-    fit_getunixtime(&current_time);
+    fit_getunixtime(fit_ctx_default(), &current_time);
     DBG(FIT_TRACE_INFO, "waiting for RTC increment ... ");
     last_time = current_time;
     while (last_time == current_time) {
         fit_trace_flags = 0;
-        fit_getunixtime(&current_time);
+        fit_getunixtime(fit_ctx_default(), &current_time);
         fit_trace_flags = FIT_TRACE_ALL;
     }
     DBG(FIT_TRACE_INFO, "\nRTC incremented to %u - OK\n", current_time);
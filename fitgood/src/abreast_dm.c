@@ -12,11 +12,10 @@
 
 #include "fit_aes.h"
 #include "fit_debug.h"
+#include "internal.h"
 #include "abreast_dm.h"
 #include "dm_hash.h"
-
-/* Global Data **************************************************************/
-uint8_t aes256key[32] = {0};
+#include "fit_crypto.h"
 
 /* Functions ****************************************************************/
 
@@ -35,55 +34,6 @@ void AES256_AbreastDmHash_Init(uint8_t* hash)
    fit_memset(hash,0xff,32);
 }
 
-/**
- *
- * AES_KM_Load256
- *
- * This function will update the aes key (AES algorithm) used in encryption of
- * license data.
- *
- * @param key --> Pointer to aes key data that need to be updated.
- *
- */
-void AES_KM_Load256(uint8_t *key)
-{
-    fit_memcpy(aes256key, key, 32);
-}
-
-/**
- *
- * AES_ECB_Encrypt
- *
- * This function will encrypt the data passed in based on global aes key.
- *
- * @param in --> Pointer to data that needs to be encrypted.
- * @param blk_num --> block number in case this function is called message greater
- *                    than 16 bytes.
- *
- */
-int AES_ECB_Encrypt(uint8_t *in, uint16_t blk_num)
-{
-    uint8_t skey[240]   = {{0}};
-    uint8_t aes_state[4][4]         = {{0}};
-    fit_status_t status = FIT_STATUS_OK;
-    aes_state_t aes = {0};
-    uint8_t out[16] = {0};
-
-    // Initialize the aes context
-    status = aes_setup(&aes,aes256key, AES_256_KEY_LENGTH, skey);
-    if (status != 0)
-    {
-        DBG(FIT_TRACE_ERROR, "failed to initialize aes setup error =%d\n", status);
-        return status;
-    }
-
-    fit_memset((uint8_t*)aes_state, 0, sizeof(aes_state));
-    aes_encrypt(&aes, in, out, skey, (uint8_t*)aes_state);
-    fit_memcpy(in, out, 16);
-
-    return FIT_STATUS_OK;
-}
-
 /**
  *
  * AES256_AbreastDmHash_Update
@@ -109,10 +59,8 @@ void AES256_AbreastDmHash_Update(uint8_t* pDataIn, uint16_t NbOfBlocks, uint8_t*
       // Gi = Gi-1 XOR AES(Gi-1 || Hi-1Mi)
       fit_memcpy(key,     pHashH, 16); 
       fit_memcpy(key+16,  pMsg,   16);
-      AES_KM_Load256(key);
-
       memcpy(tempbuf, pHashG, 16);
-      AES_ECB_Encrypt(tempbuf, 1);
+      aes_encrypt_key(key, AES_256_KEY_LENGTH, tempbuf, tempbuf);
       for(i=0;i<16;i++)
       {
          pHashG[i] ^= tempbuf[i];
@@ -121,14 +69,12 @@ void AES256_AbreastDmHash_Update(uint8_t* pDataIn, uint16_t NbOfBlocks, uint8_t*
       // Hi = Hi-1 XOR AES(~ Hi-1 || Mi Gi-1) 
       memcpy(key,     pMsg,   16); 
       memcpy(key+16,  pHashG, 16); 
-      AES_KM_Load256(key);
-
       memcpy(tempbuf, pHashH, 16); 
       for(i=0; i<16; i++)
       {
          tempbuf[i] ^= 0xFF;
       }
-      AES_ECB_Encrypt(tempbuf, 1);
+      aes_encrypt_key(key, AES_256_KEY_LENGTH, tempbuf, tempbuf);
       for(i=0;i<16;i++)
       {
          pHashH[i] ^= tempbuf[i];
@@ -161,10 +107,8 @@ void AES256_AbreastDmHash_UpdateBlk(uint8_t* pDataIn, uint8_t* Hash)
    // Gi = Gi-1 XOR AES(Gi-1 || Hi-1Mi)
    memcpy(key,     pHashH, 16); 
    memcpy(key+16,  pMsg,   16); 
-   AES_KM_Load256(key);
-
    memcpy(tempbuf, pHashG, 16);
-   AES_ECB_Encrypt(tempbuf, 1);
+   aes_encrypt_key(key, AES_256_KEY_LENGTH, tempbuf, tempbuf);
    for(i=0;i<16;i++)
    {
       pHashG[i] ^= tempbuf[i];
@@ -173,14 +117,12 @@ void AES256_AbreastDmHash_UpdateBlk(uint8_t* pDataIn, uint8_t* Hash)
    // Hi = Hi-1 XOR AES(~ Hi-1 || Mi Gi-1) 
    memcpy(key,     pMsg,   16); 
    memcpy(key+16,  pHashG, 16); 
-   AES_KM_Load256(key);
-
    memcpy(tempbuf, pHashH, 16); 
    for(i=0; i<16; i++)
    {
       tempbuf[i] ^= 0xFF;
    }
-   AES_ECB_Encrypt(tempbuf, 1);
+   aes_encrypt_key(key, AES_256_KEY_LENGTH, tempbuf, tempbuf);
    for(i=0;i<16;i++)
    {
       pHashH[i] ^= tempbuf[i];
@@ -200,20 +142,19 @@ void AES256_AbreastDmHash_Finalize(uint8_t* Hash)
 {
    uint8_t i;
    uint8_t tempbuf[16] = {0};
-   uint8_t tempkey[32] = {0};
-    
-   memcpy(tempkey, Hash, 32);
-   AES_KM_Load256(tempkey);
+   uint8_t skey[240]   = {0};
+   aes_state_t aes     = {0};
+
+   // Same key (initial hash value) encrypts both halves, so expand it only once.
+   aes_setup(&aes, Hash, AES_256_KEY_LENGTH, skey);
    // Hash[0-15]
-   memcpy(tempbuf, Hash, 16);
-   AES_ECB_Encrypt(tempbuf, 1);
+   aes_encrypt(&aes, Hash, tempbuf, skey, tempbuf);
    for(i =0; i< 16; i++)
    {
       Hash[i] ^= tempbuf[i];
    }
    // Hash[16-32]
-   memcpy(tempbuf, Hash+16, 16);
-   AES_ECB_Encrypt(tempbuf, 1);
+   aes_encrypt(&aes, Hash+16, tempbuf, skey, tempbuf);
    for(i =0; i< 16; i++)
    {
       Hash[i+16] ^= tempbuf[i];
@@ -224,47 +165,113 @@ void AES256_AbreastDmHash_Finalize(uint8_t* Hash)
 
 /**
  *
- * fit_get_AbreastDM_Hash
+ * fit_abreast_dm_start
  *
- * This function will get the abreast dm hash of the data passed in.
+ * This function will initialize context for streaming Abreast DM hash. Data is
+ * then passed by fit_abreast_dm_update (any number of times) and hash is
+ * calculated by fit_abreast_dm_final.
+ *
+ * @param   ctx <-- Pointer to streaming hash context.
  *
+ */
+void fit_abreast_dm_start(fit_abreast_dm_ctx_t *ctx)
+{
+    AES256_AbreastDmHash_Init(ctx->m_hash);
+    ctx->m_buflen = 0;
+    ctx->m_total = 0;
+}
+
+/**
+ *
+ * fit_abreast_dm_update
+ *
+ * This function will update streaming Abreast DM hash with data of any length.
+ * Complete 16 byte blocks are hashed as soon as they are available; rest of data
+ * is kept in context till next update or final.
+ *
+ * @param   ctx <--> Pointer to streaming hash context.
  * @param   msg --> Pointer to data passed in for which hash needs to be calculated.
- * @param   Hash <--> Hash Buffer to hold thye hash value
  *
  */
-fit_status_t fit_get_AbreastDM_Hash(fit_pointer_t *msg, uint8_t * hash)
+void fit_abreast_dm_update(fit_abreast_dm_ctx_t *ctx, fit_pointer_t *msg)
 {
-    uint16_t cntr           = 0;
-    uint8_t tempmsg[32]     = {0};
-    uint16_t msglen         = 0;
     fit_pointer_t fitptr    = {0};
-    // Initialize the read pointer.
-    fitptr.read_byte = msg->read_byte;
+    uint16_t offset         = 0;
 
-    // Initialize hash value;
-    AES256_AbreastDmHash_Init(hash);
+    fitptr.read_byte = msg->read_byte;
+    ctx->m_total += msg->length;
 
-    // Break data in blocks (16 bytes each) and hash the data.
-    for (cntr = 0; cntr < msg->length; cntr+=16)
+    while (offset < msg->length)
     {
-        if ((cntr+16) < msg->length)
-            AES256_AbreastDmHash_UpdateBlk((msg->data)+cntr, hash);
+        // Fill the block buffer as much as possible.
+        fitptr.data = msg->data + offset;
+        fitptr.length = msg->length - offset;
+        if (fitptr.length > (uint16_t)(ABREAST_DM_CIPHER_BLOCK_SIZE - ctx->m_buflen))
+            fitptr.length = ABREAST_DM_CIPHER_BLOCK_SIZE - ctx->m_buflen;
+        fitptr_memcpy(ctx->m_block + ctx->m_buflen, &fitptr);
+        ctx->m_buflen += (uint8_t)fitptr.length;
+        offset += fitptr.length;
+
+        if (ctx->m_buflen == ABREAST_DM_CIPHER_BLOCK_SIZE)
+        {
+            AES256_AbreastDmHash_UpdateBlk(ctx->m_block, ctx->m_hash);
+            ctx->m_buflen = 0;
+        }
     }
-    cntr -= 16;
+}
 
-    fitptr.data = msg->data+cntr;
-    fitptr.length = msg->length-cntr;
-    msglen = fitptr.length;
-    fitptr_memcpy(tempmsg, &fitptr);
-    
+/**
+ *
+ * fit_abreast_dm_final
+ *
+ * This function will pad buffered data (see fit_dm_hash_init), hash it and
+ * perform final update on hash.
+ *
+ * @param   ctx <--> Pointer to streaming hash context.
+ * @param   hash <-- On return it will contain the hash value.
+ *
+ */
+void fit_abreast_dm_final(fit_abreast_dm_ctx_t *ctx, uint8_t *hash)
+{
+    uint8_t tempmsg[32]     = {0};
+    uint16_t msglen         = ctx->m_buflen;
+    uint16_t cntr           = 0;
 
-    fit_dm_hash_init(tempmsg, &msglen, msg->length);
-    for (cntr = 0; cntr < msglen; cntr+=16)
+    fit_memcpy(tempmsg, ctx->m_block, ctx->m_buflen);
+    fit_dm_hash_init(tempmsg, &msglen, ctx->m_total);
+    for (cntr = 0; cntr < msglen; cntr+=ABREAST_DM_CIPHER_BLOCK_SIZE)
     {
-        AES256_AbreastDmHash_UpdateBlk(tempmsg+cntr, hash);
+        AES256_AbreastDmHash_UpdateBlk(tempmsg+cntr, ctx->m_hash);
     }
 
-    AES256_AbreastDmHash_Finalize(hash);
+    AES256_AbreastDmHash_Finalize(ctx->m_hash);
+    fit_memcpy(hash, ctx->m_hash, ABREAST_DM_HASH_SIZE);
+}
+
+/**
+ *
+ * fit_get_AbreastDM_Hash
+ *
+ * This function will get the abreast dm hash of the data passed in.
+ *
+ * @param   msg --> Pointer to data passed in for which hash needs to be calculated.
+ * @param   Hash <--> Hash Buffer to hold thye hash value
+ *
+ */
+fit_status_t fit_get_AbreastDM_Hash(fit_pointer_t *msg, uint8_t * hash)
+{
+#ifdef FIT_USE_CRYPTO_PROVIDER
+    // Hash is calculated by crypto provider (e.g. hash accelerator).
+    return fit_crypto_hash(FIT_CRYPTO_HASH_ABREAST_DM, msg, hash);
+#else
+    fit_abreast_dm_ctx_t ctx;
+
+    // Whole data is passed as one piece; padding of last block and finalization
+    // are done by fit_abreast_dm_final.
+    fit_abreast_dm_start(&ctx);
+    fit_abreast_dm_update(&ctx, msg);
+    fit_abreast_dm_final(&ctx, hash);
 
     return FIT_STATUS_OK;
+#endif // #ifdef FIT_USE_CRYPTO_PROVIDER
 }
@@ -12,9 +12,7 @@
 #include "internal.h"
 #include "hwdep.h"
 #include "fit_debug.h"
-
-
-fit_cb_time_get_t fit_time_get_callback = FIT_TIME_GET;
+#include "fit_merkle.h"
 
 /**
  *
@@ -84,17 +82,18 @@ fit_status_t fit_consume_license(fit_pointer_t *pdata,
  * return the current time in unix. If callback function is NULL or not defined
  * then return "license expiration not supported" error.
  *
+ * @param   ctx --> FIT core context that holds time callback.
  * @param   unixtime <--> Pointer to integer that will contain the current time.
  *
  */
-fit_status_t fit_getunixtime(uint32_t *unixtime)
+fit_status_t fit_getunixtime(fit_ctx_t *ctx, uint32_t *unixtime)
 {
     uint32_t time = 0;
 
-    if (fit_time_get_callback == NULL )
+    if (ctx->m_time_get == NULL )
         return FIT_LIC_EXPIRATION_NOT_SUPP;
 
-    time = fit_time_get_callback();
+    time = ctx->m_time_get();
     *unixtime = time;
 
     return FIT_STATUS_OK;
@@ -176,26 +175,20 @@ fit_status_t fit_get_lic_prop_model(fit_pointer_t *pdata, fitlicensemodel *licmo
 
 /**
  *
- * fit_licenf_consume_license
+ * fit_consume_feature
  *
- * This function is used to grant or deny access to different areas of functionality
- * in the software. This feature is similar to login type operation on licenses. It
- * will look for presence of feature id in the license binary.
+ * This function will look for presence of feature id in the license binary and
+ * check its license model (perpetual, start date, expiration). License should be
+ * already validated by fit_verify_license.
  *
- * @param   license --> Start address of the license in binary format, depending on
- *                      your READ_LICENSE_BYTE definition e.g. in case of RAM, this
- *                      can just be the memory address of the license variable 
+ * @param   ctx --> FIT core context.
+ * @param   license --> Start address of the license of type fit_pointer_t.
  * @param   feature_id --> feature id which will be consumed/used for login operation.
- * @param   state_buffer <--> Pointer to the buffer that contains the current state
- *                            of the license. Not used for perpetual licenses.
- * @param   rsakey --> start address of the rsa public key in binary format, depending on your
- *                     READ_AES_BYTE definition
  *
  */
-fit_status_t fit_licenf_consume_license(fit_pointer_t* license,
-                                        uint16_t feature_id,
-                                        void* state_buffer,
-                                        fit_pointer_t*rsakey )
+static fit_status_t fit_consume_feature(fit_ctx_t *ctx,
+                                        fit_pointer_t* license,
+                                        uint16_t feature_id)
 {
     fit_status_t status             = FIT_STATUS_OK;
     uint32_t startdate              = 0;
@@ -204,23 +197,8 @@ fit_status_t fit_licenf_consume_license(fit_pointer_t* license,
     uint8_t *lic_addr               = NULL;
     fit_pointer_t fitptr            = {0};
 
-    DBG(FIT_TRACE_INFO, "[fit_licenf_consume_license]: feature_id=%d, pdata=0x%p \n",
-        feature_id, license->data);
-
     fitptr.read_byte = license->read_byte;
 
-    // Validate parameters.
-    if (license->read_byte == NULL)
-        return FIT_INVALID_PARAM_1;
-    if (feature_id > MAX_FEATURE_ID_VALUE)
-        return FIT_INVALID_PARAM_2;
-    if (rsakey->read_byte == NULL)
-        return FIT_INVALID_PARAM_4;
-
-    status = fit_verify_license(license, rsakey, TRUE);
-    if (status != FIT_STATUS_OK)
-        return status;
-
     fit_memset((uint8_t *)&context, 0, sizeof(fitcontextdata));
 
     DBG(FIT_TRACE_INFO, "See the presence of feature id ((%d) in license binary \n",feature_id );
@@ -278,7 +256,7 @@ fit_status_t fit_licenf_consume_license(fit_pointer_t* license,
             // check the presence of clock on board. If no clock is set then return error.
             uint32_t curtime = 0;
 
-            status = fit_getunixtime(&curtime);
+            status = fit_getunixtime(ctx, &curtime);
             if (status != FIT_STATUS_OK)
                 return status;
             // TODO hard-coded value, need to sync with real clock server.
@@ -307,7 +285,7 @@ fit_status_t fit_licenf_consume_license(fit_pointer_t* license,
             {
                 uint32_t curtime = 0;
 
-                status = fit_getunixtime(&curtime);
+                status = fit_getunixtime(ctx, &curtime);
                 if (status != FIT_STATUS_OK)
                     return status;
                 if (curtime < startdate)
@@ -340,7 +318,7 @@ fit_status_t fit_licenf_consume_license(fit_pointer_t* license,
             return FIT_INVALID_V2C;
 
         enddate = read_dword(context.mparserdata.m_addr, fitptr.read_byte);
-        status = fit_getunixtime(&curtime);
+        status = fit_getunixtime(ctx, &curtime);
         if (status != FIT_STATUS_OK)
             return status;
         // Current time should be greater than start date (time)
@@ -356,3 +334,93 @@ fit_status_t fit_licenf_consume_license(fit_pointer_t* license,
 
     return FIT_INVALID_LIC_TYPE;
 }
+
+/**
+ *
+ * fit_licenf_consume_license
+ *
+ * This function is used to grant or deny access to different areas of functionality
+ * in the software. This feature is similar to login type operation on licenses. It
+ * will look for presence of feature id in the license binary.
+ *
+ * @param   license --> Start address of the license in binary format, depending on
+ *                      your READ_LICENSE_BYTE definition e.g. in case of RAM, this
+ *                      can just be the memory address of the license variable 
+ * @param   feature_id --> feature id which will be consumed/used for login operation.
+ * @param   state_buffer <--> Pointer to the buffer that contains the current state
+ *                            of the license. Not used for perpetual licenses.
+ * @param   rsakey --> start address of the rsa public key in binary format, depending on your
+ *                     READ_AES_BYTE definition
+ *
+ * Uses default context (see fit_ctx_default).
+ *
+ */
+fit_status_t fit_licenf_consume_license(fit_pointer_t* license,
+                                        uint16_t feature_id,
+                                        void* state_buffer,
+                                        fit_pointer_t*rsakey )
+{
+    return fit_licenf_consume_license_ctx(fit_ctx_default(), license, feature_id,
+        state_buffer, rsakey);
+}
+
+/**
+ *
+ * fit_licenf_consume_license_ctx
+ *
+ * Same as fit_licenf_consume_license; license validation cache, rsa key and time
+ * callback of passed in context are used.
+ *
+ * @param   ctx <--> FIT core context initialized by fit_ctx_init.
+ * @param   license --> Start address of the license in binary format.
+ * @param   feature_id --> feature id which will be consumed/used for login operation.
+ * @param   state_buffer <--> Pointer to the buffer that contains the current state
+ *                            of the license. Not used for perpetual licenses.
+ * @param   rsakey --> start address of the rsa public key in binary format.
+ *
+ */
+fit_status_t fit_licenf_consume_license_ctx(fit_ctx_t *ctx,
+                                            fit_pointer_t* license,
+                                            uint16_t feature_id,
+                                            void* state_buffer,
+                                            fit_pointer_t*rsakey )
+{
+    fit_status_t status             = FIT_STATUS_OK;
+#ifdef FIT_USE_SEGMENTED_HASH
+    fit_pointer_t tracked           = {0};
+#endif
+
+    DBG(FIT_TRACE_INFO, "[fit_licenf_consume_license]: feature_id=%d, pdata=0x%p \n",
+        feature_id, license->data);
+
+    // Validate parameters.
+    if (ctx == NULL)
+        return FIT_INVALID_PARAM;
+    if (license->read_byte == NULL)
+        return FIT_INVALID_PARAM_1;
+    if (feature_id > MAX_FEATURE_ID_VALUE)
+        return FIT_INVALID_PARAM_2;
+    if (rsakey->read_byte == NULL)
+        return FIT_INVALID_PARAM_4;
+
+    status = fit_verify_license(ctx, license, fit_ctx_get_key(ctx, rsakey), TRUE);
+    fit_ctx_release_key(ctx);
+    if (status != FIT_STATUS_OK)
+        return status;
+
+#ifdef FIT_USE_SEGMENTED_HASH
+    // Only hash tree root is verified for segmented licenses; authenticate the license
+    // segments that are read while looking for the feature.
+    if (ctx->m_cache.m_algid == MERKLE_ALGID)
+    {
+        fit_merkle_track_start(&ctx->m_merkle, license, &tracked);
+        status = fit_consume_feature(ctx, &tracked, feature_id);
+        if (fit_merkle_track_verify(&ctx->m_merkle) != FIT_STATUS_OK)
+            status = FIT_INVALID_V2C;
+
+        return status;
+    }
+#endif // #ifdef FIT_USE_SEGMENTED_HASH
+
+    return fit_consume_feature(ctx, license, feature_id);
+}
@@ -12,8 +12,7 @@
 #include "internal.h"
 #include "parser.h"
 #include "fit_aes.h"
-
-#define ROUNDS_KEY_LENGTH       176
+#include "fit_crypto.h"
 
 /**
  *
@@ -73,117 +72,172 @@ void fit_dm_hash_init(uint8_t *pdata, uint16_t *pdatalen, uint16_t msgfulllen)
 
 /**
  *
- * fit_davies_meyer_hash
+ * fit_dm_hash_block
  *
- * This function will be used to get the davies meyer hash of the data passed in.
- * This is performed by first splitting the data (message m) into 128 bits (m1  mn)
- * For each of the 128 bit sub-block, calculate
+ * This function will perform one step of davies meyer hash function i.e. for
+ * 128 bit sub-block (mi) of message calculate
  *      Hi = AES (Hi-1, mi)  XOR Hi-1
- * The final Hash is calculated as:
- *      H = AES (Hn, Hn) XOR Hn
  *
- * @param   pdata --> Pointer to data that needs to be hashed.
- * @param   datalen <--> Length of above data.
- * @param   dmhash <-- On return this will contain the davies mayer hash of data
- *                     passed in.
+ * @param   hash <--> On entry contains Hi-1, on return will contain Hi.
+ * @param   block --> 128 bit sub-block of message (in RAM) used as AES key.
  *
  */
-fit_status_t fit_davies_meyer_hash(fit_pointer_t *pdata, uint8_t *dmhash)
+fit_status_t fit_dm_hash_block(uint8_t *hash, uint8_t *block)
 {
-    fit_status_t  status            = FIT_STATUS_OK;
-    uint8_t skey[ROUNDS_KEY_LENGTH]   = {0};
-    uint8_t aes_state[4][4]         = {{0}};
-    uint16_t cntr                   = 0;
-    uint16_t cntr2                  = 0;
+    fit_status_t status             = FIT_STATUS_OK;
     uint8_t output[16]              = {0};
-    uint8_t prev_hash[16]           = {0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
-                                       0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF};
-    aes_state_t aes = {0};
-    uint8_t tempmsg[32]     = {0};
-    uint16_t msglen         = 0;
+    uint16_t cntr                   = 0;
+
+    // Encrypt data (AES 128); block is the key, so round keys are derived on the fly.
+    status = aes_encrypt_key(block, AES_128_KEY_LENGTH, hash, output);
+    if (status != FIT_STATUS_OK)
+    {
+        DBG(FIT_TRACE_ERROR, "failed to encrypt dm hash block error =%d\n", status);
+        return status;
+    }
+
+    for (cntr = 0; cntr < DM_CIPHER_BLOCK_SIZE; cntr++)
+    {
+        hash[cntr] ^= output[cntr];
+    }
+
+    return status;
+}
+
+/**
+ *
+ * fit_dm_hash_start
+ *
+ * This function will initialize context for streaming davies meyer hash. Data is
+ * then passed by fit_dm_hash_update (any number of times) and hash is calculated
+ * by fit_dm_hash_final.
+ *
+ * @param   ctx <-- Pointer to streaming hash context.
+ *
+ */
+void fit_dm_hash_start(fit_dm_hash_ctx_t *ctx)
+{
+    // Start hash with 0xFF
+    fit_memset(ctx->m_hash, 0xFF, DM_CIPHER_BLOCK_SIZE);
+    ctx->m_buflen = 0;
+    ctx->m_total = 0;
+}
+
+/**
+ *
+ * fit_dm_hash_update
+ *
+ * This function will update streaming davies meyer hash with data of any length.
+ * Complete 128 bit sub-blocks are hashed as soon as they are available; rest of
+ * data is kept in context till next update or final.
+ *
+ * @param   ctx <--> Pointer to streaming hash context.
+ * @param   pdata --> Pointer to data that needs to be hashed.
+ *
+ */
+fit_status_t fit_dm_hash_update(fit_dm_hash_ctx_t *ctx, fit_pointer_t *pdata)
+{
+    fit_status_t status     = FIT_STATUS_OK;
     fit_pointer_t fitptr    = {0};
+    uint16_t offset         = 0;
 
-    // Initialize the read pointer.
     fitptr.read_byte = pdata->read_byte;
+    ctx->m_total += pdata->length;
 
-    // For each of the 128 bit sub-block, calculate
-    //      Hi = AES (Hi-1, mi)  XOR Hi-1
-    for (cntr = 0; cntr < pdata->length; cntr+=16)
+    while (offset < pdata->length)
     {
-        if ((cntr+16) < pdata->length)
+        // Fill the block buffer as much as possible.
+        fitptr.data = pdata->data + offset;
+        fitptr.length = pdata->length - offset;
+        if (fitptr.length > (uint16_t)(DM_CIPHER_BLOCK_SIZE - ctx->m_buflen))
+            fitptr.length = DM_CIPHER_BLOCK_SIZE - ctx->m_buflen;
+        fitptr_memcpy(ctx->m_block + ctx->m_buflen, &fitptr);
+        ctx->m_buflen += (uint8_t)fitptr.length;
+        offset += fitptr.length;
+
+        if (ctx->m_buflen == DM_CIPHER_BLOCK_SIZE)
         {
-            // Initialize the aes context
-            status = aes_setup(&aes, (pdata->data)+cntr, AES_128_KEY_LENGTH, skey);
+            status = fit_dm_hash_block(ctx->m_hash, ctx->m_block);
             if (status != FIT_STATUS_OK)
-            {
-                DBG(FIT_TRACE_ERROR, "failed to initialize aes setup error =%d\n", status);
                 return status;
-            }
-
-            fit_memset((uint8_t*)aes_state, 0, sizeof(aes_state));
-            fit_memset((uint8_t*)output, 0, sizeof(output));
-            // Encrypt data (AES 128)
-            aes_encrypt(&aes, prev_hash, output, skey, (uint8_t*)aes_state);
-            for (cntr2 = 0; cntr2 < 16; cntr2++)
-            {
-                dmhash[cntr2] = output[cntr2] ^ prev_hash[cntr2];
-            }
-            fit_memcpy(prev_hash, dmhash, 16);
+            ctx->m_buflen = 0;
         }
     }
-    cntr -= 16;
-
-    // Pad the last block of data (last block will always be less than 16 bytes)
-    // and calculate Hi = AES (Hi-1, mi)  XOR Hi-1 
-    fitptr.data = pdata->data+cntr;
-    fitptr.length = pdata->length-cntr;
-    msglen = fitptr.length;
-    fitptr_memcpy(tempmsg, &fitptr);
-
-    // Do padding for the last block of data.
-    fit_dm_hash_init(tempmsg, &msglen, pdata->length);
-    // For each of the 128 bit sub-block, calculate
-    //      Hi = AES (Hi-1, mi)  XOR Hi-1
-    for (cntr = 0; cntr < msglen; cntr+=16)
+
+    return status;
+}
+
+/**
+ *
+ * fit_dm_hash_final
+ *
+ * This function will pad buffered data (see fit_dm_hash_init), hash it and then
+ * calculate the final hash as H = AES (Hn, Hn) XOR Hn.
+ *
+ * @param   ctx <--> Pointer to streaming hash context.
+ * @param   dmhash <-- On return this will contain the davies mayer hash of data
+ *                     passed in.
+ *
+ */
+fit_status_t fit_dm_hash_final(fit_dm_hash_ctx_t *ctx, uint8_t *dmhash)
+{
+    fit_status_t  status    = FIT_STATUS_OK;
+    uint8_t tempmsg[32]     = {0};
+    uint16_t msglen         = ctx->m_buflen;
+    uint16_t cntr           = 0;
+
+    fit_memcpy(tempmsg, ctx->m_block, ctx->m_buflen);
+    fit_dm_hash_init(tempmsg, &msglen, ctx->m_total);
+    for (cntr = 0; cntr < msglen; cntr+=DM_CIPHER_BLOCK_SIZE)
     {
-        // Initialize the aes context
-        status = aes_setup(&aes, tempmsg+cntr, AES_128_KEY_LENGTH, skey);
+        status = fit_dm_hash_block(ctx->m_hash, tempmsg+cntr);
         if (status != FIT_STATUS_OK)
-        {
-            DBG(FIT_TRACE_ERROR, "failed to initialize aes setup error =%d\n", status);
             return status;
-        }
-
-        fit_memset((uint8_t*)aes_state, 0, sizeof(aes_state));
-        fit_memset((uint8_t*)output, 0, sizeof(output));
-        // Encrypt data (AES 128)
-        aes_encrypt(&aes, prev_hash, output, skey, (uint8_t*)aes_state);
-        for (cntr2 = 0; cntr2 < 16; cntr2++)
-        {
-            dmhash[cntr2] = output[cntr2] ^ prev_hash[cntr2];
-        }
-        fit_memcpy(prev_hash, dmhash, 16);
     }
 
     // The final Hash is calculated as:
     //      H = AES (Hn, Hn) XOR Hn
-    // Initialize the aes context
-    status = aes_setup(&aes, prev_hash, AES_128_KEY_LENGTH, skey);
-    if (status != FIT_STATUS_OK)
-    {
-        DBG(FIT_TRACE_ERROR, "failed to initialize aes setup error =%d\n", status);
-        return status;
-    }
-
-    fit_memset((uint8_t*)aes_state, 0, sizeof(aes_state));
-    fit_memset((uint8_t*)output, 0, sizeof(output));
-    // Encrypt data (AES 128)
-    aes_encrypt(&aes, prev_hash, output, skey, (uint8_t*)aes_state);
-    for (cntr2 = 0; cntr2 < 16; cntr2++)
-    {
-        dmhash[cntr2] = output[cntr2] ^ prev_hash[cntr2];
-    }
+    fit_memcpy(tempmsg, ctx->m_hash, DM_CIPHER_BLOCK_SIZE);
+    status = fit_dm_hash_block(ctx->m_hash, tempmsg);
+    if (status == FIT_STATUS_OK)
+        fit_memcpy(dmhash, ctx->m_hash, DM_CIPHER_BLOCK_SIZE);
 
     return status;
 }
 
+/**
+ *
+ * fit_davies_meyer_hash
+ *
+ * This function will be used to get the davies meyer hash of the data passed in.
+ * This is performed by first splitting the data (message m) into 128 bits (m1  mn)
+ * For each of the 128 bit sub-block, calculate
+ *      Hi = AES (Hi-1, mi)  XOR Hi-1
+ * The final Hash is calculated as:
+ *      H = AES (Hn, Hn) XOR Hn
+ *
+ * @param   pdata --> Pointer to data that needs to be hashed.
+ * @param   datalen <--> Length of above data.
+ * @param   dmhash <-- On return this will contain the davies mayer hash of data
+ *                     passed in.
+ *
+ */
+fit_status_t fit_davies_meyer_hash(fit_pointer_t *pdata, uint8_t *dmhash)
+{
+#ifdef FIT_USE_CRYPTO_PROVIDER
+    // Hash is calculated by crypto provider (e.g. hash accelerator).
+    return fit_crypto_hash(FIT_CRYPTO_HASH_DM, pdata, dmhash);
+#else
+    fit_status_t  status    = FIT_STATUS_OK;
+    fit_dm_hash_ctx_t ctx;
+
+    // Whole data is passed as one piece; padding of last block and final hash
+    // are done by fit_dm_hash_final.
+    fit_dm_hash_start(&ctx);
+    status = fit_dm_hash_update(&ctx, pdata);
+    if (status != FIT_STATUS_OK)
+        return status;
+
+    return fit_dm_hash_final(&ctx, dmhash);
+#endif // #ifdef FIT_USE_CRYPTO_PROVIDER
+}
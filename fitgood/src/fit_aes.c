@@ -2,13 +2,17 @@
 **
 ** aes.c
 **
-** Defines functionality for implementation for AES algorithm
+** Defines functionality for implementation for AES algorithm. By default
+** byte oriented (small footprint) cipher is used; if FIT_USE_AES_TTABLE is
+** defined, rounds are computed on 32 bit columns using 1 KB lookup table.
+** Host builds defining FIT_USE_AESNI use AES instructions when available.
 ** 
 ** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
 **
 \****************************************************************************/
 
 #include "fit_aes.h"
+#include "fit_aesni.h"
 
 static const uint8_t sbox[256] = {
     0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
@@ -46,6 +50,44 @@ static const uint8_t Rcon[255] = {
     0xc6, 0x97, 0x35, 0x6a, 0xd4, 0xb3, 0x7d, 0xfa, 0xef, 0xc5, 0x91, 0x39, 0x72, 0xe4, 0xd3, 0xbd, 
     0x61, 0xc2, 0x9f, 0x25, 0x4a, 0x94, 0x33, 0x66, 0xcc, 0x83, 0x1d, 0x3a, 0x74, 0xe8, 0xcb  };
 
+#ifdef FIT_USE_AES_TTABLE
+// Round table combining SubBytes and MixColumns for one state byte: column
+// {02,01,01,03}*sbox[x], big endian. Tables for other rows are its byte rotations.
+static const uint32_t Te0[256] = {
+    0xc66363a5, 0xf87c7c84, 0xee777799, 0xf67b7b8d, 0xfff2f20d, 0xd66b6bbd, 0xde6f6fb1, 0x91c5c554,
+    0x60303050, 0x02010103, 0xce6767a9, 0x562b2b7d, 0xe7fefe19, 0xb5d7d762, 0x4dababe6, 0xec76769a,
+    0x8fcaca45, 0x1f82829d, 0x89c9c940, 0xfa7d7d87, 0xeffafa15, 0xb25959eb, 0x8e4747c9, 0xfbf0f00b,
+    0x41adadec, 0xb3d4d467, 0x5fa2a2fd, 0x45afafea, 0x239c9cbf, 0x53a4a4f7, 0xe4727296, 0x9bc0c05b,
+    0x75b7b7c2, 0xe1fdfd1c, 0x3d9393ae, 0x4c26266a, 0x6c36365a, 0x7e3f3f41, 0xf5f7f702, 0x83cccc4f,
+    0x6834345c, 0x51a5a5f4, 0xd1e5e534, 0xf9f1f108, 0xe2717193, 0xabd8d873, 0x62313153, 0x2a15153f,
+    0x0804040c, 0x95c7c752, 0x46232365, 0x9dc3c35e, 0x30181828, 0x379696a1, 0x0a05050f, 0x2f9a9ab5,
+    0x0e070709, 0x24121236, 0x1b80809b, 0xdfe2e23d, 0xcdebeb26, 0x4e272769, 0x7fb2b2cd, 0xea75759f,
+    0x1209091b, 0x1d83839e, 0x582c2c74, 0x341a1a2e, 0x361b1b2d, 0xdc6e6eb2, 0xb45a5aee, 0x5ba0a0fb,
+    0xa45252f6, 0x763b3b4d, 0xb7d6d661, 0x7db3b3ce, 0x5229297b, 0xdde3e33e, 0x5e2f2f71, 0x13848497,
+    0xa65353f5, 0xb9d1d168, 0x00000000, 0xc1eded2c, 0x40202060, 0xe3fcfc1f, 0x79b1b1c8, 0xb65b5bed,
+    0xd46a6abe, 0x8dcbcb46, 0x67bebed9, 0x7239394b, 0x944a4ade, 0x984c4cd4, 0xb05858e8, 0x85cfcf4a,
+    0xbbd0d06b, 0xc5efef2a, 0x4faaaae5, 0xedfbfb16, 0x864343c5, 0x9a4d4dd7, 0x66333355, 0x11858594,
+    0x8a4545cf, 0xe9f9f910, 0x04020206, 0xfe7f7f81, 0xa05050f0, 0x783c3c44, 0x259f9fba, 0x4ba8a8e3,
+    0xa25151f3, 0x5da3a3fe, 0x804040c0, 0x058f8f8a, 0x3f9292ad, 0x219d9dbc, 0x70383848, 0xf1f5f504,
+    0x63bcbcdf, 0x77b6b6c1, 0xafdada75, 0x42212163, 0x20101030, 0xe5ffff1a, 0xfdf3f30e, 0xbfd2d26d,
+    0x81cdcd4c, 0x180c0c14, 0x26131335, 0xc3ecec2f, 0xbe5f5fe1, 0x359797a2, 0x884444cc, 0x2e171739,
+    0x93c4c457, 0x55a7a7f2, 0xfc7e7e82, 0x7a3d3d47, 0xc86464ac, 0xba5d5de7, 0x3219192b, 0xe6737395,
+    0xc06060a0, 0x19818198, 0x9e4f4fd1, 0xa3dcdc7f, 0x44222266, 0x542a2a7e, 0x3b9090ab, 0x0b888883,
+    0x8c4646ca, 0xc7eeee29, 0x6bb8b8d3, 0x2814143c, 0xa7dede79, 0xbc5e5ee2, 0x160b0b1d, 0xaddbdb76,
+    0xdbe0e03b, 0x64323256, 0x743a3a4e, 0x140a0a1e, 0x924949db, 0x0c06060a, 0x4824246c, 0xb85c5ce4,
+    0x9fc2c25d, 0xbdd3d36e, 0x43acacef, 0xc46262a6, 0x399191a8, 0x319595a4, 0xd3e4e437, 0xf279798b,
+    0xd5e7e732, 0x8bc8c843, 0x6e373759, 0xda6d6db7, 0x018d8d8c, 0xb1d5d564, 0x9c4e4ed2, 0x49a9a9e0,
+    0xd86c6cb4, 0xac5656fa, 0xf3f4f407, 0xcfeaea25, 0xca6565af, 0xf47a7a8e, 0x47aeaee9, 0x10080818,
+    0x6fbabad5, 0xf0787888, 0x4a25256f, 0x5c2e2e72, 0x381c1c24, 0x57a6a6f1, 0x73b4b4c7, 0x97c6c651,
+    0xcbe8e823, 0xa1dddd7c, 0xe874749c, 0x3e1f1f21, 0x964b4bdd, 0x61bdbddc, 0x0d8b8b86, 0x0f8a8a85,
+    0xe0707090, 0x7c3e3e42, 0x71b5b5c4, 0xcc6666aa, 0x904848d8, 0x06030305, 0xf7f6f601, 0x1c0e0e12,
+    0xc26161a3, 0x6a35355f, 0xae5757f9, 0x69b9b9d0, 0x17868691, 0x99c1c158, 0x3a1d1d27, 0x279e9eb9,
+    0xd9e1e138, 0xebf8f813, 0x2b9898b3, 0x22111133, 0xd26969bb, 0xa9d9d970, 0x078e8e89, 0x339494a7,
+    0x2d9b9bb6, 0x3c1e1e22, 0x15878792, 0xc9e9e920, 0x87cece49, 0xaa5555ff, 0x50282878, 0xa5dfdf7a,
+    0x038c8c8f, 0x59a1a1f8, 0x09898980, 0x1a0d0d17, 0x65bfbfda, 0xd7e6e631, 0x844242c6, 0xd06868b8,
+    0x824141c3, 0x299999b0, 0x5a2d2d77, 0x1e0f0f11, 0x7bb0b0cb, 0xa85454fc, 0x6dbbbbd6, 0x2c16163a };
+#endif // #ifdef FIT_USE_AES_TTABLE
+
 
 static uint8_t get_sbox_value(uint8_t num)
 {
@@ -90,6 +132,15 @@ fit_status_t aes_setup(aes_state_t* aes, const uint8_t *key, uint16_t keylen, ui
         aes->keylen = AES_256_KEY_LENGTH;
     }
 
+#ifdef FIT_AESNI_AVAILABLE
+    // Use AES instructions if supported by processor.
+    if (fit_aesni_supported())
+    {
+        fit_aesni_setup(aes, key, skey);
+        return FIT_STATUS_OK;
+    }
+#endif
+
     // The first round key is the key itself.
     for(i = 0; i < aes->Nk; ++i)
     {
@@ -256,6 +307,108 @@ void mix_columns(uint8_t *state)
     }
 }
 
+#define AES_ROTL8(x)        (((x) << 8) | ((x) >> 24))
+#define AES_ROTR8(x)        (((x) >> 8) | ((x) << 24))
+#define AES_ROTR16(x)       (((x) >> 16) | ((x) << 16))
+#define AES_GET_WORD(p)     (((uint32_t)(p)[0] << 24) | ((uint32_t)(p)[1] << 16) | \
+                             ((uint32_t)(p)[2] << 8) | (uint32_t)(p)[3])
+#define AES_PUT_WORD(p, x)  { (p)[0] = (uint8_t)((x) >> 24); (p)[1] = (uint8_t)((x) >> 16); \
+                              (p)[2] = (uint8_t)((x) >> 8); (p)[3] = (uint8_t)(x); }
+
+// SubBytes and ShiftRows for output column; a, b, c, d are input columns.
+#define AES_SUBSHIFT(a, b, c, d) \
+    ((((uint32_t)sbox[(a) >> 24]) << 24) ^ (((uint32_t)sbox[((b) >> 16) & 0xff]) << 16) ^ \
+     (((uint32_t)sbox[((c) >> 8) & 0xff]) << 8) ^ ((uint32_t)sbox[(d) & 0xff]))
+
+#ifdef FIT_USE_AES_TTABLE
+
+// SubBytes, ShiftRows and MixColumns for output column by table lookups.
+#define AES_FULLROUND(a, b, c, d) \
+    (Te0[(a) >> 24] ^ AES_ROTR8(Te0[((b) >> 16) & 0xff]) ^ \
+     AES_ROTR16(Te0[((c) >> 8) & 0xff]) ^ AES_ROTL8(Te0[(d) & 0xff]))
+
+#else
+
+// xtime applied to all four bytes of a column.
+#define AES_XTIME_WORD(x)   ((((x) & 0x7f7f7f7f) << 1) ^ ((((x) >> 7) & 0x01010101) * 0x1b))
+
+// MixColumns for one column i.e. b[i] = 2*a[i] ^ 3*a[i+1] ^ a[i+2] ^ a[i+3].
+static uint32_t mix_column_word(uint32_t x)
+{
+    uint32_t r = AES_ROTL8(x);
+
+    return AES_XTIME_WORD(x ^ r) ^ r ^ AES_ROTR16(x) ^ AES_ROTR8(x);
+}
+
+#define AES_FULLROUND(a, b, c, d)   mix_column_word(AES_SUBSHIFT(a, b, c, d))
+
+#endif // #ifdef FIT_USE_AES_TTABLE
+
+// One full round on state columns with round key rk.
+static void round_word(uint32_t *s, const uint32_t *rk)
+{
+    uint32_t t0 = AES_FULLROUND(s[0], s[1], s[2], s[3]) ^ rk[0];
+    uint32_t t1 = AES_FULLROUND(s[1], s[2], s[3], s[0]) ^ rk[1];
+    uint32_t t2 = AES_FULLROUND(s[2], s[3], s[0], s[1]) ^ rk[2];
+    uint32_t t3 = AES_FULLROUND(s[3], s[0], s[1], s[2]) ^ rk[3];
+
+    s[0] = t0; s[1] = t1; s[2] = t2; s[3] = t3;
+}
+
+// Last round (no MixColumns) on state columns with round key rk.
+static void last_round_word(uint32_t *s, const uint32_t *rk)
+{
+    uint32_t t0 = AES_SUBSHIFT(s[0], s[1], s[2], s[3]) ^ rk[0];
+    uint32_t t1 = AES_SUBSHIFT(s[1], s[2], s[3], s[0]) ^ rk[1];
+    uint32_t t2 = AES_SUBSHIFT(s[2], s[3], s[0], s[1]) ^ rk[2];
+    uint32_t t3 = AES_SUBSHIFT(s[3], s[0], s[1], s[2]) ^ rk[3];
+
+    s[0] = t0; s[1] = t1; s[2] = t2; s[3] = t3;
+}
+
+#ifdef FIT_USE_AES_TTABLE
+
+/**
+ *
+ * encrypt
+ *
+ * Table based cipher. State columns are kept as 32 bit words and each round is
+ * computed by four table lookups per column. Round keys are read from expanded
+ * key in same (byte) layout as written by aes_setup.
+ *
+ * @param   aes --> Pointer to structure containing aes state.
+ * @param   key --> Expanded key (see aes_setup).
+ * @param   state <--> Data to be encrypted; on return it will contain encrypted data.
+ *
+ */
+static void encrypt(aes_state_t* aes, const uint8_t* key, uint8_t *state)
+{
+    uint32_t s[4]   = {0};
+    uint32_t rk[4]  = {0};
+    uint16_t round  = 0;
+    uint8_t i       = 0;
+
+    for (i = 0; i < Nb; ++i)
+        s[i] = AES_GET_WORD(state + 4*i) ^ AES_GET_WORD(key + 4*i);
+
+    for (round = 1; round <= aes->Nr; ++round)
+    {
+        key += Nb * 4;
+        for (i = 0; i < Nb; ++i)
+            rk[i] = AES_GET_WORD(key + 4*i);
+
+        if (round < aes->Nr)
+            round_word(s, rk);
+        else
+            last_round_word(s, rk);
+    }
+
+    for (i = 0; i < Nb; ++i)
+        AES_PUT_WORD(state + 4*i, s[i]);
+}
+
+#else
+
 // Cipher is the main function that encrypts the PlainText.
 static void encrypt(aes_state_t* aes, const uint8_t* key, uint8_t *state)
 {
@@ -282,6 +435,8 @@ static void encrypt(aes_state_t* aes, const uint8_t* key, uint8_t *state)
     add_round_key(state, key, aes->Nr);
 }
 
+#endif // #ifdef FIT_USE_AES_TTABLE
+
 void block_copy(uint8_t* output, uint8_t* input)
 {
     uint8_t i = 0;
@@ -310,6 +465,15 @@ void aes_encrypt(aes_state_t* aes,
                  const uint8_t* key,
                  uint8_t *state)
 {
+#ifdef FIT_AESNI_AVAILABLE
+    // Use AES instructions if supported by processor.
+    if (fit_aesni_supported())
+    {
+        fit_aesni_encrypt(aes, input, output, key);
+        return;
+    }
+#endif
+
     // Copy input to output, and work in-memory on output
     block_copy(output, input);
     state = (uint8_t*)output;
@@ -318,3 +482,117 @@ void aes_encrypt(aes_state_t* aes,
     encrypt(aes, key, state);
 }
 
+
+// SubWord i.e. S-box applied to each byte of key word.
+static uint32_t sub_word(uint32_t x)
+{
+    return AES_SUBSHIFT(x, x, x, x);
+}
+
+/**
+ *
+ * next_round_key
+ *
+ * This function derives round key for the round passed in from the previous
+ * round keys kept in w (last Nk words of expanded key). Rounds must be processed
+ * in order starting with round 1.
+ *
+ * @param   w <--> Last Nk words of expanded key; updated in place.
+ * @param   nk --> Number of 32 bit words in key.
+ * @param   round --> Round number.
+ *
+ */
+static const uint32_t *next_round_key(uint32_t *w, uint16_t nk, uint16_t round)
+{
+    uint32_t *rk    = w;
+    uint32_t temp   = 0;
+
+    if (nk == 8)
+    {
+        // AES-256: w holds two round keys, which are updated alternately.
+        rk = w + 4*(round & 1);
+        if (round < 2)
+            return rk;
+        if (round & 1)
+            temp = sub_word(w[3]);
+        else
+            temp = sub_word(AES_ROTL8(w[7])) ^ ((uint32_t)Rcon[round/2] << 24);
+    }
+    else
+    {
+        temp = sub_word(AES_ROTL8(w[3])) ^ ((uint32_t)Rcon[round] << 24);
+    }
+
+    rk[0] ^= temp;
+    rk[1] ^= rk[0];
+    rk[2] ^= rk[1];
+    rk[3] ^= rk[2];
+
+    return rk;
+}
+
+/**
+ *
+ * aes_encrypt_key
+ *
+ * Encrypts one block with the key passed in. Round keys are derived while the
+ * block is being encrypted, so no expanded key is stored. Should be used when
+ * the key changes for every block (e.g. Davies Meyer hashes); when the same key
+ * encrypts more blocks use aes_setup and aes_encrypt.
+ *
+ * @param   key --> Encryption key used in AES.
+ * @param   keylen --> key length (AES_128_KEY_LENGTH or AES_256_KEY_LENGTH).
+ * @param   input --> Plain data i.e. data to be encrypted.
+ * @param   output <-- Encrypted data. Can be same as input.
+ *
+ */
+fit_status_t aes_encrypt_key(const uint8_t *key,
+                             uint16_t keylen,
+                             const uint8_t *input,
+                             uint8_t *output)
+{
+    uint32_t w[8]   = {0};
+    uint32_t s[4]   = {0};
+    uint16_t nk     = 0;
+    uint16_t round  = 0;
+    uint16_t i      = 0;
+
+    if (!(keylen == AES_128_KEY_LENGTH || keylen == AES_256_KEY_LENGTH))
+    {
+        DBG(FIT_TRACE_ERROR, "aes_encrypt_key - Invalid Keysize %d", keylen);
+        return FIT_INVALID_KEYSIZE;
+    }
+
+#ifdef FIT_AESNI_AVAILABLE
+    // Key expansion by AES instructions is cheaper than on the fly derivation.
+    if (fit_aesni_supported())
+    {
+        aes_state_t aes     = {0};
+        uint8_t skey[240]   = {0};
+
+        aes_setup(&aes, key, keylen, skey);
+        fit_aesni_encrypt(&aes, input, output, skey);
+        return FIT_STATUS_OK;
+    }
+#endif
+
+    nk = keylen/4;
+    for (i = 0; i < nk; ++i)
+        w[i] = AES_GET_WORD(key + 4*i);
+    for (i = 0; i < Nb; ++i)
+        s[i] = AES_GET_WORD(input + 4*i) ^ w[i];
+
+    // Nr = Nk + 6 rounds; last one without MixColumns.
+    for (round = 1; round <= nk + 6; ++round)
+    {
+        if (round < nk + 6)
+            round_word(s, next_round_key(w, nk, round));
+        else
+            last_round_word(s, next_round_key(w, nk, round));
+    }
+
+    for (i = 0; i < Nb; ++i)
+        AES_PUT_WORD(output + 4*i, s[i]);
+
+    return FIT_STATUS_OK;
+}
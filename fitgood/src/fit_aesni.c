@@ -0,0 +1,298 @@
+/****************************************************************************\
+**
+** fit_aesni.c
+**
+** Defines functionality for AES-NI based implementation of AES algorithm. Round
+** keys are stored in same byte layout as produced by aes_setup, so expanded keys
+** and results are identical to portable implementation.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+/* Required Includes ********************************************************/
+#include "fit_aesni.h"
+
+#ifdef FIT_AESNI_AVAILABLE
+
+#include "hwdep.h"
+#include <wmmintrin.h>
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+/* Constants ****************************************************************/
+
+// AES instructions are enabled per function, so rest of the library does not
+// require target specific compiler options.
+#if defined(__GNUC__) || defined(__clang__)
+#define FIT_AESNI_TARGET            __attribute__((target("aes,sse2")))
+#define FIT_AESNI_INLINE            __attribute__((always_inline)) inline
+#define FIT_AESNI_UNROLL            _Pragma("GCC unroll 8")
+#else
+#define FIT_AESNI_TARGET
+#define FIT_AESNI_INLINE            __forceinline
+#define FIT_AESNI_UNROLL
+#endif
+
+// CPUID.01H:ECX bit indicating support of AES instructions.
+#define FIT_CPUID_AES_BIT           (1UL << 25)
+
+/* Global Data **************************************************************/
+
+// Result of processor feature check; 0xFF till not checked.
+static uint8_t fit_aesni_state = 0xFF;
+
+/* Functions ****************************************************************/
+
+/**
+ *
+ * fit_aesni_supported
+ *
+ * This function will check (once) whether processor supports AES instructions.
+ *
+ */
+uint8_t fit_aesni_supported(void)
+{
+    uint8_t state   = FIT_CPU_STATE_LOAD(&fit_aesni_state);
+    uint32_t ecx    = 0;
+
+    if (state == 0xFF)
+    {
+#if defined(_MSC_VER)
+        int regs[4] = {0};
+
+        __cpuid(regs, 1);
+        ecx = (uint32_t)regs[2];
+#else
+        unsigned int a = 0, b = 0, c = 0, d = 0;
+
+        if (__get_cpuid(1, &a, &b, &c, &d))
+            ecx = c;
+#endif
+        state = (ecx & FIT_CPUID_AES_BIT) ? TRUE : FALSE;
+        FIT_CPU_STATE_STORE(&fit_aesni_state, state);
+    }
+
+    return state;
+}
+
+// Combine previous round key with word of AESKEYGENASSIST output (broadcast to
+// all words) i.e. w[i] = w[i-Nk] ^ temp for all four words of round key.
+FIT_AESNI_TARGET
+static __m128i fit_aesni_expand(__m128i key, __m128i temp)
+{
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+    key = _mm_xor_si128(key, _mm_slli_si128(key, 4));
+
+    return _mm_xor_si128(key, temp);
+}
+
+// Round constant of AESKEYGENASSIST must be immediate value.
+#define AESNI_EXPAND128(k, rcon) \
+    fit_aesni_expand((k), _mm_shuffle_epi32(_mm_aeskeygenassist_si128((k), (rcon)), 0xff))
+#define AESNI_EXPAND256_A(k1, k2, rcon) \
+    fit_aesni_expand((k1), _mm_shuffle_epi32(_mm_aeskeygenassist_si128((k2), (rcon)), 0xff))
+#define AESNI_EXPAND256_B(k1, k2) \
+    fit_aesni_expand((k2), _mm_shuffle_epi32(_mm_aeskeygenassist_si128((k1), 0x00), 0xaa))
+
+// Same expansion for lanes. AESKEYGENASSIST can not be pipelined on many processors,
+// so SubWord of last word is done by AESENCLAST on that word copied to all columns
+// (ShiftRows then has no effect), and RotWord by shifts.
+#define AESNI_SUBWORD(k) \
+    _mm_aesenclast_si128(_mm_shuffle_epi32((k), 0xff), _mm_setzero_si128())
+#define AESNI_ROTWORD(t) \
+    _mm_or_si128(_mm_srli_epi32((t), 8), _mm_slli_epi32((t), 24))
+#define AESNI_LANE_EXPAND_A(k1, k2, rcon) \
+    fit_aesni_expand((k1), _mm_xor_si128(AESNI_ROTWORD(AESNI_SUBWORD(k2)), _mm_set1_epi32(rcon)))
+#define AESNI_LANE_EXPAND_B(k1, k2) \
+    fit_aesni_expand((k2), AESNI_SUBWORD(k1))
+
+/**
+ *
+ * fit_aesni_setup
+ *
+ * This function produces Nb(Nr+1) round keys using AES instructions. Key length
+ * should already be validated and aes state updated by aes_setup.
+ *
+ * @param   aes --> Pointer to structure containing aes state.
+ * @param   key --> AES encryption key.
+ * @param   skey <-- On return it will contains the Nb(Nr+1) round keys
+ *
+ */
+FIT_AESNI_TARGET
+void fit_aesni_setup(aes_state_t* aes, const uint8_t *key, uint8_t *skey)
+{
+    __m128i *rk = (__m128i *)skey;
+    __m128i k1  = _mm_loadu_si128((const __m128i *)key);
+    __m128i k2;
+
+    _mm_storeu_si128(rk, k1);
+    if (aes->keylen == AES_128_KEY_LENGTH)
+    {
+        k1 = AESNI_EXPAND128(k1, 0x01); _mm_storeu_si128(rk + 1, k1);
+        k1 = AESNI_EXPAND128(k1, 0x02); _mm_storeu_si128(rk + 2, k1);
+        k1 = AESNI_EXPAND128(k1, 0x04); _mm_storeu_si128(rk + 3, k1);
+        k1 = AESNI_EXPAND128(k1, 0x08); _mm_storeu_si128(rk + 4, k1);
+        k1 = AESNI_EXPAND128(k1, 0x10); _mm_storeu_si128(rk + 5, k1);
+        k1 = AESNI_EXPAND128(k1, 0x20); _mm_storeu_si128(rk + 6, k1);
+        k1 = AESNI_EXPAND128(k1, 0x40); _mm_storeu_si128(rk + 7, k1);
+        k1 = AESNI_EXPAND128(k1, 0x80); _mm_storeu_si128(rk + 8, k1);
+        k1 = AESNI_EXPAND128(k1, 0x1b); _mm_storeu_si128(rk + 9, k1);
+        k1 = AESNI_EXPAND128(k1, 0x36); _mm_storeu_si128(rk + 10, k1);
+        return;
+    }
+
+    k2 = _mm_loadu_si128((const __m128i *)(key + 16));
+    _mm_storeu_si128(rk + 1, k2);
+    k1 = AESNI_EXPAND256_A(k1, k2, 0x01); _mm_storeu_si128(rk + 2, k1);
+    k2 = AESNI_EXPAND256_B(k1, k2);       _mm_storeu_si128(rk + 3, k2);
+    k1 = AESNI_EXPAND256_A(k1, k2, 0x02); _mm_storeu_si128(rk + 4, k1);
+    k2 = AESNI_EXPAND256_B(k1, k2);       _mm_storeu_si128(rk + 5, k2);
+    k1 = AESNI_EXPAND256_A(k1, k2, 0x04); _mm_storeu_si128(rk + 6, k1);
+    k2 = AESNI_EXPAND256_B(k1, k2);       _mm_storeu_si128(rk + 7, k2);
+    k1 = AESNI_EXPAND256_A(k1, k2, 0x08); _mm_storeu_si128(rk + 8, k1);
+    k2 = AESNI_EXPAND256_B(k1, k2);       _mm_storeu_si128(rk + 9, k2);
+    k1 = AESNI_EXPAND256_A(k1, k2, 0x10); _mm_storeu_si128(rk + 10, k1);
+    k2 = AESNI_EXPAND256_B(k1, k2);       _mm_storeu_si128(rk + 11, k2);
+    k1 = AESNI_EXPAND256_A(k1, k2, 0x20); _mm_storeu_si128(rk + 12, k1);
+    k2 = AESNI_EXPAND256_B(k1, k2);       _mm_storeu_si128(rk + 13, k2);
+    k1 = AESNI_EXPAND256_A(k1, k2, 0x40); _mm_storeu_si128(rk + 14, k1);
+}
+
+/**
+ *
+ * fit_aesni_encrypt
+ *
+ * This function will encrypt one block using AES instructions.
+ *
+ * @param   aes --> Pointer to structure containing aes state.
+ * @param   input --> Plain data i.e. data to be encrypted.
+ * @param   output <-- Encrypted data. Can be same as input.
+ * @param   skey --> Round keys (see aes_setup).
+ *
+ */
+FIT_AESNI_TARGET
+void fit_aesni_encrypt(aes_state_t* aes, const uint8_t* input, uint8_t* output, const uint8_t* skey)
+{
+    const __m128i *rk   = (const __m128i *)skey;
+    __m128i state       = _mm_loadu_si128((const __m128i *)input);
+    uint16_t round      = 0;
+
+    state = _mm_xor_si128(state, _mm_loadu_si128(rk));
+    for (round = 1; round < aes->Nr; ++round)
+        state = _mm_aesenc_si128(state, _mm_loadu_si128(rk + round));
+    state = _mm_aesenclast_si128(state, _mm_loadu_si128(rk + aes->Nr));
+
+    _mm_storeu_si128((__m128i *)output, state);
+}
+
+// Encrypts one block per lane (see fit_aesni_encrypt_lanes). Inlined with constant
+// number of lanes, so loops over lanes are unrolled and lanes are kept in registers.
+FIT_AESNI_TARGET
+static FIT_AESNI_INLINE void fit_aesni_lanes(uint16_t keylen,
+                                             const uint8_t lanes,
+                                             const uint8_t *keys,
+                                             const uint8_t *input,
+                                             uint8_t *output)
+{
+    __m128i k1[FIT_AESNI_MAX_LANES];
+    __m128i k2[FIT_AESNI_MAX_LANES];
+    __m128i state[FIT_AESNI_MAX_LANES];
+    uint8_t lane = 0;
+
+#define AESNI_LANES(expr) \
+    FIT_AESNI_UNROLL \
+    for (lane = 0; lane < lanes; lane++) { expr; }
+#define AESNI_LANES_ROUND128(rcon) \
+    AESNI_LANES(k1[lane] = AESNI_LANE_EXPAND_A(k1[lane], k1[lane], rcon); \
+                state[lane] = _mm_aesenc_si128(state[lane], k1[lane]))
+#define AESNI_LANES_ROUND256(rcon) \
+    AESNI_LANES(k1[lane] = AESNI_LANE_EXPAND_A(k1[lane], k2[lane], rcon); \
+                state[lane] = _mm_aesenc_si128(state[lane], k1[lane]); \
+                k2[lane] = AESNI_LANE_EXPAND_B(k1[lane], k2[lane]); \
+                state[lane] = _mm_aesenc_si128(state[lane], k2[lane]))
+
+    AESNI_LANES(k1[lane] = _mm_loadu_si128((const __m128i *)(keys + lane*AES_256_KEY_LENGTH));
+                state[lane] = _mm_xor_si128(k1[lane],
+                    _mm_loadu_si128((const __m128i *)(input + lane*AES_OUTPUT_DATA_SIZE))))
+
+    if (keylen == AES_128_KEY_LENGTH)
+    {
+        AESNI_LANES_ROUND128(0x01);
+        AESNI_LANES_ROUND128(0x02);
+        AESNI_LANES_ROUND128(0x04);
+        AESNI_LANES_ROUND128(0x08);
+        AESNI_LANES_ROUND128(0x10);
+        AESNI_LANES_ROUND128(0x20);
+        AESNI_LANES_ROUND128(0x40);
+        AESNI_LANES_ROUND128(0x80);
+        AESNI_LANES_ROUND128(0x1b);
+        AESNI_LANES(k1[lane] = AESNI_LANE_EXPAND_A(k1[lane], k1[lane], 0x36);
+                    state[lane] = _mm_aesenclast_si128(state[lane], k1[lane]))
+    }
+    else
+    {
+        AESNI_LANES(k2[lane] = _mm_loadu_si128((const __m128i *)(keys + lane*AES_256_KEY_LENGTH + 16));
+                    state[lane] = _mm_aesenc_si128(state[lane], k2[lane]))
+        AESNI_LANES_ROUND256(0x01);
+        AESNI_LANES_ROUND256(0x02);
+        AESNI_LANES_ROUND256(0x04);
+        AESNI_LANES_ROUND256(0x08);
+        AESNI_LANES_ROUND256(0x10);
+        AESNI_LANES_ROUND256(0x20);
+        AESNI_LANES(k1[lane] = AESNI_LANE_EXPAND_A(k1[lane], k2[lane], 0x40);
+                    state[lane] = _mm_aesenclast_si128(state[lane], k1[lane]))
+    }
+
+    AESNI_LANES(_mm_storeu_si128((__m128i *)(output + lane*AES_OUTPUT_DATA_SIZE), state[lane]))
+
+#undef AESNI_LANES_ROUND256
+#undef AESNI_LANES_ROUND128
+#undef AESNI_LANES
+}
+
+/**
+ *
+ * fit_aesni_encrypt_lanes
+ *
+ * This function will encrypt one block for each of number of independent lanes,
+ * every lane with its own key. Round keys are derived on the fly and each round
+ * is done for all lanes before next one, so latency of AES instructions of one
+ * lane is hidden behind other lanes (used for hashing number of messages at a
+ * time, where key changes with every block).
+ *
+ * @param   keylen --> Key length (AES_128_KEY_LENGTH or AES_256_KEY_LENGTH).
+ * @param   lanes --> Number of lanes (1 to FIT_AESNI_MAX_LANES).
+ * @param   keys --> Keys of lanes; key of lane n starts at keys + n*AES_256_KEY_LENGTH.
+ * @param   input --> Plain data; block of lane n starts at input + n*AES_OUTPUT_DATA_SIZE.
+ * @param   output <-- Encrypted data, same layout as input. Can be same as input.
+ *
+ */
+FIT_AESNI_TARGET
+void fit_aesni_encrypt_lanes(uint16_t keylen,
+                             uint8_t lanes,
+                             const uint8_t *keys,
+                             const uint8_t *input,
+                             uint8_t *output)
+{
+    switch (lanes)
+    {
+        case 1: fit_aesni_lanes(keylen, 1, keys, input, output); break;
+        case 2: fit_aesni_lanes(keylen, 2, keys, input, output); break;
+        case 3: fit_aesni_lanes(keylen, 3, keys, input, output); break;
+        case 4: fit_aesni_lanes(keylen, 4, keys, input, output); break;
+        case 5: fit_aesni_lanes(keylen, 5, keys, input, output); break;
+        case 6: fit_aesni_lanes(keylen, 6, keys, input, output); break;
+        case 7: fit_aesni_lanes(keylen, 7, keys, input, output); break;
+        case 8: fit_aesni_lanes(keylen, 8, keys, input, output); break;
+        default:
+            break;
+    }
+}
+
+#endif // #ifdef FIT_AESNI_AVAILABLE
@@ -0,0 +1,265 @@
+/****************************************************************************\
+**
+** fit_arena.c
+**
+** Defines functionality for static arena allocator used by mbedtls. Arena is
+** split in blocks, each starting with one unit header; allocation takes first free
+** block large enough (adjacent free blocks are merged while searching), free marks
+** block as free. Arena is only used between fit_arena_enter and matching
+** fit_arena_leave, after which whole arena is free again; mbedtls allocations done
+** outside of verification scope (e.g. by application using mbedtls itself) are
+** served by heap, so they are never lost by arena reset.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+/* Required Includes ********************************************************/
+#include "fit_arena.h"
+
+#ifdef FIT_USE_MBEDTLS_ARENA
+
+#include <stdlib.h>
+#include "fit_api.h"
+#include "internal.h"
+#include "fit_debug.h"
+
+/* Constants ****************************************************************/
+
+// Allocation unit; also alignment of returned memory.
+#define FIT_ARENA_UNIT          8
+#define FIT_ARENA_UNITS         ((FIT_ARENA_SIZE + FIT_ARENA_UNIT - 1) / FIT_ARENA_UNIT)
+
+// Block length is kept in 16 bits and cleared by fit_memset (16 bit length).
+#if FIT_ARENA_SIZE > 0xFFF0
+#error "FIT_ARENA_SIZE is too large"
+#endif
+
+// Contexts used by concurrent threads would share one arena.
+#if defined(FIT_USE_CONCURRENT_CTX) && !defined(FIT_USE_ARENA_PER_THREAD)
+#error "FIT_USE_MBEDTLS_ARENA with concurrent contexts requires FIT_USE_ARENA_PER_THREAD"
+#endif
+
+// Storage class of arena state.
+#ifdef FIT_USE_ARENA_PER_THREAD
+#ifdef _MSC_VER
+#define FIT_ARENA_LOCAL         __declspec(thread)
+#else
+#define FIT_ARENA_LOCAL         __thread
+#endif
+#else
+#define FIT_ARENA_LOCAL
+#endif
+
+/* Types ********************************************************************/
+
+// Block header; block length (in units) includes header.
+typedef union fit_arena_unit {
+    struct {
+        uint16_t    m_units;
+        uint8_t     m_used;
+    } m_hdr;
+    uint64_t        m_align;
+} fit_arena_unit_t;
+
+/* Global Data **************************************************************/
+
+// Arena memory; formatted (one free block) on first use.
+static FIT_ARENA_LOCAL fit_arena_unit_t fit_arena_buf[FIT_ARENA_UNITS];
+
+// Nesting level of verification scopes.
+static FIT_ARENA_LOCAL uint16_t fit_arena_depth = 0;
+
+// Usage statistics.
+static FIT_ARENA_LOCAL fit_arena_stats_t fit_arena_stats = {0};
+
+/* Functions ****************************************************************/
+
+/**
+ *
+ * fit_arena_reset
+ *
+ * This function will free all blocks i.e. make whole arena one free block.
+ *
+ */
+static void fit_arena_reset(void)
+{
+    fit_arena_buf[0].m_hdr.m_units = FIT_ARENA_UNITS;
+    fit_arena_buf[0].m_hdr.m_used = FALSE;
+    fit_arena_stats.m_in_use = 0;
+}
+
+/**
+ *
+ * fit_arena_calloc
+ *
+ * This function will allocate zeroed memory for n elements of size bytes each.
+ * Returns NULL if there is no free block large enough. Outside of verification
+ * scope memory is allocated from heap.
+ *
+ * @param   n --> Number of elements.
+ * @param   size --> Size of each element in bytes.
+ *
+ */
+void *fit_arena_calloc(size_t n, size_t size)
+{
+    fit_arena_unit_t *blk   = NULL;
+    fit_arena_unit_t *next  = NULL;
+    size_t units            = 0;
+    uint16_t idx            = 0;
+
+    // Arena is reset when outermost scope is left; memory needed beyond it is
+    // taken from heap.
+    if (fit_arena_depth == 0)
+        return calloc(n, size);
+
+    if (fit_arena_buf[0].m_hdr.m_units == 0)
+        fit_arena_reset();
+
+    if (size != 0 && n > (FIT_ARENA_SIZE / size))
+        goto fail;
+    units = 1 + (n * size + FIT_ARENA_UNIT - 1) / FIT_ARENA_UNIT;
+
+    for (idx = 0; idx < FIT_ARENA_UNITS; idx += blk->m_hdr.m_units)
+    {
+        blk = &fit_arena_buf[idx];
+        if (blk->m_hdr.m_used)
+            continue;
+
+        // Merge following free blocks.
+        while (idx + blk->m_hdr.m_units < FIT_ARENA_UNITS)
+        {
+            next = blk + blk->m_hdr.m_units;
+            if (next->m_hdr.m_used)
+                break;
+            blk->m_hdr.m_units += next->m_hdr.m_units;
+        }
+        if (blk->m_hdr.m_units < units)
+            continue;
+
+        // Split block if rest can hold at least one unit of data.
+        if (blk->m_hdr.m_units - units >= 2)
+        {
+            next = blk + units;
+            next->m_hdr.m_units = (uint16_t)(blk->m_hdr.m_units - units);
+            next->m_hdr.m_used = FALSE;
+            blk->m_hdr.m_units = (uint16_t)units;
+        }
+        blk->m_hdr.m_used = TRUE;
+        fit_memset((uint8_t *)(blk + 1), 0, (uint16_t)((blk->m_hdr.m_units - 1) * FIT_ARENA_UNIT));
+
+        fit_arena_stats.m_allocs++;
+        fit_arena_stats.m_in_use += (uint32_t)blk->m_hdr.m_units * FIT_ARENA_UNIT;
+        if (fit_arena_stats.m_peak < (uint32_t)(idx + blk->m_hdr.m_units) * FIT_ARENA_UNIT)
+            fit_arena_stats.m_peak = (uint32_t)(idx + blk->m_hdr.m_units) * FIT_ARENA_UNIT;
+
+        return blk + 1;
+    }
+
+fail:
+    DBG(FIT_TRACE_ERROR, "[fit_arena_calloc] arena is full, %u bytes requested\n",
+        (unsigned int)(n * size));
+    fit_arena_stats.m_failures++;
+
+    return NULL;
+}
+
+/**
+ *
+ * fit_arena_free
+ *
+ * This function will free memory allocated by fit_arena_calloc. Memory outside
+ * of arena was allocated from heap and is returned to heap.
+ *
+ * @param   ptr --> Memory to be freed (can be NULL).
+ *
+ */
+void fit_arena_free(void *ptr)
+{
+    fit_arena_unit_t *blk = NULL;
+
+    if (ptr == NULL)
+        return;
+    if ((fit_arena_unit_t *)ptr <= fit_arena_buf ||
+        (fit_arena_unit_t *)ptr >= fit_arena_buf + FIT_ARENA_UNITS)
+    {
+        free(ptr);
+        return;
+    }
+    blk = (fit_arena_unit_t *)ptr - 1;
+
+    if (!blk->m_hdr.m_used)
+    {
+        DBG(FIT_TRACE_ERROR, "[fit_arena_free] invalid pointer 0x%p\n", ptr);
+        return;
+    }
+
+    blk->m_hdr.m_used = FALSE;
+    fit_arena_stats.m_in_use -= (uint32_t)blk->m_hdr.m_units * FIT_ARENA_UNIT;
+}
+
+/**
+ *
+ * fit_arena_enter
+ *
+ * This function will enter verification scope. All memory allocated by mbedtls
+ * within the scope should be released before outermost scope is left.
+ *
+ */
+void fit_arena_enter(void)
+{
+    fit_arena_depth++;
+}
+
+/**
+ *
+ * fit_arena_leave
+ *
+ * This function will leave verification scope. Once outermost scope is left arena
+ * is reset wholesale, so memory not released by mbedtls is not lost.
+ *
+ */
+void fit_arena_leave(void)
+{
+    if (fit_arena_depth == 0 || --fit_arena_depth != 0)
+        return;
+
+    if (fit_arena_stats.m_in_use != 0)
+    {
+        DBG(FIT_TRACE_ERROR, "[fit_arena_leave] %u bytes not released\n",
+            (unsigned int)fit_arena_stats.m_in_use);
+    }
+    fit_arena_reset();
+}
+
+/**
+ *
+ * fit_licenf_get_arena_stats
+ *
+ * This function will get usage statistics of arena used by mbedtls during license
+ * verification. Peak is highest arena offset ever used, so FIT_ARENA_SIZE can be
+ * set to it.
+ *
+ * @param   stats <-- On return it will contain arena statistics.
+ * @param   reset --> If TRUE then statistics are reset after they are returned.
+ *
+ */
+fit_status_t fit_licenf_get_arena_stats(fit_arena_stats_t *stats,
+                                        uint8_t reset)
+{
+    if (stats == NULL)
+        return FIT_INVALID_PARAM_1;
+
+    fit_arena_stats.m_size = FIT_ARENA_UNITS * FIT_ARENA_UNIT;
+    fit_memcpy((uint8_t *)stats, (uint8_t *)&fit_arena_stats, sizeof(fit_arena_stats_t));
+    if (reset == TRUE)
+    {
+        fit_arena_stats.m_peak = 0;
+        fit_arena_stats.m_allocs = 0;
+        fit_arena_stats.m_failures = 0;
+    }
+
+    return FIT_STATUS_OK;
+}
+
+#endif // #ifdef FIT_USE_MBEDTLS_ARENA
@@ -0,0 +1,366 @@
+/****************************************************************************\
+**
+** fit_batch.c
+**
+** Defines functionality for batch license validation on host. Licenses are split
+** in equal shares, one per worker thread. Worker validates licenses from front of
+** its share; once share is empty it steals back half of largest remaining share
+** of other worker. Each worker validates with its own FIT core context and its
+** own prepared key, so workers share nothing but the share bookkeeping.
+**
+** With FIT_USE_MULTI_BUFFER_HASH worker hashes each chunk of licenses by multi-
+** buffer hash engine before validating them one by one.
+**
+** Licenses read by FIT_READ_BYTE_BOUNDED are bounded to their own data while they
+** are validated, so malformed (e.g. truncated) license can not be parsed on into
+** license that follows it in memory.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#include "fit_batch.h"
+
+#ifdef FIT_USE_BATCH_VALIDATE
+
+/* Required Includes ********************************************************/
+#include <stdlib.h>
+#include <pthread.h>
+#include "fit_api.h"
+#include "fit_ctx.h"
+#include "internal.h"
+#include "fit_debug.h"
+#include "mem_read.h"
+
+// Workers run mbedtls at the same time; each needs its own arena.
+#if defined(FIT_USE_MBEDTLS_ARENA) && !defined(FIT_USE_ARENA_PER_THREAD)
+#error "FIT_USE_BATCH_VALIDATE with FIT_USE_MBEDTLS_ARENA requires FIT_USE_ARENA_PER_THREAD"
+#endif
+
+/* Types ********************************************************************/
+
+struct fit_batch;
+
+// Worker thread and its share of licenses [m_next, m_end).
+typedef struct fit_batch_worker {
+    pthread_t           m_thread;
+    pthread_mutex_t     m_lock;
+    uint32_t            m_next;
+    uint32_t            m_end;
+    // Statistics of worker.
+    uint32_t            m_valid;
+    uint32_t            m_failed;
+    uint32_t            m_steals;
+#ifdef FIT_USE_MULTI_BUFFER_HASH
+    uint32_t            m_prehashed;
+#endif
+    uint16_t            m_id;
+    struct fit_batch    *m_batch;
+} fit_batch_worker_t;
+
+// Batch validation in progress.
+typedef struct fit_batch {
+    fit_pointer_t       *m_licenses;
+    fit_pointer_t       *m_key;
+    fit_status_t        *m_results;
+    uint16_t            m_nthreads;
+    fit_batch_worker_t  m_workers[FIT_BATCH_MAX_THREADS];
+} fit_batch_t;
+
+/* Functions ****************************************************************/
+
+/**
+ *
+ * fit_batch_set_bounds
+ *
+ * This function will bound reads of FIT_READ_BYTE_BOUNDED on calling worker to
+ * data of licenses, from start of first to end of last of them.
+ *
+ * @param   licenses --> Array of licenses of type fit_pointer_t.
+ * @param   count --> Number of licenses in above array.
+ *
+ */
+static void fit_batch_set_bounds(fit_pointer_t *licenses, uint32_t count)
+{
+    const uint8_t *start    = licenses[0].data;
+    const uint8_t *end      = licenses[0].data + licenses[0].length;
+    uint32_t cntr           = 0;
+
+    for (cntr = 1; cntr < count; cntr++)
+    {
+        if (licenses[cntr].data < start)
+            start = licenses[cntr].data;
+        if (licenses[cntr].data + licenses[cntr].length > end)
+            end = licenses[cntr].data + licenses[cntr].length;
+    }
+
+    fit_read_set_bounds(start, (uint32_t)(end - start));
+}
+
+/**
+ *
+ * fit_batch_take
+ *
+ * This function will take up to FIT_BATCH_CHUNK licenses from front of worker's
+ * own share. Returns number of licenses taken.
+ *
+ * @param   worker <--> Worker.
+ * @param   first <-- On return it will contain index of first license taken.
+ *
+ */
+static uint32_t fit_batch_take(fit_batch_worker_t *worker, uint32_t *first)
+{
+    uint32_t taken = 0;
+
+    pthread_mutex_lock(&worker->m_lock);
+    taken = worker->m_end - worker->m_next;
+    if (taken > FIT_BATCH_CHUNK)
+        taken = FIT_BATCH_CHUNK;
+    *first = worker->m_next;
+    worker->m_next += taken;
+    pthread_mutex_unlock(&worker->m_lock);
+
+    return taken;
+}
+
+/**
+ *
+ * fit_batch_steal
+ *
+ * This function will move back half of largest remaining share of other workers
+ * into (empty) share of worker. Returns FALSE if there is nothing left to steal.
+ *
+ * @param   worker <--> Worker whose own share is empty.
+ *
+ */
+static uint8_t fit_batch_steal(fit_batch_worker_t *worker)
+{
+    fit_batch_t *batch          = worker->m_batch;
+    fit_batch_worker_t *victim  = NULL;
+    uint32_t largest            = 0;
+    uint32_t left               = 0;
+    uint32_t mid                = 0;
+    uint32_t end                = 0;
+    uint16_t cntr               = 0;
+
+    // Pick worker with largest share; share may shrink before it is split below.
+    for (cntr = 1; cntr < batch->m_nthreads; cntr++)
+    {
+        fit_batch_worker_t *other = &batch->m_workers[(worker->m_id + cntr) % batch->m_nthreads];
+
+        pthread_mutex_lock(&other->m_lock);
+        left = other->m_end - other->m_next;
+        pthread_mutex_unlock(&other->m_lock);
+        if (left > largest)
+        {
+            largest = left;
+            victim = other;
+        }
+    }
+    if (victim == NULL)
+        return FALSE;
+
+    pthread_mutex_lock(&victim->m_lock);
+    left = victim->m_end - victim->m_next;
+    end = victim->m_end;
+    mid = end - (left + 1) / 2;
+    victim->m_end = mid;
+    pthread_mutex_unlock(&victim->m_lock);
+
+    if (mid == end)
+        return TRUE;
+
+    pthread_mutex_lock(&worker->m_lock);
+    worker->m_next = mid;
+    worker->m_end = end;
+    pthread_mutex_unlock(&worker->m_lock);
+    worker->m_steals++;
+
+    return TRUE;
+}
+
+/**
+ *
+ * fit_batch_worker
+ *
+ * Worker thread. Validates licenses of its share, then steals from other workers
+ * till all licenses are validated.
+ *
+ * @param   arg --> Pointer to worker.
+ *
+ */
+static void *fit_batch_worker(void *arg)
+{
+    fit_batch_worker_t *worker  = (fit_batch_worker_t *)arg;
+    fit_batch_t *batch          = worker->m_batch;
+    fit_ctx_t ctx;
+    fit_rsa_key_handle_t handle;
+    fit_status_t status         = FIT_STATUS_OK;
+    uint32_t first              = 0;
+    uint32_t taken              = 0;
+    uint32_t cntr               = 0;
+#ifdef FIT_USE_MULTI_BUFFER_HASH
+    fit_mb_license_hashes_t hashes[FIT_BATCH_CHUNK];
+#endif
+
+    fit_ctx_init(&ctx);
+    status = fit_licenf_prepare_key(&handle, batch->m_key);
+
+    for (;;)
+    {
+        taken = fit_batch_take(worker, &first);
+        if (taken == 0)
+        {
+            if (fit_batch_steal(worker) != TRUE)
+                break;
+            continue;
+        }
+
+#ifdef FIT_USE_MULTI_BUFFER_HASH
+        // Licenses are hashed during validation if this fails. Hash engine reads
+        // licenses of chunk in turns; it only hashes parts within their license.
+        fit_batch_set_bounds(&batch->m_licenses[first], taken);
+        if (status == FIT_STATUS_OK &&
+            fit_mb_hash_licenses(&batch->m_licenses[first], taken, hashes) == FIT_STATUS_OK)
+        {
+            worker->m_prehashed += taken;
+        }
+        else
+        {
+            fit_memset((uint8_t *)hashes, 0, sizeof(hashes));
+        }
+#endif // #ifdef FIT_USE_MULTI_BUFFER_HASH
+
+        for (cntr = first; cntr < first + taken; cntr++)
+        {
+#ifdef FIT_USE_MULTI_BUFFER_HASH
+            fit_ctx_set_hashes(&ctx, &hashes[cntr - first]);
+#endif
+            fit_batch_set_bounds(&batch->m_licenses[cntr], 1);
+            if (status != FIT_STATUS_OK)
+                batch->m_results[cntr] = status;
+            else if (batch->m_licenses[cntr].length == 0)
+                batch->m_results[cntr] = FIT_INVALID_V2C;
+            else
+                fit_licenf_validate_licenses_ctx(&ctx, &batch->m_licenses[cntr], 1,
+                    &handle, &batch->m_results[cntr]);
+
+            if (batch->m_results[cntr] == FIT_STATUS_OK)
+                worker->m_valid++;
+            else
+                worker->m_failed++;
+        }
+    }
+
+#ifdef FIT_USE_MULTI_BUFFER_HASH
+    fit_ctx_set_hashes(&ctx, NULL);
+#endif
+    fit_licenf_release_key(&handle);
+    fit_ctx_free(&ctx);
+
+    return NULL;
+}
+
+/**
+ *
+ * fit_batch_validate
+ *
+ * This function will validate number of licenses against same rsa public key, as
+ * per fit_licenf_validate_license, using pool of worker threads. Returns
+ * FIT_STATUS_OK if all licenses were validated (whatever their status), else error
+ * that prevented batch validation.
+ *
+ * @param   licenses --> Array of licenses of type fit_pointer_t. License data
+ *                       should remain unchanged till function returns. Empty
+ *                       license reports FIT_INVALID_V2C.
+ * @param   count --> Number of licenses in above array.
+ * @param   key --> Start address of the rsa public key of type fit_pointer_t.
+ * @param   threads --> Number of worker threads (1 to FIT_BATCH_MAX_THREADS).
+ * @param   results <-- Array of count elements that will contain validation status
+ *                      of each license.
+ * @param   stats <-- On return it will contain batch statistics (can be NULL).
+ *
+ */
+fit_status_t fit_batch_validate(fit_pointer_t *licenses,
+                                uint32_t count,
+                                fit_pointer_t *key,
+                                uint16_t threads,
+                                fit_status_t *results,
+                                fit_batch_stats_t *stats)
+{
+    fit_batch_t *batch  = NULL;
+    fit_status_t status = FIT_STATUS_OK;
+    uint32_t share      = 0;
+    uint16_t started    = 0;
+    uint16_t cntr       = 0;
+
+    if (licenses == NULL && count != 0)
+        return FIT_INVALID_PARAM_1;
+    if (key == NULL || key->read_byte == NULL)
+        return FIT_INVALID_PARAM_3;
+    if (threads == 0 || threads > FIT_BATCH_MAX_THREADS)
+        return FIT_INVALID_PARAM_4;
+    if (results == NULL && count != 0)
+        return FIT_INVALID_PARAM_5;
+
+    batch = (fit_batch_t *)calloc(1, sizeof(fit_batch_t));
+    if (batch == NULL)
+        return FIT_INSUFFICIENT_MEMORY;
+
+    if (threads > count)
+        threads = (count == 0) ? 1 : (uint16_t)count;
+    batch->m_licenses = licenses;
+    batch->m_key = key;
+    batch->m_results = results;
+    batch->m_nthreads = threads;
+
+    // Equal shares; first (count % threads) workers get one license more.
+    for (cntr = 0; cntr < threads; cntr++)
+    {
+        fit_batch_worker_t *worker = &batch->m_workers[cntr];
+
+        worker->m_id = cntr;
+        worker->m_batch = batch;
+        worker->m_next = share;
+        share += count / threads + ((cntr < count % threads) ? 1 : 0);
+        worker->m_end = share;
+        pthread_mutex_init(&worker->m_lock, NULL);
+    }
+
+    for (started = 0; started < threads; started++)
+    {
+        if (pthread_create(&batch->m_workers[started].m_thread, NULL, fit_batch_worker,
+                &batch->m_workers[started]) != 0)
+        {
+            // Workers already started take over share of this one.
+            DBG(FIT_TRACE_ERROR, "[fit_batch_validate] failed to start worker %d\n", started);
+            status = (started == 0) ? FIT_INTERNAL_ERROR : FIT_STATUS_OK;
+            break;
+        }
+    }
+    for (cntr = 0; cntr < started; cntr++)
+        pthread_join(batch->m_workers[cntr].m_thread, NULL);
+
+    if (stats != NULL)
+    {
+        fit_memset((uint8_t *)stats, 0, sizeof(fit_batch_stats_t));
+        stats->m_threads = started;
+        for (cntr = 0; cntr < threads; cntr++)
+        {
+            stats->m_valid += batch->m_workers[cntr].m_valid;
+            stats->m_failed += batch->m_workers[cntr].m_failed;
+            stats->m_steals += batch->m_workers[cntr].m_steals;
+#ifdef FIT_USE_MULTI_BUFFER_HASH
+            stats->m_prehashed += batch->m_workers[cntr].m_prehashed;
+#endif
+        }
+    }
+
+    for (cntr = 0; cntr < threads; cntr++)
+        pthread_mutex_destroy(&batch->m_workers[cntr].m_lock);
+    free(batch);
+
+    return status;
+}
+
+#endif // #ifdef FIT_USE_BATCH_VALIDATE
@@ -0,0 +1,395 @@
+/****************************************************************************\
+**
+** fit_crypto.c
+**
+** Defines functionality for crypto provider interface and software (synchronous)
+** crypto provider. Software provider is used for all operations not implemented
+** by provider of FIT core context (fit_ctx_set_crypto_provider).
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifdef FIT_USE_CRYPTO_PROVIDER
+
+/* Required Includes ********************************************************/
+#include "fit_crypto.h"
+#include "internal.h"
+#include "fit_aes.h"
+#include "abreast_dm.h"
+#include "dm_hash.h"
+#include "fit_debug.h"
+#include "fit_ctx.h"
+#include "fit_rsa.h"
+
+/* Constants ****************************************************************/
+
+// Provider selection is per thread if contexts are used by concurrent threads.
+#ifdef FIT_USE_CONCURRENT_CTX
+#ifdef _MSC_VER
+#define FIT_CRYPTO_LOCAL        __declspec(thread)
+#else
+#define FIT_CRYPTO_LOCAL        __thread
+#endif
+#else
+#define FIT_CRYPTO_LOCAL
+#endif
+
+/* Global Data **************************************************************/
+
+// Software provider; all operations are performed by fit_crypto_execute.
+static const fit_crypto_provider_t fit_sw_crypto_provider = {0};
+
+// Provider for jobs not bound to provider (hashes and rsa operations of license
+// validation); selected from context by fit_verify_license. NULL for software.
+static FIT_CRYPTO_LOCAL fit_crypto_provider_t *fit_crypto_selected = NULL;
+
+/* Functions ****************************************************************/
+
+/**
+ *
+ * fit_crypto_set_provider
+ *
+ * This function will set crypto provider of default context i.e. context used by
+ * API functions without context parameter. Should not be called while any job is
+ * pending.
+ *
+ * @param   provider --> Crypto provider; NULL to use software provider.
+ *
+ */
+void fit_crypto_set_provider(fit_crypto_provider_t *provider)
+{
+    fit_ctx_set_crypto_provider(fit_ctx_default(), provider);
+}
+
+/**
+ *
+ * fit_crypto_select
+ *
+ * This function will select crypto provider for jobs submitted by calling thread
+ * without provider (job->m_provider is NULL) e.g. by fit_crypto_hash. Returns
+ * provider selected before, so caller can restore it.
+ *
+ * @param   provider --> Crypto provider; NULL to use software provider.
+ *
+ */
+fit_crypto_provider_t *fit_crypto_select(fit_crypto_provider_t *provider)
+{
+    fit_crypto_provider_t *prev = fit_crypto_selected;
+
+    fit_crypto_selected = provider;
+
+    return prev;
+}
+
+/**
+ *
+ * fit_crypto_provider_of
+ *
+ * This function will return provider the job is (to be) submitted to.
+ *
+ * @param   job --> Crypto job.
+ *
+ */
+static const fit_crypto_provider_t *fit_crypto_provider_of(fit_crypto_job_t *job)
+{
+    if (job->m_provider != NULL)
+        return job->m_provider;
+    if (fit_crypto_selected != NULL)
+        return fit_crypto_selected;
+
+    return &fit_sw_crypto_provider;
+}
+
+/**
+ *
+ * fit_crypto_hash_update
+ *
+ * This function will update hash value with 16 byte blocks of data.
+ *
+ * @param   job --> Hash update job.
+ *
+ */
+static fit_status_t fit_crypto_hash_update(fit_crypto_job_t *job)
+{
+    fit_status_t status     = FIT_STATUS_OK;
+    uint8_t block[16]       = {0};
+    uint16_t cntr           = 0;
+
+    if ((job->m_length % DM_CIPHER_BLOCK_SIZE) != 0)
+        return FIT_INVALID_PARAM;
+
+    if (job->m_alg == FIT_CRYPTO_HASH_ABREAST_DM)
+    {
+        AES256_AbreastDmHash_Update((uint8_t *)job->m_input,
+            job->m_length/ABREAST_DM_CIPHER_BLOCK_SIZE, job->m_output);
+        return FIT_STATUS_OK;
+    }
+
+    for (cntr = 0; cntr < job->m_length && status == FIT_STATUS_OK; cntr += DM_CIPHER_BLOCK_SIZE)
+    {
+        fit_memcpy(block, (uint8_t *)job->m_input + cntr, DM_CIPHER_BLOCK_SIZE);
+        status = fit_dm_hash_block(job->m_output, block);
+    }
+
+    return status;
+}
+
+/**
+ *
+ * fit_crypto_hash_final
+ *
+ * This function will pad last block of data (see fit_dm_hash_init), update hash
+ * value with it and calculate final hash value.
+ *
+ * @param   job --> Hash final job.
+ *
+ */
+static fit_status_t fit_crypto_hash_final(fit_crypto_job_t *job)
+{
+    fit_status_t status     = FIT_STATUS_OK;
+    uint8_t tempmsg[32]     = {0};
+    uint16_t msglen         = job->m_length;
+    uint16_t cntr           = 0;
+
+    if (job->m_length > DM_CIPHER_BLOCK_SIZE)
+        return FIT_INVALID_PARAM;
+
+    fit_memcpy(tempmsg, (uint8_t *)job->m_input, job->m_length);
+    fit_dm_hash_init(tempmsg, &msglen, job->m_total);
+
+    if (job->m_alg == FIT_CRYPTO_HASH_ABREAST_DM)
+    {
+        for (cntr = 0; cntr < msglen; cntr += ABREAST_DM_CIPHER_BLOCK_SIZE)
+            AES256_AbreastDmHash_UpdateBlk(tempmsg+cntr, job->m_output);
+        AES256_AbreastDmHash_Finalize(job->m_output);
+        return FIT_STATUS_OK;
+    }
+
+    for (cntr = 0; cntr < msglen && status == FIT_STATUS_OK; cntr += DM_CIPHER_BLOCK_SIZE)
+        status = fit_dm_hash_block(job->m_output, tempmsg+cntr);
+    if (status != FIT_STATUS_OK)
+        return status;
+
+    // The final Hash is calculated as: H = AES (Hn, Hn) XOR Hn
+    fit_memcpy(tempmsg, job->m_output, DM_CIPHER_BLOCK_SIZE);
+    return fit_dm_hash_block(job->m_output, tempmsg);
+}
+
+/**
+ *
+ * fit_crypto_execute
+ *
+ * This function will perform the job in software and return its result. Job state
+ * is not changed, so providers can use it to perform the jobs (or part of them).
+ *
+ * @param   job --> Job to be performed.
+ *
+ */
+fit_status_t fit_crypto_execute(fit_crypto_job_t *job)
+{
+    fit_status_t status = FIT_STATUS_OK;
+
+    switch (job->m_op)
+    {
+        case FIT_CRYPTO_OP_AES_ENCRYPT:
+            return aes_encrypt_key(job->m_key, job->m_keylen, job->m_input, job->m_output);
+
+        case FIT_CRYPTO_OP_HASH_UPDATE:
+            return fit_crypto_hash_update(job);
+
+        case FIT_CRYPTO_OP_HASH_FINAL:
+            return fit_crypto_hash_final(job);
+
+        case FIT_CRYPTO_OP_RSA_PUBLIC:
+            if (job->m_length != RSA_SIG_SIZE)
+                return FIT_RSA_VERIFY_FAILED;
+            status = fit_rsa_key_prepare(job->m_rsakey);
+            if (status == FIT_STATUS_OK)
+                status = fit_rsa_public(job->m_rsakey, job->m_input, job->m_output);
+            if (status != FIT_STATUS_OK)
+            {
+                DBG(FIT_TRACE_ERROR, "[fit_crypto_execute] rsa public operation failed\n");
+            }
+            return status;
+
+        default:
+            break;
+    }
+
+    return FIT_INVALID_PARAM;
+}
+
+/**
+ *
+ * fit_crypto_complete
+ *
+ * This function should be called by crypto provider once job is completed. It
+ * will call the job callback (if any) and then mark the job as completed.
+ *
+ * @param   job --> Completed job.
+ * @param   status --> Result of job.
+ *
+ */
+void fit_crypto_complete(fit_crypto_job_t *job, fit_status_t status)
+{
+    job->m_status = status;
+    if (job->m_callback != NULL)
+        job->m_callback(job);
+    // Job can be reused by its owner once it is marked as done.
+    job->m_state = FIT_CRYPTO_JOB_DONE;
+}
+
+/**
+ *
+ * fit_crypto_submit
+ *
+ * This function will submit the job to its crypto provider (job->m_provider or
+ * provider selected by fit_crypto_select); provider is then recorded in the job,
+ * so it is polled by the same provider. Operations not implemented by provider
+ * are performed synchronously by software provider.
+ *
+ * @param   job --> Job to be submitted.
+ *
+ */
+fit_status_t fit_crypto_submit(fit_crypto_job_t *job)
+{
+    fit_status_t (*submit)(void *ctx, fit_crypto_job_t *job) = NULL;
+    const fit_crypto_provider_t *provider = NULL;
+    fit_status_t status = FIT_STATUS_OK;
+
+    if (job == NULL || job->m_output == NULL)
+        return FIT_INVALID_PARAM_1;
+    if (job->m_state == FIT_CRYPTO_JOB_PENDING)
+        return FIT_CRYPTO_PENDING;
+
+    provider = fit_crypto_provider_of(job);
+    switch (job->m_op)
+    {
+        case FIT_CRYPTO_OP_AES_ENCRYPT:  submit = provider->m_aes_encrypt; break;
+        case FIT_CRYPTO_OP_HASH_UPDATE:  submit = provider->m_hash_update; break;
+        case FIT_CRYPTO_OP_HASH_FINAL:   submit = provider->m_hash_final; break;
+        case FIT_CRYPTO_OP_RSA_PUBLIC:   submit = provider->m_rsa_public; break;
+        default:
+            return FIT_INVALID_PARAM_1;
+    }
+
+    job->m_state = FIT_CRYPTO_JOB_PENDING;
+    if (submit == NULL)
+    {
+        fit_crypto_complete(job, fit_crypto_execute(job));
+        return FIT_STATUS_OK;
+    }
+
+    job->m_provider = (fit_crypto_provider_t *)provider;
+    status = submit(provider->m_ctx, job);
+    if (status != FIT_STATUS_OK)
+    {
+        DBG(FIT_TRACE_ERROR, "[fit_crypto_submit] job rejected by provider, status %d\n", status);
+        job->m_state = FIT_CRYPTO_JOB_IDLE;
+    }
+
+    return status;
+}
+
+/**
+ *
+ * fit_crypto_poll
+ *
+ * This function will check the job for completion. Returns FIT_CRYPTO_PENDING till
+ * job is not completed, then result of job.
+ *
+ * @param   job --> Submitted job.
+ *
+ */
+fit_status_t fit_crypto_poll(fit_crypto_job_t *job)
+{
+    const fit_crypto_provider_t *provider = fit_crypto_provider_of(job);
+
+    if (job->m_state == FIT_CRYPTO_JOB_PENDING && provider->m_poll != NULL)
+        provider->m_poll(provider->m_ctx);
+
+    if (job->m_state == FIT_CRYPTO_JOB_PENDING)
+        return FIT_CRYPTO_PENDING;
+    if (job->m_state != FIT_CRYPTO_JOB_DONE)
+        return FIT_INVALID_PARAM_1;
+
+    return job->m_status;
+}
+
+/**
+ *
+ * fit_crypto_wait
+ *
+ * This function will wait till job is completed and return its result. While job
+ * is pending, provider yield callback (if any) lets waiting task give up the CPU.
+ *
+ * @param   job --> Submitted job.
+ *
+ */
+fit_status_t fit_crypto_wait(fit_crypto_job_t *job)
+{
+    const fit_crypto_provider_t *provider = fit_crypto_provider_of(job);
+    fit_status_t status = FIT_CRYPTO_PENDING;
+
+    for (;;)
+    {
+        status = fit_crypto_poll(job);
+        if (status != FIT_CRYPTO_PENDING)
+            break;
+        if (provider->m_yield != NULL)
+            provider->m_yield(provider->m_ctx);
+    }
+
+    return status;
+}
+
+/**
+ *
+ * fit_crypto_hash
+ *
+ * This function will calculate hash of data passed in by selected crypto provider
+ * and wait for the result. Data is split in update job (all complete blocks except
+ * last one) and final job (last block) as per fit_get_AbreastDM_Hash.
+ *
+ * @param   alg --> Hash algorithm. See enum fit_crypto_hash
+ * @param   msg --> Pointer to (memory mapped) data to be hashed.
+ * @param   hash <-- On return it will contain the hash value.
+ *
+ */
+fit_status_t fit_crypto_hash(uint8_t alg, fit_pointer_t *msg, uint8_t *hash)
+{
+    fit_crypto_job_t job    = {0};
+    fit_status_t status     = FIT_STATUS_OK;
+    uint16_t blocks         = 0;
+
+    // Initial hash value is 0xFF for both hash algorithms.
+    fit_memset(hash, 0xFF, (alg == FIT_CRYPTO_HASH_DM) ? FIT_DM_HASH_SIZE : ABREAST_DM_HASH_SIZE);
+
+    job.m_alg = alg;
+    job.m_output = hash;
+    job.m_input = msg->data;
+    blocks = (msg->length > DM_CIPHER_BLOCK_SIZE) ? (msg->length - 1)/DM_CIPHER_BLOCK_SIZE : 0;
+    if (blocks > 0)
+    {
+        job.m_op = FIT_CRYPTO_OP_HASH_UPDATE;
+        job.m_length = blocks*DM_CIPHER_BLOCK_SIZE;
+        status = fit_crypto_submit(&job);
+        if (status == FIT_STATUS_OK)
+            status = fit_crypto_wait(&job);
+        if (status != FIT_STATUS_OK)
+            return status;
+    }
+
+    job.m_op = FIT_CRYPTO_OP_HASH_FINAL;
+    job.m_input = msg->data + blocks*DM_CIPHER_BLOCK_SIZE;
+    job.m_length = msg->length - blocks*DM_CIPHER_BLOCK_SIZE;
+    job.m_total = msg->length;
+    status = fit_crypto_submit(&job);
+    if (status == FIT_STATUS_OK)
+        status = fit_crypto_wait(&job);
+
+    return status;
+}
+
+#endif // #ifdef FIT_USE_CRYPTO_PROVIDER
@@ -0,0 +1,207 @@
+/****************************************************************************\
+**
+** fit_crypto_pool.c
+**
+** Defines functionality for thread pool crypto provider. All operations are
+** queued and performed by worker threads using software implementation, so
+** overlap of crypto work with other work (e.g. storage reads) can be exercised
+** on host without crypto hardware.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#include "fit_crypto_pool.h"
+
+#if defined(FIT_USE_CRYPTO_PROVIDER) && defined(FIT_USE_CRYPTO_POOL)
+
+/* Required Includes ********************************************************/
+#include <unistd.h>
+#include <sched.h>
+#include "internal.h"
+#include "fit_debug.h"
+
+/* Functions ****************************************************************/
+
+/**
+ *
+ * fit_crypto_pool_worker
+ *
+ * Worker thread. Takes jobs from the queue, performs them and reports completion.
+ *
+ * @param   arg --> Pointer to thread pool.
+ *
+ */
+static void *fit_crypto_pool_worker(void *arg)
+{
+    fit_crypto_pool_t *pool = (fit_crypto_pool_t *)arg;
+    fit_crypto_job_t *job   = NULL;
+    fit_status_t status     = FIT_STATUS_OK;
+
+    for (;;)
+    {
+        pthread_mutex_lock(&pool->m_lock);
+        while (pool->m_count == 0 && !pool->m_stop)
+            pthread_cond_wait(&pool->m_cond, &pool->m_lock);
+        if (pool->m_count == 0)
+        {
+            pthread_mutex_unlock(&pool->m_lock);
+            break;
+        }
+        job = pool->m_queue[pool->m_head];
+        pool->m_head = (uint16_t)((pool->m_head + 1) % FIT_CRYPTO_POOL_QUEUE_SIZE);
+        pool->m_count--;
+        pthread_mutex_unlock(&pool->m_lock);
+
+        if (pool->m_latency != 0)
+            usleep(pool->m_latency);
+        status = fit_crypto_execute(job);
+
+        // Completion under lock, so it is visible to fit_crypto_poll.
+        pthread_mutex_lock(&pool->m_lock);
+        fit_crypto_complete(job, status);
+        pthread_mutex_unlock(&pool->m_lock);
+    }
+
+    return NULL;
+}
+
+/**
+ *
+ * fit_crypto_pool_submit
+ *
+ * Submit function for all operations; puts the job into the queue.
+ *
+ * @param   ctx --> Pointer to thread pool.
+ * @param   job --> Job to be performed.
+ *
+ */
+static fit_status_t fit_crypto_pool_submit(void *ctx, fit_crypto_job_t *job)
+{
+    fit_crypto_pool_t *pool = (fit_crypto_pool_t *)ctx;
+    fit_status_t status     = FIT_STATUS_OK;
+
+    pthread_mutex_lock(&pool->m_lock);
+    if (pool->m_count == FIT_CRYPTO_POOL_QUEUE_SIZE)
+    {
+        DBG(FIT_TRACE_ERROR, "[fit_crypto_pool_submit] job queue is full\n");
+        status = FIT_INTERNAL_ERROR;
+    }
+    else
+    {
+        pool->m_queue[(pool->m_head + pool->m_count) % FIT_CRYPTO_POOL_QUEUE_SIZE] = job;
+        pool->m_count++;
+        pthread_cond_signal(&pool->m_cond);
+    }
+    pthread_mutex_unlock(&pool->m_lock);
+
+    return status;
+}
+
+/**
+ *
+ * fit_crypto_pool_poll
+ *
+ * Jobs are completed by worker threads; taking the lock makes completed jobs
+ * visible to polling thread.
+ *
+ * @param   ctx --> Pointer to thread pool.
+ *
+ */
+static void fit_crypto_pool_poll(void *ctx)
+{
+    fit_crypto_pool_t *pool = (fit_crypto_pool_t *)ctx;
+
+    pthread_mutex_lock(&pool->m_lock);
+    pthread_mutex_unlock(&pool->m_lock);
+}
+
+/**
+ *
+ * fit_crypto_pool_yield
+ *
+ * Called while waiting for job completion; gives the CPU to worker threads instead
+ * of spinning on the queue lock.
+ *
+ * @param   ctx --> Pointer to thread pool.
+ *
+ */
+static void fit_crypto_pool_yield(void *ctx)
+{
+    (void)ctx;
+
+    sched_yield();
+}
+
+/**
+ *
+ * fit_crypto_pool_init
+ *
+ * This function will start worker threads and initialize the provider. Provider
+ * is then installed by fit_ctx_set_crypto_provider(ctx, &pool->m_provider).
+ *
+ * @param   pool <-- Pointer to thread pool.
+ * @param   threads --> Number of worker threads (1 to FIT_CRYPTO_POOL_MAX_THREADS).
+ * @param   latency --> Simulated latency of every job in microseconds (0 for none).
+ *
+ */
+fit_status_t fit_crypto_pool_init(fit_crypto_pool_t *pool, uint8_t threads, uint32_t latency)
+{
+    if (pool == NULL)
+        return FIT_INVALID_PARAM_1;
+    if (threads == 0 || threads > FIT_CRYPTO_POOL_MAX_THREADS)
+        return FIT_INVALID_PARAM_2;
+
+    fit_memset((uint8_t *)pool, 0, sizeof(fit_crypto_pool_t));
+    pthread_mutex_init(&pool->m_lock, NULL);
+    pthread_cond_init(&pool->m_cond, NULL);
+    pool->m_latency = latency;
+
+    pool->m_provider.m_aes_encrypt = fit_crypto_pool_submit;
+    pool->m_provider.m_hash_update = fit_crypto_pool_submit;
+    pool->m_provider.m_hash_final = fit_crypto_pool_submit;
+    pool->m_provider.m_rsa_public = fit_crypto_pool_submit;
+    pool->m_provider.m_poll = fit_crypto_pool_poll;
+    pool->m_provider.m_yield = fit_crypto_pool_yield;
+    pool->m_provider.m_ctx = pool;
+
+    for (pool->m_nthreads = 0; pool->m_nthreads < threads; pool->m_nthreads++)
+    {
+        if (pthread_create(&pool->m_threads[pool->m_nthreads], NULL,
+                           fit_crypto_pool_worker, pool) != 0)
+        {
+            fit_crypto_pool_free(pool);
+            return FIT_INTERNAL_ERROR;
+        }
+    }
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_crypto_pool_free
+ *
+ * This function will stop worker threads once all queued jobs are completed.
+ *
+ * @param   pool --> Pointer to thread pool.
+ *
+ */
+void fit_crypto_pool_free(fit_crypto_pool_t *pool)
+{
+    uint8_t cntr = 0;
+
+    pthread_mutex_lock(&pool->m_lock);
+    pool->m_stop = TRUE;
+    pthread_cond_broadcast(&pool->m_cond);
+    pthread_mutex_unlock(&pool->m_lock);
+
+    for (cntr = 0; cntr < pool->m_nthreads; cntr++)
+        pthread_join(pool->m_threads[cntr], NULL);
+    pool->m_nthreads = 0;
+
+    pthread_mutex_destroy(&pool->m_lock);
+    pthread_cond_destroy(&pool->m_cond);
+}
+
+#endif // #if defined(FIT_USE_CRYPTO_PROVIDER) && defined(FIT_USE_CRYPTO_POOL)
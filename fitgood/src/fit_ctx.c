@@ -0,0 +1,271 @@
+/****************************************************************************\
+**
+** fit_ctx.c
+**
+** Defines functionality for FIT core context i.e. state owned by one user of FIT
+** core (license validation cache, persistent rsa key, crypto provider and platform
+** callbacks).
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+/* Required Includes ********************************************************/
+#include "fit_ctx.h"
+#include "internal.h"
+#include "hwdep.h"
+#include "fit_debug.h"
+#include "dm_hash.h"
+
+/* Global Data **************************************************************/
+
+// Context used by API functions without context parameter; initialized on first use.
+static fit_ctx_t fit_default_ctx;
+static uint8_t fit_default_ctx_init = FALSE;
+
+/* Functions ****************************************************************/
+
+/**
+ *
+ * fit_ctx_init
+ *
+ * This function will initialize context with empty license validation cache and
+ * platform callbacks defined in hwdep.h. Callbacks can be changed afterwards by
+ * fit_ctx_set_time_callback and fit_ctx_set_generation_callback.
+ *
+ * @param   ctx <-- Context to be initialized.
+ *
+ */
+void fit_ctx_init(fit_ctx_t *ctx)
+{
+    fit_memset((uint8_t *)ctx, 0, sizeof(fit_ctx_t));
+    ctx->m_time_get = FIT_TIME_GET;
+    ctx->m_generation_get = FIT_STORAGE_GENERATION_GET;
+}
+
+/**
+ *
+ * fit_ctx_free
+ *
+ * This function will release resources held by context (persistent rsa key) and
+ * clear its license validation cache. Context can be used again after that.
+ *
+ * @param   ctx <--> Context to be released.
+ *
+ */
+void fit_ctx_free(fit_ctx_t *ctx)
+{
+    if (ctx->m_key_init == TRUE)
+        fit_rsa_key_free(FIT_RSA_KEY(&ctx->m_key));
+    ctx->m_key_init = FALSE;
+    fit_memset((uint8_t *)&ctx->m_cache, 0, sizeof(fit_cache_data));
+#ifdef FIT_USE_SHARED_CACHE
+    fit_memset((uint8_t *)&ctx->m_shared_snapshot, 0, sizeof(fit_cache_snapshot_t));
+    ctx->m_shared_seq = 1;
+#endif // #ifdef FIT_USE_SHARED_CACHE
+}
+
+/**
+ *
+ * fit_ctx_default
+ *
+ * This function will return default context i.e. context used by API functions
+ * without context parameter (fit_licenf_consume_license etc.). Context is
+ * initialized by fit_ctx_init on first call.
+ *
+ */
+fit_ctx_t *fit_ctx_default(void)
+{
+    if (fit_default_ctx_init == FALSE)
+    {
+        fit_ctx_init(&fit_default_ctx);
+        fit_default_ctx_init = TRUE;
+    }
+
+    return &fit_default_ctx;
+}
+
+/**
+ *
+ * fit_ctx_set_time_callback
+ *
+ * This function will set callback for getting current time (unix) used for time
+ * based licenses.
+ *
+ * @param   ctx <--> Context.
+ * @param   callback_fn --> Time callback; NULL if there is no clock.
+ *
+ */
+void fit_ctx_set_time_callback(fit_ctx_t *ctx, fit_cb_time_get_t callback_fn)
+{
+    ctx->m_time_get = callback_fn;
+}
+
+/**
+ *
+ * fit_ctx_set_generation_callback
+ *
+ * This function will set callback for getting generation number of trusted storage
+ * (see FIT_USE_TRUSTED_STORAGE).
+ *
+ * @param   ctx <--> Context.
+ * @param   callback_fn --> Generation callback; NULL to always hash the license.
+ *
+ */
+void fit_ctx_set_generation_callback(fit_ctx_t *ctx, fit_cb_generation_get_t callback_fn)
+{
+    ctx->m_generation_get = callback_fn;
+}
+
+#ifdef FIT_USE_SHARED_CACHE
+/**
+ *
+ * fit_ctx_set_shared_cache
+ *
+ * This function will attach context to license validation cache shared by number
+ * of contexts (e.g. one context per worker thread). License validated by any of
+ * them is then accepted by others without rsa signature check. Validation cache
+ * of context itself is checked first; shared cache snapshot is kept in separate
+ * slot of context, so it does not evict license validated by context itself.
+ *
+ * @param   ctx <--> Context.
+ * @param   shared --> Shared cache initialized by fit_shared_cache_init; NULL to
+ *                     detach.
+ *
+ */
+void fit_ctx_set_shared_cache(fit_ctx_t *ctx, fit_shared_cache_t *shared)
+{
+    ctx->m_shared = shared;
+    fit_memset((uint8_t *)&ctx->m_shared_snapshot, 0, sizeof(fit_cache_snapshot_t));
+    // Sequence numbers are even; force copy of first snapshot read.
+    ctx->m_shared_seq = 1;
+}
+#endif // #ifdef FIT_USE_SHARED_CACHE
+
+#ifdef FIT_USE_MULTI_BUFFER_HASH
+/**
+ *
+ * fit_ctx_set_hashes
+ *
+ * This function will pass hashes of license calculated ahead by multi-buffer hash
+ * engine (fit_mb_hash_licenses) to next validations done with context. Hashes are
+ * used only for the same license data they were calculated for.
+ *
+ * @param   ctx <--> Context.
+ * @param   hashes --> Hashes of license; NULL to calculate hashes during validation.
+ *
+ */
+void fit_ctx_set_hashes(fit_ctx_t *ctx, const fit_mb_license_hashes_t *hashes)
+{
+    ctx->m_hashes = hashes;
+}
+#endif // #ifdef FIT_USE_MULTI_BUFFER_HASH
+
+#ifdef FIT_USE_CRYPTO_PROVIDER
+/**
+ *
+ * fit_ctx_set_crypto_provider
+ *
+ * This function will set crypto provider used for license validation with context,
+ * so each task/thread can use its own provider (or channel of hardware accelerator).
+ * Should not be called while any job of context is pending.
+ *
+ * @param   ctx <--> Context.
+ * @param   provider --> Crypto provider; NULL to use software provider.
+ *
+ */
+void fit_ctx_set_crypto_provider(fit_ctx_t *ctx, fit_crypto_provider_t *provider)
+{
+    ctx->m_crypto = provider;
+}
+#endif // #ifdef FIT_USE_CRYPTO_PROVIDER
+
+/**
+ *
+ * fit_ctx_get_key
+ *
+ * This function will return rsa key structure of context for key passed in. Key is
+ * identified by its address, length, read callback and Davies Meyer hash of its
+ * bytes; structure is set up again if different key is passed in, or if key bytes
+ * changed since last call (key rotated in place). Key bytes are hashed once and the
+ * hash is reused while storage generation (see fit_ctx_set_generation_callback) is
+ * unchanged, so key rotated in place is expected to be written through the same
+ * storage. Without generation callback key bytes are hashed on every call.
+ *
+ * With FIT_USE_PERSISTENT_KEY parsed key (and Montgomery constants) are kept across
+ * license validations, so repeated validations against same key do no key setup.
+ *
+ * @param   ctx <--> Context.
+ * @param   key --> fit_pointer to RSA public key
+ *
+ */
+fit_rsa_key_t *fit_ctx_get_key(fit_ctx_t *ctx, fit_pointer_t *key)
+{
+    fit_rsa_key_t *rsakey           = FIT_RSA_KEY(&ctx->m_key);
+    uint8_t hash[FIT_DM_HASH_SIZE]  = {0};
+    fit_status_t status             = FIT_STATUS_OK;
+    uint32_t generation             = 0;
+    uint8_t same                    = FALSE;
+
+    // Get the generation before key bytes are read, so write done in between will
+    // force hashing on next call.
+    if (ctx->m_generation_get != NULL)
+        generation = ctx->m_generation_get();
+
+    if (ctx->m_key_init == TRUE &&
+        rsakey->m_hashed == TRUE &&
+        rsakey->m_key.data == key->data &&
+        rsakey->m_key.length == key->length &&
+        rsakey->m_key.read_byte == key->read_byte)
+    {
+        same = TRUE;
+    }
+
+    // Storage not written since key bytes were hashed; skip hashing.
+    if (same == TRUE && ctx->m_generation_get != NULL && ctx->m_key_generation == generation)
+        return rsakey;
+
+    status = fit_davies_meyer_hash(key, hash);
+    if (status == FIT_STATUS_OK && same == TRUE &&
+        fit_memcmp(rsakey->m_hash, hash, FIT_DM_HASH_SIZE) == 0)
+    {
+        ctx->m_key_generation = generation;
+        return rsakey;
+    }
+
+    DBG(FIT_TRACE_INFO, "[fit_ctx_get_key]: new key 0x%p\n", key->data);
+    if (ctx->m_key_init == TRUE)
+        fit_rsa_key_free(rsakey);
+    fit_rsa_key_init(rsakey, key);
+    ctx->m_key_init = TRUE;
+    ctx->m_key_generation = generation;
+    // Hash is kept for next call and for license validation cache.
+    if (status == FIT_STATUS_OK)
+    {
+        fit_memcpy(rsakey->m_hash, hash, FIT_DM_HASH_SIZE);
+        rsakey->m_hashed = TRUE;
+    }
+
+    return rsakey;
+}
+
+/**
+ *
+ * fit_ctx_release_key
+ *
+ * This function will release memory allocated for parsed rsa key of context once
+ * license validation is done, unless FIT_USE_PERSISTENT_KEY keeps the key parsed
+ * for next validation. Hash of key bytes is kept in both cases.
+ *
+ * @param   ctx <--> Context.
+ *
+ */
+void fit_ctx_release_key(fit_ctx_t *ctx)
+{
+#ifdef FIT_USE_PERSISTENT_KEY
+    (void)ctx;
+#else
+    if (ctx->m_key_init == TRUE)
+        fit_rsa_key_free(FIT_RSA_KEY(&ctx->m_key));
+#endif // #ifdef FIT_USE_PERSISTENT_KEY
+}
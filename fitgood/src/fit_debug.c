@@ -110,6 +110,14 @@ const char *fit_get_error_str (fit_status_t st)
         case FIT_FP_MISMATCH_ERROR:             return "FIT_FP_MISMATCH_ERROR";
         case FIT_INVALID_DEVICE_LEN:            return "FIT_INVALID_DEVICE_LEN";
         case FIT_RSA_VERIFY_FAILED:             return "FIT_RSA_VERIFY_FAILED";
+        case FIT_VERIFY_IN_PROGRESS:            return "FIT_VERIFY_IN_PROGRESS";
+        case FIT_CRYPTO_PENDING:                return "FIT_CRYPTO_PENDING";
+        case FIT_ED25519_VERIFY_FAILED:         return "FIT_ED25519_VERIFY_FAILED";
+        case FIT_INFO_SINK_BUSY:                return "FIT_INFO_SINK_BUSY";
+        case FIT_LICDB_IO_ERROR:                return "FIT_LICDB_IO_ERROR";
+        case FIT_LICDB_INVALID:                 return "FIT_LICDB_INVALID";
+        case FIT_LICDB_NOT_FOUND:               return "FIT_LICDB_NOT_FOUND";
+        case FIT_LICDB_DUPLICATE:               return "FIT_LICDB_DUPLICATE";
         default:;
     }
     return "UNKNOWN ERROR";
@@ -0,0 +1,964 @@
+/****************************************************************************\
+**
+** fit_ed25519.c
+**
+** Defines functionality for Ed25519 signature verification (RFC 8032). Only
+** verification is needed, so all data is public and no constant time code is
+** required; verification equation [S]B = R + [h]A is checked by computing
+** [S]B + [h](-A) in one double and add pass over both scalars and comparing
+** encoding of result with R. Public key and R of small order are rejected, as
+** e.g. neutral point as both with S = 0 would verify any message. Double and add
+** pass can be split into steps (fit_ed25519_verify_step) for fit_verify. Field
+** elements are 16 limbs of 16 bits (mod 2^255 - 19), SHA-512 is implemented
+** here, and no heap memory is used.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifdef FIT_USE_ED25519
+
+/* Required Includes ********************************************************/
+#include "fit_ed25519.h"
+#include "abreast_dm.h"
+#include "fit_debug.h"
+
+/* Constants ****************************************************************/
+
+// Builds 64 bit constant from its high and low 32 bits.
+#define FIT_U64(hi, lo)             (((uint64_t)(hi) << 32) | (uint64_t)(lo))
+
+// Size of SHA-512 block and digest in bytes.
+#define FIT_SHA512_BLOCK_SIZE       128
+#define FIT_SHA512_DIGEST_SIZE      64
+
+// Number of bits of scalars; both S and h are less than group order L < 2^253.
+#define FIT_ED25519_SCALAR_BITS     253
+
+// SHA-512 round constants.
+static const uint64_t fit_sha512_k[80] = {
+    FIT_U64(0x428a2f98, 0xd728ae22), FIT_U64(0x71374491, 0x23ef65cd),
+    FIT_U64(0xb5c0fbcf, 0xec4d3b2f), FIT_U64(0xe9b5dba5, 0x8189dbbc),
+    FIT_U64(0x3956c25b, 0xf348b538), FIT_U64(0x59f111f1, 0xb605d019),
+    FIT_U64(0x923f82a4, 0xaf194f9b), FIT_U64(0xab1c5ed5, 0xda6d8118),
+    FIT_U64(0xd807aa98, 0xa3030242), FIT_U64(0x12835b01, 0x45706fbe),
+    FIT_U64(0x243185be, 0x4ee4b28c), FIT_U64(0x550c7dc3, 0xd5ffb4e2),
+    FIT_U64(0x72be5d74, 0xf27b896f), FIT_U64(0x80deb1fe, 0x3b1696b1),
+    FIT_U64(0x9bdc06a7, 0x25c71235), FIT_U64(0xc19bf174, 0xcf692694),
+    FIT_U64(0xe49b69c1, 0x9ef14ad2), FIT_U64(0xefbe4786, 0x384f25e3),
+    FIT_U64(0x0fc19dc6, 0x8b8cd5b5), FIT_U64(0x240ca1cc, 0x77ac9c65),
+    FIT_U64(0x2de92c6f, 0x592b0275), FIT_U64(0x4a7484aa, 0x6ea6e483),
+    FIT_U64(0x5cb0a9dc, 0xbd41fbd4), FIT_U64(0x76f988da, 0x831153b5),
+    FIT_U64(0x983e5152, 0xee66dfab), FIT_U64(0xa831c66d, 0x2db43210),
+    FIT_U64(0xb00327c8, 0x98fb213f), FIT_U64(0xbf597fc7, 0xbeef0ee4),
+    FIT_U64(0xc6e00bf3, 0x3da88fc2), FIT_U64(0xd5a79147, 0x930aa725),
+    FIT_U64(0x06ca6351, 0xe003826f), FIT_U64(0x14292967, 0x0a0e6e70),
+    FIT_U64(0x27b70a85, 0x46d22ffc), FIT_U64(0x2e1b2138, 0x5c26c926),
+    FIT_U64(0x4d2c6dfc, 0x5ac42aed), FIT_U64(0x53380d13, 0x9d95b3df),
+    FIT_U64(0x650a7354, 0x8baf63de), FIT_U64(0x766a0abb, 0x3c77b2a8),
+    FIT_U64(0x81c2c92e, 0x47edaee6), FIT_U64(0x92722c85, 0x1482353b),
+    FIT_U64(0xa2bfe8a1, 0x4cf10364), FIT_U64(0xa81a664b, 0xbc423001),
+    FIT_U64(0xc24b8b70, 0xd0f89791), FIT_U64(0xc76c51a3, 0x0654be30),
+    FIT_U64(0xd192e819, 0xd6ef5218), FIT_U64(0xd6990624, 0x5565a910),
+    FIT_U64(0xf40e3585, 0x5771202a), FIT_U64(0x106aa070, 0x32bbd1b8),
+    FIT_U64(0x19a4c116, 0xb8d2d0c8), FIT_U64(0x1e376c08, 0x5141ab53),
+    FIT_U64(0x2748774c, 0xdf8eeb99), FIT_U64(0x34b0bcb5, 0xe19b48a8),
+    FIT_U64(0x391c0cb3, 0xc5c95a63), FIT_U64(0x4ed8aa4a, 0xe3418acb),
+    FIT_U64(0x5b9cca4f, 0x7763e373), FIT_U64(0x682e6ff3, 0xd6b2b8a3),
+    FIT_U64(0x748f82ee, 0x5defb2fc), FIT_U64(0x78a5636f, 0x43172f60),
+    FIT_U64(0x84c87814, 0xa1f0ab72), FIT_U64(0x8cc70208, 0x1a6439ec),
+    FIT_U64(0x90befffa, 0x23631e28), FIT_U64(0xa4506ceb, 0xde82bde9),
+    FIT_U64(0xbef9a3f7, 0xb2c67915), FIT_U64(0xc67178f2, 0xe372532b),
+    FIT_U64(0xca273ece, 0xea26619c), FIT_U64(0xd186b8c7, 0x21c0c207),
+    FIT_U64(0xeada7dd6, 0xcde0eb1e), FIT_U64(0xf57d4f7f, 0xee6ed178),
+    FIT_U64(0x06f067aa, 0x72176fba), FIT_U64(0x0a637dc5, 0xa2c898a6),
+    FIT_U64(0x113f9804, 0xbef90dae), FIT_U64(0x1b710b35, 0x131c471b),
+    FIT_U64(0x28db77f5, 0x23047d84), FIT_U64(0x32caab7b, 0x40c72493),
+    FIT_U64(0x3c9ebe0a, 0x15c9bebc), FIT_U64(0x431d67c4, 0x9c100d4c),
+    FIT_U64(0x4cc5d4be, 0xcb3e42b6), FIT_U64(0x597f299c, 0xfc657e2a),
+    FIT_U64(0x5fcb6fab, 0x3ad6faec), FIT_U64(0x6c44198c, 0x4a475817)
+};
+
+// SHA-512 initial hash value.
+static const uint64_t fit_sha512_h0[8] = {
+    FIT_U64(0x6a09e667, 0xf3bcc908), FIT_U64(0xbb67ae85, 0x84caa73b),
+    FIT_U64(0x3c6ef372, 0xfe94f82b), FIT_U64(0xa54ff53a, 0x5f1d36f1),
+    FIT_U64(0x510e527f, 0xade682d1), FIT_U64(0x9b05688c, 0x2b3e6c1f),
+    FIT_U64(0x1f83d9ab, 0xfb41bd6b), FIT_U64(0x5be0cd19, 0x137e2179)
+};
+
+// Curve constant d = -121665/121666 and 2*d (16 bit limbs, least significant first).
+static const int32_t fit_ed25519_d[16] = {
+    0x78a3, 0x1359, 0x4dca, 0x75eb, 0xd8ab, 0x4141, 0x0a4d, 0x0070,
+    0xe898, 0x7779, 0x4079, 0x8cc7, 0xfe73, 0x2b6f, 0x6cee, 0x5203 };
+static const int32_t fit_ed25519_d2[16] = {
+    0xf159, 0x26b2, 0x9b94, 0xebd6, 0xb156, 0x8283, 0x149a, 0x00e0,
+    0xd130, 0xeef3, 0x80f2, 0x198e, 0xfce7, 0x56df, 0xd9dc, 0x2406 };
+
+// Square root of -1 mod p.
+static const int32_t fit_ed25519_sqrtm1[16] = {
+    0xa0b0, 0x4a0e, 0x1b27, 0xc4ee, 0xe478, 0xad2f, 0x1806, 0x2f43,
+    0xd7a7, 0x3dfb, 0x0099, 0x2b4d, 0xdf0b, 0x4fc1, 0x2480, 0x2b83 };
+
+// Coordinates of base point B.
+static const int32_t fit_ed25519_bx[16] = {
+    0xd51a, 0x8f25, 0x2d60, 0xc956, 0xa7b2, 0x9525, 0xc760, 0x692c,
+    0xdc5c, 0xfdd6, 0xe231, 0xc0a4, 0x53fe, 0xcd6e, 0x36d3, 0x2169 };
+static const int32_t fit_ed25519_by[16] = {
+    0x6658, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666,
+    0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666, 0x6666 };
+
+// Group order L = 2^252 + 27742317777372353535851937790883648493 (little endian).
+static const uint8_t fit_ed25519_l[32] = {
+    0xed, 0xd3, 0xf5, 0x5c, 0x1a, 0x63, 0x12, 0x58, 0xd6, 0x9c, 0xf7, 0xa2,
+    0xde, 0xf9, 0xde, 0x14, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x10 };
+
+/* Types ********************************************************************/
+
+// SHA-512 context.
+typedef struct {
+    uint64_t    m_state[8];
+    uint8_t     m_block[FIT_SHA512_BLOCK_SIZE];
+    uint16_t    m_used;
+    uint32_t    m_total;
+} fit_sha512_ctx_t;
+
+/* Functions ****************************************************************/
+
+#define FIT_ROTR64(x, n)            (((x) >> (n)) | ((x) << (64 - (n))))
+
+/**
+ *
+ * fit_sha512_block
+ *
+ * This function will update SHA-512 state with one 128 byte block.
+ *
+ * @param   ctx <--> SHA-512 context.
+ * @param   block --> Block of data.
+ *
+ */
+static void fit_sha512_block(fit_sha512_ctx_t *ctx, const uint8_t *block)
+{
+    uint64_t w[16];
+    uint64_t v[8];
+    uint64_t t1 = 0, t2 = 0;
+    uint8_t i = 0, j = 0;
+
+    for (i = 0; i < 16; i++)
+    {
+        w[i] = 0;
+        for (j = 0; j < 8; j++)
+            w[i] = (w[i] << 8) | block[8*i + j];
+    }
+    for (i = 0; i < 8; i++)
+        v[i] = ctx->m_state[i];
+
+    // Message schedule is kept in 16 word circular buffer.
+    for (i = 0; i < 80; i++)
+    {
+        if (i >= 16)
+        {
+            t1 = w[(i + 1) & 15];
+            t2 = w[(i + 14) & 15];
+            w[i & 15] += (FIT_ROTR64(t2, 19) ^ FIT_ROTR64(t2, 61) ^ (t2 >> 6)) +
+                         w[(i + 9) & 15] +
+                         (FIT_ROTR64(t1, 1) ^ FIT_ROTR64(t1, 8) ^ (t1 >> 7));
+        }
+        t1 = v[7] + (FIT_ROTR64(v[4], 14) ^ FIT_ROTR64(v[4], 18) ^ FIT_ROTR64(v[4], 41)) +
+             ((v[4] & v[5]) ^ (~v[4] & v[6])) + fit_sha512_k[i] + w[i & 15];
+        t2 = (FIT_ROTR64(v[0], 28) ^ FIT_ROTR64(v[0], 34) ^ FIT_ROTR64(v[0], 39)) +
+             ((v[0] & v[1]) ^ (v[0] & v[2]) ^ (v[1] & v[2]));
+        for (j = 7; j > 0; j--)
+            v[j] = v[j - 1];
+        v[4] += t1;
+        v[0] = t1 + t2;
+    }
+
+    for (i = 0; i < 8; i++)
+        ctx->m_state[i] += v[i];
+}
+
+/**
+ *
+ * fit_sha512_init
+ *
+ * This function will initialize SHA-512 context.
+ *
+ * @param   ctx <-- SHA-512 context.
+ *
+ */
+static void fit_sha512_init(fit_sha512_ctx_t *ctx)
+{
+    uint8_t i = 0;
+
+    for (i = 0; i < 8; i++)
+        ctx->m_state[i] = fit_sha512_h0[i];
+    ctx->m_used = 0;
+    ctx->m_total = 0;
+}
+
+/**
+ *
+ * fit_sha512_update
+ *
+ * This function will update SHA-512 context with data.
+ *
+ * @param   ctx <--> SHA-512 context.
+ * @param   data --> Data to be hashed.
+ * @param   len --> Length of data in bytes.
+ *
+ */
+static void fit_sha512_update(fit_sha512_ctx_t *ctx, const uint8_t *data, uint16_t len)
+{
+    uint16_t cntr = 0;
+
+    ctx->m_total += len;
+    for (cntr = 0; cntr < len; cntr++)
+    {
+        ctx->m_block[ctx->m_used++] = data[cntr];
+        if (ctx->m_used == FIT_SHA512_BLOCK_SIZE)
+        {
+            fit_sha512_block(ctx, ctx->m_block);
+            ctx->m_used = 0;
+        }
+    }
+}
+
+/**
+ *
+ * fit_sha512_final
+ *
+ * This function will pad the data and get the SHA-512 digest.
+ *
+ * @param   ctx <--> SHA-512 context.
+ * @param   digest <-- On return it will contain 64 byte digest.
+ *
+ */
+static void fit_sha512_final(fit_sha512_ctx_t *ctx, uint8_t *digest)
+{
+    uint32_t bits = ctx->m_total << 3;
+    uint8_t i = 0;
+
+    ctx->m_block[ctx->m_used++] = 0x80;
+    if (ctx->m_used > FIT_SHA512_BLOCK_SIZE - 16)
+    {
+        while (ctx->m_used < FIT_SHA512_BLOCK_SIZE)
+            ctx->m_block[ctx->m_used++] = 0;
+        fit_sha512_block(ctx, ctx->m_block);
+        ctx->m_used = 0;
+    }
+    while (ctx->m_used < FIT_SHA512_BLOCK_SIZE)
+        ctx->m_block[ctx->m_used++] = 0;
+
+    // 128 bit big endian length in bits; messages here are shorter than 2^29 bytes.
+    ctx->m_block[FIT_SHA512_BLOCK_SIZE - 5] = (uint8_t)(ctx->m_total >> 29);
+    for (i = 0; i < 4; i++)
+        ctx->m_block[FIT_SHA512_BLOCK_SIZE - 1 - i] = (uint8_t)(bits >> (8*i));
+    fit_sha512_block(ctx, ctx->m_block);
+
+    for (i = 0; i < FIT_SHA512_DIGEST_SIZE; i++)
+        digest[i] = (uint8_t)(ctx->m_state[i >> 3] >> (8*(7 - (i & 7))));
+}
+
+/**
+ *
+ * fit_fe_carry
+ *
+ * This function will propagate carries of 64 bit limbs, so each limb is (almost)
+ * in 16 bits. Carry out of top limb is folded into lowest one (2^256 = 38 mod p).
+ *
+ * @param   o <--> Limbs to be normalized.
+ *
+ */
+static void fit_fe_carry(int64_t *o)
+{
+    int64_t c = 0;
+    uint8_t i = 0;
+
+    for (i = 0; i < 16; i++)
+    {
+        o[i] += (int64_t)1 << 16;
+        c = o[i] >> 16;
+        if (i < 15)
+            o[i + 1] += c - 1;
+        else
+            o[0] += 38 * (c - 1);
+        o[i] -= c * 65536;
+    }
+}
+
+/**
+ *
+ * fit_fe_copy
+ *
+ * o = a
+ *
+ */
+static void fit_fe_copy(fit_fe_t o, const int32_t *a)
+{
+    uint8_t i = 0;
+
+    for (i = 0; i < 16; i++)
+        o[i] = a[i];
+}
+
+/**
+ *
+ * fit_fe_add
+ *
+ * o = a + b (not normalized)
+ *
+ */
+static void fit_fe_add(fit_fe_t o, const fit_fe_t a, const fit_fe_t b)
+{
+    uint8_t i = 0;
+
+    for (i = 0; i < 16; i++)
+        o[i] = a[i] + b[i];
+}
+
+/**
+ *
+ * fit_fe_sub
+ *
+ * o = a - b (not normalized)
+ *
+ */
+static void fit_fe_sub(fit_fe_t o, const fit_fe_t a, const fit_fe_t b)
+{
+    uint8_t i = 0;
+
+    for (i = 0; i < 16; i++)
+        o[i] = a[i] - b[i];
+}
+
+/**
+ *
+ * fit_fe_mul
+ *
+ * o = a * b mod p. Limbs of a and b are at most 19 bits, so products fit in 32x32
+ * bit multiplication with 64 bit result. o can be same as a or b.
+ *
+ */
+static void fit_fe_mul(fit_fe_t o, const int32_t *a, const int32_t *b)
+{
+    int64_t t[31];
+    uint8_t i = 0, j = 0;
+
+    for (i = 0; i < 31; i++)
+        t[i] = 0;
+    for (i = 0; i < 16; i++)
+        for (j = 0; j < 16; j++)
+            t[i + j] += (int64_t)a[i] * b[j];
+    // 2^256 = 38 mod p
+    for (i = 0; i < 15; i++)
+        t[i] += 38 * t[i + 16];
+    fit_fe_carry(t);
+    fit_fe_carry(t);
+    for (i = 0; i < 16; i++)
+        o[i] = (int32_t)t[i];
+}
+
+/**
+ *
+ * fit_fe_sqr
+ *
+ * o = a^2 mod p. Cross products are calculated once and doubled. o can be same
+ * as a.
+ *
+ */
+static void fit_fe_sqr(fit_fe_t o, const fit_fe_t a)
+{
+    int64_t t[31];
+    uint8_t i = 0, j = 0;
+
+    for (i = 0; i < 31; i++)
+        t[i] = 0;
+    for (i = 0; i < 16; i++)
+        for (j = i + 1; j < 16; j++)
+            t[i + j] += (int64_t)a[i] * a[j];
+    for (i = 0; i < 31; i++)
+        t[i] *= 2;
+    for (i = 0; i < 16; i++)
+        t[2*i] += (int64_t)a[i] * a[i];
+    for (i = 0; i < 15; i++)
+        t[i] += 38 * t[i + 16];
+    fit_fe_carry(t);
+    fit_fe_carry(t);
+    for (i = 0; i < 16; i++)
+        o[i] = (int32_t)t[i];
+}
+
+/**
+ *
+ * fit_fe_pow
+ *
+ * This function will raise a to power p - 2 (inverse) or (p - 5)/8 (used by square
+ * root). Both exponents are 2^k - c with small c; bits given by skip are zero.
+ *
+ * @param   o <-- Result.
+ * @param   a --> Field element.
+ * @param   top --> Index of most significant bit of exponent.
+ * @param   skip1 --> Index of first zero bit of exponent.
+ * @param   skip2 --> Index of second zero bit of exponent (same as skip1 if only one).
+ *
+ */
+static void fit_fe_pow(fit_fe_t o, const fit_fe_t a, int16_t top, int16_t skip1, int16_t skip2)
+{
+    fit_fe_t c;
+    int16_t i = 0;
+
+    fit_fe_copy(c, a);
+    for (i = top - 1; i >= 0; i--)
+    {
+        fit_fe_sqr(c, c);
+        if (i != skip1 && i != skip2)
+            fit_fe_mul(c, c, a);
+    }
+    fit_fe_copy(o, c);
+}
+
+/**
+ *
+ * fit_fe_pack
+ *
+ * This function will encode field element as 32 bytes (little endian), fully
+ * reduced mod p.
+ *
+ * @param   o <-- Encoded field element.
+ * @param   a --> Field element.
+ *
+ */
+static void fit_fe_pack(uint8_t *o, const fit_fe_t a)
+{
+    int64_t t[16], m[16];
+    int64_t b = 0;
+    uint8_t i = 0, j = 0;
+
+    for (i = 0; i < 16; i++)
+        t[i] = a[i];
+    fit_fe_carry(t);
+    fit_fe_carry(t);
+    fit_fe_carry(t);
+    // Value is now less than 2p; subtract p (twice to be safe) when no borrow.
+    for (j = 0; j < 2; j++)
+    {
+        m[0] = t[0] - 0xffed;
+        for (i = 1; i < 15; i++)
+        {
+            m[i] = t[i] - 0xffff - ((m[i - 1] >> 16) & 1);
+            m[i - 1] &= 0xffff;
+        }
+        m[15] = t[15] - 0x7fff - ((m[14] >> 16) & 1);
+        b = (m[15] >> 16) & 1;
+        m[14] &= 0xffff;
+        if (b == 0)
+        {
+            for (i = 0; i < 16; i++)
+                t[i] = m[i];
+        }
+    }
+    for (i = 0; i < 16; i++)
+    {
+        o[2*i] = (uint8_t)(t[i] & 0xff);
+        o[2*i + 1] = (uint8_t)(t[i] >> 8);
+    }
+}
+
+/**
+ *
+ * fit_fe_equal
+ *
+ * This function will check whether two field elements are equal mod p.
+ *
+ */
+static uint8_t fit_fe_equal(const fit_fe_t a, const fit_fe_t b)
+{
+    uint8_t x[32], y[32];
+    uint8_t diff = 0;
+    uint8_t i = 0;
+
+    fit_fe_pack(x, a);
+    fit_fe_pack(y, b);
+    for (i = 0; i < 32; i++)
+        diff |= x[i] ^ y[i];
+
+    return (diff == 0) ? TRUE : FALSE;
+}
+
+/**
+ *
+ * fit_fe_parity
+ *
+ * This function will return least significant bit of fully reduced field element.
+ *
+ */
+static uint8_t fit_fe_parity(const fit_fe_t a)
+{
+    uint8_t x[32];
+
+    fit_fe_pack(x, a);
+
+    return x[0] & 1;
+}
+
+/**
+ *
+ * fit_ge_add
+ *
+ * p = p + q (unified addition; q can be same as p).
+ *
+ */
+static void fit_ge_add(fit_ge_t *p, const fit_ge_t *q)
+{
+    fit_fe_t a, b, c, d, t, e, f, g, h;
+
+    fit_fe_sub(a, p->m_y, p->m_x);
+    fit_fe_sub(t, q->m_y, q->m_x);
+    fit_fe_mul(a, a, t);
+    fit_fe_add(b, p->m_x, p->m_y);
+    fit_fe_add(t, q->m_x, q->m_y);
+    fit_fe_mul(b, b, t);
+    fit_fe_mul(c, p->m_t, q->m_t);
+    fit_fe_mul(c, c, fit_ed25519_d2);
+    fit_fe_mul(d, p->m_z, q->m_z);
+    fit_fe_add(d, d, d);
+    fit_fe_sub(e, b, a);
+    fit_fe_sub(f, d, c);
+    fit_fe_add(g, d, c);
+    fit_fe_add(h, b, a);
+
+    fit_fe_mul(p->m_x, e, f);
+    fit_fe_mul(p->m_y, h, g);
+    fit_fe_mul(p->m_z, g, f);
+    fit_fe_mul(p->m_t, e, h);
+}
+
+/**
+ *
+ * fit_ge_double
+ *
+ * p = 2p (dbl-2008-hwcd with a = -1; 4 squarings and 4 multiplications).
+ *
+ */
+static void fit_ge_double(fit_ge_t *p)
+{
+    fit_fe_t a, b, c, e, f, g, h;
+    uint8_t i = 0;
+
+    fit_fe_sqr(a, p->m_x);
+    fit_fe_sqr(b, p->m_y);
+    fit_fe_sqr(c, p->m_z);
+    fit_fe_add(c, c, c);
+    fit_fe_add(e, p->m_x, p->m_y);
+    fit_fe_sqr(e, e);
+    fit_fe_sub(e, e, a);
+    fit_fe_sub(e, e, b);
+    fit_fe_sub(g, b, a);
+    fit_fe_sub(f, g, c);
+    for (i = 0; i < 16; i++)
+        h[i] = -a[i] - b[i];
+
+    fit_fe_mul(p->m_x, e, f);
+    fit_fe_mul(p->m_y, g, h);
+    fit_fe_mul(p->m_t, e, h);
+    fit_fe_mul(p->m_z, f, g);
+}
+
+/**
+ *
+ * fit_ge_decode_neg
+ *
+ * This function will decode point from 32 bytes (y coordinate and sign of x) and
+ * negate it. Fails if encoding is not canonical or point is not on curve.
+ *
+ * @param   p <-- Negated point.
+ * @param   s --> Encoded point.
+ *
+ */
+static fit_status_t fit_ge_decode_neg(fit_ge_t *p, const uint8_t *s)
+{
+    fit_fe_t num, den, den2, den4, t, chk;
+    uint8_t packed[32];
+    uint8_t i = 0;
+
+    for (i = 0; i < 16; i++)
+        p->m_y[i] = s[2*i] + ((int32_t)s[2*i + 1] << 8);
+    p->m_y[15] &= 0x7fff;
+    for (i = 0; i < 16; i++)
+        p->m_z[i] = (i == 0) ? 1 : 0;
+
+    // y must be less than p.
+    fit_fe_pack(packed, p->m_y);
+    packed[31] |= s[31] & 0x80;
+    for (i = 0; i < 32; i++)
+    {
+        if (packed[i] != s[i])
+            return FIT_ED25519_VERIFY_FAILED;
+    }
+
+    // x^2 = (y^2 - 1)/(d*y^2 + 1) = num/den; x = num*den^3*(num*den^7)^((p-5)/8)
+    fit_fe_sqr(num, p->m_y);
+    fit_fe_mul(den, num, fit_ed25519_d);
+    fit_fe_sub(num, num, p->m_z);
+    fit_fe_add(den, p->m_z, den);
+
+    fit_fe_sqr(den2, den);
+    fit_fe_sqr(den4, den2);
+    fit_fe_mul(t, den4, den2);
+    fit_fe_mul(t, t, num);
+    fit_fe_mul(t, t, den);
+    fit_fe_pow(t, t, 251, 1, 1);
+    fit_fe_mul(t, t, num);
+    fit_fe_mul(t, t, den);
+    fit_fe_mul(t, t, den);
+    fit_fe_mul(p->m_x, t, den);
+
+    fit_fe_sqr(chk, p->m_x);
+    fit_fe_mul(chk, chk, den);
+    if (fit_fe_equal(chk, num) == FALSE)
+        fit_fe_mul(p->m_x, p->m_x, fit_ed25519_sqrtm1);
+    fit_fe_sqr(chk, p->m_x);
+    fit_fe_mul(chk, chk, den);
+    if (fit_fe_equal(chk, num) == FALSE)
+        return FIT_ED25519_VERIFY_FAILED;
+
+    // Select root with sign opposite to encoded one (negation of point).
+    if (fit_fe_parity(p->m_x) == (s[31] >> 7))
+    {
+        for (i = 0; i < 16; i++)
+            chk[i] = 0;
+        fit_fe_sub(p->m_x, chk, p->m_x);
+    }
+    fit_fe_mul(p->m_t, p->m_x, p->m_y);
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_ge_encode
+ *
+ * This function will encode point as 32 bytes (y coordinate and sign of x).
+ *
+ */
+static void fit_ge_encode(uint8_t *s, const fit_ge_t *p)
+{
+    fit_fe_t zi, x, y;
+
+    fit_fe_pow(zi, p->m_z, 254, 4, 2);
+    fit_fe_mul(x, p->m_x, zi);
+    fit_fe_mul(y, p->m_y, zi);
+    fit_fe_pack(s, y);
+    s[31] ^= (uint8_t)(fit_fe_parity(x) << 7);
+}
+
+/**
+ *
+ * fit_ge_is_small_order
+ *
+ * This function will check whether point is of small order i.e. [8]p is neutral
+ * point. Points of order 2 (and so 4 and 8) are the only ones with x = 0 after
+ * multiplication by 8, so only x is checked.
+ *
+ */
+static uint8_t fit_ge_is_small_order(const fit_ge_t *p)
+{
+    fit_ge_t q  = *p;
+    fit_fe_t zero;
+    uint8_t i   = 0;
+
+    for (i = 0; i < 16; i++)
+        zero[i] = 0;
+    for (i = 0; i < 3; i++)
+        fit_ge_double(&q);
+
+    return fit_fe_equal(q.m_x, zero);
+}
+
+/**
+ *
+ * fit_sc_reduce
+ *
+ * This function will reduce 64 byte number (SHA-512 digest, little endian) mod L.
+ *
+ * @param   r <-- 32 byte result.
+ * @param   s --> 64 byte number.
+ *
+ */
+static void fit_sc_reduce(uint8_t *r, const uint8_t *s)
+{
+    int64_t x[64];
+    int64_t carry = 0;
+    int16_t i = 0, j = 0;
+
+    for (i = 0; i < 64; i++)
+        x[i] = s[i];
+
+    // Eliminate top bytes using 2^256 = -16*(L - 2^252) mod L.
+    for (i = 63; i >= 32; i--)
+    {
+        carry = 0;
+        for (j = i - 32; j < i - 12; j++)
+        {
+            x[j] += carry - 16 * x[i] * fit_ed25519_l[j - (i - 32)];
+            carry = (x[j] + 128) >> 8;
+            x[j] -= carry * 256;
+        }
+        x[j] += carry;
+        x[i] = 0;
+    }
+    carry = 0;
+    for (j = 0; j < 32; j++)
+    {
+        x[j] += carry - (x[31] >> 4) * fit_ed25519_l[j];
+        carry = x[j] >> 8;
+        x[j] &= 255;
+    }
+    for (j = 0; j < 32; j++)
+        x[j] -= carry * fit_ed25519_l[j];
+    for (i = 0; i < 32; i++)
+    {
+        x[i + 1] += x[i] >> 8;
+        r[i] = (uint8_t)(x[i] & 255);
+    }
+}
+
+/**
+ *
+ * fit_sc_is_canonical
+ *
+ * This function will check that scalar (little endian) is less than L.
+ *
+ */
+static uint8_t fit_sc_is_canonical(const uint8_t *s)
+{
+    int8_t i = 0;
+
+    for (i = 31; i >= 0; i--)
+    {
+        if (s[i] < fit_ed25519_l[i])
+            return TRUE;
+        if (s[i] > fit_ed25519_l[i])
+            return FALSE;
+    }
+
+    return FALSE;
+}
+
+/**
+ *
+ * fit_ed25519_verify_start
+ *
+ * This function will start verification of Ed25519 signature (R || S) of message
+ * against public key A i.e. check of [S]B = R + [h]A where h = SHA-512(R || A || M)
+ * mod L. S must be canonical, and A and R must be points of large order. Double
+ * and add pass over S and h is done by fit_ed25519_verify_step.
+ *
+ * @param   ctx <-- Verification context.
+ * @param   sig --> Signature (FIT_ED25519_SIG_SIZE bytes).
+ * @param   pubkey --> Public key (FIT_ED25519_KEY_SIZE bytes).
+ * @param   msg --> Message.
+ * @param   msglen --> Length of message in bytes.
+ *
+ */
+fit_status_t fit_ed25519_verify_start(fit_ed25519_ctx_t *ctx,
+                                      const uint8_t *sig,
+                                      const uint8_t *pubkey,
+                                      const uint8_t *msg,
+                                      uint16_t msglen)
+{
+    fit_sha512_ctx_t sha;
+    uint8_t digest[FIT_SHA512_DIGEST_SIZE];
+    fit_ge_t r;
+    int16_t i = 0;
+
+    if (fit_sc_is_canonical(sig + 32) == FALSE ||
+        fit_ge_decode_neg(&ctx->m_a, pubkey) != FIT_STATUS_OK ||
+        fit_ge_decode_neg(&r, sig) != FIT_STATUS_OK)
+    {
+        DBG(FIT_TRACE_ERROR, "[fit_ed25519_verify_start] invalid signature or public key\n");
+        return FIT_ED25519_VERIFY_FAILED;
+    }
+    if (fit_ge_is_small_order(&ctx->m_a) == TRUE || fit_ge_is_small_order(&r) == TRUE)
+    {
+        DBG(FIT_TRACE_ERROR, "[fit_ed25519_verify_start] public key or R of small order\n");
+        return FIT_ED25519_VERIFY_FAILED;
+    }
+    for (i = 0; i < FIT_ED25519_SIG_SIZE; i++)
+        ctx->m_sig[i] = sig[i];
+
+    fit_sha512_init(&sha);
+    fit_sha512_update(&sha, sig, 32);
+    fit_sha512_update(&sha, pubkey, FIT_ED25519_KEY_SIZE);
+    fit_sha512_update(&sha, msg, msglen);
+    fit_sha512_final(&sha, digest);
+    fit_sc_reduce(ctx->m_h, digest);
+
+    // Base point and B - A for joint additions.
+    fit_fe_copy(ctx->m_b.m_x, fit_ed25519_bx);
+    fit_fe_copy(ctx->m_b.m_y, fit_ed25519_by);
+    fit_fe_copy(ctx->m_b.m_z, ctx->m_a.m_z);
+    fit_fe_mul(ctx->m_b.m_t, ctx->m_b.m_x, ctx->m_b.m_y);
+    ctx->m_ab = ctx->m_a;
+    fit_ge_add(&ctx->m_ab, &ctx->m_b);
+
+    // p = [S]B + [h](-A); starts as neutral point (0, 1).
+    for (i = 0; i < 16; i++)
+    {
+        ctx->m_p.m_x[i] = 0;
+        ctx->m_p.m_t[i] = 0;
+    }
+    fit_fe_copy(ctx->m_p.m_y, ctx->m_a.m_z);
+    fit_fe_copy(ctx->m_p.m_z, ctx->m_a.m_z);
+    ctx->m_bit = FIT_ED25519_SCALAR_BITS - 1;
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_ed25519_verify_step
+ *
+ * This function will continue verification started by fit_ed25519_verify_start for
+ * at most budget operations (one operation is doubling and addition for one bit of
+ * scalars; encoding of result and its comparison with R is done as one more
+ * operation). Returns FIT_VERIFY_IN_PROGRESS till verification is not completed.
+ *
+ * @param   ctx <--> Verification context.
+ * @param   budget <--> Number of operations left in this step.
+ *
+ */
+fit_status_t fit_ed25519_verify_step(fit_ed25519_ctx_t *ctx, uint16_t *budget)
+{
+    uint8_t check[32];
+    uint8_t diff = 0;
+    uint8_t hbit = 0, sbit = 0;
+    int16_t i = 0;
+
+    while (*budget > 0 && ctx->m_bit >= 0)
+    {
+        i = ctx->m_bit;
+        fit_ge_double(&ctx->m_p);
+        hbit = (ctx->m_h[i >> 3] >> (i & 7)) & 1;
+        sbit = (ctx->m_sig[32 + (i >> 3)] >> (i & 7)) & 1;
+        if (hbit && sbit)
+            fit_ge_add(&ctx->m_p, &ctx->m_ab);
+        else if (hbit)
+            fit_ge_add(&ctx->m_p, &ctx->m_a);
+        else if (sbit)
+            fit_ge_add(&ctx->m_p, &ctx->m_b);
+        ctx->m_bit--;
+        (*budget)--;
+    }
+    if (*budget == 0)
+        return FIT_VERIFY_IN_PROGRESS;
+
+    fit_ge_encode(check, &ctx->m_p);
+    (*budget)--;
+    for (i = 0; i < 32; i++)
+        diff |= check[i] ^ ctx->m_sig[i];
+    if (diff != 0)
+    {
+        DBG(FIT_TRACE_ERROR, "[fit_ed25519_verify_step] verify FAILED\n");
+        return FIT_ED25519_VERIFY_FAILED;
+    }
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_ed25519_verify
+ *
+ * This function will verify Ed25519 signature (R || S) of message against public
+ * key A i.e. check that [S]B = R + [h]A where h = SHA-512(R || A || M) mod L.
+ *
+ * @param   sig --> Signature (FIT_ED25519_SIG_SIZE bytes).
+ * @param   pubkey --> Public key (FIT_ED25519_KEY_SIZE bytes).
+ * @param   msg --> Message.
+ * @param   msglen --> Length of message in bytes.
+ *
+ */
+fit_status_t fit_ed25519_verify(const uint8_t *sig,
+                                const uint8_t *pubkey,
+                                const uint8_t *msg,
+                                uint16_t msglen)
+{
+    fit_ed25519_ctx_t ctx;
+    fit_status_t status = FIT_STATUS_OK;
+    uint16_t budget     = FIT_ED25519_SCALAR_BITS + 1;
+
+    status = fit_ed25519_verify_start(&ctx, sig, pubkey, msg, msglen);
+    if (status == FIT_STATUS_OK)
+        status = fit_ed25519_verify_step(&ctx, &budget);
+
+    return status;
+}
+
+/**
+ *
+ * fit_ed25519_start_signature
+ *
+ * This function will start verification of Ed25519 signature of license hash
+ * against public key. Only FIT_ED25519_SIG_SIZE bytes of signature and
+ * FIT_ED25519_KEY_SIZE bytes of key are read.
+ *
+ * @param   ctx         <-- Verification context.
+ * @param   signature   --> fit_pointer to the signature (part of license)
+ * @param   hash        --> RAM pointer to Abreast DM hash of license
+ * @param   key         --> fit_pointer to Ed25519 public key
+ *
+ */
+fit_status_t fit_ed25519_start_signature(fit_ed25519_ctx_t *ctx,
+                                         fit_pointer_t *signature,
+                                         uint8_t *hash,
+                                         fit_pointer_t *key)
+{
+    uint8_t sig[FIT_ED25519_SIG_SIZE];
+    uint8_t pubkey[FIT_ED25519_KEY_SIZE];
+    uint8_t i = 0;
+
+    if (signature->length != FIT_ED25519_SIG_SIZE)
+        return FIT_INVALID_FIELD_LEN;
+    if (key->length != FIT_ED25519_KEY_SIZE)
+        return FIT_INVALID_KEYSIZE;
+
+    for (i = 0; i < FIT_ED25519_SIG_SIZE; i++)
+        sig[i] = signature->read_byte(signature->data + i);
+    for (i = 0; i < FIT_ED25519_KEY_SIZE; i++)
+        pubkey[i] = key->read_byte(key->data + i);
+
+    return fit_ed25519_verify_start(ctx, sig, pubkey, hash, ABREAST_DM_HASH_SIZE);
+}
+
+/**
+ *
+ * fit_validate_ed25519_signature
+ *
+ * This function is to validate Ed25519 signature of license hash against public
+ * key. Only FIT_ED25519_SIG_SIZE bytes of signature and FIT_ED25519_KEY_SIZE bytes
+ * of key are read.
+ *
+ * @param   signature   --> fit_pointer to the signature (part of license)
+ * @param   hash        --> RAM pointer to Abreast DM hash of license
+ * @param   key         --> fit_pointer to Ed25519 public key
+ *
+ */
+fit_status_t fit_validate_ed25519_signature(fit_pointer_t *signature,
+                                            uint8_t *hash,
+                                            fit_pointer_t *key)
+{
+    fit_ed25519_ctx_t ctx;
+    fit_status_t status = FIT_STATUS_OK;
+    uint16_t budget     = FIT_ED25519_SCALAR_BITS + 1;
+
+    status = fit_ed25519_start_signature(&ctx, signature, hash, key);
+    if (status == FIT_STATUS_OK)
+        status = fit_ed25519_verify_step(&ctx, &budget);
+
+    return status;
+}
+
+#endif // #ifdef FIT_USE_ED25519
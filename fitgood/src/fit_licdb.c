@@ -0,0 +1,812 @@
+/****************************************************************************\
+**
+** fit_licdb.c
+**
+** Defines functionality for packed license database used by host tools (see
+** fit_licdb.h for file format). Reader maps whole file read only and hands out
+** licenses as fit_pointer_t into the mapping, so no license is copied or read by
+** separate I/O. Writer appends license records and new index at end of file with
+** positional writes and updates header only after they are on disk.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#include "fit_licdb.h"
+
+#ifdef FIT_USE_LICENSE_DB
+
+/* Required Includes ********************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "fit_api.h"
+#include "mem_read.h"
+#include "parser.h"
+#include "fit_debug.h"
+
+/* Constants ****************************************************************/
+
+// Size of buffer in which appended records are collected before write.
+#define FIT_LICDB_WRITE_BUFFER          0x100000
+
+// Length of record with record header and padding.
+#define FIT_LICDB_RECORD_SIZE(length)   \
+    (((uint64_t)sizeof(fit_licdb_record_t) + (length) + FIT_LICDB_ALIGN - 1) & \
+     ~(uint64_t)(FIT_LICDB_ALIGN - 1))
+
+/* Types ********************************************************************/
+
+// License being appended.
+typedef struct fit_licdb_item {
+    fit_licdb_entry_t   m_entry;
+    // Position of license in array passed to fit_licdb_append.
+    uint32_t            m_source;
+} fit_licdb_item_t;
+
+// Buffered writer of appended records.
+typedef struct fit_licdb_writer {
+    int                 m_fd;
+    uint8_t             *m_buf;
+    size_t              m_len;
+    // File offset of first byte of buffer.
+    uint64_t            m_offset;
+} fit_licdb_writer_t;
+
+/* Global Data **************************************************************/
+
+// UID of licenses without UID field.
+static const uint8_t fit_licdb_no_uid[FIT_UID_LEN] = {0};
+
+/* Functions ****************************************************************/
+
+/**
+ *
+ * fit_licdb_compare
+ *
+ * This function will compare index entry with UID and container ID (index order).
+ *
+ * @param   entry --> Index entry.
+ * @param   uid --> Unique license identifier (FIT_UID_LEN bytes).
+ * @param   container_id --> License container ID.
+ *
+ */
+static int fit_licdb_compare(const fit_licdb_entry_t *entry,
+                             const uint8_t *uid,
+                             uint32_t container_id)
+{
+    int diff = memcmp(entry->m_uid, uid, FIT_UID_LEN);
+
+    if (diff != 0)
+        return diff;
+    if (entry->m_container_id != container_id)
+        return (entry->m_container_id < container_id) ? -1 : 1;
+
+    return 0;
+}
+
+// qsort callback; licenses of equal key stay in order of source array.
+static int fit_licdb_compare_items(const void *a, const void *b)
+{
+    const fit_licdb_item_t *first   = (const fit_licdb_item_t *)a;
+    const fit_licdb_item_t *second  = (const fit_licdb_item_t *)b;
+    int diff = fit_licdb_compare(&first->m_entry, second->m_entry.m_uid,
+        second->m_entry.m_container_id);
+
+    if (diff != 0)
+        return diff;
+
+    return (first->m_source < second->m_source) ? -1 : (first->m_source > second->m_source);
+}
+
+/**
+ *
+ * fit_licdb_check_license
+ *
+ * This function will check that license is not empty and that license part
+ * covered by signature and signature itself lie within license data, so truncated
+ * license is not added. Reads of FIT_READ_BYTE_BOUNDED are bounded to license.
+ *
+ * @param   license --> License of type fit_pointer_t.
+ *
+ */
+static fit_status_t fit_licdb_check_license(fit_pointer_t *license)
+{
+    fit_pointer_t licpart   = {0};
+    fit_pointer_t signature = {0};
+    const uint8_t *end      = license->data + license->length;
+    fit_status_t status     = FIT_STATUS_OK;
+
+    if (license->length == 0)
+        return FIT_INVALID_V2C;
+    fit_read_set_bounds(license->data, license->length);
+
+    status = fit_get_signed_data(license, &licpart, &signature);
+    if (status != FIT_STATUS_OK)
+        return status;
+    if (licpart.data < license->data || licpart.data + licpart.length > end ||
+        signature.data < license->data || signature.data + signature.length > end)
+    {
+        return FIT_INVALID_V2C;
+    }
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_licdb_lower_bound
+ *
+ * This function will do binary search of index. Returns position of first entry
+ * not less than UID and container ID (count if there is none).
+ *
+ * @param   index --> Index entries.
+ * @param   count --> Number of index entries.
+ * @param   uid --> Unique license identifier (FIT_UID_LEN bytes).
+ * @param   container_id --> License container ID.
+ *
+ */
+static uint32_t fit_licdb_lower_bound(const fit_licdb_entry_t *index,
+                                      uint32_t count,
+                                      const uint8_t *uid,
+                                      uint32_t container_id)
+{
+    uint32_t low    = 0;
+    uint32_t high   = count;
+    uint32_t mid    = 0;
+
+    while (low < high)
+    {
+        mid = low + (high - low) / 2;
+        if (fit_licdb_compare(&index[mid], uid, container_id) < 0)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    return low;
+}
+
+/**
+ *
+ * fit_licdb_check_header
+ *
+ * This function will check database header against size of file.
+ *
+ * @param   header --> Database header.
+ * @param   size --> Size of database file.
+ *
+ */
+static fit_status_t fit_licdb_check_header(const fit_licdb_header_t *header, uint64_t size)
+{
+    uint64_t length = (uint64_t)header->m_count * sizeof(fit_licdb_entry_t);
+
+    if (memcmp(header->m_magic, FIT_LICDB_MAGIC, FIT_LICDB_MAGIC_LEN) != 0 ||
+        header->m_version != FIT_LICDB_VERSION ||
+        header->m_byte_order != FIT_LICDB_BYTE_ORDER)
+    {
+        DBG(FIT_TRACE_ERROR, "[fit_licdb_check_header]: not a license database of this host\n");
+        return FIT_LICDB_INVALID;
+    }
+    if (header->m_end < sizeof(fit_licdb_header_t) || header->m_end > size ||
+        (header->m_end % FIT_LICDB_ALIGN) != 0)
+    {
+        DBG(FIT_TRACE_ERROR, "[fit_licdb_check_header]: invalid end of records\n");
+        return FIT_LICDB_INVALID;
+    }
+    if (header->m_count != 0 &&
+        (header->m_index < sizeof(fit_licdb_header_t) || (header->m_index % FIT_LICDB_ALIGN) != 0 ||
+         header->m_index > header->m_end ||
+         header->m_end - header->m_index < sizeof(fit_licdb_record_t) + length))
+    {
+        DBG(FIT_TRACE_ERROR, "[fit_licdb_check_header]: invalid index\n");
+        return FIT_LICDB_INVALID;
+    }
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_licdb_open
+ *
+ * This function will map database file read only and check its header and index.
+ * Licenses are not checked till they are used.
+ *
+ * @param   db <-- On return it will describe opened database.
+ * @param   path --> Path of database file.
+ * @param   access --> How database will be used (enum fit_licdb_access); mapping
+ *                     is read ahead for FIT_LICDB_SCAN only.
+ *
+ */
+fit_status_t fit_licdb_open(fit_licdb_t *db, const char *path, uint8_t access)
+{
+    const fit_licdb_header_t *header    = NULL;
+    const fit_licdb_record_t *record    = NULL;
+    fit_status_t status                 = FIT_STATUS_OK;
+    struct stat st;
+    void *map                           = NULL;
+    int fd                              = -1;
+
+    if (db == NULL)
+        return FIT_INVALID_PARAM_1;
+    if (path == NULL)
+        return FIT_INVALID_PARAM_2;
+    memset(db, 0, sizeof(fit_licdb_t));
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        DBG(FIT_TRACE_ERROR, "[fit_licdb_open]: cannot open %s\n", path);
+        if (fd >= 0)
+            close(fd);
+        return FIT_LICDB_IO_ERROR;
+    }
+    if ((uint64_t)st.st_size < sizeof(fit_licdb_header_t) || (uint64_t)st.st_size > (size_t)-1)
+    {
+        close(fd);
+        return FIT_LICDB_INVALID;
+    }
+    map = mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return FIT_LICDB_IO_ERROR;
+
+    header = (const fit_licdb_header_t *)map;
+    status = fit_licdb_check_header(header, (uint64_t)st.st_size);
+    if (status == FIT_STATUS_OK && header->m_count != 0)
+    {
+        record = (const fit_licdb_record_t *)((const uint8_t *)map + header->m_index);
+        if (record->m_type != FIT_LICDB_RECORD_INDEX ||
+            record->m_length != header->m_count * sizeof(fit_licdb_entry_t))
+        {
+            DBG(FIT_TRACE_ERROR, "[fit_licdb_open]: header does not point to index\n");
+            status = FIT_LICDB_INVALID;
+        }
+    }
+    if (status != FIT_STATUS_OK)
+    {
+        munmap(map, (size_t)st.st_size);
+        return status;
+    }
+
+    // Scan reads records once in file order; lookups touch few pages each.
+    madvise(map, (size_t)st.st_size, (access == FIT_LICDB_SCAN) ? MADV_SEQUENTIAL : MADV_RANDOM);
+
+    db->m_map = (const uint8_t *)map;
+    db->m_size = (size_t)st.st_size;
+    db->m_index = (record != NULL) ? (const fit_licdb_entry_t *)(record + 1) : NULL;
+    db->m_count = header->m_count;
+    db->m_end = header->m_end;
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_licdb_close
+ *
+ * This function will unmap database. Licenses got from database can not be used
+ * after it is closed.
+ *
+ * @param   db <--> Database opened by fit_licdb_open.
+ *
+ */
+void fit_licdb_close(fit_licdb_t *db)
+{
+    if (db == NULL || db->m_map == NULL)
+        return;
+
+    munmap((void *)db->m_map, db->m_size);
+    memset(db, 0, sizeof(fit_licdb_t));
+}
+
+/**
+ *
+ * fit_licdb_license
+ *
+ * This function will check index entry and set license to its data in mapping.
+ *
+ * @param   db --> Database.
+ * @param   entry --> Index entry of license.
+ * @param   license <-- On return it will describe license data.
+ *
+ */
+static fit_status_t fit_licdb_license(fit_licdb_t *db,
+                                      const fit_licdb_entry_t *entry,
+                                      fit_pointer_t *license)
+{
+    if (entry->m_length > 0xFFFF ||
+        entry->m_offset < sizeof(fit_licdb_header_t) + sizeof(fit_licdb_record_t) + sizeof(fit_licdb_entry_t) ||
+        entry->m_offset > db->m_end || db->m_end - entry->m_offset < entry->m_length)
+    {
+        DBG(FIT_TRACE_ERROR, "[fit_licdb_license]: license outside of records\n");
+        return FIT_LICDB_INVALID;
+    }
+
+    license->data = (uint8_t *)(db->m_map + entry->m_offset);
+    license->length = (uint16_t)entry->m_length;
+    license->read_byte = (fit_read_byte_callback_t)FIT_READ_BYTE_RAM;
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_licdb_get
+ *
+ * This function will get license by its position in index; licenses are in order
+ * of UID and container ID. License data is not copied, it stays in the mapping.
+ * Parser does not stop at license length, so license of untrusted database should
+ * be read with bounds checked read_byte callback (license ends within mapping).
+ *
+ * @param   db --> Database opened by fit_licdb_open.
+ * @param   index --> Position of license in index (0 to m_count - 1).
+ * @param   license <-- On return it will describe license data (RAM).
+ * @param   entry <-- On return it will point to index entry of license (can be NULL).
+ *
+ */
+fit_status_t fit_licdb_get(fit_licdb_t *db,
+                           uint32_t index,
+                           fit_pointer_t *license,
+                           const fit_licdb_entry_t **entry)
+{
+    fit_status_t status = FIT_STATUS_OK;
+
+    if (db == NULL || db->m_map == NULL)
+        return FIT_INVALID_PARAM_1;
+    if (index >= db->m_count)
+        return FIT_INVALID_PARAM_2;
+    if (license == NULL)
+        return FIT_INVALID_PARAM_3;
+
+    status = fit_licdb_license(db, &db->m_index[index], license);
+    if (status == FIT_STATUS_OK && entry != NULL)
+        *entry = &db->m_index[index];
+
+    return status;
+}
+
+/**
+ *
+ * fit_licdb_find
+ *
+ * This function will find license by UID (FIT_UID_TAG_ID) and container ID by
+ * binary search in index. If container ID is FIT_LICDB_ANY_CONTAINER then first
+ * license with UID is found; licenses of same UID follow it in index.
+ *
+ * @param   db --> Database opened by fit_licdb_open.
+ * @param   uid --> Unique license identifier (FIT_UID_LEN bytes).
+ * @param   container_id --> License container ID or FIT_LICDB_ANY_CONTAINER.
+ * @param   index <-- On return it will contain position of license in index.
+ *
+ */
+fit_status_t fit_licdb_find(fit_licdb_t *db,
+                            const uint8_t *uid,
+                            uint32_t container_id,
+                            uint32_t *index)
+{
+    uint8_t any = (container_id == FIT_LICDB_ANY_CONTAINER) ? TRUE : FALSE;
+    uint32_t pos = 0;
+
+    if (db == NULL || db->m_map == NULL)
+        return FIT_INVALID_PARAM_1;
+    if (uid == NULL)
+        return FIT_INVALID_PARAM_2;
+    if (index == NULL)
+        return FIT_INVALID_PARAM_4;
+
+    pos = fit_licdb_lower_bound(db->m_index, db->m_count, uid, any ? 0 : container_id);
+    if (pos == db->m_count || memcmp(db->m_index[pos].m_uid, uid, FIT_UID_LEN) != 0 ||
+        (!any && db->m_index[pos].m_container_id != container_id))
+    {
+        return FIT_LICDB_NOT_FOUND;
+    }
+    *index = pos;
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_licdb_next
+ *
+ * This function will get next license in file order, i.e. order in which licenses
+ * were appended. Records are read strictly sequentially, so scan of whole database
+ * is limited by disk bandwidth only. Returns FIT_LICDB_NOT_FOUND after last license.
+ *
+ * @param   db --> Database opened by fit_licdb_open.
+ * @param   pos <--> Position of scan; 0 to start from first license.
+ * @param   license <-- On return it will describe license data (RAM).
+ * @param   entry <-- On return it will point to index entry of license (can be NULL).
+ *
+ */
+fit_status_t fit_licdb_next(fit_licdb_t *db,
+                            uint64_t *pos,
+                            fit_pointer_t *license,
+                            const fit_licdb_entry_t **entry)
+{
+    const fit_licdb_record_t *record    = NULL;
+    const fit_licdb_entry_t *own        = NULL;
+    fit_status_t status                 = FIT_STATUS_OK;
+    uint64_t offset                     = 0;
+
+    if (db == NULL || db->m_map == NULL)
+        return FIT_INVALID_PARAM_1;
+    if (pos == NULL)
+        return FIT_INVALID_PARAM_2;
+    if (license == NULL)
+        return FIT_INVALID_PARAM_3;
+
+    offset = (*pos == 0) ? sizeof(fit_licdb_header_t) : *pos;
+    for (;;)
+    {
+        if (offset >= db->m_end)
+            return FIT_LICDB_NOT_FOUND;
+        if ((offset % FIT_LICDB_ALIGN) != 0 || db->m_end - offset < sizeof(fit_licdb_record_t))
+            return FIT_LICDB_INVALID;
+
+        record = (const fit_licdb_record_t *)(db->m_map + offset);
+        if (db->m_end - offset < FIT_LICDB_RECORD_SIZE(record->m_length))
+        {
+            DBG(FIT_TRACE_ERROR, "[fit_licdb_next]: record at %lu beyond end\n", (unsigned long)offset);
+            return FIT_LICDB_INVALID;
+        }
+        offset += FIT_LICDB_RECORD_SIZE(record->m_length);
+
+        // Index records (current and replaced ones) are skipped.
+        if (record->m_type == FIT_LICDB_RECORD_LICENSE)
+            break;
+    }
+
+    own = (const fit_licdb_entry_t *)(record + 1);
+    if (record->m_length < sizeof(fit_licdb_entry_t) ||
+        own->m_length != record->m_length - sizeof(fit_licdb_entry_t) ||
+        own->m_offset != (uint64_t)((const uint8_t *)(own + 1) - db->m_map))
+    {
+        DBG(FIT_TRACE_ERROR, "[fit_licdb_next]: invalid license record\n");
+        return FIT_LICDB_INVALID;
+    }
+    status = fit_licdb_license(db, own, license);
+    if (status != FIT_STATUS_OK)
+        return status;
+
+    *pos = offset;
+    if (entry != NULL)
+        *entry = own;
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_licdb_write
+ *
+ * This function will write data at file offset; short writes are continued.
+ *
+ * @param   fd --> File descriptor.
+ * @param   data --> Data to write.
+ * @param   length --> Length of data.
+ * @param   offset --> File offset.
+ *
+ */
+static fit_status_t fit_licdb_write(int fd, const uint8_t *data, size_t length, uint64_t offset)
+{
+    ssize_t written = 0;
+
+    while (length > 0)
+    {
+        written = pwrite(fd, data, length, (off_t)offset);
+        if (written < 0 && errno == EINTR)
+            continue;
+        if (written <= 0)
+        {
+            DBG(FIT_TRACE_ERROR, "[fit_licdb_write]: write failed (errno %d)\n", errno);
+            return FIT_LICDB_IO_ERROR;
+        }
+        data += written;
+        length -= (size_t)written;
+        offset += (uint64_t)written;
+    }
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_licdb_put
+ *
+ * This function will add record to write buffer; buffer is written when full.
+ * Record larger than buffer is written directly.
+ *
+ * @param   writer <--> Writer.
+ * @param   type --> Record type.
+ * @param   head --> First part of record data (can be NULL if head_len is 0).
+ * @param   head_len --> Length of first part.
+ * @param   data --> Rest of record data.
+ * @param   length --> Length of rest of record data.
+ *
+ */
+static fit_status_t fit_licdb_put(fit_licdb_writer_t *writer,
+                                  uint32_t type,
+                                  const void *head,
+                                  size_t head_len,
+                                  const void *data,
+                                  size_t length)
+{
+    fit_licdb_record_t record;
+    uint64_t size       = FIT_LICDB_RECORD_SIZE(head_len + length);
+    fit_status_t status = FIT_STATUS_OK;
+    uint8_t *p          = NULL;
+
+    if (writer->m_len + size > FIT_LICDB_WRITE_BUFFER && writer->m_len > 0)
+    {
+        status = fit_licdb_write(writer->m_fd, writer->m_buf, writer->m_len, writer->m_offset);
+        if (status != FIT_STATUS_OK)
+            return status;
+        writer->m_offset += writer->m_len;
+        writer->m_len = 0;
+    }
+
+    record.m_type = type;
+    record.m_length = (uint32_t)(head_len + length);
+    if (size > FIT_LICDB_WRITE_BUFFER)
+    {
+        // Only index can be this large; header and entries are aligned already.
+        status = fit_licdb_write(writer->m_fd, (const uint8_t *)&record, sizeof(record), writer->m_offset);
+        if (status == FIT_STATUS_OK && head_len > 0)
+            status = fit_licdb_write(writer->m_fd, (const uint8_t *)head, head_len,
+                writer->m_offset + sizeof(record));
+        if (status == FIT_STATUS_OK)
+            status = fit_licdb_write(writer->m_fd, (const uint8_t *)data, length,
+                writer->m_offset + sizeof(record) + head_len);
+        writer->m_offset += size;
+        return status;
+    }
+
+    p = writer->m_buf + writer->m_len;
+    memset(p, 0, (size_t)size);
+    memcpy(p, &record, sizeof(record));
+    if (head_len > 0)
+        memcpy(p + sizeof(record), head, head_len);
+    memcpy(p + sizeof(record) + head_len, data, length);
+    writer->m_len += (size_t)size;
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_licdb_append
+ *
+ * This function will append licenses to database file; file is created if it
+ * does not exist. UID and container ID of every license are taken from license
+ * itself (fit_licenf_get_info_flat); empty or truncated licenses, licenses that can
+ * not be parsed and licenses already in database (same UID and container ID) are
+ * not added. Licenses read by FIT_READ_BYTE_BOUNDED are bounded to their own data. Licenses without
+ * UID are indexed by zero UID and never taken as duplicates. License records
+ * and new index are written after last record, then header is updated, so
+ * interrupted append leaves database as it was before. Database must not be
+ * appended by two callers at the same time; opened readers are not affected.
+ *
+ * @param   path --> Path of database file.
+ * @param   licenses --> Array of licenses of type fit_pointer_t.
+ * @param   count --> Number of licenses in above array.
+ * @param   results <-- Array of count elements that will contain FIT_STATUS_OK for
+ *                      licenses added, else reason license was not added (can be
+ *                      NULL).
+ *
+ */
+fit_status_t fit_licdb_append(const char *path,
+                              fit_pointer_t *licenses,
+                              uint32_t count,
+                              fit_status_t *results)
+{
+    fit_licdb_header_t header;
+    fit_licdb_record_t record;
+    fit_licdb_writer_t writer;
+    fit_info_flat_t info;
+    fit_licdb_entry_t *old          = NULL;
+    fit_licdb_entry_t *index        = NULL;
+    fit_licdb_item_t *items         = NULL;
+    fit_status_t *status_of         = NULL;
+    uint32_t *slot                  = NULL;
+    fit_status_t status             = FIT_STATUS_OK;
+    struct stat st;
+    uint64_t offset                 = 0;
+    uint32_t added                  = 0;
+    uint32_t total                  = 0;
+    uint32_t cntr                   = 0;
+    uint32_t from_old               = 0;
+    uint32_t from_new               = 0;
+    uint16_t size                   = 0;
+    ssize_t got                     = 0;
+    int fd                          = -1;
+
+    if (path == NULL)
+        return FIT_INVALID_PARAM_1;
+    if (licenses == NULL && count != 0)
+        return FIT_INVALID_PARAM_2;
+
+    memset(&writer, 0, sizeof(writer));
+    fd = open(path, O_RDWR | O_CREAT, 0644);
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        DBG(FIT_TRACE_ERROR, "[fit_licdb_append]: cannot open %s\n", path);
+        status = FIT_LICDB_IO_ERROR;
+        goto bail;
+    }
+
+    // Current header and index; new file gets header without records.
+    memset(&header, 0, sizeof(header));
+    if (st.st_size == 0)
+    {
+        memcpy(header.m_magic, FIT_LICDB_MAGIC, FIT_LICDB_MAGIC_LEN);
+        header.m_version = FIT_LICDB_VERSION;
+        header.m_byte_order = FIT_LICDB_BYTE_ORDER;
+        header.m_end = sizeof(fit_licdb_header_t);
+    }
+    else
+    {
+        got = pread(fd, &header, sizeof(header), 0);
+        status = (got == (ssize_t)sizeof(header)) ?
+            fit_licdb_check_header(&header, (uint64_t)st.st_size) : FIT_LICDB_INVALID;
+        if (status != FIT_STATUS_OK)
+            goto bail;
+    }
+    if (header.m_count != 0)
+    {
+        size_t length = (size_t)header.m_count * sizeof(fit_licdb_entry_t);
+
+        old = (fit_licdb_entry_t *)malloc(length);
+        if (old == NULL)
+        {
+            status = FIT_INSUFFICIENT_MEMORY;
+            goto bail;
+        }
+        if (pread(fd, &record, sizeof(record), (off_t)header.m_index) != (ssize_t)sizeof(record) ||
+            record.m_type != FIT_LICDB_RECORD_INDEX || record.m_length != length ||
+            pread(fd, old, length, (off_t)(header.m_index + sizeof(record))) != (ssize_t)length)
+        {
+            status = FIT_LICDB_INVALID;
+            goto bail;
+        }
+    }
+    if ((uint64_t)header.m_count + count > 0xFFFFFFFFUL / sizeof(fit_licdb_entry_t))
+    {
+        status = FIT_INVALID_PARAM_3;
+        goto bail;
+    }
+
+    items = (fit_licdb_item_t *)calloc(count + 1, sizeof(fit_licdb_item_t));
+    status_of = (fit_status_t *)calloc(count + 1, sizeof(fit_status_t));
+    slot = (uint32_t *)calloc(count + 1, sizeof(uint32_t));
+    index = (fit_licdb_entry_t *)malloc(((size_t)header.m_count + count + 1) * sizeof(fit_licdb_entry_t));
+    writer.m_buf = (uint8_t *)malloc(FIT_LICDB_WRITE_BUFFER);
+    if (items == NULL || status_of == NULL || index == NULL || slot == NULL ||
+        writer.m_buf == NULL)
+    {
+        status = FIT_INSUFFICIENT_MEMORY;
+        goto bail;
+    }
+
+    // Keys of licenses (sizing pass of get info only, tables are not needed).
+    for (cntr = 0; cntr < count; cntr++)
+    {
+        items[cntr].m_source = cntr;
+        status_of[cntr] = fit_licdb_check_license(&licenses[cntr]);
+        if (status_of[cntr] == FIT_STATUS_OK)
+            status_of[cntr] = fit_licenf_get_info_flat(&licenses[cntr], &info, NULL, &size);
+        if (status_of[cntr] != FIT_STATUS_OK)
+            continue;
+        memcpy(items[cntr].m_entry.m_uid, info.m_uid, FIT_UID_LEN);
+        items[cntr].m_entry.m_container_id = info.m_container_id;
+        items[cntr].m_entry.m_length = licenses[cntr].length;
+    }
+
+    // Sorted keys; licenses already in database or earlier in array are skipped.
+    qsort(items, count, sizeof(fit_licdb_item_t), fit_licdb_compare_items);
+    for (cntr = 0; cntr < count; cntr++)
+    {
+        fit_licdb_entry_t *entry = &items[cntr].m_entry;
+        uint32_t pos = 0;
+
+        if (status_of[items[cntr].m_source] != FIT_STATUS_OK)
+            continue;
+        if (memcmp(entry->m_uid, fit_licdb_no_uid, FIT_UID_LEN) == 0)
+        {
+            slot[items[cntr].m_source] = added;
+            items[added++] = items[cntr];
+            continue;
+        }
+        pos = fit_licdb_lower_bound(old, header.m_count, entry->m_uid, entry->m_container_id);
+        if ((pos < header.m_count &&
+             fit_licdb_compare(&old[pos], entry->m_uid, entry->m_container_id) == 0) ||
+            (added > 0 && fit_licdb_compare(&items[added - 1].m_entry, entry->m_uid,
+                entry->m_container_id) == 0))
+        {
+            status_of[items[cntr].m_source] = FIT_LICDB_DUPLICATE;
+            continue;
+        }
+        slot[items[cntr].m_source] = added;
+        items[added++] = items[cntr];
+    }
+
+    // License records in order of source array; offsets are set in sorted items.
+    offset = header.m_end;
+    writer.m_fd = fd;
+    writer.m_offset = header.m_end;
+    for (cntr = 0; cntr < count; cntr++)
+    {
+        fit_licdb_item_t *item = &items[slot[cntr]];
+
+        if (status_of[cntr] != FIT_STATUS_OK)
+            continue;
+        item->m_entry.m_offset = offset + sizeof(fit_licdb_record_t) + sizeof(fit_licdb_entry_t);
+        status = fit_licdb_put(&writer, FIT_LICDB_RECORD_LICENSE, &item->m_entry,
+            sizeof(fit_licdb_entry_t), licenses[cntr].data, licenses[cntr].length);
+        if (status != FIT_STATUS_OK)
+            goto bail;
+        offset += FIT_LICDB_RECORD_SIZE(sizeof(fit_licdb_entry_t) + licenses[cntr].length);
+    }
+
+    if (added > 0)
+    {
+        // New index merges old index and sorted new licenses; of licenses with same
+        // key (no UID) older ones come first.
+        while (from_old < header.m_count || from_new < added)
+        {
+            if (from_new == added ||
+                (from_old < header.m_count && fit_licdb_compare(&old[from_old],
+                    items[from_new].m_entry.m_uid, items[from_new].m_entry.m_container_id) <= 0))
+            {
+                index[total++] = old[from_old++];
+            }
+            else
+            {
+                index[total++] = items[from_new++].m_entry;
+            }
+        }
+        status = fit_licdb_put(&writer, FIT_LICDB_RECORD_INDEX, NULL, 0, index,
+            (size_t)total * sizeof(fit_licdb_entry_t));
+        if (status == FIT_STATUS_OK && writer.m_len > 0)
+            status = fit_licdb_write(fd, writer.m_buf, writer.m_len, writer.m_offset);
+        if (status != FIT_STATUS_OK)
+            goto bail;
+
+        header.m_count = total;
+        header.m_index = offset;
+        header.m_end = offset + FIT_LICDB_RECORD_SIZE((uint64_t)total * sizeof(fit_licdb_entry_t));
+    }
+
+    // Records must be on disk before header points to them.
+    if (fdatasync(fd) != 0 ||
+        fit_licdb_write(fd, (const uint8_t *)&header, sizeof(header), 0) != FIT_STATUS_OK ||
+        fdatasync(fd) != 0)
+    {
+        status = FIT_LICDB_IO_ERROR;
+        goto bail;
+    }
+    status = FIT_STATUS_OK;
+
+    if (results != NULL)
+        memcpy(results, status_of, (size_t)count * sizeof(fit_status_t));
+
+bail:
+    if (fd >= 0)
+        close(fd);
+    free(old);
+    free(index);
+    free(items);
+    free(status_of);
+    free(slot);
+    free(writer.m_buf);
+
+    return status;
+}
+
+#endif // #ifdef FIT_USE_LICENSE_DB
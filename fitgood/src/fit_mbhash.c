@@ -0,0 +1,466 @@
+/****************************************************************************\
+**
+** fit_mbhash.c
+**
+** Defines functionality for multi-buffer hash engine. Every lane hashes one
+** message; at each step next block of every busy lane is hashed by one AES call
+** for all lanes (see fit_aesni_encrypt_lanes). Lane that finished its message is
+** loaded with next one, so lanes stay busy till last messages. Results are same as
+** of fit_davies_meyer_hash and fit_get_AbreastDM_Hash.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifdef FIT_USE_MULTI_BUFFER_HASH
+
+/* Required Includes ********************************************************/
+#include <string.h>
+#include "fit_mbhash.h"
+#include "fit_aes.h"
+#include "fit_aesni.h"
+#include "abreast_dm.h"
+#include "dm_hash.h"
+#include "internal.h"
+#include "parser.h"
+#include "fit_debug.h"
+
+/* Constants ****************************************************************/
+
+// Number of licenses prepared at a time by fit_mb_hash_licenses.
+#define FIT_MB_GROUP                    32
+
+/* Types ********************************************************************/
+
+// State of one lane.
+typedef struct fit_mb_lane {
+    // Set while lane is hashing message m_msg.
+    uint8_t         m_busy;
+    uint32_t        m_msg;
+    // Complete blocks of message not yet hashed.
+    fit_pointer_t   m_data;
+    // Padded last block(s) of message (see fit_dm_hash_init), and position of next
+    // block in it.
+    uint8_t         m_tail[2*DM_CIPHER_BLOCK_SIZE];
+    uint8_t         m_tailpos;
+    uint8_t         m_taillen;
+    // Set once final step of davies meyer hash (H = AES (Hn, Hn) XOR Hn) is done.
+    uint8_t         m_final;
+    // Hash value (Hi for davies meyer, Gi || Hi for Abreast DM).
+    uint8_t         m_hash[FIT_MB_HASH_SIZE];
+} fit_mb_lane_t;
+
+/* Functions ****************************************************************/
+
+/**
+ *
+ * fit_mb_encrypt
+ *
+ * This function will encrypt one block per lane, each with its own key.
+ *
+ * @param   keylen --> Key length (AES_128_KEY_LENGTH or AES_256_KEY_LENGTH).
+ * @param   lanes --> Number of lanes.
+ * @param   keys --> Keys of lanes (AES_256_KEY_LENGTH bytes apart).
+ * @param   data <--> Plain data of lanes on entry, encrypted data on return.
+ *
+ */
+static fit_status_t fit_mb_encrypt(uint16_t keylen,
+                                   uint8_t lanes,
+                                   uint8_t keys[][AES_256_KEY_LENGTH],
+                                   uint8_t data[][AES_OUTPUT_DATA_SIZE])
+{
+    fit_status_t status = FIT_STATUS_OK;
+    uint8_t lane        = 0;
+
+#ifdef FIT_AESNI_AVAILABLE
+    if (fit_aesni_supported())
+    {
+        fit_aesni_encrypt_lanes(keylen, lanes, keys[0], data[0], data[0]);
+        return FIT_STATUS_OK;
+    }
+#endif // #ifdef FIT_AESNI_AVAILABLE
+
+    // No wide AES available; lanes are encrypted one after another.
+    for (lane = 0; lane < lanes && status == FIT_STATUS_OK; lane++)
+        status = aes_encrypt_key(keys[lane], keylen, data[lane], data[lane]);
+
+    return status;
+}
+
+/**
+ *
+ * fit_mb_lane_load
+ *
+ * This function will start hashing of message in lane. Last (incomplete) block of
+ * message is padded right away, so lane reads message data only once.
+ *
+ * @param   lane <-- Lane.
+ * @param   msg --> Message.
+ * @param   index --> Index of message.
+ *
+ */
+static void fit_mb_lane_load(fit_mb_lane_t *lane, fit_pointer_t *msg, uint32_t index)
+{
+    fit_pointer_t fitptr    = {0};
+    uint16_t length         = msg->length % DM_CIPHER_BLOCK_SIZE;
+
+    lane->m_busy = TRUE;
+    lane->m_msg = index;
+    lane->m_data = *msg;
+    lane->m_data.length = msg->length - length;
+
+    fitptr.read_byte = msg->read_byte;
+    fitptr.data = msg->data + lane->m_data.length;
+    fitptr.length = length;
+    fitptr_memcpy(lane->m_tail, &fitptr);
+    fit_dm_hash_init(lane->m_tail, &length, msg->length);
+    lane->m_taillen = (uint8_t)length;
+    lane->m_tailpos = 0;
+    lane->m_final = FALSE;
+
+    // Start hash with 0xFF
+    fit_memset(lane->m_hash, 0xFF, FIT_MB_HASH_SIZE);
+}
+
+/**
+ *
+ * fit_mb_lane_next
+ *
+ * This function will get next block to be hashed by lane. Returns FALSE once all
+ * blocks of message are hashed.
+ *
+ * @param   alg --> Hash algorithm. See enum fit_mb_hash_alg
+ * @param   lane <--> Lane.
+ * @param   block <-- On return it will contain next block.
+ *
+ */
+static uint8_t fit_mb_lane_next(uint8_t alg, fit_mb_lane_t *lane, uint8_t *block)
+{
+    fit_pointer_t fitptr = {0};
+
+    if (lane->m_data.length > 0)
+    {
+        fitptr.read_byte = lane->m_data.read_byte;
+        fitptr.data = lane->m_data.data;
+        fitptr.length = DM_CIPHER_BLOCK_SIZE;
+        fitptr_memcpy(block, &fitptr);
+        lane->m_data.data += DM_CIPHER_BLOCK_SIZE;
+        lane->m_data.length -= DM_CIPHER_BLOCK_SIZE;
+        return TRUE;
+    }
+    if (lane->m_tailpos < lane->m_taillen)
+    {
+        memcpy(block, lane->m_tail + lane->m_tailpos, DM_CIPHER_BLOCK_SIZE);
+        lane->m_tailpos += DM_CIPHER_BLOCK_SIZE;
+        return TRUE;
+    }
+    if (alg == FIT_MB_HASH_DM && lane->m_final == FALSE)
+    {
+        // The final Hash is calculated as: H = AES (Hn, Hn) XOR Hn
+        memcpy(block, lane->m_hash, DM_CIPHER_BLOCK_SIZE);
+        lane->m_final = TRUE;
+        return TRUE;
+    }
+
+    return FALSE;
+}
+
+/**
+ *
+ * fit_mb_step
+ *
+ * This function will hash one block in each of busy lanes.
+ *
+ * @param   alg --> Hash algorithm. See enum fit_mb_hash_alg
+ * @param   lanes <--> Busy lanes.
+ * @param   count --> Number of busy lanes.
+ * @param   blocks --> Block to be hashed by each of busy lanes.
+ *
+ */
+static fit_status_t fit_mb_step(uint8_t alg,
+                                fit_mb_lane_t **lanes,
+                                uint8_t count,
+                                uint8_t blocks[][DM_CIPHER_BLOCK_SIZE])
+{
+    fit_status_t status = FIT_STATUS_OK;
+    uint8_t keys[FIT_MB_LANES][AES_256_KEY_LENGTH];
+    uint8_t data[FIT_MB_LANES][AES_OUTPUT_DATA_SIZE];
+    uint8_t lane        = 0;
+    uint8_t cntr        = 0;
+
+    if (alg == FIT_MB_HASH_DM)
+    {
+        // Hi = AES (Hi-1, mi) XOR Hi-1
+        for (lane = 0; lane < count; lane++)
+        {
+            memcpy(keys[lane], blocks[lane], DM_CIPHER_BLOCK_SIZE);
+            memcpy(data[lane], lanes[lane]->m_hash, DM_CIPHER_BLOCK_SIZE);
+        }
+        status = fit_mb_encrypt(AES_128_KEY_LENGTH, count, keys, data);
+        for (lane = 0; lane < count; lane++)
+            for (cntr = 0; cntr < DM_CIPHER_BLOCK_SIZE; cntr++)
+                lanes[lane]->m_hash[cntr] ^= data[lane][cntr];
+
+        return status;
+    }
+
+    // Gi = Gi-1 XOR AES(Gi-1 || Hi-1Mi)
+    for (lane = 0; lane < count; lane++)
+    {
+        memcpy(keys[lane], lanes[lane]->m_hash + 16, 16);
+        memcpy(keys[lane] + 16, blocks[lane], 16);
+        memcpy(data[lane], lanes[lane]->m_hash, 16);
+    }
+    status = fit_mb_encrypt(AES_256_KEY_LENGTH, count, keys, data);
+    if (status != FIT_STATUS_OK)
+        return status;
+    for (lane = 0; lane < count; lane++)
+        for (cntr = 0; cntr < 16; cntr++)
+            lanes[lane]->m_hash[cntr] ^= data[lane][cntr];
+
+    // Hi = Hi-1 XOR AES(~ Hi-1 || Mi Gi-1)
+    for (lane = 0; lane < count; lane++)
+    {
+        memcpy(keys[lane], blocks[lane], 16);
+        memcpy(keys[lane] + 16, lanes[lane]->m_hash, 16);
+        for (cntr = 0; cntr < 16; cntr++)
+            data[lane][cntr] = lanes[lane]->m_hash[cntr + 16] ^ 0xFF;
+    }
+    status = fit_mb_encrypt(AES_256_KEY_LENGTH, count, keys, data);
+    for (lane = 0; lane < count; lane++)
+        for (cntr = 0; cntr < 16; cntr++)
+            lanes[lane]->m_hash[cntr + 16] ^= data[lane][cntr];
+
+    return status;
+}
+
+/**
+ *
+ * fit_mb_hash
+ *
+ * This function will calculate davies meyer or Abreast DM hash of number of
+ * messages, FIT_MB_LANES messages at a time. Messages may have different lengths.
+ *
+ * @param   alg --> Hash algorithm. See enum fit_mb_hash_alg
+ * @param   msgs --> Array of messages. Messages with read_byte set to NULL are
+ *                   skipped (their hash is not written).
+ * @param   count --> Number of messages in above array.
+ * @param   hashes <-- On return it will contain hash of each message; hash of
+ *                     message n starts at hashes + n*(hash size).
+ *
+ */
+fit_status_t fit_mb_hash(uint8_t alg,
+                         fit_pointer_t *msgs,
+                         uint32_t count,
+                         uint8_t *hashes)
+{
+    fit_status_t status                 = FIT_STATUS_OK;
+    fit_mb_lane_t lanes[FIT_MB_LANES];
+    fit_mb_lane_t *busy[FIT_MB_LANES];
+    uint8_t blocks[FIT_MB_LANES][DM_CIPHER_BLOCK_SIZE];
+    uint16_t size                       = 0;
+    uint32_t next                       = 0;
+    uint8_t nbusy                       = 0;
+    uint8_t lane                        = 0;
+
+    if (alg == FIT_MB_HASH_DM)
+        size = FIT_DM_HASH_SIZE;
+    else if (alg == FIT_MB_HASH_ABREAST_DM)
+        size = FIT_MB_HASH_SIZE;
+    else
+        return FIT_INVALID_PARAM_1;
+
+    fit_memset((uint8_t *)lanes, 0, sizeof(lanes));
+
+    do
+    {
+        // Get next block of every lane; lane that is done takes next message.
+        nbusy = 0;
+        for (lane = 0; lane < FIT_MB_LANES; lane++)
+        {
+            fit_mb_lane_t *current = &lanes[lane];
+
+            while (current->m_busy != TRUE ||
+                   fit_mb_lane_next(alg, current, blocks[nbusy]) != TRUE)
+            {
+                if (current->m_busy == TRUE)
+                {
+                    if (alg == FIT_MB_HASH_ABREAST_DM)
+                        AES256_AbreastDmHash_Finalize(current->m_hash);
+                    fit_memcpy(hashes + current->m_msg*size, current->m_hash, size);
+                    current->m_busy = FALSE;
+                }
+
+                while (next < count && msgs[next].read_byte == NULL)
+                    next++;
+                if (next == count)
+                    break;
+                fit_mb_lane_load(current, &msgs[next], next);
+                next++;
+            }
+            if (current->m_busy == TRUE)
+                busy[nbusy++] = current;
+        }
+
+        if (nbusy > 0)
+            status = fit_mb_step(alg, busy, nbusy, blocks);
+    } while (nbusy > 0 && status == FIT_STATUS_OK);
+
+    return status;
+}
+
+/**
+ *
+ * fit_mb_within
+ *
+ * This function will check whether part of license lies within license data.
+ *
+ * @param   license --> License of type fit_pointer_t.
+ * @param   part --> Part of license (read_byte NULL if there is none).
+ *
+ */
+static uint8_t fit_mb_within(const fit_pointer_t *license, const fit_pointer_t *part)
+{
+    if (part->read_byte == NULL)
+        return TRUE;
+
+    return (uint8_t)((part->data >= license->data &&
+        part->data + part->length <= license->data + license->length) ? TRUE : FALSE);
+}
+
+/**
+ *
+ * fit_mb_hash_licenses
+ *
+ * This function will calculate, for number of licenses, hashes that are needed
+ * for their validation (see fit_check_license_validation): Abreast DM hash of part
+ * covered by signature and davies meyer hash of license data. Hashes are then
+ * passed to validation by fit_ctx_set_hashes. Parts that do not lie within license
+ * (malformed license) are not hashed.
+ *
+ * @param   licenses --> Array of licenses of type fit_pointer_t.
+ * @param   count --> Number of licenses in above array.
+ * @param   hashes <-- Array of count elements that will contain hashes of each
+ *                     license.
+ *
+ */
+fit_status_t fit_mb_hash_licenses(fit_pointer_t *licenses,
+                                  uint32_t count,
+                                  fit_mb_license_hashes_t *hashes)
+{
+    fit_status_t status     = FIT_STATUS_OK;
+    fit_status_t parsed     = FIT_STATUS_OK;
+    fitcontextdata context;
+    fit_pointer_t signature = {0};
+    fit_pointer_t msgs[FIT_MB_GROUP];
+    uint8_t out[FIT_MB_GROUP*FIT_MB_HASH_SIZE];
+    uint32_t first          = 0;
+    uint32_t cntr           = 0;
+    uint32_t n              = 0;
+#if defined(FIT_USE_SEGMENTED_HASH) || defined(FIT_USE_ED25519) || defined(FIT_USE_SHA256_DIGEST)
+    uint8_t algid           = AES_ALGID;
+#endif
+
+    for (first = 0; first < count && status == FIT_STATUS_OK; first += n)
+    {
+        n = (count - first > FIT_MB_GROUP) ? FIT_MB_GROUP : count - first;
+
+        for (cntr = 0; cntr < n; cntr++)
+        {
+            fit_mb_license_hashes_t *license = &hashes[first + cntr];
+
+            fit_memset((uint8_t *)license, 0, sizeof(fit_mb_license_hashes_t));
+
+            // Licenses that fail here fail validation too; validation then reports
+            // the error.
+            if (fit_get_signed_data(&licenses[first + cntr], &license->m_signed, &signature) != FIT_STATUS_OK)
+                license->m_signed.read_byte = NULL;
+#if defined(FIT_USE_SEGMENTED_HASH) || defined(FIT_USE_ED25519) || defined(FIT_USE_SHA256_DIGEST)
+            else if (fit_get_signature_algid(&licenses[first + cntr], &algid) != FIT_STATUS_OK ||
+                algid != AES_ALGID)
+            {
+                license->m_signed.read_byte = NULL;
+            }
+#endif
+
+            fit_memset((uint8_t *)&context, 0, sizeof(context));
+            context.m_level = STRUCT_V2C_LEVEL;
+            context.m_index = LICENSE_FIELD;
+            context.m_operation = (uint8_t)FIT_PARSE_LICENSE;
+            parsed = fit_parse_object(STRUCT_V2C_LEVEL, LICENSE_FIELD, &licenses[first + cntr], &context);
+            if (parsed == FIT_STATUS_OK || parsed == FIT_STOP_PARSE)
+            {
+                license->m_license.read_byte = licenses[first + cntr].read_byte;
+                license->m_license.data = licenses[first + cntr].data;
+                license->m_license.length = context.m_length;
+            }
+            if (fit_mb_within(&licenses[first + cntr], &license->m_signed) != TRUE)
+                license->m_signed.read_byte = NULL;
+            if (fit_mb_within(&licenses[first + cntr], &license->m_license) != TRUE)
+                license->m_license.read_byte = NULL;
+            msgs[cntr] = license->m_signed;
+        }
+
+        status = fit_mb_hash(FIT_MB_HASH_ABREAST_DM, msgs, n, out);
+        if (status != FIT_STATUS_OK)
+            break;
+        for (cntr = 0; cntr < n; cntr++)
+        {
+            fit_memcpy(hashes[first + cntr].m_abreast, out + cntr*FIT_MB_HASH_SIZE, FIT_MB_HASH_SIZE);
+            msgs[cntr] = hashes[first + cntr].m_license;
+        }
+
+        status = fit_mb_hash(FIT_MB_HASH_DM, msgs, n, out);
+        for (cntr = 0; cntr < n && status == FIT_STATUS_OK; cntr++)
+            fit_memcpy(hashes[first + cntr].m_dm, out + cntr*FIT_DM_HASH_SIZE, FIT_DM_HASH_SIZE);
+    }
+
+    if (status != FIT_STATUS_OK)
+    {
+        DBG(FIT_TRACE_ERROR, "[fit_mb_hash_licenses]: failed with status %d\n", status);
+    }
+
+    return status;
+}
+
+/**
+ *
+ * fit_mb_hash_lookup
+ *
+ * This function will look up hash of data in hashes calculated ahead of license
+ * validation. Returns TRUE if hash was found; hash is then copied out.
+ *
+ * @param   hashes --> Hashes of license being validated (can be NULL).
+ * @param   alg --> Hash algorithm. See enum fit_mb_hash_alg
+ * @param   data --> Data whose hash is needed.
+ * @param   hash <-- On return it will contain the hash value (if found).
+ *
+ */
+uint8_t fit_mb_hash_lookup(const fit_mb_license_hashes_t *hashes,
+                           uint8_t alg,
+                           fit_pointer_t *data,
+                           uint8_t *hash)
+{
+    const fit_pointer_t *part = NULL;
+
+    if (hashes == NULL)
+        return FALSE;
+
+    part = (alg == FIT_MB_HASH_ABREAST_DM) ? &hashes->m_signed : &hashes->m_license;
+    if (part->read_byte == NULL ||
+        part->read_byte != data->read_byte ||
+        part->data != data->data ||
+        part->length != data->length)
+    {
+        return FALSE;
+    }
+
+    if (alg == FIT_MB_HASH_ABREAST_DM)
+        fit_memcpy(hash, (uint8_t *)hashes->m_abreast, FIT_MB_HASH_SIZE);
+    else
+        fit_memcpy(hash, (uint8_t *)hashes->m_dm, FIT_DM_HASH_SIZE);
+
+    return TRUE;
+}
+
+#endif // #ifdef FIT_USE_MULTI_BUFFER_HASH
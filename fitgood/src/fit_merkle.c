@@ -0,0 +1,379 @@
+/****************************************************************************\
+**
+** fit_merkle.c
+**
+** Defines functionality for segmented (Merkle) license hashing. License part
+** covered by signature is divided into FIT_MERKLE_SEGMENT_SIZE byte segments.
+** Abreast DM hash of each segment is carried in the license (signature structure)
+** and the signed value is root of binary hash tree over these segment hashes.
+** Segment (leaf) hash is Abreast DM hash of FIT_MERKLE_LEAF_PREFIX byte followed
+** by segment data; tree node is Abreast DM hash of FIT_MERKLE_NODE_PREFIX byte
+** followed by its two children (64 bytes). Last node at any level without sibling
+** is moved to next level unchanged. Prefixes keep leaf and node hashes apart, also
+** for segment of exactly two hash sizes.
+**
+** Segment hashes of verified license are kept in FIT core context. Only license
+** read function used while tracking reads (fit_merkle_read_byte) has no context
+** parameter; it finds tracking state by fit_merkle_tracked, which is thread local
+** if contexts are used by concurrent threads (FIT_USE_CONCURRENT_CTX, implied by
+** batch validation and shared cache). Otherwise tracking must not be done by two
+** tasks at the same time.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifdef FIT_USE_SEGMENTED_HASH
+
+/* Required Includes ********************************************************/
+#include "fit_merkle.h"
+#include "parser.h"
+#include "internal.h"
+#include "hwdep.h"
+#include "fit_debug.h"
+#include "abreast_dm.h"
+
+/* Constants ****************************************************************/
+
+// Storage class of tracking state; concurrent contexts track reads in several
+// threads at the same time.
+#ifdef FIT_USE_CONCURRENT_CTX
+#ifdef _MSC_VER
+#define FIT_MERKLE_LOCAL        __declspec(thread)
+#else
+#define FIT_MERKLE_LOCAL        __thread
+#endif
+#else
+#define FIT_MERKLE_LOCAL
+#endif
+
+/* Global Data **************************************************************/
+
+// Segment hashes whose reads are being tracked; NULL if tracking is not active.
+static FIT_MERKLE_LOCAL fit_merkle_data_t *fit_merkle_tracked = NULL;
+
+/* Functions ****************************************************************/
+
+/**
+ *
+ * fit_merkle_get_leaves
+ *
+ * This function will get the segment hashes from the license binary and check their
+ * number against length of license part.
+ *
+ * @param   license --> Pointer to license data.
+ * @param   licpart --> License part covered by signature.
+ * @param   leaves <-- On return it will contain segment hashes.
+ *
+ */
+static fit_status_t fit_merkle_get_leaves(fit_pointer_t *license,
+                                          fit_pointer_t *licpart,
+                                          fit_pointer_t *leaves)
+{
+    fit_status_t status     = FIT_STATUS_OK;
+    fitcontextdata context  = {0};
+    uint16_t segments       = 0;
+
+    context.m_level = STRUCT_SIGNATURE_LEVEL;
+    context.m_index = SEGMENT_HASH_FIELD;
+    context.m_operation = (uint8_t)FIT_GET_DATA_ADDRESS;
+    status = fit_parse_object(STRUCT_V2C_LEVEL, LICENSE_FIELD, license, &context);
+    if (!(status == FIT_STATUS_OK || status == FIT_STOP_PARSE))
+        return status;
+    if (context.mparserdata.m_addr == NULL)
+        return FIT_INVALID_V2C;
+
+    leaves->read_byte = license->read_byte;
+    leaves->data = context.mparserdata.m_addr;
+    leaves->length = (uint16_t)read_dword(leaves->data - PSTRING_SIZE, license->read_byte);
+
+    // There should be exactly one hash for each segment of license part.
+    segments = (uint16_t)((licpart->length + FIT_MERKLE_SEGMENT_SIZE - 1)/FIT_MERKLE_SEGMENT_SIZE);
+    if (segments == 0 || segments > FIT_MERKLE_MAX_SEGMENTS ||
+        leaves->length != segments*FIT_MERKLE_HASH_SIZE)
+    {
+        DBG(FIT_TRACE_ERROR, "[fit_merkle_get_leaves]: invalid number of segment hashes\n");
+        return FIT_INVALID_FIELD_LEN;
+    }
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_merkle_hash
+ *
+ * This function will calculate Abreast DM hash of prefix byte followed by data.
+ *
+ * @param   prefix --> FIT_MERKLE_LEAF_PREFIX or FIT_MERKLE_NODE_PREFIX.
+ * @param   data --> Data to be hashed.
+ * @param   hash <-- On return it will contain the hash. Can overlap data, as hash
+ *                   is written after all data is read.
+ *
+ */
+static void fit_merkle_hash(uint8_t prefix, fit_pointer_t *data, uint8_t *hash)
+{
+    fit_abreast_dm_ctx_t ctx;
+    fit_pointer_t fitptr    = {0};
+
+    fitptr.read_byte = (fit_read_byte_callback_t)READ_BYTE_RAM;
+    fitptr.data = &prefix;
+    fitptr.length = 1;
+
+    fit_abreast_dm_start(&ctx);
+    fit_abreast_dm_update(&ctx, &fitptr);
+    fit_abreast_dm_update(&ctx, data);
+    fit_abreast_dm_final(&ctx, hash);
+}
+
+/**
+ *
+ * fit_merkle_hash_node
+ *
+ * This function will calculate hash tree node from its two children.
+ *
+ * @param   left <--> Left child; buffer of twice the hash size. On return first half
+ *                    will contain the node hash.
+ * @param   right --> Right child.
+ *
+ */
+static void fit_merkle_hash_node(uint8_t *left, uint8_t *right)
+{
+    fit_pointer_t node = {0};
+
+    fit_memcpy(left + FIT_MERKLE_HASH_SIZE, right, FIT_MERKLE_HASH_SIZE);
+    node.read_byte = (fit_read_byte_callback_t)READ_BYTE_RAM;
+    node.data = left;
+    node.length = 2*FIT_MERKLE_HASH_SIZE;
+    fit_merkle_hash(FIT_MERKLE_NODE_PREFIX, &node, left);
+}
+
+/**
+ *
+ * fit_merkle_get_root
+ *
+ * This function will calculate root of hash tree over segment hashes present in
+ * license. Tree is calculated bottom up with a stack holding at most one pending
+ * node per tree level. License part and segment hashes are remembered, so segments
+ * can be verified later by fit_merkle_verify_range.
+ *
+ * @param   merkle <-- Segment hashes state of FIT core context.
+ * @param   license --> Pointer to license data.
+ * @param   licpart --> License part covered by signature (see fit_get_signed_data).
+ * @param   root <-- On return it will contain root of hash tree.
+ *
+ */
+fit_status_t fit_merkle_get_root(fit_merkle_data_t *merkle,
+                                 fit_pointer_t *license,
+                                 fit_pointer_t *licpart,
+                                 uint8_t *root)
+{
+    fit_status_t status                                         = FIT_STATUS_OK;
+    uint8_t stack[FIT_MERKLE_MAX_DEPTH][2*FIT_MERKLE_HASH_SIZE] = {{0}};
+    uint8_t height[FIT_MERKLE_MAX_DEPTH]                        = {0};
+    uint8_t top                                                 = 0;
+    uint16_t cntr                                               = 0;
+    fit_pointer_t leaves                                        = {0};
+    fit_pointer_t fitptr                                        = {0};
+
+    fit_memset((uint8_t *)merkle, 0, sizeof(fit_merkle_data_t));
+
+    status = fit_merkle_get_leaves(license, licpart, &leaves);
+    if (status != FIT_STATUS_OK)
+        return status;
+
+    fitptr.read_byte = leaves.read_byte;
+    fitptr.length = FIT_MERKLE_HASH_SIZE;
+
+    for (cntr = 0; cntr < leaves.length; cntr += FIT_MERKLE_HASH_SIZE)
+    {
+        // Push segment hash; stack entry holds node in its first half.
+        fitptr.data = leaves.data + cntr;
+        fitptr_memcpy(stack[top], &fitptr);
+        height[top++] = 0;
+
+        // Combine two topmost nodes while they are at same height.
+        while (top > 1 && height[top-1] == height[top-2])
+        {
+            fit_merkle_hash_node(stack[top-2], stack[top-1]);
+            height[top-2]++;
+            top--;
+        }
+    }
+
+    // Combine remaining nodes from right to left i.e. nodes without sibling are
+    // moved up unchanged.
+    while (top > 1)
+    {
+        fit_merkle_hash_node(stack[top-2], stack[top-1]);
+        top--;
+    }
+    fit_memcpy(root, stack[0], FIT_MERKLE_HASH_SIZE);
+
+    merkle->m_licpart = *licpart;
+    merkle->m_leaves = leaves;
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_merkle_verify_segment
+ *
+ * This function will calculate hash of license segment and compare it with segment
+ * hash present in license.
+ *
+ * @param   merkle --> Segment hashes state of FIT core context.
+ * @param   segment --> Index of segment to be verified.
+ *
+ */
+static fit_status_t fit_merkle_verify_segment(fit_merkle_data_t *merkle, uint16_t segment)
+{
+    uint8_t hash[FIT_MERKLE_HASH_SIZE]  = {0};
+    uint8_t leaf[FIT_MERKLE_HASH_SIZE]  = {0};
+    uint16_t offset                     = segment*FIT_MERKLE_SEGMENT_SIZE;
+    fit_pointer_t fitptr                = {0};
+
+    fitptr.read_byte = merkle->m_licpart.read_byte;
+    fitptr.data = merkle->m_licpart.data + offset;
+    fitptr.length = merkle->m_licpart.length - offset;
+    if (fitptr.length > FIT_MERKLE_SEGMENT_SIZE)
+        fitptr.length = FIT_MERKLE_SEGMENT_SIZE;
+    fit_merkle_hash(FIT_MERKLE_LEAF_PREFIX, &fitptr, hash);
+
+    fitptr.read_byte = merkle->m_leaves.read_byte;
+    fitptr.data = merkle->m_leaves.data + segment*FIT_MERKLE_HASH_SIZE;
+    fitptr.length = FIT_MERKLE_HASH_SIZE;
+    fitptr_memcpy(leaf, &fitptr);
+
+    if (fit_memcmp(hash, leaf, FIT_MERKLE_HASH_SIZE) != 0)
+    {
+        DBG(FIT_TRACE_ERROR, "[fit_merkle_verify_segment]: segment %d modified\n", segment);
+        return FIT_INVALID_V2C;
+    }
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_merkle_verify_range
+ *
+ * This function will verify all license segments that cover the data range passed
+ * in. Data outside of license part covered by signature is ignored. Should be called
+ * after fit_merkle_get_root and root is verified against the signature.
+ *
+ * @param   merkle --> Segment hashes state of FIT core context.
+ * @param   data --> Start address of data range (address within license).
+ * @param   length --> Length of data range.
+ *
+ */
+fit_status_t fit_merkle_verify_range(fit_merkle_data_t *merkle,
+                                     uint8_t *data,
+                                     uint16_t length)
+{
+    fit_status_t status = FIT_STATUS_OK;
+    uint8_t *start      = merkle->m_licpart.data;
+    uint8_t *end        = merkle->m_licpart.data + merkle->m_licpart.length;
+    uint16_t first      = 0;
+    uint16_t last       = 0;
+
+    if (start == NULL)
+        return FIT_INVALID_V2C;
+    if (length == 0 || data >= end || data + length <= start)
+        return FIT_STATUS_OK;
+
+    if (data < start)
+    {
+        length = (uint16_t)(length - (start - data));
+        data = start;
+    }
+    if (data + length > end)
+        length = (uint16_t)(end - data);
+
+    first = (uint16_t)((data - start)/FIT_MERKLE_SEGMENT_SIZE);
+    last = (uint16_t)((data - start + length - 1)/FIT_MERKLE_SEGMENT_SIZE);
+    for (; first <= last && status == FIT_STATUS_OK; first++)
+        status = fit_merkle_verify_segment(merkle, first);
+
+    return status;
+}
+
+/**
+ *
+ * fit_merkle_read_byte
+ *
+ * Read function used while tracking. It will mark the segment containing the address
+ * as read and then read the byte by license read function.
+ *
+ * @param   address --> Address of byte to be read.
+ *
+ */
+static uint8_t fit_merkle_read_byte(const void *address)
+{
+    fit_merkle_data_t *merkle   = fit_merkle_tracked;
+    const uint8_t *addr         = (const uint8_t *)address;
+    uint16_t segment            = 0;
+
+    if (addr >= merkle->m_licpart.data &&
+        addr < merkle->m_licpart.data + merkle->m_licpart.length)
+    {
+        segment = (uint16_t)((addr - merkle->m_licpart.data)/FIT_MERKLE_SEGMENT_SIZE);
+        merkle->m_touched[segment/8] |= (uint8_t)(1 << (segment%8));
+    }
+
+    return merkle->m_read_byte(address);
+}
+
+/**
+ *
+ * fit_merkle_track_start
+ *
+ * This function will start tracking of license reads. All reads done through tracked
+ * license pointer are recorded, so fit_merkle_track_verify can authenticate only the
+ * segments that were actually read. Should be called after license root is verified.
+ * Tracking ends with fit_merkle_track_verify; only one tracking can be active.
+ *
+ * @param   merkle <--> Segment hashes state of FIT core context.
+ * @param   license --> Pointer to license data.
+ * @param   tracked <-- On return it will contain license pointer to be used for reads.
+ *
+ */
+void fit_merkle_track_start(fit_merkle_data_t *merkle,
+                            fit_pointer_t *license,
+                            fit_pointer_t *tracked)
+{
+    fit_memset(merkle->m_touched, 0, sizeof(merkle->m_touched));
+    merkle->m_read_byte = license->read_byte;
+    fit_merkle_tracked = merkle;
+
+    *tracked = *license;
+    tracked->read_byte = fit_merkle_read_byte;
+}
+
+/**
+ *
+ * fit_merkle_track_verify
+ *
+ * This function will verify all license segments read since fit_merkle_track_start
+ * and end the tracking.
+ *
+ * @param   merkle --> Segment hashes state passed to fit_merkle_track_start.
+ *
+ */
+fit_status_t fit_merkle_track_verify(fit_merkle_data_t *merkle)
+{
+    fit_status_t status = FIT_STATUS_OK;
+    uint16_t segment    = 0;
+
+    fit_merkle_tracked = NULL;
+    for (segment = 0; segment < FIT_MERKLE_MAX_SEGMENTS && status == FIT_STATUS_OK; segment++)
+    {
+        if (merkle->m_touched[segment/8] & (1 << (segment%8)))
+            status = fit_merkle_verify_segment(merkle, segment);
+    }
+
+    return status;
+}
+
+#endif // #ifdef FIT_USE_SEGMENTED_HASH
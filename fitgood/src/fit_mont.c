@@ -0,0 +1,537 @@
+/****************************************************************************\
+**
+** fit_mont.c
+**
+** Defines functionality for fixed size Montgomery arithmetic used by rsa public
+** operation with small public exponent. All numbers are FIT_MONT_LIMBS limbs long
+** (least significant limb first) and kept in stack buffers, so no memory is
+** allocated and no exponentiation window table is used (compare with
+** mbedtls_mpi_exp_mod). Public operation only; code is not constant time.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+/* Required Includes ********************************************************/
+#include "fit_mont.h"
+
+#ifdef FIT_MONT_AVAILABLE
+
+#include "fit_rsa.h"
+#include "internal.h"
+#include "fit_debug.h"
+#ifdef FIT_MONT_MULX_AVAILABLE
+#include "hwdep.h"
+#include <cpuid.h>
+#endif
+
+/* Constants ****************************************************************/
+
+// Number of bits in limb.
+#define FIT_MONT_LIMB_BITS      (sizeof(mbedtls_mpi_uint) << 3)
+
+#if FIT_MONT_SIZE != RSA_SIG_SIZE
+#error "FIT_MONT_SIZE should be same as RSA_SIG_SIZE"
+#endif
+
+// R = 2^(FIT_MONT_SIZE*8); R^2 mod N is derived by repeated squaring of powers of
+// two (see fit_mont_rr), which requires length of modulus to be power of two.
+#if (FIT_MONT_SIZE & (FIT_MONT_SIZE - 1)) != 0
+#error "FIT_MONT_SIZE should be power of two"
+#endif
+
+// Number of doublings of R mod N done before squarings in fit_mont_rr; doubling is
+// much cheaper than Montgomery squaring.
+#define FIT_MONT_RR_SHIFT       64
+
+/* Types ********************************************************************/
+
+// Multiply-accumulate kernel: t[0..len-1] += a[0..len-1] * b, returns carry limb.
+typedef mbedtls_mpi_uint (*fit_mont_muladd_t)(mbedtls_mpi_uint *t,
+                                              const mbedtls_mpi_uint *a,
+                                              mbedtls_mpi_uint b,
+                                              uint16_t len);
+
+/* Global Data **************************************************************/
+
+#ifdef FIT_MONT_MULX_AVAILABLE
+// Result of processor feature check; 0xFF till not checked.
+static uint8_t fit_mont_mulx_state = 0xFF;
+// TRUE if tuned kernel is turned off by fit_mont_use_asm.
+static uint8_t fit_mont_mulx_off = FALSE;
+#endif
+
+/* Functions ****************************************************************/
+
+/**
+ *
+ * fit_mont_init
+ *
+ * This function will calculate -N^-1 mod 2^FIT_MONT_LIMB_BITS (Newton iteration,
+ * see mpi_montg_init of mbedtls).
+ *
+ * @param   n0 --> Least significant limb of modulus (odd).
+ *
+ */
+static mbedtls_mpi_uint fit_mont_init(mbedtls_mpi_uint n0)
+{
+    mbedtls_mpi_uint x  = n0;
+    uint16_t cntr       = 0;
+
+    x += ((n0 + 2) & 4) << 1;
+    for (cntr = FIT_MONT_LIMB_BITS; cntr >= 8; cntr /= 2)
+        x *= (2 - (n0 * x));
+
+    return ~x + 1;
+}
+
+/**
+ *
+ * fit_mont_sub
+ *
+ * This function will subtract modulus from number (d = d - n) and return borrow.
+ *
+ * @param   d <--> Number to be reduced.
+ * @param   n --> Modulus.
+ *
+ */
+static mbedtls_mpi_uint fit_mont_sub(mbedtls_mpi_uint *d, const mbedtls_mpi_uint *n)
+{
+    mbedtls_mpi_uint borrow = 0;
+    mbedtls_mpi_uint t      = 0;
+    uint16_t cntr           = 0;
+
+    for (cntr = 0; cntr < FIT_MONT_LIMBS; cntr++)
+    {
+        t = d[cntr] - borrow;
+        borrow = (t > d[cntr]);
+        borrow += (t < n[cntr]);
+        d[cntr] = t - n[cntr];
+    }
+
+    return borrow;
+}
+
+/**
+ *
+ * fit_mont_ge
+ *
+ * This function will return TRUE if number is greater than or equal to modulus.
+ *
+ * @param   a --> Number to be compared.
+ * @param   n --> Modulus.
+ *
+ */
+static uint8_t fit_mont_ge(const mbedtls_mpi_uint *a, const mbedtls_mpi_uint *n)
+{
+    uint16_t cntr = FIT_MONT_LIMBS;
+
+    while (cntr-- > 0)
+    {
+        if (a[cntr] != n[cntr])
+            return (uint8_t)(a[cntr] > n[cntr]);
+    }
+
+    return TRUE;
+}
+
+/**
+ *
+ * fit_mont_muladd
+ *
+ * Portable kernel: t[0..len-1] += a[0..len-1] * b. Returns carry limb.
+ *
+ * @param   t <--> Accumulator.
+ * @param   a --> Multiplicand.
+ * @param   b --> Multiplier limb.
+ * @param   len --> Number of limbs of a.
+ *
+ */
+static mbedtls_mpi_uint fit_mont_muladd(mbedtls_mpi_uint *t,
+                                        const mbedtls_mpi_uint *a,
+                                        mbedtls_mpi_uint b,
+                                        uint16_t len)
+{
+    mbedtls_t_udbl r        = 0;
+    mbedtls_mpi_uint carry  = 0;
+    uint16_t j              = 0;
+
+    for (j = 0; j < len; j++)
+    {
+        r = (mbedtls_t_udbl)a[j] * b + t[j] + carry;
+        t[j] = (mbedtls_mpi_uint)r;
+        carry = (mbedtls_mpi_uint)(r >> FIT_MONT_LIMB_BITS);
+    }
+
+    return carry;
+}
+
+#ifdef FIT_MONT_MULX_AVAILABLE
+
+/**
+ *
+ * fit_mont_muladd_mulx
+ *
+ * x86-64 kernel using MULX (BMI2) and two independent carry chains ADCX/ADOX
+ * (ADX): CF chain adds low product halves, OF chain adds high halves of previous
+ * limb. Loop control uses LEA/JRCXZ only, which do not change flags.
+ *
+ */
+static mbedtls_mpi_uint fit_mont_muladd_mulx(mbedtls_mpi_uint *t,
+                                             const mbedtls_mpi_uint *a,
+                                             mbedtls_mpi_uint b,
+                                             uint16_t len)
+{
+    mbedtls_mpi_uint carry  = 0;
+    uint64_t cnt            = len;
+
+    __asm__ volatile (
+        "xorl   %%r8d, %%r8d            \n\t"   // clears CF and OF
+        "1:                             \n\t"
+        "jrcxz  2f                      \n\t"
+        "movq   (%[t]), %%r8            \n\t"
+        "mulxq  (%[a]), %%r9, %%r10     \n\t"   // r10:r9 = a[j] * b
+        "adcxq  %%r9, %%r8              \n\t"
+        "adoxq  %[c], %%r8              \n\t"
+        "movq   %%r8, (%[t])            \n\t"
+        "movq   %%r10, %[c]             \n\t"
+        "leaq   8(%[t]), %[t]           \n\t"
+        "leaq   8(%[a]), %[a]           \n\t"
+        "leaq   -1(%%rcx), %%rcx        \n\t"
+        "jmp    1b                      \n\t"
+        "2:                             \n\t"
+        "movl   $0, %%r8d               \n\t"
+        "adcxq  %%r8, %[c]              \n\t"
+        "adoxq  %%r8, %[c]              \n\t"
+        : [t] "+r" (t), [a] "+r" (a), [c] "+r" (carry), "+c" (cnt)
+        : "d" (b)
+        : "r8", "r9", "r10", "cc", "memory");
+
+    return carry;
+}
+
+/**
+ *
+ * fit_mont_mulx_supported
+ *
+ * This function will check (once) whether processor supports BMI2 and ADX
+ * instructions (CPUID.(EAX=07H,ECX=0):EBX bits 8 and 19).
+ *
+ */
+static uint8_t fit_mont_mulx_supported(void)
+{
+    uint8_t state = FIT_CPU_STATE_LOAD(&fit_mont_mulx_state);
+    unsigned int a = 0, b = 0, c = 0, d = 0;
+
+    if (state == 0xFF)
+    {
+        state = FALSE;
+        if (__get_cpuid_count(7, 0, &a, &b, &c, &d) &&
+            (b & (1UL << 8)) != 0 && (b & (1UL << 19)) != 0)
+        {
+            state = TRUE;
+        }
+        FIT_CPU_STATE_STORE(&fit_mont_mulx_state, state);
+    }
+
+    return state;
+}
+
+#endif // #ifdef FIT_MONT_MULX_AVAILABLE
+
+// Kernel used by fit_mont_mul and fit_mont_sqr.
+#if defined(FIT_MONT_MULX_AVAILABLE)
+#define FIT_MONT_MULADD         ((fit_mont_mulx_supported() && \
+                                  !FIT_CPU_STATE_LOAD(&fit_mont_mulx_off)) ? \
+                                 fit_mont_muladd_mulx : fit_mont_muladd)
+#else
+#define FIT_MONT_MULADD         fit_mont_muladd
+#endif
+
+/**
+ *
+ * fit_mont_reduce
+ *
+ * This function will perform Montgomery reduction d = t * R^-1 mod N of double
+ * length product (separated operand scanning).
+ *
+ * @param   d <-- Result.
+ * @param   t <--> Product (2*FIT_MONT_LIMBS + 1 limbs, top limb zero); destroyed.
+ * @param   n --> Modulus.
+ * @param   mm --> -N^-1 mod 2^FIT_MONT_LIMB_BITS (see fit_mont_init).
+ * @param   muladd --> Kernel.
+ *
+ */
+static void fit_mont_reduce(mbedtls_mpi_uint *d,
+                            mbedtls_mpi_uint *t,
+                            const mbedtls_mpi_uint *n,
+                            mbedtls_mpi_uint mm,
+                            fit_mont_muladd_t muladd)
+{
+    mbedtls_mpi_uint carry  = 0;
+    uint16_t i              = 0;
+    uint16_t k              = 0;
+
+    for (i = 0; i < FIT_MONT_LIMBS; i++)
+    {
+        // m is chosen so that limb i becomes zero.
+        carry = muladd(t + i, n, t[i] * mm, FIT_MONT_LIMBS);
+        for (k = i + FIT_MONT_LIMBS; carry != 0; k++)
+        {
+            t[k] += carry;
+            carry = (t[k] < carry);
+        }
+    }
+
+    // Result is less than 2N; one subtraction is enough.
+    t += FIT_MONT_LIMBS;
+    if (t[FIT_MONT_LIMBS] != 0 || fit_mont_ge(t, n))
+        fit_mont_sub(t, n);
+    fit_memcpy((uint8_t *)d, (uint8_t *)t, FIT_MONT_LIMBS * sizeof(mbedtls_mpi_uint));
+}
+
+/**
+ *
+ * fit_mont_mul
+ *
+ * This function will perform Montgomery multiplication d = a * b * R^-1 mod N.
+ * Inputs should be less than N; d can be same as a or b.
+ *
+ * @param   d <-- Result.
+ * @param   a --> First multiplicand.
+ * @param   b --> Second multiplicand.
+ * @param   n --> Modulus.
+ * @param   mm --> -N^-1 mod 2^FIT_MONT_LIMB_BITS (see fit_mont_init).
+ *
+ */
+static void fit_mont_mul(mbedtls_mpi_uint *d,
+                         const mbedtls_mpi_uint *a,
+                         const mbedtls_mpi_uint *b,
+                         const mbedtls_mpi_uint *n,
+                         mbedtls_mpi_uint mm)
+{
+    mbedtls_mpi_uint t[2 * FIT_MONT_LIMBS + 1];
+    fit_mont_muladd_t muladd = FIT_MONT_MULADD;
+    uint16_t i = 0;
+
+    fit_memset((uint8_t *)t, 0, sizeof(t));
+    for (i = 0; i < FIT_MONT_LIMBS; i++)
+        t[i + FIT_MONT_LIMBS] = muladd(t + i, a, b[i], FIT_MONT_LIMBS);
+
+    fit_mont_reduce(d, t, n, mm, muladd);
+}
+
+/**
+ *
+ * fit_mont_sqr
+ *
+ * This function will perform Montgomery squaring d = a * a * R^-1 mod N. Products
+ * a[i] * a[j] (i < j) are calculated once and doubled, then squares a[i] * a[i]
+ * are added.
+ *
+ * @param   d <-- Result.
+ * @param   a --> Number to be squared (less than N); d can be same as a.
+ * @param   n --> Modulus.
+ * @param   mm --> -N^-1 mod 2^FIT_MONT_LIMB_BITS (see fit_mont_init).
+ *
+ */
+static void fit_mont_sqr(mbedtls_mpi_uint *d,
+                         const mbedtls_mpi_uint *a,
+                         const mbedtls_mpi_uint *n,
+                         mbedtls_mpi_uint mm)
+{
+    mbedtls_mpi_uint t[2 * FIT_MONT_LIMBS + 1];
+    fit_mont_muladd_t muladd    = FIT_MONT_MULADD;
+    mbedtls_mpi_uint carry      = 0;
+    mbedtls_mpi_uint x          = 0;
+    mbedtls_t_udbl r            = 0;
+    uint16_t i                  = 0;
+
+    fit_memset((uint8_t *)t, 0, sizeof(t));
+    for (i = 0; i < FIT_MONT_LIMBS - 1; i++)
+        t[i + FIT_MONT_LIMBS] = muladd(t + 2 * i + 1, a + i + 1, a[i], FIT_MONT_LIMBS - 1 - i);
+
+    for (i = 0; i < 2 * FIT_MONT_LIMBS; i++)
+    {
+        x = t[i];
+        t[i] = (x << 1) | carry;
+        carry = x >> (FIT_MONT_LIMB_BITS - 1);
+    }
+
+    carry = 0;
+    for (i = 0; i < FIT_MONT_LIMBS; i++)
+    {
+        r = (mbedtls_t_udbl)a[i] * a[i] + t[2 * i] + carry;
+        t[2 * i] = (mbedtls_mpi_uint)r;
+        r = (mbedtls_t_udbl)t[2 * i + 1] + (mbedtls_mpi_uint)(r >> FIT_MONT_LIMB_BITS);
+        t[2 * i + 1] = (mbedtls_mpi_uint)r;
+        carry = (mbedtls_mpi_uint)(r >> FIT_MONT_LIMB_BITS);
+    }
+
+    fit_mont_reduce(d, t, n, mm, muladd);
+}
+
+/**
+ *
+ * fit_mont_rr
+ *
+ * This function will calculate R^2 mod N. R mod N is 2^k - N (top bit of N is set);
+ * it is doubled FIT_MONT_RR_SHIFT times to get 2^(k+j) mod N, then every Montgomery
+ * squaring of 2^(k+j) gives 2^(k+2j) till j is k.
+ *
+ * @param   rr <-- On return it will contain R^2 mod N.
+ * @param   n --> Modulus.
+ * @param   mm --> -N^-1 mod 2^FIT_MONT_LIMB_BITS.
+ *
+ */
+static void fit_mont_rr(mbedtls_mpi_uint *rr, const mbedtls_mpi_uint *n, mbedtls_mpi_uint mm)
+{
+    mbedtls_mpi_uint carry  = 0;
+    mbedtls_mpi_uint t      = 0;
+    uint16_t cntr           = 0;
+    uint16_t j              = 0;
+
+    // 2^k - N i.e. two's complement of N.
+    fit_memset((uint8_t *)rr, 0, FIT_MONT_LIMBS * sizeof(mbedtls_mpi_uint));
+    fit_mont_sub(rr, n);
+
+    for (j = 0; j < FIT_MONT_RR_SHIFT; j++)
+    {
+        carry = 0;
+        for (cntr = 0; cntr < FIT_MONT_LIMBS; cntr++)
+        {
+            t = rr[cntr];
+            rr[cntr] = (t << 1) | carry;
+            carry = t >> (FIT_MONT_LIMB_BITS - 1);
+        }
+        if (carry != 0 || fit_mont_ge(rr, n))
+            fit_mont_sub(rr, n);
+    }
+
+    for (j = FIT_MONT_RR_SHIFT; j < FIT_MONT_SIZE * 8; j <<= 1)
+        fit_mont_sqr(rr, rr, n, mm);
+}
+
+/**
+ *
+ * fit_mont_setup
+ *
+ * This function will set up Montgomery constants of rsa public key. Key should
+ * stay valid (and unchanged) as long as ctx is used, as modulus is not copied.
+ * Precomputed constants (e.g. shipped with raw key) skip calculation of R^2 mod N;
+ * mm is checked (N * mm = -1) and constants are calculated if it does not match.
+ * Returns FIT_RSA_VERIFY_FAILED if key is not supported.
+ *
+ * @param   ctx <-- Montgomery context to be set up.
+ * @param   N --> Modulus; FIT_MONT_SIZE bytes long.
+ * @param   E --> Public exponent; at most FIT_MONT_MAX_EXP_BITS bits long.
+ * @param   rr --> Precomputed R^2 mod N (FIT_MONT_LIMBS limbs) or NULL.
+ * @param   mm --> Precomputed -N^-1 mod 2^FIT_MONT_LIMB_BITS; ignored if rr is NULL.
+ *
+ */
+fit_status_t fit_mont_setup(fit_mont_ctx_t *ctx,
+                            const mbedtls_mpi *N,
+                            const mbedtls_mpi *E,
+                            const mbedtls_mpi_uint *rr,
+                            mbedtls_mpi_uint mm)
+{
+    if (mbedtls_mpi_size(N) != FIT_MONT_SIZE || (N->p[0] & 1) == 0 ||
+        mbedtls_mpi_bitlen(E) < 2 || mbedtls_mpi_bitlen(E) > FIT_MONT_MAX_EXP_BITS)
+    {
+        DBG(FIT_TRACE_ERROR, "[fit_mont_setup] unsupported public key\n");
+        return FIT_RSA_VERIFY_FAILED;
+    }
+
+    ctx->m_n = N->p;
+    ctx->m_e = E->p[0];
+    ctx->m_ebits = (uint8_t)mbedtls_mpi_bitlen(E);
+    if (rr != NULL && (mbedtls_mpi_uint)(N->p[0] * mm) == (mbedtls_mpi_uint)-1)
+    {
+        ctx->m_mm = mm;
+        fit_memcpy((uint8_t *)ctx->m_rr, (uint8_t *)rr, sizeof(ctx->m_rr));
+    }
+    else
+    {
+        ctx->m_mm = fit_mont_init(N->p[0]);
+        fit_mont_rr(ctx->m_rr, ctx->m_n, ctx->m_mm);
+    }
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_mont_exp_small
+ *
+ * This function will perform rsa public operation (input ^ E mod N) with a short
+ * chain of Montgomery squarings and multiplications (left-to-right binary method);
+ * e.g. 2 operations for E = 3 and 17 for E = 65537, plus conversion to and from
+ * Montgomery form. Returns FIT_RSA_VERIFY_FAILED if input is not less than N.
+ *
+ * @param   ctx --> Montgomery context set up by fit_mont_setup.
+ * @param   input --> Signature (FIT_MONT_SIZE bytes, big endian).
+ * @param   output <-- On return it will contain input ^ E mod N (FIT_MONT_SIZE bytes).
+ *
+ */
+fit_status_t fit_mont_exp_small(const fit_mont_ctx_t *ctx, const uint8_t *input, uint8_t *output)
+{
+    mbedtls_mpi_uint x[FIT_MONT_LIMBS];
+    mbedtls_mpi_uint acc[FIT_MONT_LIMBS];
+    uint16_t cntr       = 0;
+    int16_t bit         = 0;
+
+    // Big endian input to limbs.
+    fit_memset((uint8_t *)x, 0, sizeof(x));
+    for (cntr = 0; cntr < FIT_MONT_SIZE; cntr++)
+        x[cntr / sizeof(mbedtls_mpi_uint)] |=
+            (mbedtls_mpi_uint)input[FIT_MONT_SIZE - 1 - cntr] << ((cntr % sizeof(mbedtls_mpi_uint)) << 3);
+    if (fit_mont_ge(x, ctx->m_n))
+        return FIT_RSA_VERIFY_FAILED;
+
+    // x = input * R mod N; acc = x (top bit of E).
+    fit_mont_mul(x, x, ctx->m_rr, ctx->m_n, ctx->m_mm);
+    fit_memcpy((uint8_t *)acc, (uint8_t *)x, sizeof(acc));
+    for (bit = (int16_t)ctx->m_ebits - 2; bit >= 0; bit--)
+    {
+        fit_mont_sqr(acc, acc, ctx->m_n, ctx->m_mm);
+        if ((ctx->m_e >> bit) & 1)
+            fit_mont_mul(acc, acc, x, ctx->m_n, ctx->m_mm);
+    }
+
+    // Out of Montgomery form: acc * 1 * R^-1.
+    fit_memset((uint8_t *)x, 0, sizeof(x));
+    x[0] = 1;
+    fit_mont_mul(acc, acc, x, ctx->m_n, ctx->m_mm);
+
+    for (cntr = 0; cntr < FIT_MONT_SIZE; cntr++)
+        output[FIT_MONT_SIZE - 1 - cntr] =
+            (uint8_t)(acc[cntr / sizeof(mbedtls_mpi_uint)] >> ((cntr % sizeof(mbedtls_mpi_uint)) << 3));
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_mont_use_asm
+ *
+ * This function will turn tuned kernel (FIT_USE_MONT_ASM) on or off, e.g. to compare
+ * it with portable kernel. Tuned kernel is on by default. Returns TRUE if tuned
+ * kernel is used afterwards i.e. it is built in, supported by processor and on.
+ *
+ * @param   enable --> TRUE to use tuned kernel, FALSE to use portable kernel.
+ *
+ */
+uint8_t fit_mont_use_asm(uint8_t enable)
+{
+#ifdef FIT_MONT_MULX_AVAILABLE
+    FIT_CPU_STATE_STORE(&fit_mont_mulx_off, (uint8_t)((enable == TRUE) ? FALSE : TRUE));
+
+    return (uint8_t)((enable == TRUE && fit_mont_mulx_supported()) ? TRUE : FALSE);
+#else
+    (void)enable;
+
+    return FALSE;
+#endif
+}
+
+#endif // #ifdef FIT_MONT_AVAILABLE
@@ -9,11 +9,508 @@
 \****************************************************************************/
 
 #include <string.h>
+#include <stddef.h>
 
 #include "fit_rsa.h"
+#include "mbedtls/asn1.h"
 #include "hwdep.h"
+#include "internal.h"
 #include "fit_debug.h"
-#include "mbedtls\pk.h"
+#include "fit_crypto.h"
+#include "dm_hash.h"
+
+/* Constants ****************************************************************/
+
+// DER encoding of DigestInfo header for SHA-256 (RFC 3447, section 9.2 notes)
+static const uint8_t sha256_digest_info[] = {
+    0x30, 0x31, 0x30, 0x0d, 0x06, 0x09, 0x60, 0x86, 0x48, 0x01,
+    0x65, 0x03, 0x04, 0x02, 0x01, 0x05, 0x00, 0x04, 0x20 };
+
+/* Functions ****************************************************************/
+
+/**
+ *
+ * fit_rsa_error
+ *
+ * This function will map mbedtls error code to FIT status. Memory allocation
+ * failures are reported as FIT_INSUFFICIENT_MEMORY, so they are not taken for bad
+ * signature (which is cached by negative validation cache).
+ *
+ * @param   ret     --> mbedtls error code (negative).
+ *
+ */
+static fit_status_t fit_rsa_error(int ret)
+{
+    // Low level error (e.g. bignum) is added to high level one (e.g. rsa).
+    int low = (-ret) & 0x007F;
+
+    if (ret == MBEDTLS_ERR_PK_ALLOC_FAILED ||
+        low == -MBEDTLS_ERR_MPI_ALLOC_FAILED ||
+        low == -MBEDTLS_ERR_ASN1_ALLOC_FAILED)
+    {
+        return FIT_INSUFFICIENT_MEMORY;
+    }
+
+    return FIT_RSA_VERIFY_FAILED;
+}
+
+#ifndef FIT_USE_RAW_PUBKEY_ONLY
+
+/**
+ *
+ * fit_rsa_parse_key
+ *
+ * This function will read the rsa public key (PEM format) into RAM and parse it
+ * into pk context passed in. Caller should call mbedtls_pk_free on pk context once
+ * it is no longer required (even if parsing fails).
+ *
+ * @param   pk      <-- mbedtls pk context that will contain parsed public key.
+ * @param   key     --> fit_pointer to RSA public key
+ *
+ */
+fit_status_t fit_rsa_parse_key(mbedtls_pk_context *pk, fit_pointer_t *key)
+{
+    uint8_t pubkey[512] = {0};
+    int i, ret;
+
+    mbedtls_pk_init( pk );
+
+    if (key->length >= sizeof(pubkey))
+        return FIT_INVALID_KEYSIZE;
+
+    /* read pubkey into RAM */
+    for (i = 0; i < key->length; i++)
+        pubkey[i] = key->read_byte(key->data + i);
+
+    ret = mbedtls_pk_parse_public_key( pk, (const unsigned char *)pubkey, key->length + 1);
+    if (ret) {
+        DBG(FIT_TRACE_ERROR, "[fit_rsa_parse_key] parsing public key FAILED -0x%04x\n", -ret);
+        return fit_rsa_error(ret);
+    }
+    if (mbedtls_pk_get_type(pk) != MBEDTLS_PK_RSA || mbedtls_pk_rsa(*pk)->len != RSA_SIG_SIZE) {
+        DBG(FIT_TRACE_ERROR, "[fit_rsa_parse_key] unsupported public key\n");
+        return FIT_INVALID_KEYSIZE;
+    }
+    DBG(FIT_TRACE_INFO, "[fit_rsa_parse_key] public key is accepted\n" );
+
+    return FIT_STATUS_OK;
+}
+
+#endif // #ifndef FIT_USE_RAW_PUBKEY_ONLY
+
+/**
+ *
+ * fit_rsa_is_raw_key
+ *
+ * This function will check whether rsa public key is in raw (pre-parsed) format
+ * i.e. it has size of fit_rsa_raw_key_t and starts with FIT_RSA_RAW_KEY_MAGIC.
+ *
+ * @param   key     --> fit_pointer to RSA public key
+ *
+ */
+static uint8_t fit_rsa_is_raw_key(fit_pointer_t *key)
+{
+    const uint8_t magic[4]  = FIT_RSA_RAW_KEY_MAGIC;
+    uint16_t cntr           = 0;
+
+    if (key->length != sizeof(fit_rsa_raw_key_t))
+        return FALSE;
+    for (cntr = 0; cntr < sizeof(magic); cntr++)
+    {
+        if (key->read_byte(key->data + cntr) != magic[cntr])
+            return FALSE;
+    }
+
+    return TRUE;
+}
+
+/**
+ *
+ * fit_rsa_read_limbs
+ *
+ * This function will read big endian number of raw public key into limbs (least
+ * significant limb first).
+ *
+ * @param   key     --> fit_pointer to raw RSA public key
+ * @param   offset  --> Offset of number in raw key.
+ * @param   size    --> Size of number in bytes (multiple of limb size).
+ * @param   limbs   <-- On return it will contain the number.
+ *
+ */
+static void fit_rsa_read_limbs(fit_pointer_t *key,
+                               uint16_t offset,
+                               uint16_t size,
+                               mbedtls_mpi_uint *limbs)
+{
+    uint16_t cntr   = 0;
+    uint8_t byte    = 0;
+
+    fit_memset((uint8_t *)limbs, 0, size);
+    for (cntr = 0; cntr < size; cntr++)
+    {
+        byte = key->read_byte(key->data + offset + size - 1 - cntr);
+        limbs[cntr / sizeof(mbedtls_mpi_uint)] |=
+            (mbedtls_mpi_uint)byte << (8 * (cntr % sizeof(mbedtls_mpi_uint)));
+    }
+}
+
+/**
+ *
+ * fit_rsa_set_key
+ *
+ * This function will set up rsa context of key structure from modulus and public
+ * exponent in m_nbuf/m_ebuf. No memory is allocated; modulus and exponent belong to
+ * key structure, so they should never be freed (see fit_rsa_key_free). Precomputed
+ * R^2 mod N (if present in m_rrbuf) is used by mbedtls in place of its own cached
+ * value.
+ *
+ * @param   rsakey  <--> rsa key structure initialized by fit_rsa_key_init.
+ * @param   rr      --> TRUE if m_rrbuf contains R^2 mod N.
+ *
+ */
+static fit_status_t fit_rsa_set_key(fit_rsa_key_t *rsakey, uint8_t rr)
+{
+    mbedtls_rsa_context *rsa = &rsakey->m_rsa;
+
+    mbedtls_rsa_init( rsa, MBEDTLS_RSA_PKCS_V15, 0 );
+    rsa->N.s = 1;
+    rsa->N.n = FIT_RSA_N_LIMBS;
+    rsa->N.p = rsakey->m_nbuf;
+    rsa->E.s = 1;
+    rsa->E.n = FIT_RSA_E_LIMBS;
+    rsa->E.p = rsakey->m_ebuf;
+    rsa->len = mbedtls_mpi_size( &rsa->N );
+
+    if (rsa->len != RSA_SIG_SIZE || mbedtls_rsa_check_pubkey( rsa ) != 0) {
+        DBG(FIT_TRACE_ERROR, "[fit_rsa_set_key] unsupported public key\n");
+        fit_memset((uint8_t *)rsa, 0, sizeof(mbedtls_rsa_context));
+        return FIT_INVALID_KEYSIZE;
+    }
+
+    // pk context refers to rsa context of key structure (no mbedtls_pk_setup).
+    rsakey->m_pk.pk_info = mbedtls_pk_info_from_type( MBEDTLS_PK_RSA );
+    rsakey->m_pk.pk_ctx = rsa;
+    rsakey->m_raw = TRUE;
+    if (rr == TRUE)
+    {
+        rsa->RN.s = 1;
+        rsa->RN.n = FIT_RSA_N_LIMBS;
+        rsa->RN.p = rsakey->m_rrbuf;
+        rsakey->m_raw_rr = TRUE;
+    }
+    DBG(FIT_TRACE_INFO, "[fit_rsa_set_key] public key is accepted\n" );
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_rsa_load_raw_key
+ *
+ * This function will read raw public key (through read_byte callback of key) into
+ * key structure and set up rsa context for it.
+ *
+ * @param   rsakey  <--> rsa key structure initialized by fit_rsa_key_init.
+ * @param   mm      <-- Precomputed -N^-1 mod 2^(limb bits); 0 if not present.
+ *
+ */
+static fit_status_t fit_rsa_load_raw_key(fit_rsa_key_t *rsakey, mbedtls_mpi_uint *mm)
+{
+    fit_pointer_t *key  = &rsakey->m_key;
+    mbedtls_mpi_uint mmbuf[FIT_RSA_RAW_MM_SIZE / sizeof(mbedtls_mpi_uint)];
+    uint8_t flags       = 0;
+
+    flags = key->read_byte(key->data + offsetof(fit_rsa_raw_key_t, m_flags));
+    fit_rsa_read_limbs(key, offsetof(fit_rsa_raw_key_t, m_n), RSA_SIG_SIZE, rsakey->m_nbuf);
+    fit_rsa_read_limbs(key, offsetof(fit_rsa_raw_key_t, m_e), FIT_RSA_RAW_E_SIZE, rsakey->m_ebuf);
+    *mm = 0;
+    if ((flags & FIT_RSA_RAW_KEY_RR) != 0)
+    {
+        fit_rsa_read_limbs(key, offsetof(fit_rsa_raw_key_t, m_rr), RSA_SIG_SIZE, rsakey->m_rrbuf);
+        fit_rsa_read_limbs(key, offsetof(fit_rsa_raw_key_t, m_mm), FIT_RSA_RAW_MM_SIZE, mmbuf);
+        // For 32 bit limbs constant is low half of 64 bit one.
+        *mm = mmbuf[0];
+    }
+
+    return fit_rsa_set_key(rsakey, ((flags & FIT_RSA_RAW_KEY_RR) != 0) ? TRUE : FALSE);
+}
+
+#if defined(FIT_USE_MBEDTLS_ARENA) && !defined(FIT_USE_RAW_PUBKEY_ONLY)
+
+/**
+ *
+ * fit_rsa_detach_key
+ *
+ * This function will copy modulus and public exponent of parsed PEM key into rsa
+ * key structure and release parsed key, so key does not hold arena memory beyond
+ * verification scope. Key is then used same way as raw key (see fit_rsa_set_key).
+ *
+ * @param   rsakey  <--> rsa key structure with parsed key in m_pk.
+ *
+ */
+static fit_status_t fit_rsa_detach_key(fit_rsa_key_t *rsakey)
+{
+    mbedtls_rsa_context *rsa    = mbedtls_pk_rsa(rsakey->m_pk);
+    fit_status_t status         = FIT_STATUS_OK;
+
+    fit_memset((uint8_t *)rsakey->m_nbuf, 0, sizeof(rsakey->m_nbuf));
+    fit_memset((uint8_t *)rsakey->m_ebuf, 0, sizeof(rsakey->m_ebuf));
+    if (mbedtls_mpi_size(&rsa->N) != RSA_SIG_SIZE ||
+        mbedtls_mpi_size(&rsa->E) > sizeof(rsakey->m_ebuf))
+    {
+        status = FIT_INVALID_KEYSIZE;
+    }
+    else
+    {
+        // Limbs are copied as is (least significant limb first).
+        fit_memcpy((uint8_t *)rsakey->m_nbuf, (uint8_t *)rsa->N.p, sizeof(rsakey->m_nbuf));
+        fit_memcpy((uint8_t *)rsakey->m_ebuf, (uint8_t *)rsa->E.p,
+            (uint16_t)(((rsa->E.n < FIT_RSA_E_LIMBS) ? rsa->E.n : FIT_RSA_E_LIMBS) * sizeof(mbedtls_mpi_uint)));
+    }
+    mbedtls_pk_free( &rsakey->m_pk );
+    if (status != FIT_STATUS_OK)
+    {
+        DBG(FIT_TRACE_ERROR, "[fit_rsa_detach_key] unsupported public key\n");
+        return status;
+    }
+
+    return fit_rsa_set_key(rsakey, FALSE);
+}
+
+#endif // #if defined(FIT_USE_MBEDTLS_ARENA) && !defined(FIT_USE_RAW_PUBKEY_ONLY)
+
+/**
+ *
+ * fit_rsa_check_encoding
+ *
+ * This function will compare the result of rsa public operation on signature
+ * (encoded message) against PKCS#1 v1.5 encoding of SHA-256 sized hash i.e.
+ *      00 01 FF .. FF 00 || DigestInfo(SHA-256) || hash
+ *
+ * @param   em      --> encoded message (output of rsa public operation)
+ * @param   hash    --> RAM pointer to hash to be verified
+ *
+ */
+fit_status_t fit_rsa_check_encoding(const uint8_t *em, const uint8_t *hash)
+{
+    uint16_t cntr   = 0;
+    uint16_t pslen  = RSA_SIG_SIZE - 3 - sizeof(sha256_digest_info) - FIT_RSA_HASH_SIZE;
+    uint8_t diff    = 0;
+
+    diff |= em[0] ^ 0x00;
+    diff |= em[1] ^ 0x01;
+    for (cntr = 0; cntr < pslen; cntr++)
+        diff |= em[2 + cntr] ^ 0xFF;
+    diff |= em[2 + pslen];
+    em += 3 + pslen;
+
+    for (cntr = 0; cntr < sizeof(sha256_digest_info); cntr++)
+        diff |= em[cntr] ^ sha256_digest_info[cntr];
+    em += sizeof(sha256_digest_info);
+
+    for (cntr = 0; cntr < FIT_RSA_HASH_SIZE; cntr++)
+        diff |= em[cntr] ^ hash[cntr];
+
+    if (diff != 0)
+        return FIT_RSA_VERIFY_FAILED;
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_rsa_public
+ *
+ * This function will perform rsa public operation (input ^ E mod N). Small public
+ * exponents (e.g. 3 or 65537) are handled by fit_mont_exp_small if enabled by
+ * FIT_USE_RSA_SMALL_EXP (see fit_rsa_key_prepare); mbedtls exponentiation is used
+ * otherwise.
+ *
+ * @param   rsakey  --> rsa key prepared by fit_rsa_key_prepare.
+ * @param   input   --> signature (RSA_SIG_SIZE bytes)
+ * @param   output  <-- result of rsa public operation (RSA_SIG_SIZE bytes)
+ *
+ */
+fit_status_t fit_rsa_public(fit_rsa_key_t *rsakey, const uint8_t *input, uint8_t *output)
+{
+    mbedtls_rsa_context *rsa = mbedtls_pk_rsa(rsakey->m_pk);
+    int ret = 0;
+
+    if (rsa->len != RSA_SIG_SIZE)
+        return FIT_RSA_VERIFY_FAILED;
+
+#ifdef FIT_MONT_AVAILABLE
+    if (rsakey->m_small_exp == TRUE)
+        return fit_mont_exp_small(&rsakey->m_mont, input, output);
+#endif // #ifdef FIT_MONT_AVAILABLE
+
+#ifdef FIT_USE_MBEDTLS_ARENA
+    fit_arena_enter();
+#endif
+    ret = mbedtls_rsa_public(rsa, input, output);
+#ifdef FIT_USE_MBEDTLS_ARENA
+    // R^2 mod N is cached by mbedtls in key; it is in arena so it should not be
+    // kept beyond verification scope (unless it is precomputed one of raw key).
+    if (rsakey->m_raw_rr == FALSE)
+        mbedtls_mpi_free(&rsa->RN);
+    fit_arena_leave();
+#endif
+    if (ret != 0) {
+        DBG(FIT_TRACE_ERROR, "[fit_rsa_public] FAILED -0x%04x\n", -ret);
+        return fit_rsa_error(ret);
+    }
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_rsa_key_init
+ *
+ * This function will initialize rsa key structure for key passed in. Key is not
+ * parsed here; it is parsed by fit_rsa_key_prepare on first use.
+ *
+ * @param   rsakey  <-- rsa key structure to be initialized.
+ * @param   key     --> fit_pointer to RSA public key
+ *
+ */
+void fit_rsa_key_init(fit_rsa_key_t *rsakey, fit_pointer_t *key)
+{
+    rsakey->m_key = *key;
+    rsakey->m_parsed = FALSE;
+    rsakey->m_raw = FALSE;
+    rsakey->m_raw_rr = FALSE;
+    rsakey->m_hashed = FALSE;
+#ifdef FIT_MONT_AVAILABLE
+    rsakey->m_small_exp = FALSE;
+#endif
+    mbedtls_pk_init( &rsakey->m_pk );
+}
+
+/**
+ *
+ * fit_rsa_key_hash
+ *
+ * This function will get Davies Meyer hash of public key bytes. Caches use it to
+ * identify the key by its contents, not by its address. Hash is calculated on first
+ * call only.
+ *
+ * @param   rsakey  <--> rsa key structure initialized by fit_rsa_key_init.
+ * @param   hash    <-- On return it will contain hash of key (FIT_DM_HASH_SIZE bytes).
+ *
+ */
+fit_status_t fit_rsa_key_hash(fit_rsa_key_t *rsakey, uint8_t *hash)
+{
+    fit_status_t status = FIT_STATUS_OK;
+
+    if (rsakey->m_hashed != TRUE)
+    {
+        status = fit_davies_meyer_hash(&rsakey->m_key, rsakey->m_hash);
+        if (status != FIT_STATUS_OK)
+            return status;
+        rsakey->m_hashed = TRUE;
+    }
+    fit_memcpy(hash, rsakey->m_hash, FIT_DM_HASH_SIZE);
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_rsa_key_prepare
+ *
+ * This function will parse the rsa public key if it is not yet parsed. Subsequent
+ * calls will reuse already parsed key.
+ *
+ * @param   rsakey  <--> rsa key structure initialized by fit_rsa_key_init.
+ *
+ */
+fit_status_t fit_rsa_key_prepare(fit_rsa_key_t *rsakey)
+{
+    fit_status_t status             = FIT_STATUS_OK;
+    mbedtls_mpi_uint mm             = 0;
+#ifdef FIT_MONT_AVAILABLE
+    mbedtls_rsa_context *rsa        = NULL;
+#endif
+
+    if (rsakey->m_parsed == TRUE)
+        return FIT_STATUS_OK;
+
+    if (fit_rsa_is_raw_key(&rsakey->m_key) == TRUE)
+    {
+        status = fit_rsa_load_raw_key(rsakey, &mm);
+        if (status != FIT_STATUS_OK)
+            return status;
+    }
+    else
+    {
+#ifdef FIT_USE_RAW_PUBKEY_ONLY
+        DBG(FIT_TRACE_ERROR, "[fit_rsa_key_prepare] only raw public keys are supported\n");
+        return FIT_RSA_VERIFY_FAILED;
+#else
+#ifdef FIT_USE_MBEDTLS_ARENA
+        fit_arena_enter();
+#endif
+        status = fit_rsa_parse_key(&rsakey->m_pk, &rsakey->m_key);
+        if (status != FIT_STATUS_OK)
+            mbedtls_pk_free( &rsakey->m_pk );
+#ifdef FIT_USE_MBEDTLS_ARENA
+        else
+            status = fit_rsa_detach_key(rsakey);
+        fit_arena_leave();
+#endif
+        if (status != FIT_STATUS_OK)
+            return status;
+#endif // #ifdef FIT_USE_RAW_PUBKEY_ONLY
+    }
+
+#ifdef FIT_MONT_AVAILABLE
+    // Montgomery constants are set up once per key; keys with large public
+    // exponent are handled by mbedtls.
+    rsa = mbedtls_pk_rsa(rsakey->m_pk);
+    if (mbedtls_mpi_bitlen(&rsa->E) <= FIT_MONT_MAX_EXP_BITS &&
+        fit_mont_setup(&rsakey->m_mont, &rsa->N, &rsa->E,
+            (rsakey->m_raw_rr == TRUE) ? rsakey->m_rrbuf : NULL, mm) == FIT_STATUS_OK)
+    {
+        rsakey->m_small_exp = TRUE;
+    }
+#endif // #ifdef FIT_MONT_AVAILABLE
+    rsakey->m_parsed = TRUE;
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_rsa_key_free
+ *
+ * This function will release memory allocated for parsed rsa public key.
+ *
+ * @param   rsakey  <--> rsa key structure initialized by fit_rsa_key_init.
+ *
+ */
+void fit_rsa_key_free(fit_rsa_key_t *rsakey)
+{
+    if (rsakey->m_raw == TRUE)
+    {
+        // Modulus and exponent belong to raw key; only values calculated by
+        // rsa public operation (R^2 mod N, unless precomputed) are allocated.
+        if (rsakey->m_raw_rr == FALSE)
+            mbedtls_mpi_free( &rsakey->m_rsa.RN );
+        fit_memset((uint8_t *)&rsakey->m_rsa, 0, sizeof(mbedtls_rsa_context));
+        mbedtls_pk_init( &rsakey->m_pk );
+        rsakey->m_raw = FALSE;
+        rsakey->m_raw_rr = FALSE;
+    }
+    else
+    {
+        mbedtls_pk_free( &rsakey->m_pk );
+    }
+#ifdef FIT_MONT_AVAILABLE
+    rsakey->m_small_exp = FALSE;
+#endif
+    rsakey->m_parsed = FALSE;
+}
 
 /**
  *
@@ -24,47 +521,74 @@
  *
  * @param   signature   --> fit_pointer to the signature (part of license)
  * @param   hash        --> RAM pointer to hash to be verified
- * @param   key         --> fit_pointer to RSA public key
+ * @param   rsakey      --> RSA public key; parsed here if not yet parsed
  *
  */
 fit_status_t fit_validate_rsa_signature(fit_pointer_t *signature,
                                         uint8_t       *hash,
-                                        fit_pointer_t *key)
+                                        fit_rsa_key_t *rsakey)
 {
-    mbedtls_pk_context pk;
-    uint8_t pubkey_or_sig[512] = {0}; /* share memory */
-    int i, ret;
+    uint8_t sig[RSA_SIG_SIZE] = {0};
+    fit_status_t status = FIT_STATUS_OK;
+    int i = 0;
+#if !defined(FIT_USE_CRYPTO_PROVIDER) && !defined(FIT_USE_RSA_SMALL_EXP) && \
+    !defined(FIT_USE_MBEDTLS_ARENA)
+    int ret = 0;
+#endif
 
-    /* read pubkey into RAM */
-    for (i = 0; i < key->length; i++) 
-        pubkey_or_sig[i] = key->read_byte(key->data + i);
+    status = fit_rsa_key_prepare(rsakey);
+    if (status != FIT_STATUS_OK)
+        return status;
 
-    mbedtls_pk_init( &pk );
+    /* read signature from license memory */
+    for (i = 0; i < RSA_SIG_SIZE; i++)
+        sig[i] = signature->read_byte(signature->data + i);
 
-    ret = mbedtls_pk_parse_public_key( &pk, (const unsigned char *)pubkey_or_sig, key->length + 1);
-    if (ret) {
-        DBG(FIT_TRACE_ERROR, "[fit_validate_rsa_signature] parsing public key FAILED -0x%04x\n", -ret);
-        goto exit;
-    }
-    DBG(FIT_TRACE_INFO, "[fit_validate_rsa_signature] public key is accepted\n" );
+#ifdef FIT_USE_CRYPTO_PROVIDER
+    {
+        // RSA public operation is performed by crypto provider; encoding of result
+        // is then checked here.
+        fit_crypto_job_t job        = {0};
+        uint8_t em[RSA_SIG_SIZE]    = {0};
 
-    /* read signature from license memory */
-    for (i = 0; i < 256; i++)
-        pubkey_or_sig[i] = signature->read_byte(signature->data + i);
+        job.m_op = FIT_CRYPTO_OP_RSA_PUBLIC;
+        job.m_rsakey = rsakey;
+        job.m_input = sig;
+        job.m_length = RSA_SIG_SIZE;
+        job.m_output = em;
+        status = fit_crypto_submit(&job);
+        if (status == FIT_STATUS_OK)
+            status = fit_crypto_wait(&job);
+        if (status == FIT_STATUS_OK)
+            status = fit_rsa_check_encoding(em, hash);
+        if (status != FIT_STATUS_OK) {
+            DBG(FIT_TRACE_ERROR, "[fit_validate_rsa_signature] verify FAILED, status %d\n", status);
+            return status;
+        }
+    }
+#elif defined(FIT_USE_RSA_SMALL_EXP) || defined(FIT_USE_MBEDTLS_ARENA)
+    {
+        // Public operation in fixed size buffers (see fit_rsa_public), then check of
+        // PKCS#1 v1.5 encoding.
+        uint8_t em[RSA_SIG_SIZE]    = {0};
 
-    ret = mbedtls_pk_verify(&pk, MBEDTLS_MD_SHA256, hash, 32, pubkey_or_sig, 256);
+        status = fit_rsa_public(rsakey, sig, em);
+        if (status == FIT_STATUS_OK)
+            status = fit_rsa_check_encoding(em, hash);
+        if (status != FIT_STATUS_OK) {
+            DBG(FIT_TRACE_ERROR, "[fit_validate_rsa_signature] verify FAILED, status %d\n", status);
+            return status;
+        }
+    }
+#else
+    ret = mbedtls_pk_verify(&rsakey->m_pk, MBEDTLS_MD_SHA256, hash, FIT_RSA_HASH_SIZE, sig, RSA_SIG_SIZE);
     if (ret) {
         DBG(FIT_TRACE_ERROR, "[fit_validate_rsa_signature] verify FAILED -0x%04x\n", -ret);
-        goto exit;
+        return fit_rsa_error(ret);
     }
+#endif // #ifdef FIT_USE_CRYPTO_PROVIDER
 
     DBG(FIT_TRACE_INFO, "[fit_validate_rsa_signature] verify OK\n" );
-    ret = 0;
-
- exit:
-    mbedtls_pk_free( &pk );
-
-    if (ret) return FIT_RSA_VERIFY_FAILED;
-    return FIT_STATUS_OK;
 
+    return status;
 }
@@ -0,0 +1,346 @@
+/****************************************************************************\
+**
+** fit_sha256.c
+**
+** Defines functionality for SHA-256 license digest (SHA256_ALGID). Replaces
+** mbedtls SHA-256 block compression function (MBEDTLS_SHA256_PROCESS_ALT) by
+** unrolled portable implementation, or by SHA instructions (x86 SHA-NI) if
+** FIT_USE_SHANI is defined and processor supports them.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifdef FIT_USE_SHA256_DIGEST
+
+/* Required Includes ********************************************************/
+#include "fit_sha256.h"
+#include "internal.h"
+
+#ifdef FIT_SHANI_AVAILABLE
+#include "hwdep.h"
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif // #ifdef FIT_SHANI_AVAILABLE
+
+/* Constants ****************************************************************/
+
+#ifdef FIT_SHANI_AVAILABLE
+// SHA instructions are enabled per function, so rest of the library does not
+// require target specific compiler options.
+#if defined(__GNUC__) || defined(__clang__)
+#define FIT_SHANI_TARGET            __attribute__((target("sha,sse4.1,ssse3")))
+#else
+#define FIT_SHANI_TARGET
+#endif
+
+// CPUID.07H:EBX bit indicating support of SHA instructions.
+#define FIT_CPUID_SHA_BIT           (1UL << 29)
+// CPUID.01H:ECX bits indicating support of SSSE3 and SSE4.1 instructions.
+#define FIT_CPUID_SSSE3_BIT         (1UL << 9)
+#define FIT_CPUID_SSE41_BIT         (1UL << 19)
+#endif // #ifdef FIT_SHANI_AVAILABLE
+
+// SHA-256 round constants.
+static const uint32_t fit_sha256_k[64] = {
+    0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5,
+    0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+    0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3,
+    0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+    0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC,
+    0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+    0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7,
+    0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+    0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13,
+    0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+    0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3,
+    0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+    0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5,
+    0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3,
+    0x748F82EE, 0x78A5636F, 0x84C87814, 0x8CC70208,
+    0x90BEFFFA, 0xA4506CEB, 0xBEF9A3F7, 0xC67178F2,
+};
+
+/* Macros *******************************************************************/
+
+#define FIT_SHA256_ROTR(x, n)       (((x) >> (n)) | ((x) << (32 - (n))))
+
+#define FIT_SHA256_S0(x)    (FIT_SHA256_ROTR(x, 7) ^ FIT_SHA256_ROTR(x, 18) ^ ((x) >> 3))
+#define FIT_SHA256_S1(x)    (FIT_SHA256_ROTR(x, 17) ^ FIT_SHA256_ROTR(x, 19) ^ ((x) >> 10))
+#define FIT_SHA256_S2(x)    (FIT_SHA256_ROTR(x, 2) ^ FIT_SHA256_ROTR(x, 13) ^ FIT_SHA256_ROTR(x, 22))
+#define FIT_SHA256_S3(x)    (FIT_SHA256_ROTR(x, 6) ^ FIT_SHA256_ROTR(x, 11) ^ FIT_SHA256_ROTR(x, 25))
+
+#define FIT_SHA256_F0(x, y, z)      (((x) & (y)) | ((z) & ((x) | (y))))
+#define FIT_SHA256_F1(x, y, z)      ((z) ^ ((x) & ((y) ^ (z))))
+
+// Message word i (0 to 15) read as big endian from data block.
+#define FIT_SHA256_LOAD(i)  (W[i] = ((uint32_t)data[4*(i)] << 24) |             \
+                                    ((uint32_t)data[4*(i)+1] << 16) |           \
+                                    ((uint32_t)data[4*(i)+2] << 8) |            \
+                                    ((uint32_t)data[4*(i)+3]))
+
+// Message word i (16 to 63); only last 16 words are kept in W.
+#define FIT_SHA256_SCHED(i) (W[(i) & 15] += FIT_SHA256_S1(W[((i) - 2) & 15]) + \
+                                            W[((i) - 7) & 15] +                 \
+                                            FIT_SHA256_S0(W[((i) - 15) & 15]))
+
+// One round; instead of moving the working variables, next round is called with
+// variables renamed, so that 8 rounds return them to their original places.
+#define FIT_SHA256_ROUND(a, b, c, d, e, f, g, h, i, W_)                         \
+    do {                                                                        \
+        temp = (h) + FIT_SHA256_S3(e) + FIT_SHA256_F1(e, f, g) +                \
+               fit_sha256_k[i] + W_(i);                                         \
+        (d) += temp;                                                            \
+        (h) = temp + FIT_SHA256_S2(a) + FIT_SHA256_F0(a, b, c);                 \
+    } while (0)
+
+#define FIT_SHA256_ROUNDS8(i, W_)                                               \
+    do {                                                                        \
+        FIT_SHA256_ROUND(A, B, C, D, E, F, G, H, (i) + 0, W_);                  \
+        FIT_SHA256_ROUND(H, A, B, C, D, E, F, G, (i) + 1, W_);                  \
+        FIT_SHA256_ROUND(G, H, A, B, C, D, E, F, (i) + 2, W_);                  \
+        FIT_SHA256_ROUND(F, G, H, A, B, C, D, E, (i) + 3, W_);                  \
+        FIT_SHA256_ROUND(E, F, G, H, A, B, C, D, (i) + 4, W_);                  \
+        FIT_SHA256_ROUND(D, E, F, G, H, A, B, C, (i) + 5, W_);                  \
+        FIT_SHA256_ROUND(C, D, E, F, G, H, A, B, (i) + 6, W_);                  \
+        FIT_SHA256_ROUND(B, C, D, E, F, G, H, A, (i) + 7, W_);                  \
+    } while (0)
+
+#ifdef FIT_SHANI_AVAILABLE
+// Four rounds with message words w (words i to i+3); SHA256RNDS2 performs two
+// rounds using low two words of its message operand.
+#define FIT_SHANI_ROUNDS4(w, i)                                                 \
+    do {                                                                        \
+        msg = _mm_add_epi32(w, _mm_loadu_si128((const __m128i *)&fit_sha256_k[i])); \
+        cdgh = _mm_sha256rnds2_epu32(cdgh, abef, msg);                          \
+        msg = _mm_shuffle_epi32(msg, 0x0E);                                     \
+        abef = _mm_sha256rnds2_epu32(abef, cdgh, msg);                          \
+    } while (0)
+
+// Next four message words (replacing w0) from last sixteen words w0 to w3.
+#define FIT_SHANI_SCHED(w0, w1, w2, w3)                                         \
+    do {                                                                        \
+        tmp = _mm_add_epi32(_mm_sha256msg1_epu32(w0, w1), _mm_alignr_epi8(w3, w2, 4)); \
+        w0 = _mm_sha256msg2_epu32(tmp, w3);                                     \
+    } while (0)
+#endif // #ifdef FIT_SHANI_AVAILABLE
+
+/* Global Data **************************************************************/
+
+#ifdef FIT_SHANI_AVAILABLE
+// Result of processor feature check; 0xFF till not checked.
+static uint8_t fit_shani_state = 0xFF;
+#endif
+
+/* Functions ****************************************************************/
+
+/**
+ *
+ * fit_sha256_process_c
+ *
+ * This function will update SHA-256 state with one 64 byte block. Rounds are
+ * unrolled by 8 and message schedule is kept in 16 words (instead of 64 words
+ * used by mbedtls), so it is faster and uses less stack than mbedtls version
+ * built with MBEDTLS_SHA256_SMALLER.
+ *
+ * @param   state <--> SHA-256 state (8 words).
+ * @param   data --> Block of data to be hashed.
+ *
+ */
+static void fit_sha256_process_c(uint32_t *state, const uint8_t *data)
+{
+    uint32_t W[16];
+    uint32_t A = state[0], B = state[1], C = state[2], D = state[3];
+    uint32_t E = state[4], F = state[5], G = state[6], H = state[7];
+    uint32_t temp = 0;
+    uint8_t i = 0;
+
+    FIT_SHA256_ROUNDS8(0, FIT_SHA256_LOAD);
+    FIT_SHA256_ROUNDS8(8, FIT_SHA256_LOAD);
+    for (i = 16; i < 64; i += 8)
+        FIT_SHA256_ROUNDS8(i, FIT_SHA256_SCHED);
+
+    state[0] += A; state[1] += B; state[2] += C; state[3] += D;
+    state[4] += E; state[5] += F; state[6] += G; state[7] += H;
+}
+
+#ifdef FIT_SHANI_AVAILABLE
+
+/**
+ *
+ * fit_shani_supported
+ *
+ * This function will check (once) whether processor supports SHA instructions
+ * (and SSSE3/SSE4.1 instructions used together with them).
+ *
+ */
+uint8_t fit_shani_supported(void)
+{
+    uint8_t state   = FIT_CPU_STATE_LOAD(&fit_shani_state);
+    uint32_t ebx    = 0;
+    uint32_t ecx    = 0;
+
+    if (state == 0xFF)
+    {
+#if defined(_MSC_VER)
+        int regs[4] = {0};
+
+        __cpuid(regs, 0);
+        if (regs[0] >= 7)
+        {
+            __cpuidex(regs, 7, 0);
+            ebx = (uint32_t)regs[1];
+            __cpuid(regs, 1);
+            ecx = (uint32_t)regs[2];
+        }
+#else
+        unsigned int a = 0, b = 0, c = 0, d = 0;
+
+        if (__get_cpuid_max(0, NULL) >= 7)
+        {
+            __cpuid_count(7, 0, a, b, c, d);
+            ebx = b;
+            if (__get_cpuid(1, &a, &b, &c, &d))
+                ecx = c;
+        }
+#endif
+        state = ((ebx & FIT_CPUID_SHA_BIT) &&
+                 (ecx & FIT_CPUID_SSSE3_BIT) &&
+                 (ecx & FIT_CPUID_SSE41_BIT)) ? TRUE : FALSE;
+        FIT_CPU_STATE_STORE(&fit_shani_state, state);
+    }
+
+    return state;
+}
+
+/**
+ *
+ * fit_sha256_process_shani
+ *
+ * This function will update SHA-256 state with one 64 byte block using SHA
+ * instructions. State is kept as ABEF/CDGH register pair during the rounds,
+ * as required by SHA256RNDS2.
+ *
+ * @param   state <--> SHA-256 state (8 words).
+ * @param   data --> Block of data to be hashed.
+ *
+ */
+FIT_SHANI_TARGET
+static void fit_sha256_process_shani(uint32_t *state, const uint8_t *data)
+{
+    __m128i abef, cdgh, abef_save, cdgh_save, msg, tmp;
+    __m128i w0, w1, w2, w3;
+    const __m128i mask = _mm_set_epi64x(0x0C0D0E0F08090A0BULL, 0x0405060700010203ULL);
+    uint8_t i = 0;
+
+    // Convert state from ABCD/EFGH to ABEF/CDGH.
+    tmp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[0]), 0xB1);
+    cdgh = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i *)&state[4]), 0x1B);
+    abef = _mm_alignr_epi8(tmp, cdgh, 8);
+    cdgh = _mm_blend_epi16(cdgh, tmp, 0xF0);
+    abef_save = abef;
+    cdgh_save = cdgh;
+
+    w0 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 0)), mask);
+    w1 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 16)), mask);
+    w2 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 32)), mask);
+    w3 = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i *)(data + 48)), mask);
+
+    FIT_SHANI_ROUNDS4(w0, 0);
+    FIT_SHANI_ROUNDS4(w1, 4);
+    FIT_SHANI_ROUNDS4(w2, 8);
+    FIT_SHANI_ROUNDS4(w3, 12);
+    for (i = 16; i < 64; i += 16)
+    {
+        FIT_SHANI_SCHED(w0, w1, w2, w3);
+        FIT_SHANI_ROUNDS4(w0, i);
+        FIT_SHANI_SCHED(w1, w2, w3, w0);
+        FIT_SHANI_ROUNDS4(w1, i + 4);
+        FIT_SHANI_SCHED(w2, w3, w0, w1);
+        FIT_SHANI_ROUNDS4(w2, i + 8);
+        FIT_SHANI_SCHED(w3, w0, w1, w2);
+        FIT_SHANI_ROUNDS4(w3, i + 12);
+    }
+
+    abef = _mm_add_epi32(abef, abef_save);
+    cdgh = _mm_add_epi32(cdgh, cdgh_save);
+
+    // Convert state back from ABEF/CDGH to ABCD/EFGH.
+    tmp = _mm_shuffle_epi32(abef, 0x1B);
+    cdgh = _mm_shuffle_epi32(cdgh, 0xB1);
+    _mm_storeu_si128((__m128i *)&state[0], _mm_blend_epi16(tmp, cdgh, 0xF0));
+    _mm_storeu_si128((__m128i *)&state[4], _mm_alignr_epi8(cdgh, tmp, 8));
+}
+
+#endif // #ifdef FIT_SHANI_AVAILABLE
+
+/**
+ *
+ * mbedtls_sha256_process
+ *
+ * SHA-256 block compression function used by mbedtls SHA-256 (replaces mbedtls
+ * version, see MBEDTLS_SHA256_PROCESS_ALT).
+ *
+ * @param   ctx <--> mbedtls SHA-256 context.
+ * @param   data --> Block of data to be hashed.
+ *
+ */
+void mbedtls_sha256_process(mbedtls_sha256_context *ctx, const unsigned char data[64])
+{
+#ifdef FIT_SHANI_AVAILABLE
+    if (fit_shani_supported())
+    {
+        fit_sha256_process_shani(ctx->state, data);
+        return;
+    }
+#endif // #ifdef FIT_SHANI_AVAILABLE
+
+    fit_sha256_process_c(ctx->state, data);
+}
+
+/**
+ *
+ * fit_sha256_digest
+ *
+ * This function will calculate SHA-256 digest of the data passed in. Data is read
+ * in 64 byte blocks through its fit_pointer read function.
+ *
+ * @param   msg --> Pointer to data passed in for which digest needs to be calculated.
+ * @param   hash <-- On return it will contain the digest (FIT_SHA256_HASH_SIZE bytes).
+ *
+ */
+fit_status_t fit_sha256_digest(fit_pointer_t *msg, uint8_t *hash)
+{
+    mbedtls_sha256_context ctx;
+    uint8_t block[FIT_SHA256_BLOCK_SIZE] = {0};
+    fit_pointer_t fitptr    = {0};
+    uint16_t cntr           = 0;
+
+    if (msg == NULL || hash == NULL)
+        return FIT_INVALID_PARAM;
+
+    // Initialize the read pointer.
+    fitptr.read_byte = msg->read_byte;
+
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_starts(&ctx, 0);
+    for (cntr = 0; cntr < msg->length; cntr += FIT_SHA256_BLOCK_SIZE)
+    {
+        fitptr.data = msg->data + cntr;
+        fitptr.length = msg->length - cntr;
+        if (fitptr.length > FIT_SHA256_BLOCK_SIZE)
+            fitptr.length = FIT_SHA256_BLOCK_SIZE;
+        fitptr_memcpy(block, &fitptr);
+        mbedtls_sha256_update(&ctx, block, fitptr.length);
+    }
+    mbedtls_sha256_finish(&ctx, hash);
+    mbedtls_sha256_free(&ctx);
+
+    return FIT_STATUS_OK;
+}
+
+#endif // #ifdef FIT_USE_SHA256_DIGEST
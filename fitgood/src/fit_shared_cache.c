@@ -0,0 +1,124 @@
+/****************************************************************************\
+**
+** fit_shared_cache.c
+**
+** Defines functionality for license validation cache shared by FIT core contexts.
+** Snapshot is protected by sequence lock: writer makes sequence number odd, writes
+** the snapshot and makes it even again; reader copies the snapshot and accepts it
+** only if sequence number was even and unchanged during the copy.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifdef FIT_USE_SHARED_CACHE
+
+/* Required Includes ********************************************************/
+#include "fit_shared_cache.h"
+#include "internal.h"
+#include "hwdep.h"
+#include "fit_debug.h"
+
+/* Functions ****************************************************************/
+
+/**
+ *
+ * fit_shared_cache_init
+ *
+ * This function will initialize shared cache with no validated license. Must not
+ * be called while any context attached to shared cache is in use.
+ *
+ * @param   shared <-- Shared cache to be initialized.
+ *
+ */
+void fit_shared_cache_init(fit_shared_cache_t *shared)
+{
+    fit_memset((uint8_t *)shared, 0, sizeof(fit_shared_cache_t));
+}
+
+/**
+ *
+ * fit_shared_cache_read
+ *
+ * This function will copy last published snapshot out of shared cache. No lock is
+ * taken; if snapshot is written at the same time then copy is repeated, at most
+ * FIT_SHARED_CACHE_RETRIES times. Returns TRUE if consistent snapshot was copied.
+ *
+ * @param   shared --> Shared cache.
+ * @param   snapshot <-- On return it will contain copy of snapshot.
+ * @param   seq <-- On return it will contain sequence number of snapshot copied.
+ *
+ */
+uint8_t fit_shared_cache_read(fit_shared_cache_t *shared,
+                              fit_cache_snapshot_t *snapshot,
+                              uint32_t *seq)
+{
+    fit_cache_snapshot_words_t copy;
+    uint32_t start  = 0;
+    uint16_t tries  = 0;
+    uint16_t cntr   = 0;
+
+    for (tries = 0; tries < FIT_SHARED_CACHE_RETRIES; tries++)
+    {
+        start = FIT_ATOMIC_LOAD_ACQ(&shared->m_seq);
+        if (start & 1)
+            continue;
+
+        for (cntr = 0; cntr < sizeof(copy.m_words) / sizeof(uint32_t); cntr++)
+            copy.m_words[cntr] = FIT_ATOMIC_LOAD(&shared->m_data.m_words[cntr]);
+
+        // Snapshot loads must complete before sequence number is read again.
+        FIT_ATOMIC_FENCE_ACQ();
+        if (FIT_ATOMIC_LOAD(&shared->m_seq) == start)
+        {
+            fit_memcpy((uint8_t *)snapshot, (uint8_t *)&copy.m_snapshot, sizeof(fit_cache_snapshot_t));
+            *seq = start;
+            return TRUE;
+        }
+    }
+
+    DBG(FIT_TRACE_INFO, "[fit_shared_cache_read]: no consistent snapshot after %d tries\n", tries);
+    return FALSE;
+}
+
+/**
+ *
+ * fit_shared_cache_publish
+ *
+ * This function will publish new snapshot. Writers do not wait for each other: if
+ * other context is publishing at the same time then FALSE is returned and snapshot
+ * is not written (it will be published by later validation). Readers are never
+ * blocked.
+ *
+ * @param   shared <--> Shared cache.
+ * @param   snapshot --> Snapshot to be published.
+ *
+ */
+uint8_t fit_shared_cache_publish(fit_shared_cache_t *shared,
+                                 const fit_cache_snapshot_t *snapshot)
+{
+    fit_cache_snapshot_words_t copy;
+    uint32_t seq    = 0;
+    uint16_t cntr   = 0;
+
+    if (!FIT_ATOMIC_TRYLOCK(&shared->m_lock))
+        return FALSE;
+
+    fit_memset((uint8_t *)&copy, 0, sizeof(copy));
+    fit_memcpy((uint8_t *)&copy.m_snapshot, (uint8_t *)snapshot, sizeof(fit_cache_snapshot_t));
+
+    seq = FIT_ATOMIC_LOAD(&shared->m_seq);
+    FIT_ATOMIC_STORE(&shared->m_seq, seq + 1);
+    // Odd sequence number must be visible before any snapshot word is changed.
+    FIT_ATOMIC_FENCE_REL();
+    for (cntr = 0; cntr < sizeof(copy.m_words) / sizeof(uint32_t); cntr++)
+        FIT_ATOMIC_STORE(&shared->m_data.m_words[cntr], copy.m_words[cntr]);
+    FIT_ATOMIC_STORE_REL(&shared->m_seq, seq + 2);
+
+    FIT_ATOMIC_UNLOCK(&shared->m_lock);
+
+    DBG(FIT_TRACE_INFO, "[fit_shared_cache_publish]: seq=%ld\n", seq + 2);
+    return TRUE;
+}
+
+#endif // #ifdef FIT_USE_SHARED_CACHE
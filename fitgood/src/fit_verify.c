@@ -0,0 +1,672 @@
+/****************************************************************************\
+**
+** fit_verify.c
+**
+** Defines functionality for resumable (time sliced) license verification. Each
+** call of fit_verify_step performs bounded amount of work, so license verification
+** can be done in between other tasks of bare metal super loop or cooperative
+** scheduler without missing their deadlines.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+/* Required Includes ********************************************************/
+#include "fit_verify.h"
+#include "parser.h"
+#include "internal.h"
+#include "fit_debug.h"
+#include "fit_rsa.h"
+#include "dm_hash.h"
+#include "fit_ed25519.h"
+#include "fit_sha256.h"
+
+/* Constants ****************************************************************/
+
+// Gets fit_verify_rsa_t kept in verification context.
+#define FIT_VERIFY_RSA(ctx)     ((fit_verify_rsa_t *)(void *)&(ctx)->m_rsa)
+
+/* Types ********************************************************************/
+
+// State of verification context that refers to mbedtls types; kept in storage of
+// fit_verify_ctx_t (m_rsa), so fit_verify.h does not depend on mbedtls headers.
+typedef struct fit_verify_rsa {
+    // RSA public key (parsed in FIT_VERIFY_STATE_KEY).
+    fit_rsa_key_t           m_rsakey;
+    // Signature and accumulator for rsa public operation.
+    mbedtls_mpi             m_sig;
+    mbedtls_mpi             m_acc;
+#ifdef FIT_USE_SHA256_DIGEST
+    // SHA-256 context for licenses signed over SHA-256 digest.
+    mbedtls_sha256_context  m_sha;
+#endif
+} fit_verify_rsa_t;
+
+// Fails to compile if FIT_VERIFY_RSA_SIZE is too small for fit_verify_rsa_t.
+typedef char fit_verify_rsa_size_check_t[(sizeof(fit_verify_rsa_t) <= FIT_VERIFY_RSA_SIZE) ? 1 : -1];
+
+/* Functions ****************************************************************/
+
+#ifdef FIT_USE_CRYPTO_PROVIDER
+
+/**
+ *
+ * fit_verify_hash_job
+ *
+ * This function will calculate hash of data by jobs submitted to crypto provider.
+ * Each job covers at most budget blocks; last block (with padding) and finalization
+ * is one more job. If job is not completed, budget is exhausted and step returns,
+ * so caller can do other work while provider is busy.
+ *
+ * @param   ctx <--> Pointer to verification context.
+ * @param   data --> Data to be hashed.
+ * @param   alg --> Hash algorithm. See enum fit_crypto_hash
+ * @param   hash <--> Hash value; should be initialized before first call.
+ * @param   budget <--> Number of operations left in this step.
+ *
+ */
+static fit_status_t fit_verify_hash_job(fit_verify_ctx_t *ctx,
+                                        fit_pointer_t *data,
+                                        uint8_t alg,
+                                        uint8_t *hash,
+                                        uint16_t *budget)
+{
+    fit_crypto_job_t *job   = &ctx->m_job;
+    fit_status_t status     = FIT_STATUS_OK;
+    uint16_t blocks         = 0;
+
+    for (;;)
+    {
+        // Checking completion of submitted job does not consume budget.
+        if (job->m_state != FIT_CRYPTO_JOB_IDLE)
+        {
+            status = fit_crypto_poll(job);
+            if (status == FIT_CRYPTO_PENDING)
+            {
+                *budget = 0;
+                return FIT_VERIFY_IN_PROGRESS;
+            }
+            job->m_state = FIT_CRYPTO_JOB_IDLE;
+            if (status != FIT_STATUS_OK)
+                return status;
+            if (job->m_op == FIT_CRYPTO_OP_HASH_FINAL)
+                return FIT_STATUS_OK;
+            ctx->m_offset += job->m_length;
+        }
+        if (*budget == 0)
+            return FIT_VERIFY_IN_PROGRESS;
+
+        fit_memset((uint8_t *)job, 0, sizeof(fit_crypto_job_t));
+        job->m_provider = ctx->m_fitctx->m_crypto;
+        job->m_alg = alg;
+        job->m_output = hash;
+        job->m_input = data->data + ctx->m_offset;
+        blocks = (uint16_t)(data->length - ctx->m_offset);
+        blocks = (blocks > DM_CIPHER_BLOCK_SIZE) ? (blocks - 1)/DM_CIPHER_BLOCK_SIZE : 0;
+        if (blocks > 0)
+        {
+            if (blocks > *budget)
+                blocks = *budget;
+            job->m_op = FIT_CRYPTO_OP_HASH_UPDATE;
+            job->m_length = blocks*DM_CIPHER_BLOCK_SIZE;
+            *budget -= blocks;
+        }
+        else
+        {
+            job->m_op = FIT_CRYPTO_OP_HASH_FINAL;
+            job->m_length = data->length - ctx->m_offset;
+            job->m_total = data->length;
+            (*budget)--;
+        }
+        status = fit_crypto_submit(job);
+        if (status != FIT_STATUS_OK)
+            return status;
+    }
+}
+
+#endif // #ifdef FIT_USE_CRYPTO_PROVIDER
+
+#ifdef FIT_USE_SHA256_DIGEST
+/**
+ *
+ * fit_verify_sha256
+ *
+ * This function will calculate SHA-256 digest of license part for at most budget
+ * operations (one operation is one 64 bytes block). Returns FIT_VERIFY_IN_PROGRESS
+ * till digest is not completed.
+ *
+ * @param   ctx <--> Pointer to verification context.
+ * @param   budget <--> Number of operations left in this step.
+ *
+ */
+static fit_status_t fit_verify_sha256(fit_verify_ctx_t *ctx, uint16_t *budget)
+{
+    fit_verify_rsa_t *rsastate  = FIT_VERIFY_RSA(ctx);
+    uint8_t block[FIT_SHA256_BLOCK_SIZE] = {0};
+    fit_pointer_t fitptr    = {0};
+
+    fitptr.read_byte = ctx->m_licpart.read_byte;
+
+    while (*budget > 0 && ctx->m_offset < ctx->m_licpart.length)
+    {
+        fitptr.data = ctx->m_licpart.data + ctx->m_offset;
+        fitptr.length = ctx->m_licpart.length - ctx->m_offset;
+        if (fitptr.length > FIT_SHA256_BLOCK_SIZE)
+            fitptr.length = FIT_SHA256_BLOCK_SIZE;
+        fitptr_memcpy(block, &fitptr);
+        mbedtls_sha256_update(&rsastate->m_sha, block, fitptr.length);
+        ctx->m_offset += fitptr.length;
+        (*budget)--;
+    }
+    if (*budget == 0)
+        return FIT_VERIFY_IN_PROGRESS;
+
+    mbedtls_sha256_finish(&rsastate->m_sha, ctx->m_hash);
+    (*budget)--;
+
+    return FIT_STATUS_OK;
+}
+#endif // #ifdef FIT_USE_SHA256_DIGEST
+
+/**
+ *
+ * fit_verify_abreast_hash
+ *
+ * This function will calculate Abreast DM hash of license part for at most budget
+ * operations (one operation is one 16 bytes block). Returns FIT_VERIFY_IN_PROGRESS
+ * till hash is not completed.
+ *
+ * @param   ctx <--> Pointer to verification context.
+ * @param   budget <--> Number of operations left in this step.
+ *
+ */
+static fit_status_t fit_verify_abreast_hash(fit_verify_ctx_t *ctx, uint16_t *budget)
+{
+#ifdef FIT_USE_SHA256_DIGEST
+    if (ctx->m_algid == SHA256_ALGID)
+        return fit_verify_sha256(ctx, budget);
+#endif // #ifdef FIT_USE_SHA256_DIGEST
+#ifdef FIT_USE_CRYPTO_PROVIDER
+    return fit_verify_hash_job(ctx, &ctx->m_licpart, FIT_CRYPTO_HASH_ABREAST_DM,
+                               ctx->m_hash, budget);
+#else
+    fit_pointer_t fitptr    = ctx->m_licpart;
+
+    // Pass data to the hash in blocks (16 bytes each). Padding of last block and
+    // finalization is done as one more operation.
+    while (*budget > 0 && ctx->m_offset < ctx->m_licpart.length)
+    {
+        fitptr.data = ctx->m_licpart.data + ctx->m_offset;
+        fitptr.length = ctx->m_licpart.length - ctx->m_offset;
+        if (fitptr.length > ABREAST_DM_CIPHER_BLOCK_SIZE)
+            fitptr.length = ABREAST_DM_CIPHER_BLOCK_SIZE;
+        fit_abreast_dm_update(&ctx->m_abreast, &fitptr);
+        ctx->m_offset += fitptr.length;
+        (*budget)--;
+    }
+    if (*budget == 0)
+        return FIT_VERIFY_IN_PROGRESS;
+
+    fit_abreast_dm_final(&ctx->m_abreast, ctx->m_hash);
+    (*budget)--;
+
+    return FIT_STATUS_OK;
+#endif // #ifdef FIT_USE_CRYPTO_PROVIDER
+}
+
+/**
+ *
+ * fit_verify_dm_hash
+ *
+ * This function will calculate Davies Meyer hash of license for at most budget
+ * operations (one operation is one 16 bytes block). Returns FIT_VERIFY_IN_PROGRESS
+ * till hash is not completed.
+ *
+ * @param   ctx <--> Pointer to verification context.
+ * @param   budget <--> Number of operations left in this step.
+ *
+ */
+static fit_status_t fit_verify_dm_hash(fit_verify_ctx_t *ctx, uint16_t *budget)
+{
+#ifdef FIT_USE_CRYPTO_PROVIDER
+    fit_pointer_t license   = ctx->m_license;
+
+    license.length = ctx->m_dmlength;
+    return fit_verify_hash_job(ctx, &license, FIT_CRYPTO_HASH_DM, ctx->m_dmhash, budget);
+#else
+    fit_status_t status     = FIT_STATUS_OK;
+    fit_pointer_t fitptr    = ctx->m_license;
+
+    // Pass data to the hash in blocks (16 bytes each). Padding of last block and
+    // final hash is done as one more operation.
+    while (*budget > 0 && ctx->m_offset < ctx->m_dmlength)
+    {
+        fitptr.data = ctx->m_license.data + ctx->m_offset;
+        fitptr.length = ctx->m_dmlength - ctx->m_offset;
+        if (fitptr.length > DM_CIPHER_BLOCK_SIZE)
+            fitptr.length = DM_CIPHER_BLOCK_SIZE;
+        status = fit_dm_hash_update(&ctx->m_dm, &fitptr);
+        if (status != FIT_STATUS_OK)
+            return status;
+        ctx->m_offset += fitptr.length;
+        (*budget)--;
+    }
+    if (*budget == 0)
+        return FIT_VERIFY_IN_PROGRESS;
+
+    status = fit_dm_hash_final(&ctx->m_dm, ctx->m_dmhash);
+    (*budget)--;
+
+    return status;
+#endif // #ifdef FIT_USE_CRYPTO_PROVIDER
+}
+
+/**
+ *
+ * fit_verify_rsa_exp
+ *
+ * This function will perform rsa public operation (signature ^ E mod N) for at most
+ * budget operations using left-to-right square and multiply. One operation is one
+ * modular squaring or one modular multiplication.
+ *
+ * @param   ctx <--> Pointer to verification context.
+ * @param   budget <--> Number of operations left in this step.
+ *
+ */
+static fit_status_t fit_verify_rsa_exp(fit_verify_ctx_t *ctx, uint16_t *budget)
+{
+    fit_verify_rsa_t *rsastate  = FIT_VERIFY_RSA(ctx);
+    mbedtls_rsa_context *rsa = mbedtls_pk_rsa(rsastate->m_rsakey.m_pk);
+    int ret = 0;
+
+    while (*budget > 0 && ctx->m_bit >= 0)
+    {
+        if (ctx->m_mul == FALSE)
+        {
+            ret = mbedtls_mpi_mul_mpi(&rsastate->m_acc, &rsastate->m_acc, &rsastate->m_acc);
+            // Multiplication is required only if exponent bit is set.
+            ctx->m_mul = (uint8_t)mbedtls_mpi_get_bit(&rsa->E, ctx->m_bit);
+            if (ctx->m_mul == FALSE)
+                ctx->m_bit--;
+        }
+        else
+        {
+            ret = mbedtls_mpi_mul_mpi(&rsastate->m_acc, &rsastate->m_acc, &rsastate->m_sig);
+            ctx->m_mul = FALSE;
+            ctx->m_bit--;
+        }
+        if (ret == 0)
+            ret = mbedtls_mpi_mod_mpi(&rsastate->m_acc, &rsastate->m_acc, &rsa->N);
+        if (ret != 0)
+        {
+            DBG(FIT_TRACE_ERROR, "[fit_verify_rsa_exp] FAILED -0x%04x\n", -ret);
+            return FIT_RSA_VERIFY_FAILED;
+        }
+        (*budget)--;
+    }
+
+    if (ctx->m_bit >= 0)
+        return FIT_VERIFY_IN_PROGRESS;
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_verify_release
+ *
+ * This function will free memory allocated during verification and leave arena
+ * scope held by context. Can be called any number of times.
+ *
+ * @param   ctx <--> Pointer to verification context.
+ *
+ */
+static void fit_verify_release(fit_verify_ctx_t *ctx)
+{
+    fit_verify_rsa_t *rsastate = FIT_VERIFY_RSA(ctx);
+
+    mbedtls_mpi_free(&rsastate->m_acc);
+    mbedtls_mpi_free(&rsastate->m_sig);
+    fit_rsa_key_free(&rsastate->m_rsakey);
+#ifdef FIT_USE_SHA256_DIGEST
+    mbedtls_sha256_free(&rsastate->m_sha);
+#endif
+#ifdef FIT_USE_MBEDTLS_ARENA
+    if (ctx->m_scope == TRUE)
+        fit_arena_leave();
+    ctx->m_scope = FALSE;
+#endif
+}
+
+/**
+ *
+ * fit_verify_cleanup
+ *
+ * This function will free memory allocated during verification and update the
+ * license cache as per result of verification.
+ *
+ * @param   ctx <--> Pointer to verification context.
+ * @param   status --> Result of verification.
+ *
+ */
+static void fit_verify_cleanup(fit_verify_ctx_t *ctx, fit_status_t status)
+{
+    fit_verify_release(ctx);
+
+    if (status != FIT_STATUS_OK)
+    {
+        ctx->m_fitctx->m_cache.m_rsa_check_done = FALSE;
+        fit_memset(ctx->m_fitctx->m_cache.m_dm_hash, 0, sizeof(ctx->m_fitctx->m_cache.m_dm_hash));
+#ifdef FIT_USE_TRUSTED_STORAGE
+        ctx->m_fitctx->m_cache.m_trusted = FALSE;
+#endif
+    }
+
+    ctx->m_status = status;
+    ctx->m_state = FIT_VERIFY_STATE_DONE;
+}
+
+/**
+ *
+ * fit_verify_start
+ *
+ * This function will initialize the context for resumable license verification.
+ * Verification is then performed by calling fit_verify_step till it returns status
+ * other than FIT_VERIFY_IN_PROGRESS. Result of verification is same as result of
+ * fit_licenf_validate_license.
+ *
+ * @param   ctx <-- Pointer to caller owned verification context.
+ * @param   license --> Start address of the license of type fit_pointer_t. License
+ *                      data should not be changed till verification is in progress.
+ * @param   key --> Start address of the rsa public key of type fit_pointer_t.
+ *
+ * Result is written into license validation cache of default context (see
+ * fit_ctx_default).
+ *
+ */
+fit_status_t fit_verify_start(fit_verify_ctx_t *ctx,
+                              fit_pointer_t *license,
+                              fit_pointer_t *key)
+{
+    return fit_verify_start_ctx(fit_ctx_default(), ctx, license, key);
+}
+
+/**
+ *
+ * fit_verify_start_ctx
+ *
+ * Same as fit_verify_start; license validation cache of passed in FIT core context
+ * is updated with result of verification.
+ *
+ * @param   fitctx <--> FIT core context; should stay available till verification
+ *                      is done.
+ * @param   ctx <-- Pointer to caller owned verification context.
+ * @param   license --> Start address of the license of type fit_pointer_t.
+ * @param   key --> Start address of the rsa public key of type fit_pointer_t.
+ *
+ */
+fit_status_t fit_verify_start_ctx(fit_ctx_t *fitctx,
+                                  fit_verify_ctx_t *ctx,
+                                  fit_pointer_t *license,
+                                  fit_pointer_t *key)
+{
+    if (fitctx == NULL)
+        return FIT_INVALID_PARAM;
+    if (ctx == NULL)
+        return FIT_INVALID_PARAM_1;
+    if (license == NULL || license->read_byte == NULL)
+        return FIT_INVALID_PARAM_2;
+    if (key == NULL || key->read_byte == NULL)
+        return FIT_INVALID_PARAM_3;
+
+    DBG(FIT_TRACE_INFO, "[fit_verify_start]: license=0x%p length=%hd\n", license->data, license->length);
+
+    fit_memset((uint8_t *)ctx, 0, sizeof(fit_verify_ctx_t));
+#ifdef FIT_USE_MBEDTLS_ARENA
+    // Signature and accumulator stay in arena till verification is done.
+    fit_arena_enter();
+    ctx->m_scope = TRUE;
+#endif
+    fit_rsa_key_init(&FIT_VERIFY_RSA(ctx)->m_rsakey, key);
+    mbedtls_mpi_init(&FIT_VERIFY_RSA(ctx)->m_sig);
+    mbedtls_mpi_init(&FIT_VERIFY_RSA(ctx)->m_acc);
+
+    ctx->m_license = *license;
+    ctx->m_fitctx = fitctx;
+    ctx->m_status = FIT_VERIFY_IN_PROGRESS;
+    ctx->m_state = FIT_VERIFY_STATE_LOCATE;
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_verify_step
+ *
+ * This function will perform next step of license verification. Each step performs
+ * at most budget operations, where one operation is hashing of one 16 bytes block,
+ * one modular squaring/multiplication of rsa public operation, one bit of Ed25519
+ * double and add pass or one pass of license parsing. Returns FIT_VERIFY_IN_PROGRESS
+ * till verification is not completed, then result of verification.
+ *
+ * @param   ctx <--> Pointer to verification context initialized by fit_verify_start.
+ * @param   budget --> Maximum number of operations to perform in this step. If zero
+ *                     then FIT_VERIFY_STEP_BUDGET is used.
+ *
+ */
+fit_status_t fit_verify_step(fit_verify_ctx_t *ctx, uint16_t budget)
+{
+    fit_status_t status             = FIT_STATUS_OK;
+    fitcontextdata context          = {0};
+    uint8_t em[RSA_SIG_SIZE]        = {0};
+    mbedtls_rsa_context *rsa        = NULL;
+    fit_verify_rsa_t *rsastate      = NULL;
+    uint16_t cntr                   = 0;
+
+    if (ctx == NULL || ctx->m_state == FIT_VERIFY_STATE_IDLE)
+        return FIT_INVALID_PARAM_1;
+    rsastate = FIT_VERIFY_RSA(ctx);
+
+    if (budget == 0)
+        budget = FIT_VERIFY_STEP_BUDGET;
+
+    while (budget > 0 && ctx->m_state != FIT_VERIFY_STATE_DONE)
+    {
+        switch (ctx->m_state)
+        {
+            case FIT_VERIFY_STATE_LOCATE:
+                status = fit_get_signed_data(&ctx->m_license, &ctx->m_licpart, &ctx->m_signature);
+#if defined(FIT_USE_SEGMENTED_HASH) || defined(FIT_USE_ED25519) || defined(FIT_USE_SHA256_DIGEST)
+                // Only licenses signed over Abreast DM hash (or SHA-256 digest) can
+                // be verified in steps.
+                if (status == FIT_STATUS_OK)
+                {
+                    uint8_t algid = AES_ALGID;
+
+                    status = fit_get_signature_algid(&ctx->m_license, &algid);
+#ifdef FIT_USE_ED25519
+                    // Ed25519 signature is over Abreast DM hash as well; it is
+                    // verified in FIT_VERIFY_STATE_ED25519 instead of rsa states.
+                    if (status == FIT_STATUS_OK && algid == ED25519_ALGID)
+                        ctx->m_algid = ED25519_ALGID;
+                    else if (status == FIT_STATUS_OK && ctx->m_signature.length != RSA_SIG_SIZE)
+                        status = FIT_INVALID_FIELD_LEN;
+                    else
+#endif
+#ifdef FIT_USE_SHA256_DIGEST
+                    if (status == FIT_STATUS_OK && algid == SHA256_ALGID)
+                        ctx->m_algid = SHA256_ALGID;
+                    else
+#endif
+                    if (status == FIT_STATUS_OK && algid != AES_ALGID)
+                        status = FIT_INVALID_SIG_ID;
+                }
+#endif // #if defined(FIT_USE_SEGMENTED_HASH) || defined(FIT_USE_ED25519) || defined(FIT_USE_SHA256_DIGEST)
+#ifdef FIT_USE_CRYPTO_PROVIDER
+                AES256_AbreastDmHash_Init(ctx->m_hash);
+#else
+                fit_abreast_dm_start(&ctx->m_abreast);
+#endif
+#ifdef FIT_USE_SHA256_DIGEST
+                mbedtls_sha256_starts(&rsastate->m_sha, 0);
+#endif
+                ctx->m_offset = 0;
+                ctx->m_state = FIT_VERIFY_STATE_ABREAST_HASH;
+                budget--;
+                break;
+
+            case FIT_VERIFY_STATE_ABREAST_HASH:
+                status = fit_verify_abreast_hash(ctx, &budget);
+                if (status == FIT_STATUS_OK)
+                    ctx->m_state = FIT_VERIFY_STATE_KEY;
+                break;
+
+            case FIT_VERIFY_STATE_KEY:
+#ifdef FIT_USE_ED25519
+                if (ctx->m_algid == ED25519_ALGID)
+                {
+                    status = fit_ed25519_start_signature(&ctx->m_ed25519, &ctx->m_signature,
+                                                         ctx->m_hash, &rsastate->m_rsakey.m_key);
+                    ctx->m_state = FIT_VERIFY_STATE_ED25519;
+                    budget--;
+                    break;
+                }
+#endif // #ifdef FIT_USE_ED25519
+                status = fit_rsa_key_prepare(&rsastate->m_rsakey);
+                if (status == FIT_STATUS_OK)
+                {
+                    rsa = mbedtls_pk_rsa(rsastate->m_rsakey.m_pk);
+                    // Read signature from license memory.
+                    fitptr_memcpy(em, &ctx->m_signature);
+                    if (mbedtls_mpi_read_binary(&rsastate->m_sig, em, RSA_SIG_SIZE) != 0 ||
+                        mbedtls_mpi_cmp_mpi(&rsastate->m_sig, &rsa->N) >= 0 ||
+                        mbedtls_mpi_cmp_int(&rsa->E, 0) <= 0 ||
+                        mbedtls_mpi_copy(&rsastate->m_acc, &rsastate->m_sig) != 0)
+                    {
+                        status = FIT_RSA_VERIFY_FAILED;
+                    }
+                    // Most significant bit of exponent is covered by copy of signature.
+                    ctx->m_bit = (int16_t)mbedtls_mpi_bitlen(&rsa->E) - 2;
+                    ctx->m_mul = FALSE;
+                }
+                ctx->m_state = FIT_VERIFY_STATE_RSA_EXP;
+                budget--;
+                break;
+
+#ifdef FIT_USE_ED25519
+            case FIT_VERIFY_STATE_ED25519:
+                status = fit_ed25519_verify_step(&ctx->m_ed25519, &budget);
+                if (status != FIT_VERIFY_IN_PROGRESS)
+                {
+                    DBG(FIT_TRACE_INFO, "[fit_verify_step] ed25519 verify status %d\n", status);
+                }
+                if (status == FIT_STATUS_OK)
+                    ctx->m_state = FIT_VERIFY_STATE_PARSE;
+                break;
+#endif // #ifdef FIT_USE_ED25519
+
+            case FIT_VERIFY_STATE_RSA_EXP:
+                status = fit_verify_rsa_exp(ctx, &budget);
+                if (status == FIT_STATUS_OK)
+                    ctx->m_state = FIT_VERIFY_STATE_RSA_CHECK;
+                break;
+
+            case FIT_VERIFY_STATE_RSA_CHECK:
+                if (mbedtls_mpi_write_binary(&rsastate->m_acc, em, RSA_SIG_SIZE) != 0)
+                    status = FIT_RSA_VERIFY_FAILED;
+                else
+                    status = fit_rsa_check_encoding(em, ctx->m_hash);
+                DBG(FIT_TRACE_INFO, "[fit_verify_step] rsa verify status %d\n", status);
+                ctx->m_state = FIT_VERIFY_STATE_PARSE;
+                budget--;
+                break;
+
+            case FIT_VERIFY_STATE_PARSE:
+                // Validate license data and get the length of data for Davies Meyer hash.
+                context.m_level = STRUCT_V2C_LEVEL;
+                context.m_index = LICENSE_FIELD;
+                context.m_operation = (uint8_t)FIT_PARSE_LICENSE;
+                status = fit_parse_object(STRUCT_V2C_LEVEL, LICENSE_FIELD, &ctx->m_license, &context);
+                if (status == FIT_STOP_PARSE)
+                    status = FIT_STATUS_OK;
+                ctx->m_dmlength = context.m_length;
+                ctx->m_offset = 0;
+#ifdef FIT_USE_CRYPTO_PROVIDER
+                fit_memset(ctx->m_dmhash, 0xFF, FIT_DM_HASH_SIZE);
+#else
+                fit_dm_hash_start(&ctx->m_dm);
+#endif
+                ctx->m_state = FIT_VERIFY_STATE_DM_HASH;
+                budget--;
+                break;
+
+            case FIT_VERIFY_STATE_DM_HASH:
+                status = fit_verify_dm_hash(ctx, &budget);
+                if (status == FIT_STATUS_OK)
+                {
+                    // License is verified; write Davies Meyer hash (and hash of key
+                    // bytes it was verified with) into the license cache.
+                    if (fit_rsa_key_hash(&rsastate->m_rsakey, ctx->m_fitctx->m_cache.m_key_hash) == FIT_STATUS_OK)
+                        ctx->m_fitctx->m_cache.m_rsa_check_done = TRUE;
+                    fit_memcpy(ctx->m_fitctx->m_cache.m_dm_hash, ctx->m_dmhash, FIT_DM_HASH_SIZE);
+#ifdef FIT_USE_TRUSTED_STORAGE
+                    // Storage generation is not tracked for time sliced verification.
+                    ctx->m_fitctx->m_cache.m_trusted = FALSE;
+#endif
+#ifdef FIT_USE_SEGMENTED_HASH
+                    ctx->m_fitctx->m_cache.m_algid = AES_ALGID;
+#endif
+                    ctx->m_state = FIT_VERIFY_STATE_NODE_LOCK;
+                }
+                break;
+
+            case FIT_VERIFY_STATE_NODE_LOCK:
+                status = fit_check_node_lock(&ctx->m_license);
+                budget--;
+                fit_verify_cleanup(ctx, status);
+                break;
+
+            default:
+                status = FIT_INTERNAL_ERROR;
+                break;
+        }
+
+        if (status != FIT_STATUS_OK && status != FIT_VERIFY_IN_PROGRESS)
+        {
+            DBG(FIT_TRACE_ERROR, "[fit_verify_step] verification failed in state %d, status %d\n",
+                ctx->m_state, status);
+            fit_verify_cleanup(ctx, status);
+        }
+    }
+
+    // Do not keep copies of signature data on stack.
+    for (cntr = 0; cntr < RSA_SIG_SIZE; cntr++)
+        em[cntr] = 0;
+
+    return (fit_status_t)ctx->m_status;
+}
+
+/**
+ *
+ * fit_verify_abort
+ *
+ * This function will release resources allocated for verification context. It should
+ * be called if verification is abandoned before fit_verify_step completes it.
+ *
+ * @param   ctx <--> Pointer to verification context.
+ *
+ */
+void fit_verify_abort(fit_verify_ctx_t *ctx)
+{
+    if (ctx == NULL || ctx->m_state == FIT_VERIFY_STATE_IDLE)
+        return;
+
+#ifdef FIT_USE_CRYPTO_PROVIDER
+    // Provider may still write into the context; wait for submitted job.
+    if (ctx->m_job.m_state == FIT_CRYPTO_JOB_PENDING)
+        fit_crypto_wait(&ctx->m_job);
+#endif
+    // Arena scope is left here unless fit_verify_cleanup did it already.
+    fit_verify_release(ctx);
+    ctx->m_state = FIT_VERIFY_STATE_IDLE;
+}
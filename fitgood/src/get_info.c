@@ -10,6 +10,88 @@
 #include "parser.h"
 #include "internal.h"
 
+/* Constants ****************************************************************/
+
+// Tags used by fit_licenf_get_info_flat; signature, fingerprint, version regex and
+// counters are not parsed.
+#define FIT_INFO_FLAT_TAGS_MASK     (FIT_TAG_MASK(FIT_ALGORITHM_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_LICGEN_VERSION_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_LM_VERSION_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_UID_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_ID_LC_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_VENDOR_ID_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_PRODUCT_ID_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_PRODUCT_PART_ID_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_FEATURE_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_PERPETUAL_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_START_DATE_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_END_DATE_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_DURATION_FROM_FIRST_USE_TAG_ID))
+
+#ifdef FIT_USE_INFO_TLV
+// Tags of objects and arrays; these have no value of their own and are not written
+// by fit_licenf_get_info_tlv.
+#define FIT_INFO_TLV_TREE_TAGS      (FIT_TAG_MASK(FIT_LICENSE_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_SIGNATURE_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_HEADER_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_LIC_CONTAINER_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_VENDOR_ARRAY_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_PRODUCT_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_PRODUCT_PART_ARRAY_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_LIC_PROP_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_FEATURE_ARRAY_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_COUNTER_ARRAY_TAG_ID))
+// Tags of string fields, written as FIT_INFO_TLV_BYTES; all others are integers.
+#define FIT_INFO_TLV_BYTES_TAGS     (FIT_TAG_MASK(FIT_RSA_SIG_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_UID_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_FP_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_VERSION_REGEX_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_SEGMENT_HASH_TAG_ID))
+// Size of buffer collecting records before they are passed to sink.
+#define FIT_INFO_TLV_BUF_SIZE       32
+#endif // #ifdef FIT_USE_INFO_TLV
+
+/* Types ********************************************************************/
+
+// State of fit_licenf_get_info_flat passed to fit_get_info_flat_cb as context.
+typedef struct fit_info_flat_state {
+    // License information being filled; table sizes are used as counters.
+    fit_info_flat_t *m_info;
+    // FALSE for sizing pass (entries are only counted), TRUE for fill pass.
+    uint8_t         m_fill;
+    // Number of table entries found by sizing pass (fill pass capacity).
+    uint16_t        m_max_products;
+    uint16_t        m_max_parts;
+    uint16_t        m_max_features;
+} fit_info_flat_state_t;
+
+#ifdef FIT_USE_INFO_TLV
+// State of fit_licenf_get_info_tlv passed to fit_get_info_tlv_cb as context.
+typedef struct fit_info_tlv_state {
+    // Sink function and its context.
+    fit_info_sink_t m_sink;
+    void            *m_context;
+    // Bytes accepted by sink in previous calls; these are encoded again but not
+    // passed to sink.
+    uint32_t        m_skip;
+    // Bytes encoded (or skipped) so far and not yet in m_buf.
+    uint32_t        m_pos;
+    // License field of record output is continued from; records are not written
+    // till it is found. NULL if output is not resumed or field was found.
+    uint8_t         *m_seek;
+    // License field and output offset of record being written.
+    uint8_t         *m_field;
+    uint32_t        m_field_pos;
+    // Same for record to continue from if sink does not accept whole m_buf, i.e.
+    // record being written when m_buf was empty.
+    uint8_t         *m_resume;
+    uint32_t        m_resume_pos;
+    // Records not yet passed to sink.
+    uint8_t         m_buf[FIT_INFO_TLV_BUF_SIZE];
+    uint8_t         m_len;
+} fit_info_tlv_state_t;
+#endif // #ifdef FIT_USE_INFO_TLV
+
 /**
  *
  * fit_licenf_get_info
@@ -29,11 +111,39 @@
 fit_status_t fit_licenf_get_info(fit_pointer_t* license,
                                  fit_get_info_callback callback_fn,
                                  void *context)
+{
+    return fit_licenf_get_info_filtered(license, FIT_ALL_TAGS_MASK, callback_fn, context);
+}
+
+/**
+ *
+ * fit_licenf_get_info_filtered
+ *
+ * This function is same as fit_licenf_get_info, but user provided callback function
+ * is called only for tags selected by tag mask. Objects and arrays for which neither
+ * their own tag nor tag of any field they contain is selected are skipped without
+ * reading their data, e.g. asking only for dates does not parse signature, header
+ * and counters. Checks done by parser while parsing (field types, lengths and
+ * offsets within license) are skipped for those as well, so success of filtered
+ * call does not mean that whole license is well formed; validate license with
+ * fit_licenf_validate_license first where that matters.
+ *
+ * @param   license --> Start address of the license in binary format.
+ * @param   tag_mask --> Tags for which callback is to be called; FIT_TAG_MASK of
+ *                       each wanted tag id or-ed together.
+ * @param   callback_fn --> User provided callback function to be called by fit core.
+ * @param   context <--> Pointer to user provided data structure.
+ *
+ */
+fit_status_t fit_licenf_get_info_filtered(fit_pointer_t* license,
+                                          uint32_t tag_mask,
+                                          fit_get_info_callback callback_fn,
+                                          void *context)
 {
     fit_status_t status         = FIT_STATUS_OK;
     fitcontextdata getinfo    = {0UL};
 
-    DBG(FIT_TRACE_INFO, "[fit_licenf_get_info]: pdata=0x%p \n", license);
+    DBG(FIT_TRACE_INFO, "[fit_licenf_get_info]: pdata=0x%p mask=0x%X \n", license, tag_mask);
 
     /* Validate parameters */
     if (callback_fn == NULL) {
@@ -47,6 +157,7 @@ fit_status_t fit_licenf_get_info(fit_pointer_t* license,
     getinfo.m_operation = (uint8_t)FIT_GET_LICENSE_INFO_DATA;
     getinfo.mparserdata.m_getinfodata.m_callback_fn = callback_fn;
     getinfo.mparserdata.m_getinfodata.m_get_info_data = context;
+    getinfo.mparserdata.m_getinfodata.m_tag_mask = tag_mask;
 
     /* Parse license data and call the user provided callback fn for each field. */
     status = fit_parse_object(STRUCT_V2C_LEVEL, LICENSE_FIELD, license, (void *)&getinfo);
@@ -58,3 +169,527 @@ fit_status_t fit_licenf_get_info(fit_pointer_t* license,
 
     return FIT_STATUS_OK;
 }
+
+/**
+ *
+ * fit_info_read_value
+ *
+ * This function will read integer value of license field. Small values are stored
+ * in field part (as value*2+2), other values in data part.
+ *
+ * @param   pdata --> Pointer to field data.
+ * @param   length --> Length of field data (PFIELD_SIZE or PARRAY_SIZE).
+ *
+ */
+static uint32_t fit_info_read_value(fit_pointer_t *pdata, uint16_t length)
+{
+    if (length == PFIELD_SIZE)
+        return (uint32_t)read_word(pdata->data, pdata->read_byte)/2 - 1;
+
+    return read_dword(pdata->data, pdata->read_byte);
+}
+
+/**
+ *
+ * fit_get_info_flat_cb
+ *
+ * Get info callback of fit_licenf_get_info_flat. In sizing pass it only counts
+ * products, product parts and features; in fill pass it also writes table entries.
+ * Product parts follow their product and features follow their product part in
+ * license data, so entries of each product/part are contiguous in tables.
+ *
+ * @param   tagid --> define unique field in sentinel fit license.
+ * @param   pdata --> Pointer to data that gives tagid information.
+ * @param   length --> Length of the data in bytes.
+ * @param   context <--> Pointer to fit_info_flat_state_t.
+ *
+ */
+static fit_status_t fit_get_info_flat_cb(uint8_t tagid,
+                                         fit_pointer_t *pdata,
+                                         uint16_t length,
+                                         void *context)
+{
+    fit_info_flat_state_t *state    = (fit_info_flat_state_t *)context;
+    fit_info_flat_t *info           = state->m_info;
+    fit_info_product_t *product     = NULL;
+    fit_info_part_t *part           = NULL;
+    fit_pointer_t fitptr            = {0};
+
+    // Features, dates and license model belong to last product part.
+    if (state->m_fill && info->m_part_count > 0)
+        part = &info->m_parts[info->m_part_count-1];
+
+    switch (tagid)
+    {
+        case FIT_ALGORITHM_TAG_ID:
+            info->m_algid = (uint16_t)fit_info_read_value(pdata, length);
+            break;
+
+        case FIT_LICGEN_VERSION_TAG_ID:
+            info->m_licgen_version = (uint16_t)fit_info_read_value(pdata, length);
+            break;
+
+        case FIT_LM_VERSION_TAG_ID:
+            info->m_lm_version = (uint16_t)fit_info_read_value(pdata, length);
+            break;
+
+        case FIT_UID_TAG_ID:
+            fitptr.read_byte = pdata->read_byte;
+            fitptr.data = pdata->data;
+            fitptr.length = FIT_UID_LEN;
+            fitptr_memcpy(info->m_uid, &fitptr);
+            break;
+
+        case FIT_ID_LC_TAG_ID:
+            info->m_container_id = fit_info_read_value(pdata, length);
+            break;
+
+        case FIT_VENDOR_ID_TAG_ID:
+            info->m_vendorid = fit_info_read_value(pdata, length);
+            break;
+
+        case FIT_PRODUCT_ID_TAG_ID:
+            if (state->m_fill && info->m_product_count >= state->m_max_products)
+                return FIT_INSUFFICIENT_MEMORY;
+            if (state->m_fill)
+            {
+                product = &info->m_products[info->m_product_count];
+                product->m_prodid = fit_info_read_value(pdata, length);
+                product->m_first_part = info->m_part_count;
+                product->m_part_count = 0;
+            }
+            info->m_product_count++;
+            break;
+
+        case FIT_PRODUCT_PART_ID_TAG_ID:
+            if (info->m_product_count == 0)
+                return FIT_INVALID_V2C;
+            if (state->m_fill && info->m_part_count >= state->m_max_parts)
+                return FIT_INSUFFICIENT_MEMORY;
+            if (state->m_fill)
+            {
+                part = &info->m_parts[info->m_part_count];
+                fit_memset((uint8_t *)part, 0, sizeof(fit_info_part_t));
+                part->m_partid = fit_info_read_value(pdata, length);
+                part->m_product = info->m_product_count-1;
+                part->m_first_feature = info->m_feature_count;
+                info->m_products[info->m_product_count-1].m_part_count++;
+            }
+            info->m_part_count++;
+            break;
+
+        case FIT_FEATURE_TAG_ID:
+            if (info->m_part_count == 0)
+                return FIT_INVALID_V2C;
+            if (state->m_fill && info->m_feature_count >= state->m_max_features)
+                return FIT_INSUFFICIENT_MEMORY;
+            if (part != NULL)
+            {
+                info->m_features[info->m_feature_count] = fit_info_read_value(pdata, length);
+                part->m_feature_count++;
+            }
+            info->m_feature_count++;
+            break;
+
+        case FIT_PERPETUAL_TAG_ID:
+            if (info->m_part_count == 0)
+                return FIT_INVALID_V2C;
+            if (part != NULL)
+            {
+                part->m_perpetual = (uint8_t)fit_info_read_value(pdata, length);
+                part->m_lictype = FIT_LIC_PERPETUAL;
+            }
+            break;
+
+        case FIT_START_DATE_TAG_ID:
+            if (info->m_part_count == 0)
+                return FIT_INVALID_V2C;
+            if (part != NULL)
+                part->m_startdate = fit_info_read_value(pdata, length);
+            break;
+
+        case FIT_END_DATE_TAG_ID:
+            if (info->m_part_count == 0)
+                return FIT_INVALID_V2C;
+            if (part != NULL)
+            {
+                part->m_enddate = fit_info_read_value(pdata, length);
+                part->m_lictype = FIT_LIC_EXPIRATION_BASED;
+            }
+            break;
+
+        case FIT_DURATION_FROM_FIRST_USE_TAG_ID:
+            if (info->m_part_count == 0)
+                return FIT_INVALID_V2C;
+            if (part != NULL)
+                part->m_lictype = FIT_LIC_TIME_BASED;
+            break;
+
+        default:
+            return FIT_STATUS_OK;
+    }
+
+    return FIT_CONTINUE_PARSE;
+}
+
+/**
+ *
+ * fit_licenf_get_info_flat
+ *
+ * This function will get license information (header, vendor, products, product
+ * parts and features) as flat tables linked by indexes. License is parsed twice:
+ * sizing pass counts table entries, then fill pass writes tables into the caller
+ * supplied arena. No memory is allocated and no state is kept between calls.
+ *
+ * @param   license --> Start address of the license in binary format.
+ * @param   info <-- On return it will contain license information; tables point
+ *                   into arena.
+ * @param   arena --> Caller supplied memory for tables (aligned to 4 bytes). If
+ *                    NULL, only size of arena required is returned.
+ * @param   size <--> On entry size of arena in bytes; on return number of bytes
+ *                    required for tables. If arena is too small FIT_INSUFFICIENT_MEMORY
+ *                    is returned.
+ *
+ */
+fit_status_t fit_licenf_get_info_flat(fit_pointer_t* license,
+                                      fit_info_flat_t *info,
+                                      uint8_t *arena,
+                                      uint16_t *size)
+{
+    fit_status_t status             = FIT_STATUS_OK;
+    fit_info_flat_state_t state     = {0};
+    uint32_t required               = 0;
+
+    DBG(FIT_TRACE_INFO, "[fit_licenf_get_info_flat]: pdata=0x%p \n", license);
+
+    if (license == NULL || license->read_byte == NULL)
+        return FIT_INVALID_PARAM_1;
+    if (info == NULL)
+        return FIT_INVALID_PARAM_2;
+    if (((size_t)arena % sizeof(uint32_t)) != 0)
+        return FIT_INVALID_PARAM_3;
+    if (size == NULL)
+        return FIT_INVALID_PARAM_4;
+
+    // Sizing pass.
+    fit_memset((uint8_t *)info, 0, sizeof(fit_info_flat_t));
+    state.m_info = info;
+    state.m_fill = FALSE;
+    status = fit_licenf_get_info_filtered(license, FIT_INFO_FLAT_TAGS_MASK,
+        fit_get_info_flat_cb, &state);
+    if (status != FIT_STATUS_OK)
+        return status;
+
+    // Entries sizes are multiples of 4 bytes, so all tables stay aligned.
+    required = (uint32_t)info->m_product_count*sizeof(fit_info_product_t) +
+               (uint32_t)info->m_part_count*sizeof(fit_info_part_t) +
+               (uint32_t)info->m_feature_count*sizeof(uint32_t);
+    if (required > 0xFFFF)
+        return FIT_INSUFFICIENT_MEMORY;
+    if (arena == NULL)
+    {
+        *size = (uint16_t)required;
+        return FIT_STATUS_OK;
+    }
+    if (*size < required)
+    {
+        *size = (uint16_t)required;
+        return FIT_INSUFFICIENT_MEMORY;
+    }
+    *size = (uint16_t)required;
+
+    // Fill pass; table sizes are counted again while entries are written.
+    state.m_max_products = info->m_product_count;
+    state.m_max_parts = info->m_part_count;
+    state.m_max_features = info->m_feature_count;
+    info->m_products = (fit_info_product_t *)arena;
+    info->m_parts = (fit_info_part_t *)(info->m_products + info->m_product_count);
+    info->m_features = (uint32_t *)(info->m_parts + info->m_part_count);
+    info->m_product_count = 0;
+    info->m_part_count = 0;
+    info->m_feature_count = 0;
+    state.m_fill = TRUE;
+
+    return fit_licenf_get_info_filtered(license, FIT_INFO_FLAT_TAGS_MASK,
+        fit_get_info_flat_cb, &state);
+}
+
+#ifdef FIT_USE_INFO_TLV
+
+/**
+ *
+ * fit_info_tlv_flush
+ *
+ * This function will pass collected records to sink. Part of data accepted by sink
+ * in previous calls of fit_licenf_get_info_tlv is skipped.
+ *
+ * @param   state <--> Encoder state.
+ *
+ */
+static fit_status_t fit_info_tlv_flush(fit_info_tlv_state_t *state)
+{
+    uint8_t *data       = state->m_buf;
+    uint16_t length     = state->m_len;
+    uint16_t accepted   = 0;
+
+    state->m_len = 0;
+    if (state->m_pos + length <= state->m_skip)
+    {
+        state->m_pos += length;
+        state->m_resume = state->m_field;
+        state->m_resume_pos = state->m_field_pos;
+        return FIT_STATUS_OK;
+    }
+    if (state->m_pos < state->m_skip)
+    {
+        data += state->m_skip - state->m_pos;
+        length -= (uint16_t)(state->m_skip - state->m_pos);
+        state->m_pos = state->m_skip;
+    }
+
+    accepted = state->m_sink(state->m_context, data, length);
+    state->m_pos += (accepted < length) ? accepted : length;
+    if (accepted < length)
+        return FIT_INFO_SINK_BUSY;
+    // Rest of record being written goes to next m_buf.
+    state->m_resume = state->m_field;
+    state->m_resume_pos = state->m_field_pos;
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_info_tlv_put
+ *
+ * This function will add data to collected records; full buffer is passed to sink.
+ *
+ * @param   state <--> Encoder state.
+ * @param   data --> Data to be written.
+ * @param   length --> Length of data in bytes.
+ *
+ */
+static fit_status_t fit_info_tlv_put(fit_info_tlv_state_t *state,
+                                     const uint8_t *data,
+                                     uint16_t length)
+{
+    fit_status_t status = FIT_STATUS_OK;
+    uint16_t chunk      = 0;
+
+    while (length > 0)
+    {
+        chunk = FIT_INFO_TLV_BUF_SIZE - state->m_len;
+        if (chunk > length)
+            chunk = length;
+        fit_memcpy(state->m_buf + state->m_len, (uint8_t *)data, chunk);
+        state->m_len += (uint8_t)chunk;
+        data += chunk;
+        length -= chunk;
+
+        if (state->m_len == FIT_INFO_TLV_BUF_SIZE)
+        {
+            status = fit_info_tlv_flush(state);
+            if (status != FIT_STATUS_OK)
+                return status;
+        }
+    }
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_info_tlv_header
+ *
+ * This function will write record header i.e. header byte followed by value (for
+ * FIT_INFO_TLV_UINT) or data length (for FIT_INFO_TLV_BYTES) as varint.
+ *
+ * @param   state <--> Encoder state.
+ * @param   type --> Record type (FIT_INFO_TLV_UINT or FIT_INFO_TLV_BYTES).
+ * @param   tagid --> Tag id of field.
+ * @param   value --> Integer value or length of data.
+ *
+ */
+static fit_status_t fit_info_tlv_header(fit_info_tlv_state_t *state,
+                                        uint8_t type,
+                                        uint8_t tagid,
+                                        uint32_t value)
+{
+    uint8_t header[6]   = {0};
+    uint16_t length     = 0;
+
+    header[length++] = (uint8_t)((type << FIT_INFO_TLV_TYPE_SHIFT) | tagid);
+    while (value >= 0x80)
+    {
+        header[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    header[length++] = (uint8_t)value;
+
+    return fit_info_tlv_put(state, header, length);
+}
+
+/**
+ *
+ * fit_get_info_tlv_cb
+ *
+ * Get info callback of fit_licenf_get_info_tlv. Writes record for every field with
+ * a value; string data is copied from license in chunks, so no memory is needed for
+ * long fields like rsa signature.
+ *
+ * @param   tagid --> define unique field in sentinel fit license.
+ * @param   pdata --> Pointer to data that gives tagid information.
+ * @param   length --> Length of the data in bytes.
+ * @param   context <--> Pointer to fit_info_tlv_state_t.
+ *
+ */
+static fit_status_t fit_get_info_tlv_cb(uint8_t tagid,
+                                        fit_pointer_t *pdata,
+                                        uint16_t length,
+                                        void *context)
+{
+    fit_info_tlv_state_t *state     = (fit_info_tlv_state_t *)context;
+    fit_status_t status             = FIT_STATUS_OK;
+    uint8_t chunk[16]               = {0};
+    fit_pointer_t fitptr            = {0};
+    uint16_t cntr                   = 0;
+
+    if (tagid == 0 || tagid > FIT_INFO_TLV_TAG_MASK ||
+        (FIT_TAG_MASK(tagid) & FIT_INFO_TLV_TREE_TAGS) != 0)
+    {
+        return FIT_STATUS_OK;
+    }
+
+    // Records before the one output is continued from were written already.
+    if (state->m_seek != NULL)
+    {
+        if (pdata->data != state->m_seek)
+            return FIT_CONTINUE_PARSE;
+        state->m_seek = NULL;
+        state->m_pos = state->m_resume_pos;
+    }
+    state->m_field = pdata->data;
+    state->m_field_pos = state->m_pos + state->m_len;
+    if (state->m_len == 0)
+    {
+        state->m_resume = state->m_field;
+        state->m_resume_pos = state->m_field_pos;
+    }
+
+    if ((FIT_TAG_MASK(tagid) & FIT_INFO_TLV_BYTES_TAGS) == 0)
+    {
+        status = fit_info_tlv_header(state, FIT_INFO_TLV_UINT, tagid,
+            fit_info_read_value(pdata, length));
+        return (status == FIT_STATUS_OK) ? FIT_CONTINUE_PARSE : status;
+    }
+
+    status = fit_info_tlv_header(state, FIT_INFO_TLV_BYTES, tagid, length);
+    // Data accepted by sink in previous calls is not read again.
+    if (status == FIT_STATUS_OK && state->m_pos + state->m_len < state->m_skip)
+    {
+        status = fit_info_tlv_flush(state);
+        cntr = (state->m_skip - state->m_pos < length) ?
+            (uint16_t)(state->m_skip - state->m_pos) : length;
+        state->m_pos += cntr;
+    }
+    fitptr.read_byte = pdata->read_byte;
+    for (; cntr < length && status == FIT_STATUS_OK; cntr += fitptr.length)
+    {
+        fitptr.data = pdata->data + cntr;
+        fitptr.length = (uint16_t)(length - cntr);
+        if (fitptr.length > sizeof(chunk))
+            fitptr.length = sizeof(chunk);
+        fitptr_memcpy(chunk, &fitptr);
+        status = fit_info_tlv_put(state, chunk, fitptr.length);
+    }
+
+    return (status == FIT_STATUS_OK) ? FIT_CONTINUE_PARSE : status;
+}
+
+/**
+ *
+ * fit_licenf_get_info_tlv
+ *
+ * This function will write license information in compact binary (TLV) format, see
+ * FIT_INFO_TLV_VERSION. Data is passed to sink in small pieces as license is parsed,
+ * so there is no limit on output size and no memory is allocated. If sink accepts
+ * less data than passed (e.g. its transmit queue is full), FIT_INFO_SINK_BUSY is
+ * returned and position tells how much was accepted; calling this function again
+ * with same position continues the output from that point. Objects and arrays
+ * whose output was accepted are not parsed again, and only records from the one
+ * being written when sink got current buffer are encoded again, so resuming costs
+ * about the same whatever part of output was accepted.
+ *
+ * @param   license --> Start address of the license in binary format.
+ * @param   tag_mask --> Tags to be written; FIT_TAG_MASK of each wanted tag id or-ed
+ *                       together (FIT_ALL_TAGS_MASK for all).
+ * @param   sink --> Sink function receiving output.
+ * @param   context <--> Context passed to sink function.
+ * @param   pos <--> On entry position returned by previous call (all zero to start
+ *                   output); on return bytes accepted by sink in total and record
+ *                   to continue from. License and tag mask must be the same.
+ *
+ */
+fit_status_t fit_licenf_get_info_tlv(fit_pointer_t* license,
+                                     uint32_t tag_mask,
+                                     fit_info_sink_t sink,
+                                     void *context,
+                                     fit_info_tlv_pos_t *pos)
+{
+    fit_status_t status             = FIT_STATUS_OK;
+    fit_info_tlv_state_t state;
+    fitcontextdata getinfo;
+    uint8_t marker                  = FIT_INFO_TLV_VERSION;
+
+    DBG(FIT_TRACE_INFO, "[fit_licenf_get_info_tlv]: pdata=0x%p \n", license);
+
+    if (license == NULL || license->read_byte == NULL)
+        return FIT_INVALID_PARAM_1;
+    if (sink == NULL)
+        return FIT_INVALID_PARAM_3;
+    if (pos == NULL)
+        return FIT_INVALID_PARAM_5;
+
+    fit_memset((uint8_t *)&state, 0, sizeof(fit_info_tlv_state_t));
+    state.m_sink = sink;
+    state.m_context = context;
+    state.m_skip = pos->m_offset;
+    state.m_seek = pos->m_field;
+    state.m_resume = pos->m_field;
+    state.m_resume_pos = pos->m_field_offset;
+
+    fit_memset((uint8_t *)&getinfo, 0, sizeof(fitcontextdata));
+    getinfo.m_operation = (uint8_t)FIT_GET_LICENSE_INFO_DATA;
+    getinfo.mparserdata.m_getinfodata.m_callback_fn = fit_get_info_tlv_cb;
+    getinfo.mparserdata.m_getinfodata.m_get_info_data = &state;
+    getinfo.mparserdata.m_getinfodata.m_tag_mask = tag_mask;
+    getinfo.mparserdata.m_getinfodata.m_resume = pos->m_field;
+
+    // Version byte is written only if output is not continued from a record.
+    if (state.m_seek == NULL)
+        status = fit_info_tlv_put(&state, &marker, 1);
+    if (status == FIT_STATUS_OK)
+    {
+        status = fit_parse_object(STRUCT_V2C_LEVEL, LICENSE_FIELD, license, (void *)&getinfo);
+        if (status == FIT_CONTINUE_PARSE)
+            status = FIT_STATUS_OK;
+    }
+    // Record to continue from is not in license i.e. license or tag mask changed.
+    if (status == FIT_STATUS_OK && state.m_seek != NULL)
+        status = FIT_INVALID_PARAM_5;
+    marker = FIT_INFO_TLV_END;
+    if (status == FIT_STATUS_OK)
+        status = fit_info_tlv_put(&state, &marker, 1);
+    if (status == FIT_STATUS_OK && state.m_len > 0)
+        status = fit_info_tlv_flush(&state);
+
+    if (status == FIT_STATUS_OK || status == FIT_INFO_SINK_BUSY)
+    {
+        pos->m_offset = state.m_pos;
+        pos->m_field = state.m_resume;
+        pos->m_field_offset = state.m_resume_pos;
+    }
+    return status;
+}
+
+#endif // #ifdef FIT_USE_INFO_TLV
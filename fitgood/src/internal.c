@@ -13,82 +13,428 @@
 #include "hwdep.h"
 #include "fit_debug.h"
 #include "mem_read.h"
-#ifdef FIT_USE_NODE_LOCKING
+#include "fit_merkle.h"
 #include "dm_hash.h"
-#endif // ifdef FIT_USE_NODE_LOCKING
 
-extern fit_cache_data fit_cache;
+#ifdef FIT_USE_TRUSTED_STORAGE
+/**
+ *
+ * fit_cache_is_current
+ *
+ * This function will check if license passed in was validated earlier and storage
+ * has not been written since then. In that case license data is unchanged and there
+ * is no need to calculate its hash again.
+ *
+ * @param   ctx --> FIT core context.
+ * @param   license --> Start address of the license of type fit_pointer_t.
+ * @param   generation --> Current generation number of the storage.
+ *
+ */
+static uint8_t fit_cache_is_current(fit_ctx_t *ctx, fit_pointer_t *license, uint32_t generation)
+{
+    if (ctx->m_generation_get == NULL || ctx->m_cache.m_trusted != TRUE)
+        return FALSE;
+
+    if (ctx->m_cache.m_license != license->data || ctx->m_cache.m_length != license->length)
+        return FALSE;
+
+    return (ctx->m_cache.m_generation == generation) ? TRUE : FALSE;
+}
+#endif // #ifdef FIT_USE_TRUSTED_STORAGE
 
 /**
  *
- * fit_verify_license
+ * fit_get_license_dm_hash
+ *
+ * This function will calculate Davies Meyer hash of license data i.e. of license
+ * without signature, as kept in license validation cache.
+ *
+ * @param   license --> Start address of the license of type fit_pointer_t.
+ * @param   dmhash <-- On return it will contain the hash of license data.
+ *
+ */
+static fit_status_t fit_get_license_dm_hash(fit_pointer_t *license, uint8_t *dmhash)
+{
+    fit_status_t status     = FIT_STATUS_OK;
+    fitcontextdata context  = {0};
+    fit_pointer_t fitptr    = {0};
+
+    context.m_level = STRUCT_V2C_LEVEL;
+    context.m_index = LICENSE_FIELD;
+    context.m_operation = (uint8_t)FIT_PARSE_LICENSE;
+    // Parse license data.
+    status = fit_parse_object(STRUCT_V2C_LEVEL, LICENSE_FIELD, license, &context);
+    if (!(status == FIT_STATUS_OK || status == FIT_STOP_PARSE))
+    {
+        DBG(FIT_TRACE_ERROR, "Error in license parsing %d\n", status);
+        return status;
+    }
+
+    fitptr.read_byte = license->read_byte;
+    fitptr.data = (uint8_t *) license->data;
+    fitptr.length = context.m_length;
+    // Get the hash of data.
+    status = fit_davies_meyer_hash(&fitptr, dmhash);
+    if (status != FIT_STATUS_OK)
+    {
+        DBG(FIT_TRACE_ERROR, "Error in getting Davies Meyer hash with status %d\n", status);
+    }
+
+    return status;
+}
+
+#ifdef FIT_USE_SEGMENTED_HASH
+/**
+ *
+ * fit_check_merkle_root
+ *
+ * This function will calculate root of hash tree over segment hashes present in
+ * license and return TRUE if it is same as root passed in (root verified during
+ * earlier validation).
+ *
+ * @param   ctx <--> FIT core context.
+ * @param   license --> Start address of the license of type fit_pointer_t.
+ * @param   verified --> Verified root of hash tree.
+ *
+ */
+static uint8_t fit_check_merkle_root(fit_ctx_t *ctx, fit_pointer_t *license, const uint8_t *verified)
+{
+    fit_status_t status                 = FIT_STATUS_OK;
+    uint8_t root[FIT_MERKLE_HASH_SIZE]  = {0};
+    fit_pointer_t licpart               = {0};
+    fit_pointer_t signature             = {0};
+
+    status = fit_get_signed_data(license, &licpart, &signature);
+    if (status == FIT_STATUS_OK)
+        status = fit_merkle_get_root(&ctx->m_merkle, license, &licpart, root);
+
+    return (status == FIT_STATUS_OK &&
+            fit_memcmp((uint8_t *)verified, root, FIT_MERKLE_HASH_SIZE) == 0) ? TRUE : FALSE;
+}
+#endif // #ifdef FIT_USE_SEGMENTED_HASH
+
+#ifdef FIT_USE_SHARED_CACHE
+/**
+ *
+ * fit_shared_cache_import
+ *
+ * This function will copy snapshot of shared cache into shared snapshot slot of the
+ * context, if snapshot was published since last copy. Validation cache of the
+ * context itself is not changed.
+ *
+ * @param   ctx <--> FIT core context attached to shared cache.
+ *
+ */
+static void fit_shared_cache_import(fit_ctx_t *ctx)
+{
+    fit_cache_snapshot_t snapshot;
+    uint32_t seq = 0;
+
+    if (fit_shared_cache_read(ctx->m_shared, &snapshot, &seq) != TRUE ||
+        seq == ctx->m_shared_seq)
+    {
+        return;
+    }
+
+    ctx->m_shared_seq = seq;
+    fit_memcpy((uint8_t *)&ctx->m_shared_snapshot, (uint8_t *)&snapshot, sizeof(fit_cache_snapshot_t));
+}
+
+/**
+ *
+ * fit_shared_cache_hit
+ *
+ * This function will check if license passed in is the license of shared snapshot
+ * slot i.e. validated by other context with same key bytes. Snapshot is checked the
+ * same way as validation cache of the context; on success it replaces the license
+ * in that cache, as it is now the license in use.
+ *
+ * @param   ctx <--> FIT core context attached to shared cache.
+ * @param   license --> Start address of the license of type fit_pointer_t.
+ * @param   keyhash --> Hash of key bytes used for current validation.
+ * @param   generation --> Current generation number of the storage.
+ * @param   root_checked <-- Set to TRUE if only hash tree root was checked.
+ *
+ */
+static uint8_t fit_shared_cache_hit(fit_ctx_t *ctx,
+                                    fit_pointer_t *license,
+                                    uint8_t *keyhash,
+                                    uint32_t generation,
+                                    uint8_t *root_checked)
+{
+    fit_cache_snapshot_t *snapshot      = &ctx->m_shared_snapshot;
+    uint8_t dmhash[FIT_DM_HASH_SIZE]    = {0};
+    uint8_t hit                         = FALSE;
+
+    fit_shared_cache_import(ctx);
+    if (snapshot->m_valid != TRUE ||
+        fit_memcmp(snapshot->m_key_hash, keyhash, FIT_DM_HASH_SIZE) != 0)
+    {
+        return FALSE;
+    }
+
+#ifdef FIT_USE_TRUSTED_STORAGE
+    if (ctx->m_generation_get != NULL && snapshot->m_trusted == TRUE &&
+        snapshot->m_license == license->data && snapshot->m_length == license->length &&
+        snapshot->m_generation == generation)
+    {
+        hit = TRUE;
+    }
+    else
+#endif // #ifdef FIT_USE_TRUSTED_STORAGE
+#ifdef FIT_USE_SEGMENTED_HASH
+    if (snapshot->m_algid == MERKLE_ALGID)
+    {
+        hit = fit_check_merkle_root(ctx, license, snapshot->m_root);
+        *root_checked = hit;
+    }
+    else
+#endif // #ifdef FIT_USE_SEGMENTED_HASH
+    if (fit_get_license_dm_hash(license, dmhash) == FIT_STATUS_OK &&
+        fit_memcmp(snapshot->m_dm_hash, dmhash, FIT_DM_HASH_SIZE) == 0)
+    {
+        hit = TRUE;
+    }
+    if (hit != TRUE)
+        return FALSE;
+
+    DBG(FIT_TRACE_INFO, "License validated by other context\n");
+    ctx->m_cache.m_rsa_check_done = TRUE;
+    fit_memcpy(ctx->m_cache.m_dm_hash, snapshot->m_dm_hash, FIT_DM_HASH_SIZE);
+    fit_memcpy(ctx->m_cache.m_key_hash, snapshot->m_key_hash, FIT_DM_HASH_SIZE);
+#ifdef FIT_USE_TRUSTED_STORAGE
+    ctx->m_cache.m_trusted = snapshot->m_trusted;
+    ctx->m_cache.m_generation = snapshot->m_generation;
+    ctx->m_cache.m_license = snapshot->m_license;
+    ctx->m_cache.m_length = snapshot->m_length;
+#endif // #ifdef FIT_USE_TRUSTED_STORAGE
+#ifdef FIT_USE_SEGMENTED_HASH
+    ctx->m_cache.m_algid = snapshot->m_algid;
+    fit_memcpy(ctx->m_cache.m_root, snapshot->m_root, FIT_MERKLE_HASH_SIZE);
+#endif // #ifdef FIT_USE_SEGMENTED_HASH
+
+    return TRUE;
+}
+
+/**
+ *
+ * fit_shared_cache_export
+ *
+ * This function will publish validation cache of the context (license that just
+ * passed rsa signature check) into shared cache.
+ *
+ * @param   ctx --> FIT core context attached to shared cache.
+ *
+ */
+static void fit_shared_cache_export(fit_ctx_t *ctx)
+{
+    fit_cache_snapshot_t snapshot;
+
+    fit_memset((uint8_t *)&snapshot, 0, sizeof(fit_cache_snapshot_t));
+    snapshot.m_valid = ctx->m_cache.m_rsa_check_done;
+    fit_memcpy(snapshot.m_key_hash, ctx->m_cache.m_key_hash, FIT_DM_HASH_SIZE);
+    fit_memcpy(snapshot.m_dm_hash, ctx->m_cache.m_dm_hash, FIT_DM_HASH_SIZE);
+#ifdef FIT_USE_TRUSTED_STORAGE
+    snapshot.m_trusted = ctx->m_cache.m_trusted;
+    snapshot.m_generation = ctx->m_cache.m_generation;
+    snapshot.m_license = ctx->m_cache.m_license;
+    snapshot.m_length = ctx->m_cache.m_length;
+#endif // #ifdef FIT_USE_TRUSTED_STORAGE
+#ifdef FIT_USE_SEGMENTED_HASH
+    snapshot.m_algid = ctx->m_cache.m_algid;
+    fit_memcpy(snapshot.m_root, ctx->m_cache.m_root, FIT_MERKLE_HASH_SIZE);
+#endif // #ifdef FIT_USE_SEGMENTED_HASH
+
+    fit_shared_cache_publish(ctx->m_shared, &snapshot);
+}
+#endif // #ifdef FIT_USE_SHARED_CACHE
+
+/**
+ *
+ * fit_get_failure_hash
+ *
+ * This function will calculate Davies Meyer hash of complete license binary. This
+ * hash is used as key for negative cache. License data need not be parsed here, as
+ * license that failed validation may not be parsable.
+ *
+ * @param   license --> Start address of the license of type fit_pointer_t.
+ * @param   hash <-- On return it will contain the hash of license.
+ *
+ */
+static fit_status_t fit_get_failure_hash(fit_pointer_t *license, uint8_t *hash)
+{
+    fit_pointer_t fitptr = {0};
+
+    if (license->length == 0)
+        return FIT_INVALID_V2C;
+
+    fitptr.read_byte = license->read_byte;
+    fitptr.data = license->data;
+    fitptr.length = license->length;
+
+    return fit_davies_meyer_hash(&fitptr, hash);
+}
+
+/**
+ *
+ * fit_is_cacheable_failure
+ *
+ * This function will check whether validation failure depends only on license and
+ * key bytes (bad signature, malformed license), so it can be kept in negative cache.
+ * Failures that can go away on retry (out of memory, crypto provider or device
+ * errors) and node locking failures are never cached.
+ *
+ * @param   status --> Validation status.
+ *
+ */
+static uint8_t fit_is_cacheable_failure(fit_status_t status)
+{
+    switch (status)
+    {
+        case FIT_INVALID_V2C:
+        case FIT_UNKNOWN_ALG:
+        case FIT_INVALID_SIGNATURE:
+        case FIT_INVALID_LICGEN_VERSION:
+        case FIT_INVALID_SIG_ID:
+        case FIT_INVALID_WIRE_TYPE:
+        case FIT_INVALID_FIELD_LEN:
+        case FIT_RSA_VERIFY_FAILED:
+        case FIT_ED25519_VERIFY_FAILED:
+            return TRUE;
+
+        default:
+            return FALSE;
+    }
+}
+
+/**
+ *
+ * fit_verify_license_data
  *
  * This function is used to validate following:
  *      1. RSA signature of new license.
  *      2. New license node lock varification.
  * On return it will either return validation success or failure.
  *
+ * @param   ctx <--> FIT core context; its license validation cache is used and
+ *                   updated.
  * @param   license --> Start address of the license of type fit_pointer_t.
  *                      fit_pointer_t will describe, from what type of
  *                      memory to read the license through function pointer.
  *
- * @param   key --> Start address of the key of type fit_pointer_t.
- *                  fit_pointer_t will describe, from what type of
- *                  memory to read the key through function pointer.
+ * @param   key --> RSA public key initialized by fit_rsa_key_init. Key is parsed
+ *                  only if rsa signature check is required.
  *
  */
-fit_status_t fit_verify_license(fit_pointer_t *license,
-                                fit_pointer_t *key,
-                                uint8_t check_cache)
+static fit_status_t fit_verify_license_data(fit_ctx_t *ctx,
+                                            fit_pointer_t *license,
+                                            fit_rsa_key_t *key,
+                                            uint8_t check_cache)
 {
     fit_status_t status                 = FIT_STATUS_OK;
     uint8_t dmhash[FIT_DM_HASH_SIZE]     = {0};
-    fitcontextdata context              = {0};
-    fit_pointer_t fitptr                = {0};
-
-#ifdef FIT_USE_NODE_LOCKING
-    uint8_t valid_fp_present  = FALSE;
-    fit_fingerprint_t licensefp = {0};
-    fit_fingerprint_t devicefp = {0};
-    fit_fp_callback callback_fn = fit_deviceid_get;
-#endif // #ifdef FIT_USE_NODE_LOCKING
+    uint8_t failhash[FIT_DM_HASH_SIZE]  = {0};
+    uint8_t keyhash[FIT_DM_HASH_SIZE]   = {0};
+    fit_status_t hashstatus             = FIT_STATUS_ERROR;
+    uint8_t keyhashed                   = FALSE;
+    uint8_t cached                      = FALSE;
+    uint8_t miss                        = TRUE;
+#if defined(FIT_USE_TRUSTED_STORAGE) || defined(FIT_USE_SHARED_CACHE)
+    uint32_t generation                 = 0;
+#endif
+#ifdef FIT_USE_SHARED_CACHE
+    uint32_t rsa_checks                 = ctx->m_cache.m_stats.m_rsa_checks;
+#endif
+#if defined(FIT_USE_SEGMENTED_HASH) || defined(FIT_USE_SHARED_CACHE)
+    uint8_t root_checked                = FALSE;
+#endif
+#ifdef FIT_USE_SEGMENTED_HASH
+    fit_pointer_t tracked               = {0};
+#endif
 
     DBG(FIT_TRACE_INFO, "[fit_verify_license]: license=0x%p length=%hd\n", license->data, license->length);
 
-    fitptr.read_byte = license->read_byte;
+    ctx->m_cache.m_stats.m_requests++;
 
-        // Check validity of license data by RSA signature check.
-    if (fit_cache.m_rsa_check_done == TRUE && check_cache == TRUE)
-    {
-        // Calculate Davies-Meyer-hash on the license. Write that hash into the hash table.
-        context.m_level = STRUCT_V2C_LEVEL;
-        context.m_index = LICENSE_FIELD;
-        context.m_operation = (uint8_t)FIT_PARSE_LICENSE;
-        // Parse license data.
-        status = fit_parse_object(STRUCT_V2C_LEVEL, LICENSE_FIELD, license, &context);
-        if (!(status == FIT_STATUS_OK || status == FIT_STOP_PARSE))
-        {
-            DBG(FIT_TRACE_ERROR, "Error in license parsing %d\n", status);
-            goto bail;
-        }
+    // Hash of key bytes is calculated once per key (see fit_ctx_get_key), so getting
+    // it is cheap. It identifies the key in both validated and failed license cache.
+    if (fit_rsa_key_hash(key, keyhash) == FIT_STATUS_OK)
+        keyhashed = TRUE;
 
-        fitptr.data = (uint8_t *) license->data;
-        fitptr.length = context.m_length;
-        // Get the hash of data.
-        status = fit_davies_meyer_hash(&fitptr, (uint8_t *)&dmhash);
+    // Validated license is taken from cache only if it was validated with same key
+    // bytes; key passed in may be rotated in place.
+    if (check_cache == TRUE && keyhashed == TRUE && ctx->m_cache.m_rsa_check_done == TRUE &&
+        fit_memcmp(ctx->m_cache.m_key_hash, keyhash, FIT_DM_HASH_SIZE) == 0)
+    {
+        cached = TRUE;
+    }
+
+#ifdef FIT_USE_TRUSTED_STORAGE
+    // Get the generation before license data is read, so write done in between
+    // will force full validation on next call.
+    if (ctx->m_generation_get != NULL)
+        generation = ctx->m_generation_get();
+
+    if (cached == TRUE && fit_cache_is_current(ctx, license, generation) == TRUE)
+    {
+        // License storage not written since last validation; skip hashing.
+        DBG(FIT_TRACE_INFO, "Storage generation %ld unchanged\n", generation);
+        miss = FALSE;
+    }
+    else
+#endif // #ifdef FIT_USE_TRUSTED_STORAGE
+#ifdef FIT_USE_SEGMENTED_HASH
+    if (cached == TRUE && ctx->m_cache.m_algid == MERKLE_ALGID)
+    {
+        // Segments are authenticated when they are read, so only check that segment
+        // hashes in license still match the verified root.
+        root_checked = fit_check_merkle_root(ctx, license, ctx->m_cache.m_root);
+        miss = (root_checked == TRUE) ? FALSE : TRUE;
+    }
+    else
+#endif // #ifdef FIT_USE_SEGMENTED_HASH
+    if (cached == TRUE)
+    {
+        // Calculate Davies-Meyer-hash on the license and compare it with the cached one.
+        status = fit_get_license_dm_hash(license, dmhash);
         if (status != FIT_STATUS_OK)
-        {
-            DBG(FIT_TRACE_ERROR, "Error in getting Davies Meyer hash with status %d\n", status);
             goto bail;
-        }
-        if(fit_memcmp(fit_cache.m_dm_hash, dmhash, FIT_DM_HASH_SIZE) != 0 )
+        if (fit_memcmp(ctx->m_cache.m_dm_hash, dmhash, FIT_DM_HASH_SIZE) == 0)
+            miss = FALSE;
+    }
+
+    // If same license was already rejected with same key then return the cached failure
+    // status, instead of doing the rsa signature check again. License and key are
+    // compared by hash of their bytes, so changed data is never taken for cached one.
+    // Checked only if validated license cache missed, so unchanged valid license is
+    // not hashed for it.
+    if (miss == TRUE && keyhashed == TRUE && ctx->m_cache.m_fail_status != FIT_STATUS_OK)
+    {
+        hashstatus = fit_get_failure_hash(license, failhash);
+        if (hashstatus == FIT_STATUS_OK &&
+            fit_memcmp(ctx->m_cache.m_fail_hash, failhash, FIT_DM_HASH_SIZE) == 0 &&
+            fit_memcmp(ctx->m_cache.m_fail_key, keyhash, FIT_DM_HASH_SIZE) == 0)
         {
-            status = fit_check_license_validation(license, key);
+            DBG(FIT_TRACE_INFO, "License already failed validation with status %d\n", ctx->m_cache.m_fail_status);
+            ctx->m_cache.m_stats.m_fail_hits++;
+            return ctx->m_cache.m_fail_status;
         }
     }
-    else
+
+    if (miss == TRUE)
     {
-        status = fit_check_license_validation(license, key);
+#ifdef FIT_USE_SHARED_CACHE
+        // License may have been validated by other context attached to same shared
+        // cache; its snapshot is checked only after own cache missed.
+        if (ctx->m_shared != NULL && keyhashed == TRUE &&
+            fit_shared_cache_hit(ctx, license, keyhash, generation, &root_checked) == TRUE)
+        {
+            status = FIT_STATUS_OK;
+        }
+        else
+#endif // #ifdef FIT_USE_SHARED_CACHE
+        // Check validity of license data by RSA signature check.
+        status = fit_check_license_validation(ctx, license, key);
     }
 
     if (status != FIT_STATUS_OK)
@@ -101,6 +447,110 @@ fit_status_t fit_verify_license(fit_pointer_t *license,
         DBG(FIT_TRACE_INFO, "fit_check_license_validation successfully passed \n");
     }
 
+    // Check node locking information present in the license data.
+#ifdef FIT_USE_SEGMENTED_HASH
+    // If only hash tree root was checked then license segments are not authenticated
+    // yet; authenticate the ones read while looking for fingerprint.
+    if (root_checked == TRUE && ctx->m_cache.m_algid == MERKLE_ALGID)
+    {
+        fit_merkle_track_start(&ctx->m_merkle, license, &tracked);
+        status = fit_check_node_lock(&tracked);
+        if (fit_merkle_track_verify(&ctx->m_merkle) != FIT_STATUS_OK)
+            status = FIT_INVALID_V2C;
+    }
+    else
+#endif // #ifdef FIT_USE_SEGMENTED_HASH
+    status = fit_check_node_lock(license);
+
+bail:
+    // Remember the failure, so validation of unchanged license fails fast. Validated
+    // license (if any) stays cached; entries are replaced only by their own kind.
+    if (fit_is_cacheable_failure(status) == TRUE)
+    {
+        if (hashstatus != FIT_STATUS_OK)
+            hashstatus = fit_get_failure_hash(license, failhash);
+        if (hashstatus == FIT_STATUS_OK && keyhashed == TRUE)
+        {
+            ctx->m_cache.m_fail_status = status;
+            fit_memcpy(ctx->m_cache.m_fail_hash, failhash, FIT_DM_HASH_SIZE);
+            fit_memcpy(ctx->m_cache.m_fail_key, keyhash, FIT_DM_HASH_SIZE);
+            ctx->m_cache.m_stats.m_fail_stored++;
+        }
+    }
+#ifdef FIT_USE_TRUSTED_STORAGE
+    // Remember storage generation at which license was validated.
+    ctx->m_cache.m_trusted = (status == FIT_STATUS_OK && ctx->m_generation_get != NULL) ? TRUE : FALSE;
+    ctx->m_cache.m_generation = generation;
+    ctx->m_cache.m_license = license->data;
+    ctx->m_cache.m_length = license->length;
+#endif // #ifdef FIT_USE_TRUSTED_STORAGE
+#ifdef FIT_USE_SHARED_CACHE
+    // Publish license that needed rsa signature check, so other contexts skip it.
+    if (ctx->m_shared != NULL && status == FIT_STATUS_OK &&
+        ctx->m_cache.m_stats.m_rsa_checks != rsa_checks)
+    {
+        fit_shared_cache_export(ctx);
+    }
+#endif // #ifdef FIT_USE_SHARED_CACHE
+
+    return status;
+}
+
+/**
+ *
+ * fit_verify_license
+ *
+ * This function will validate the license (see fit_verify_license_data) with crypto
+ * provider of context selected for hashes and rsa operations.
+ *
+ * @param   ctx <--> FIT core context.
+ * @param   license --> Start address of the license of type fit_pointer_t.
+ * @param   key --> RSA public key initialized by fit_rsa_key_init.
+ * @param   check_cache --> TRUE if license validation cache can be used.
+ *
+ */
+fit_status_t fit_verify_license(fit_ctx_t *ctx,
+                                fit_pointer_t *license,
+                                fit_rsa_key_t *key,
+                                uint8_t check_cache)
+{
+#ifdef FIT_USE_CRYPTO_PROVIDER
+    fit_crypto_provider_t *prev = fit_crypto_select(ctx->m_crypto);
+    fit_status_t status         = fit_verify_license_data(ctx, license, key, check_cache);
+
+    fit_crypto_select(prev);
+
+    return status;
+#else
+    return fit_verify_license_data(ctx, license, key, check_cache);
+#endif // #ifdef FIT_USE_CRYPTO_PROVIDER
+}
+
+/**
+ *
+ * fit_check_node_lock
+ *
+ * This function will check the presence of fingerprint in the license data. If
+ * fingerprint is present then it will be compared against fingerprint of the device.
+ *
+ * @param   license --> Start address of the license of type fit_pointer_t.
+ *
+ */
+fit_status_t fit_check_node_lock(fit_pointer_t *license)
+{
+    fit_status_t status                 = FIT_STATUS_OK;
+    fitcontextdata context              = {0};
+
+#ifdef FIT_USE_NODE_LOCKING
+    fit_pointer_t fitptr                = {0};
+    uint8_t valid_fp_present  = FALSE;
+    fit_fingerprint_t licensefp = {0};
+    fit_fingerprint_t devicefp = {0};
+    fit_fp_callback callback_fn = fit_deviceid_get;
+
+    fitptr.read_byte = license->read_byte;
+#endif // #ifdef FIT_USE_NODE_LOCKING
+
     // Check the presence of fingerprint in the license data.
     context.m_level = STRUCT_HEADER_LEVEL;
     context.m_index = FINGERPRINT_FIELD;
@@ -167,15 +617,9 @@ fit_status_t fit_verify_license(fit_pointer_t *license,
             DBG(FIT_TRACE_INFO, "Device fingerprint match with stored fingerprint data in license string\n");
         }
     }
-#endif // #ifdef FIT_USE_NODE_LOCKING
 
 bail:
-    if (status != FIT_STATUS_OK)
-    {
-        fit_cache.m_rsa_check_done = FALSE;
-        fit_memset(fit_cache.m_dm_hash, 0, sizeof(fit_cache.m_dm_hash));
-    }
-
+#endif // #ifdef FIT_USE_NODE_LOCKING
     return status;
 }
 
@@ -8,6 +8,32 @@
 **
 \****************************************************************************/
 #include "mem_read.h"
+#include "fit_ctx.h"
+
+/* Constants ****************************************************************/
+
+#ifdef FIT_READ_BYTE_BOUNDED
+
+// Bounds are per thread if contexts are used by concurrent threads.
+#ifdef FIT_USE_CONCURRENT_CTX
+#ifdef _MSC_VER
+#define FIT_READ_LOCAL          __declspec(thread)
+#else
+#define FIT_READ_LOCAL          __thread
+#endif
+#else
+#define FIT_READ_LOCAL
+#endif
+
+/* Global Data **************************************************************/
+
+// Data read by FIT_READ_BYTE_BOUNDED: [fit_read_start, fit_read_end).
+static FIT_READ_LOCAL const uint8_t *fit_read_start  = NULL;
+static FIT_READ_LOCAL const uint8_t *fit_read_end    = NULL;
+
+#endif // #ifdef FIT_READ_BYTE_BOUNDED
+
+/* Functions ****************************************************************/
 
 /**
  *
@@ -83,3 +109,44 @@ uint8_t fit_read_ram_u8 (const uint8_t *datap)
 {
     return (uint8_t)*datap;
 }
+
+#ifdef FIT_READ_BYTE_BOUNDED
+/**
+ *
+ * fit_read_set_bounds
+ *
+ * Sets data read by FIT_READ_BYTE_BOUNDED (of calling thread if contexts are used
+ * by concurrent threads). Bytes outside of it read as zero.
+ *
+ * @param   start --> Start address of data (e.g. license being parsed).
+ *
+ * @param   length --> Length of data; zero makes every read return zero.
+ *
+ */
+void fit_read_set_bounds(const uint8_t *start, uint32_t length)
+{
+    fit_read_start = start;
+    fit_read_end = start + length;
+}
+
+/**
+ *
+ * fit_read_bounded_u8
+ *
+ * Reads 1 byte data from data pointer passed in; zero is returned for address
+ * outside of data set by fit_read_set_bounds.
+ *
+ * @param   datap --> pointer to data.
+ *
+ */
+uint8_t fit_read_bounded_u8 (const uint8_t *datap)
+{
+    if ((uintptr_t)datap < (uintptr_t)fit_read_start ||
+        (uintptr_t)datap >= (uintptr_t)fit_read_end)
+    {
+        return 0;
+    }
+
+    return (uint8_t)*datap;
+}
+#endif // #ifdef FIT_READ_BYTE_BOUNDED
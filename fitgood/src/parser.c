@@ -15,18 +15,66 @@
 #include "dm_hash.h"
 #include "fit_rsa.h"
 #include "abreast_dm.h"
+#include "fit_merkle.h"
+#include "fit_ed25519.h"
+#include "fit_sha256.h"
 
 
 /* Global Data **************************************************************/
-// Initialize all field types for {level, index} to FIT_INVALID_VALUE
-wire_type_t lic_field_type[MAX_LEVEL][MAX_INDEX] = {{0xFF}};
-uint8_t lic_tag_id[MAX_LEVEL][MAX_INDEX] = {{0xFF}};
-fit_cache_data fit_cache = {0};
 #ifdef FIT_USE_UNIT_TESTS
 extern unsigned char licensebin[];
 #endif
 
 /* Constants ****************************************************************/
+
+// Field types (see enum wire_type) and tag ids of fit licenses (as per sproto schema)
+// hard-coded for each level and index, see level/index defines in internal.h. Tables
+// are constant, so parsing keeps no global state. Unused entries are 0.
+static const wire_type_t lic_field_type[MAX_LEVEL][MAX_INDEX] = {
+    // V2C - level 0: license, signature
+    {FIT_OBJECT, FIT_ARRAY},
+    // License - level 1: header, license container
+    // Signature - level 1: algorithm id, rsa signature, segment hashes
+    {FIT_OBJECT, FIT_ARRAY, FIT_INTEGER, FIT_STRING, FIT_STRING},
+    // Header - level 2: licgen version, LM version, UID, fingerprint
+    // LicenseContainer - level 2: container id, vendors
+    {FIT_INTEGER, FIT_INTEGER, FIT_STRING, FIT_STRING, FIT_INTEGER, FIT_ARRAY},
+    // Vendor - level 3: vendor id, product
+    {FIT_INTEGER, FIT_OBJECT},
+    // Product - level 4: product id, version regex, product parts
+    {FIT_INTEGER, FIT_STRING, FIT_ARRAY},
+    // Product Part - level 5: product part id, license properties
+    {FIT_INTEGER, FIT_OBJECT},
+    // LicenseProperties - level 6: features, perpetual, start date, end date,
+    // counters, duration from first use
+    {FIT_ARRAY, FIT_INTEGER, FIT_INTEGER, FIT_INTEGER, FIT_ARRAY, FIT_INTEGER},
+    // Feature - level 7: feature id
+    // Counter - level 7: counter id, limit, soft limit, is field
+    {FIT_INTEGER, 0, FIT_INTEGER, FIT_INTEGER, FIT_INTEGER, FIT_INTEGER},
+};
+
+static const uint8_t lic_tag_id[MAX_LEVEL][MAX_INDEX] = {
+    // V2C - level 0
+    {FIT_LICENSE_TAG_ID, FIT_SIGNATURE_TAG_ID},
+    // License and Signature - level 1
+    {FIT_HEADER_TAG_ID, FIT_LIC_CONTAINER_TAG_ID, FIT_ALGORITHM_TAG_ID,
+     FIT_RSA_SIG_TAG_ID, FIT_SEGMENT_HASH_TAG_ID},
+    // Header and LicenseContainer - level 2
+    {FIT_LICGEN_VERSION_TAG_ID, FIT_LM_VERSION_TAG_ID, FIT_UID_TAG_ID,
+     FIT_FP_TAG_ID, FIT_ID_LC_TAG_ID, FIT_VENDOR_ARRAY_TAG_ID},
+    // Vendor - level 3
+    {FIT_VENDOR_ID_TAG_ID, FIT_PRODUCT_TAG_ID},
+    // Product - level 4
+    {FIT_PRODUCT_ID_TAG_ID, FIT_VERSION_REGEX_TAG_ID, FIT_PRODUCT_PART_ARRAY_TAG_ID},
+    // Product Part - level 5
+    {FIT_PRODUCT_PART_ID_TAG_ID, FIT_LIC_PROP_TAG_ID},
+    // LicenseProperties - level 6
+    {FIT_FEATURE_ARRAY_TAG_ID, FIT_PERPETUAL_TAG_ID, FIT_START_DATE_TAG_ID,
+     FIT_END_DATE_TAG_ID, FIT_COUNTER_ARRAY_TAG_ID, FIT_DURATION_FROM_FIRST_USE_TAG_ID},
+    // Feature and Counter - level 7
+    {FIT_FEATURE_TAG_ID, 0, FIT_COUNTER_TAG_ID, FIT_LIMIT_TAG_ID,
+     FIT_SOFT_LIMIT_TAG_ID, FIT_IS_FIELD_TAG_ID},
+};
 struct callbacks fct[] = {{FIT_CONSUME_LICENSE, fit_consume_license},
                           {FIT_PARSE_LICENSE, fit_parse_field_data},
                           {FIT_GET_DATA_ADDRESS, fit_get_data_address}
@@ -72,12 +120,57 @@ struct testcallbacks testfct[] =
 
 #endif //#ifdef FIT_USE_UNIT_TESTS
 
+// Tag masks of objects and arrays (as per sproto schema) i.e. tag of object/array
+// and tags of all fields it contains. Used by get info operation to skip objects
+// and arrays containing no tag requested by user.
+#define FIT_COUNTER_TREE_MASK       (FIT_TAG_MASK(FIT_COUNTER_ARRAY_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_COUNTER_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_LIMIT_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_SOFT_LIMIT_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_IS_FIELD_TAG_ID))
+#define FIT_FEATURE_TREE_MASK       (FIT_TAG_MASK(FIT_FEATURE_ARRAY_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_FEATURE_TAG_ID))
+#define FIT_LIC_PROP_TREE_MASK      (FIT_TAG_MASK(FIT_LIC_PROP_TAG_ID) | \
+                                     FIT_FEATURE_TREE_MASK | \
+                                     FIT_TAG_MASK(FIT_PERPETUAL_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_START_DATE_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_END_DATE_TAG_ID) | \
+                                     FIT_COUNTER_TREE_MASK | \
+                                     FIT_TAG_MASK(FIT_DURATION_FROM_FIRST_USE_TAG_ID))
+#define FIT_PRODUCT_PART_TREE_MASK  (FIT_TAG_MASK(FIT_PRODUCT_PART_ARRAY_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_PRODUCT_PART_ID_TAG_ID) | \
+                                     FIT_LIC_PROP_TREE_MASK)
+#define FIT_PRODUCT_TREE_MASK       (FIT_TAG_MASK(FIT_PRODUCT_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_PRODUCT_ID_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_VERSION_REGEX_TAG_ID) | \
+                                     FIT_PRODUCT_PART_TREE_MASK)
+#define FIT_VENDOR_TREE_MASK        (FIT_TAG_MASK(FIT_VENDOR_ARRAY_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_VENDOR_ID_TAG_ID) | \
+                                     FIT_PRODUCT_TREE_MASK)
+#define FIT_LIC_CONTAINER_TREE_MASK (FIT_TAG_MASK(FIT_LIC_CONTAINER_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_ID_LC_TAG_ID) | \
+                                     FIT_VENDOR_TREE_MASK)
+#define FIT_HEADER_TREE_MASK        (FIT_TAG_MASK(FIT_HEADER_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_LICGEN_VERSION_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_LM_VERSION_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_UID_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_FP_TAG_ID))
+#define FIT_LICENSE_TREE_MASK       (FIT_TAG_MASK(FIT_LICENSE_TAG_ID) | \
+                                     FIT_HEADER_TREE_MASK | \
+                                     FIT_LIC_CONTAINER_TREE_MASK)
+#define FIT_SIGNATURE_TREE_MASK     (FIT_TAG_MASK(FIT_SIGNATURE_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_ALGORITHM_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_RSA_SIG_TAG_ID) | \
+                                     FIT_TAG_MASK(FIT_SEGMENT_HASH_TAG_ID))
+
 /* Function Prototypes ******************************************************/
 // This function will be called in case value of field is 00 00 and data is encoded
 // in data part.
 
-static void register_field_types(void);
-static void register_tag_id(void);
+static uint8_t fit_skip_tag_tree(uint8_t level, uint8_t index, void *context);
+#ifdef FIT_USE_INFO_TLV
+static uint8_t fit_skip_resumed(uint8_t *data, fit_read_byte_callback_t read_byte, void *context);
+#endif
 
 static fit_status_t fit_parse_data(uint8_t level,
                                    uint8_t index,
@@ -121,9 +214,12 @@ fit_status_t fit_parse_object(uint8_t level,
     uint8_t skip_fields     = 0;
     uint8_t cur_index       = index;
     uint8_t *parserdata     = pdata->data;
+    // Current field. Passed in pointer is not moved, so same license pointer can be
+    // parsed by different tasks at the same time.
+    fit_pointer_t field     = *pdata;
     fit_pointer_t fitptr    = {0}; 
     // Header is a 16bit integer. It represents number of fields.
-    uint16_t num_fields     = read_word(pdata->data, pdata->read_byte);
+    uint16_t num_fields     = read_word(field.data, field.read_byte);
     // struct_offset contains value that represents start of field data(all except integer data)
     // i.e. number of bytes after which field data will start. If field value
     // is 00 00 that means data corresponding to that filed will be encoded in data part.
@@ -131,13 +227,6 @@ fit_status_t fit_parse_object(uint8_t level,
     // Contains success or error code.
     fit_status_t status     = FIT_STATUS_OK;
     uint16_t field_data     = 0;
-    static uint8_t fit_initialized = 0;
-
-    if( fit_initialized == 0 ){
-        fit_initialized ++;
-        register_tag_id();
-        register_field_types();
-    }
 
     DBG(FIT_TRACE_INFO, "[parse_object start]: for Level=%d, Index=%d, pdata=0x%X \n",
         level, index, pdata->data);
@@ -147,7 +236,7 @@ fit_status_t fit_parse_object(uint8_t level,
 
     // First field represents no. of fields for object. Move data pointer to next
     // field to get first field data.
-    pdata->data = pdata->data + PFIELD_SIZE;
+    field.data = field.data + PFIELD_SIZE;
 
     // Parse all fields data in a structure.
     for( cntr = 0; cntr < num_fields; cntr++)
@@ -157,7 +246,7 @@ fit_status_t fit_parse_object(uint8_t level,
             break;
         // Each field in field part is a 16bit integer  Value of this field will
         // tell what type of data it contains.
-        field_data = read_word(pdata->data, pdata->read_byte);
+        field_data = read_word(field.data, field.read_byte);
         // If field_data is zero, that means the field data is encoded in data part.
         // This field data can be in form of string or array or an object itself.
         if( field_data == 0 )
@@ -182,7 +271,7 @@ fit_status_t fit_parse_object(uint8_t level,
             status = fit_parse_data (level, cur_index, &fitptr, context);
             struct_offset   = (uint16_t)(struct_offset + (uint16_t)read_dword(parserdata+struct_offset, pdata->read_byte) + sizeof(uint32_t));
             // Move data pointer to next field.
-            pdata->data     = pdata->data + PFIELD_SIZE;
+            field.data      = field.data + PFIELD_SIZE;
             // Go to next index value.
             cur_index++;
         }
@@ -193,7 +282,7 @@ fit_status_t fit_parse_object(uint8_t level,
         {
            skip_fields  = (uint8_t)(field_data+1)/2;
            // Move data pointer to next field.
-           pdata->data  = pdata->data + PFIELD_SIZE;
+           field.data   = field.data + PFIELD_SIZE;
            // skip the fields as it does not contain any data in V2C.
            cur_index    = cur_index + skip_fields;
         } 
@@ -207,17 +296,17 @@ fit_status_t fit_parse_object(uint8_t level,
             // at particular level and index.
             if (((fitcontextdata *)context)->m_testop == TRUE)
             {
-                status = fieldcallbackfn(level, cur_index, pdata, context);
+                status = fieldcallbackfn(level, cur_index, &field, context);
             }
             else
 #endif // #ifdef FIT_USE_UNIT_TESTS
 
             // Get the value. Also if there is any callback function registered at
             // passed in level and index or operation requested by Fit context then call the function.
-            status = parsercallbacks(level, cur_index, pdata, sizeof(uint16_t), context);
+            status = parsercallbacks(level, cur_index, &field, sizeof(uint16_t), context);
 
             // Move data pointer to next field.
-            pdata->data = pdata->data + PFIELD_SIZE;
+            field.data = field.data + PFIELD_SIZE;
             // Go to next index value.
             cur_index++;
         }
@@ -247,7 +336,6 @@ fit_status_t fit_parse_object(uint8_t level,
     }
 
     DBG(FIT_TRACE_INFO, "[parse_object end]: for Level=%d, Index=%d \n\n", level, index);
-    pdata->data = parserdata;
     return status;
 }
 
@@ -289,6 +377,15 @@ static fit_status_t fit_parse_data(uint8_t level,
     {
         case(FIT_ARRAY):
         {
+            // Array contains no field requested by get info operation.
+            if (fit_skip_tag_tree(level, index, context))
+                break;
+#ifdef FIT_USE_INFO_TLV
+            // Its output was already accepted by get info sink.
+            if (fit_skip_resumed(pdata->data, pdata->read_byte, context))
+                break;
+#endif
+
             // Check if there is any operation or some checks that need to be performed on object.
             status = parsercallbacks(level, index, pdata, POBJECT_SIZE, context);
             if (status != FIT_STATUS_OK && status != FIT_CONTINUE_PARSE)
@@ -303,6 +400,15 @@ static fit_status_t fit_parse_data(uint8_t level,
 
         case (FIT_OBJECT):
         {
+            // Object contains no field requested by get info operation.
+            if (fit_skip_tag_tree(level, index, context))
+                break;
+#ifdef FIT_USE_INFO_TLV
+            // Its output was already accepted by get info sink.
+            if (fit_skip_resumed(pdata->data, pdata->read_byte, context))
+                break;
+#endif
+
             // Check if there is any operation or some checks that need to be performed on object.
             status = parsercallbacks(level, index, pdata, POBJECT_SIZE, context);
             if (status != FIT_STATUS_OK && status != FIT_CONTINUE_PARSE)
@@ -395,9 +501,15 @@ fit_status_t fit_parse_array(uint8_t level, uint8_t index, fit_pointer_t *pdata,
         // structure in array.
         fitptr.data = dataoffset+POBJECT_SIZE;
 
-        status = fit_parse_object(level, index, &fitptr, context);
-        if (status != FIT_STATUS_OK && status != FIT_CONTINUE_PARSE)
-            break;
+#ifdef FIT_USE_INFO_TLV
+        // Object whose output was already accepted by get info sink is skipped.
+        if (!fit_skip_resumed(dataoffset, pdata->read_byte, context))
+#endif
+        {
+            status = fit_parse_object(level, index, &fitptr, context);
+            if (status != FIT_STATUS_OK && status != FIT_CONTINUE_PARSE)
+                break;
+        }
         cntr += (uint16_t)(POBJECT_SIZE + read_dword(dataoffset, pdata->read_byte));
         // Get to the next structure data in the array.
         dataoffset += POBJECT_SIZE + read_dword(dataoffset, pdata->read_byte);
@@ -408,40 +520,33 @@ fit_status_t fit_parse_array(uint8_t level, uint8_t index, fit_pointer_t *pdata,
 
 /**
  *
- * add_field_type
+ * get_field_type
  *
- * This function will add/register the field type(see enum wire_type) corresponding
- * to particular level and index.
+ * Return wire type corresponding to index and level passed in.
  *
- * @param   level --> level/depth of license schema.
+ * @param   level --> level/depth of license schema to be parsed.
  * @param   index --> structure index. All fields will have unique index at each level.
  *                    So all fields at level 0 will have index value from 0..n, fields at
  *                    level 1 will have index value from 0..n and so on.
- * @param   type --> wire_type to be registered at particular level and index. See enum wire_type.
  *
  */
-fit_status_t add_field_type(uint8_t level, uint8_t index, wire_type_t type)
+wire_type_t get_field_type(uint8_t level, uint8_t index)
 {
     // Validate Parameters.
     if (level >= MAX_LEVEL)
-        return FIT_INVALID_PARAM_1;
+        return FIT_INVALID_VALUE;
     if (index >= MAX_INDEX)
-        return FIT_INVALID_PARAM_2;
-    if (!(type >= (uint8_t)FIT_INTEGER && type <= (uint8_t)FIT_ARRAY))
-        return FIT_INVALID_PARAM_3;
-
-    // Add field type at particular level and index. So all fields will be hard-coded
-    // at each level and index.
-    lic_field_type[level][index] = type;
+        return FIT_INVALID_VALUE;
 
-    return FIT_STATUS_OK;
+    /* Field type is hard-coded based on level and Index of the structure in question */
+    return lic_field_type[level][index];
 }
 
 /**
  *
- * get_field_type
+ * get_tag_id
  *
- * Return wire type corresponding to index and level passed in.
+ * Return tag id corresponding to index and level passed in.
  *
  * @param   level --> level/depth of license schema to be parsed.
  * @param   index --> structure index. All fields will have unique index at each level.
@@ -449,7 +554,7 @@ fit_status_t add_field_type(uint8_t level, uint8_t index, wire_type_t type)
  *                    level 1 will have index value from 0..n and so on.
  *
  */
-wire_type_t get_field_type(uint8_t level, uint8_t index)
+uint8_t get_tag_id(uint8_t level, uint8_t index)
 {
     // Validate Parameters.
     if (level >= MAX_LEVEL)
@@ -457,64 +562,81 @@ wire_type_t get_field_type(uint8_t level, uint8_t index)
     if (index >= MAX_INDEX)
         return FIT_INVALID_VALUE;
 
-    /* Field type is hard-coded based on level and Index of the structure in question */
-    return lic_field_type[level][index];
+    /* tag id is hard-coded based on level and Index of the structure in question */
+    return lic_tag_id[level][index];
 }
 
 /**
  *
- * add_tag_id
+ * fit_skip_tag_tree
  *
- * This function will add/register the tag id (as per sproto schema) corresponding
- * to particular level and index.
+ * Tells whether object or array at passed in level and index can be skipped by
+ * get info operation, i.e. neither its tag nor tag of any field it contains is
+ * selected by tag mask passed to fit_licenf_get_info_filtered. Skipped data is not
+ * parsed, so none of the parser checks are applied to it.
  *
  * @param   level --> level/depth of license schema.
- * @param   index --> structure index. All fields will have unique index at each level.
- *                    So all fields at level 0 will have index value from 0..n, fields at
- *                    level 1 will have index value from 0..n and so on.
- * @param   tag_id --> tag id to be registered at particular level and index.
+ * @param   index --> structure index of object or array.
+ * @param   context --> Pointer to fit context structure.
  *
  */
-fit_status_t add_tag_id(uint8_t level, uint8_t index, uint8_t tag_id)
+static uint8_t fit_skip_tag_tree(uint8_t level, uint8_t index, void *context)
 {
-    // Validate Parameters.
-    if (level >= MAX_LEVEL)
-        return FIT_INVALID_PARAM_1;
-    if (index >= MAX_INDEX)
-        return FIT_INVALID_PARAM_2;
-    if (!(tag_id > FIT_BASE_TAG_ID_VALUE && tag_id <= FIT_END_TAG_ID))
-        return FIT_INVALID_PARAM_3;
+    fitcontextdata *pcontext    = (fitcontextdata *)context;
+    uint8_t tagid               = 0;
+    uint32_t treemask           = 0;
 
-    // Add tag id at particular level and index. So all tags will be hardc-oded
-    // at each level and index.
-    lic_tag_id[level][index] = tag_id;
+    if (pcontext->m_operation != (uint8_t)FIT_GET_LICENSE_INFO_DATA)
+        return FALSE;
 
-    return FIT_STATUS_OK;
+    tagid = get_tag_id(level, index);
+    switch (tagid)
+    {
+        case FIT_LICENSE_TAG_ID:            treemask = FIT_LICENSE_TREE_MASK; break;
+        case FIT_SIGNATURE_TAG_ID:          treemask = FIT_SIGNATURE_TREE_MASK; break;
+        case FIT_HEADER_TAG_ID:             treemask = FIT_HEADER_TREE_MASK; break;
+        case FIT_LIC_CONTAINER_TAG_ID:      treemask = FIT_LIC_CONTAINER_TREE_MASK; break;
+        case FIT_VENDOR_ARRAY_TAG_ID:       treemask = FIT_VENDOR_TREE_MASK; break;
+        case FIT_PRODUCT_TAG_ID:            treemask = FIT_PRODUCT_TREE_MASK; break;
+        case FIT_PRODUCT_PART_ARRAY_TAG_ID: treemask = FIT_PRODUCT_PART_TREE_MASK; break;
+        case FIT_LIC_PROP_TAG_ID:           treemask = FIT_LIC_PROP_TREE_MASK; break;
+        case FIT_FEATURE_ARRAY_TAG_ID:      treemask = FIT_FEATURE_TREE_MASK; break;
+        case FIT_COUNTER_ARRAY_TAG_ID:      treemask = FIT_COUNTER_TREE_MASK; break;
+        // Unknown object/array is always parsed.
+        default:                            return FALSE;
+    }
+
+    return (uint8_t)((treemask & pcontext->mparserdata.m_getinfodata.m_tag_mask) == 0);
 }
 
+#ifdef FIT_USE_INFO_TLV
 /**
  *
- * get_tag_id
+ * fit_skip_resumed
  *
- * Return tag id corresponding to index and level passed in.
+ * Tells whether object or array can be skipped by get info operation as its output
+ * was already accepted, i.e. it ends at or before resume address. Objects and arrays
+ * are parsed in order of their addresses, so all of them were parsed before.
  *
- * @param   level --> level/depth of license schema to be parsed.
- * @param   index --> structure index. All fields will have unique index at each level.
- *                    So all fields at level 0 will have index value from 0..n, fields at
- *                    level 1 will have index value from 0..n and so on.
+ * @param   data --> Address of object or array (its size).
+ * @param   read_byte --> Read function of license memory.
+ * @param   context --> Pointer to fit context structure.
  *
  */
-uint8_t get_tag_id(uint8_t level, uint8_t index)
+static uint8_t fit_skip_resumed(uint8_t *data, fit_read_byte_callback_t read_byte, void *context)
 {
-    // Validate Parameters.
-    if (level >= MAX_LEVEL)
-        return FIT_INVALID_VALUE;
-    if (index >= MAX_INDEX)
-        return FIT_INVALID_VALUE;
+    fitcontextdata *pcontext    = (fitcontextdata *)context;
+    uint8_t *resume             = NULL;
 
-    /* tag id is hard-coded based on level and Index of the structure in question */
-    return lic_tag_id[level][index];
+    if (pcontext->m_operation != (uint8_t)FIT_GET_LICENSE_INFO_DATA)
+        return FALSE;
+    resume = pcontext->mparserdata.m_getinfodata.m_resume;
+    if (resume == NULL || data >= resume)
+        return FALSE;
+
+    return (uint8_t)(data + sizeof(uint32_t) + read_dword(data, read_byte) <= resume);
 }
+#endif // #ifdef FIT_USE_INFO_TLV
 
 /**
  *
@@ -550,9 +672,20 @@ fit_status_t fit_parse_field_data(fit_pointer_t *pdata,
     // Check if field length is greater than maximum allowed.
     if (level == STRUCT_SIGNATURE_LEVEL && index == RSA_SIGNATURE_FIELD)
     {
+#ifdef FIT_USE_ED25519
+        if (length != RSA_SIG_SIZE && length != FIT_ED25519_SIG_SIZE)
+#else
         if (length != RSA_SIG_SIZE)
+#endif // #ifdef FIT_USE_ED25519
             return FIT_INVALID_FIELD_LEN;
     }
+#ifdef FIT_USE_SEGMENTED_HASH
+    else if (level == STRUCT_SIGNATURE_LEVEL && index == SEGMENT_HASH_FIELD)
+    {
+        if (length == 0 || length % FIT_MERKLE_HASH_SIZE != 0)
+            return FIT_INVALID_FIELD_LEN;
+    }
+#endif // #ifdef FIT_USE_SEGMENTED_HASH
     else if (length > FIT_MAX_FIELD_SIZE)
         return FIT_INVALID_FIELD_LEN;
 
@@ -604,8 +737,20 @@ fit_status_t fit_parse_field_data(fit_pointer_t *pdata,
 
     // Validate Algorithm used for signing license data.
     if (level == STRUCT_SIGNATURE_LEVEL && index == ALGORITHM_ID_FIELD)
-        if (integer != AES_ALGID)
+    {
+        if (integer != AES_ALGID
+#ifdef FIT_USE_SEGMENTED_HASH
+            && integer != MERKLE_ALGID
+#endif
+#ifdef FIT_USE_ED25519
+            && integer != ED25519_ALGID
+#endif
+#ifdef FIT_USE_SHA256_DIGEST
+            && integer != SHA256_ALGID
+#endif
+            )
             status = FIT_INVALID_SIG_ID;
+    }
 
     // Validate vendor ID.
     if (level == STRUCT_LICENSE_CONTAINER_LEVEL && index == VENDOR_FIELD)
@@ -779,6 +924,10 @@ fit_status_t parsercallbacks(uint8_t level,
         uint8_t tagid = get_tag_id(level, index);
         fitv2cdata *v2c = (fitv2cdata *)pcontext->mparserdata.m_getinfodata.m_get_info_data;
 
+        // Callback is called only for tags requested by user.
+        if (tagid < 32 && (pcontext->mparserdata.m_getinfodata.m_tag_mask & FIT_TAG_MASK(tagid)) == 0)
+            return FIT_STATUS_OK;
+
         DBG(FIT_TRACE_INFO, "Calling user provided callback function\n");
         status = pcontext->mparserdata.m_getinfodata.m_callback_fn(tagid, pdata, length, v2c);
     }
@@ -799,6 +948,94 @@ fit_status_t parsercallbacks(uint8_t level,
     return status;
 }
 
+/**
+ *
+ * fit_get_signed_data
+ *
+ * This function will get the address of RSA signature and address and length of
+ * license part (data covered by RSA signature) from the license binary. With
+ * FIT_USE_ED25519 signature length is taken from license, as Ed25519 signature
+ * is shorter.
+ *
+ * @param   license --> Pointer to license data.
+ * @param   licpart <-- On return it will contain license part covered by signature.
+ * @param   signature <-- On return it will contain RSA signature.
+ *
+ */
+fit_status_t fit_get_signed_data(fit_pointer_t *license,
+                                 fit_pointer_t *licpart,
+                                 fit_pointer_t *signature)
+{
+    fit_status_t status           = FIT_STATUS_OK;
+    fitcontextdata context        = {0};
+    uint16_t num_fields           = 0;
+
+    licpart->read_byte = license->read_byte;
+    signature->read_byte = license->read_byte;
+
+    // Get RSA signature from license binary.
+    context.m_level = STRUCT_SIGNATURE_LEVEL;
+    context.m_index = RSA_SIGNATURE_FIELD;
+    context.m_operation = (uint8_t)FIT_GET_DATA_ADDRESS;
+    // Parse license data.
+    status = fit_parse_object(STRUCT_V2C_LEVEL, LICENSE_FIELD, license, &context);
+    if (!(status == FIT_STATUS_OK || status == FIT_STOP_PARSE))
+    {
+        DBG(FIT_TRACE_ERROR, "Not able to get rsa data %d\n", status);
+        return status;
+    }
+    if (context.mparserdata.m_addr == NULL)
+        return FIT_INVALID_V2C;
+
+    signature->data = context.mparserdata.m_addr;
+#ifdef FIT_USE_ED25519
+    signature->length = (uint16_t)read_dword(signature->data - PSTRING_SIZE, license->read_byte);
+    if (signature->length != RSA_SIG_SIZE && signature->length != FIT_ED25519_SIG_SIZE)
+        return FIT_INVALID_FIELD_LEN;
+#else
+    signature->length = RSA_SIG_SIZE;
+#endif // #ifdef FIT_USE_ED25519
+
+    // Get address and length of license part in binary.
+    // TODO we can get address via parsing of hard coded knowledge of schema
+    num_fields  = read_word(license->data, license->read_byte);
+    licpart->length  = (uint16_t)(read_dword(license->data + ((num_fields*PFIELD_SIZE)+PFIELD_SIZE), license->read_byte));
+    licpart->data = (uint8_t *)license->data + ((num_fields*PFIELD_SIZE)+PFIELD_SIZE+PARRAY_SIZE);
+
+    return FIT_STATUS_OK;
+}
+
+/**
+ *
+ * fit_get_signature_algid
+ *
+ * This function will get the algorithm id used for signing the license data.
+ *
+ * @param   license --> Pointer to license data.
+ * @param   algid <-- On return it will contain algorithm id.
+ *
+ */
+fit_status_t fit_get_signature_algid(fit_pointer_t *license, uint8_t *algid)
+{
+    fit_status_t status           = FIT_STATUS_OK;
+    fitcontextdata context        = {0};
+
+    context.m_level = STRUCT_SIGNATURE_LEVEL;
+    context.m_index = ALGORITHM_ID_FIELD;
+    context.m_operation = (uint8_t)FIT_GET_DATA_ADDRESS;
+    // Parse license data.
+    status = fit_parse_object(STRUCT_V2C_LEVEL, LICENSE_FIELD, license, &context);
+    if (!(status == FIT_STATUS_OK || status == FIT_STOP_PARSE))
+        return status;
+    if (context.mparserdata.m_addr == NULL)
+        return FIT_INVALID_V2C;
+
+    // Algorithm id is small integer value i.e. present in field part.
+    *algid = (uint8_t)((read_word(context.mparserdata.m_addr, license->read_byte)/2)-1);
+
+    return FIT_STATUS_OK;
+}
+
 /**
  *
  * fit_check_license_validation
@@ -812,61 +1049,64 @@ fit_status_t parsercallbacks(uint8_t level,
  *      Calculate Davies-Meyer-hash on the license
  *      Write that hash into the hash table.
  *
+ * @param   ctx <--> FIT core context; its license cache is updated.
  * @param   license --> Pointer to license data that need to be validated for RSA decryption.
- * @param   rsakey --> start address of the rsa public key in binary format, depending on your
- *                     READ_AES_BYTE definition
- * @param   rsakeylen --> Length of above rsa public key.
+ * @param   rsakey --> rsa public key; parsed on first use and kept parsed for
+ *                     subsequent licenses.
  *
  */
-fit_status_t fit_check_license_validation(fit_pointer_t* license,
-                                          fit_pointer_t* rsakey)
+fit_status_t fit_check_license_validation(fit_ctx_t *ctx,
+                                          fit_pointer_t* license,
+                                          fit_rsa_key_t* rsakey)
 {
     fit_status_t status           = FIT_STATUS_OK;
     fitcontextdata context        = {0};
     fit_pointer_t licaddr         = {0};
     fit_pointer_t signature       = {0};
-    uint16_t num_fields           = 0;
     uint8_t abreasthash[ABREAST_DM_HASH_SIZE] = {0};
     uint8_t dmhash[FIT_DM_HASH_SIZE]              = {0};
+#if defined(FIT_USE_SEGMENTED_HASH) || defined(FIT_USE_ED25519) || defined(FIT_USE_SHA256_DIGEST)
+    uint8_t algid                                 = AES_ALGID;
+#endif
 
     DBG(FIT_TRACE_INFO, "[fit_check_license_validation]: Entry.\n");
 
-    licaddr.read_byte = license->read_byte;
-    signature.read_byte = license->read_byte;
+    ctx->m_cache.m_stats.m_rsa_checks++;
 
     // Check RSA signature:
     // Step 1:  Decrypt RSA signature by RSA public key
     // Step 2:  Calculate Hash of the license by Abreast-DM
     // Step 3:  Compare calculated Hash and decrypted RSA signature (including sanity check on padding)
 
-    // Step 1: Get RSA signature from license hash. Decrypt RSA signature by RSA public key
-    context.m_level = STRUCT_SIGNATURE_LEVEL;
-    context.m_index = RSA_SIGNATURE_FIELD;
-    context.m_operation = (uint8_t)FIT_GET_DATA_ADDRESS;
-    // Parse license data.
-    status = fit_parse_object(STRUCT_V2C_LEVEL, LICENSE_FIELD, license, &context);
-    if (!(status == FIT_STATUS_OK || status == FIT_STOP_PARSE))
-    {
-        DBG(FIT_TRACE_ERROR, "Not able to get rsa data %d\n", status);
-        goto bail;
-    }
-    if (context.mparserdata.m_addr == NULL)
-    {
-        status = FIT_INVALID_V2C;
+    // Get RSA signature and license part (covered by signature) from license binary.
+    status = fit_get_signed_data(license, &licaddr, &signature);
+    if (status != FIT_STATUS_OK)
         goto bail;
-    }
-
-    licaddr.data = context.mparserdata.m_addr;
-    signature.data = licaddr.data;
-    signature.length = RSA_SIG_SIZE;
 
     // Step 2:  Calculate Hash of the license by Abreast-DM
-    // Get address and length of license part in binary.
-    // TODO we can get address via parsing of hard coded knowledge of schema
-    num_fields  = read_word(license->data, license->read_byte);
-    licaddr.length  = (uint16_t)(read_dword(license->data + ((num_fields*PFIELD_SIZE)+PFIELD_SIZE), license->read_byte));
-    licaddr.data = (uint8_t *)license->data + ((num_fields*PFIELD_SIZE)+PFIELD_SIZE+PARRAY_SIZE);
-
+#if defined(FIT_USE_SEGMENTED_HASH) || defined(FIT_USE_ED25519) || defined(FIT_USE_SHA256_DIGEST)
+    status = fit_get_signature_algid(license, &algid);
+    if (status != FIT_STATUS_OK)
+        goto bail;
+#endif
+#ifdef FIT_USE_SEGMENTED_HASH
+    // For segmented licenses signed value is root of hash tree over license segments.
+    if (algid == MERKLE_ALGID)
+        status = fit_merkle_get_root(&ctx->m_merkle, license, &licaddr, abreasthash);
+    else
+#endif // #ifdef FIT_USE_SEGMENTED_HASH
+#ifdef FIT_USE_SHA256_DIGEST
+    // SHA-256 digest is signed instead of Abreast DM hash (same size).
+    if (algid == SHA256_ALGID)
+        status = fit_sha256_digest(&licaddr, abreasthash);
+    else
+#endif // #ifdef FIT_USE_SHA256_DIGEST
+#ifdef FIT_USE_MULTI_BUFFER_HASH
+    // Hash may already be calculated by multi-buffer hash engine (batch validation).
+    if (fit_mb_hash_lookup(ctx->m_hashes, FIT_MB_HASH_ABREAST_DM, &licaddr, abreasthash) == TRUE)
+        status = FIT_STATUS_OK;
+    else
+#endif // #ifdef FIT_USE_MULTI_BUFFER_HASH
     // Get Abreast DM hash of the license
     status = fit_get_AbreastDM_Hash(&licaddr, abreasthash);
 
@@ -880,10 +1120,28 @@ fit_status_t fit_check_license_validation(fit_pointer_t* license,
         DBG(FIT_TRACE_INFO, "Got AbreastDM hash successfully. \n");
     }
 
+#ifdef FIT_USE_ED25519
+    // Same hash is signed by Ed25519; key passed in is then 32 byte Ed25519 key.
+    if (algid == ED25519_ALGID)
+        status = fit_validate_ed25519_signature(&signature, abreasthash, &rsakey->m_key);
+    else if (signature.length != RSA_SIG_SIZE)
+        status = FIT_INVALID_FIELD_LEN;
+    else
+#endif // #ifdef FIT_USE_ED25519
     status = fit_validate_rsa_signature(&signature, abreasthash, rsakey);
     if (status != FIT_STATUS_OK)
         goto bail;
 
+#ifdef FIT_USE_SEGMENTED_HASH
+    if (algid == MERKLE_ALGID)
+    {
+        // Root is verified; now authenticate all segments before license is parsed.
+        status = fit_merkle_verify_range(&ctx->m_merkle, licaddr.data, licaddr.length);
+        if (status != FIT_STATUS_OK)
+            goto bail;
+    }
+#endif // #ifdef FIT_USE_SEGMENTED_HASH
+
     // Calculate Davies-Meyer-hash on the license. Write that hash into the hash table.
     context.m_level = STRUCT_V2C_LEVEL;
     context.m_index = LICENSE_FIELD;
@@ -900,14 +1158,25 @@ fit_status_t fit_check_license_validation(fit_pointer_t* license,
     licaddr.data = (uint8_t *) license->data;
 
     // Get the hash of data.
+#ifdef FIT_USE_MULTI_BUFFER_HASH
+    if (fit_mb_hash_lookup(ctx->m_hashes, FIT_MB_HASH_DM, &licaddr, dmhash) == TRUE)
+        status = FIT_STATUS_OK;
+    else
+#endif // #ifdef FIT_USE_MULTI_BUFFER_HASH
     status = fit_davies_meyer_hash(&licaddr, (uint8_t *)&dmhash);
     if (status != FIT_STATUS_OK)
     {
         DBG(FIT_TRACE_ERROR, "Error in getting Davies Meyer hash with status %d\n", status);
         goto bail;
     }
-    fit_cache.m_rsa_check_done = TRUE;
-    fit_memcpy(fit_cache.m_dm_hash, dmhash, FIT_DM_HASH_SIZE);
+    // Cached license is bound to key bytes it was validated with.
+    if (fit_rsa_key_hash(rsakey, ctx->m_cache.m_key_hash) == FIT_STATUS_OK)
+        ctx->m_cache.m_rsa_check_done = TRUE;
+    fit_memcpy(ctx->m_cache.m_dm_hash, dmhash, FIT_DM_HASH_SIZE);
+#ifdef FIT_USE_SEGMENTED_HASH
+    ctx->m_cache.m_algid = algid;
+    fit_memcpy(ctx->m_cache.m_root, abreasthash, FIT_MERKLE_HASH_SIZE);
+#endif // #ifdef FIT_USE_SEGMENTED_HASH
 
 bail:
     DBG(FIT_TRACE_INFO, "[fit_check_license_validation]: Exit.\n");
@@ -915,135 +1184,6 @@ bail:
     return status;
 }
 
-/**
- *
- * register_tag_id
- *
- * This function will register all tag's corresponding to.particular level and
- * index i.e. hard-coded tag ID for fit licenses (as per sproto schema)
- *
- */
-static void register_tag_id(void)
-{
-    DBG(FIT_TRACE_INFO, "[register_tag_id]: Entry.\n");
-
-    // V2C - level 0
-    add_tag_id(STRUCT_V2C_LEVEL, LICENSE_FIELD, FIT_LICENSE_TAG_ID);
-    add_tag_id(STRUCT_V2C_LEVEL, SIGNATURE_FIELD, FIT_SIGNATURE_TAG_ID);
-
-    // License - Level 1
-    add_tag_id(STRUCT_LICENSE, HEADER_FIELD, FIT_HEADER_TAG_ID);
-    add_tag_id(STRUCT_LICENSE, LICENSE_CONTAINER_FIELD, FIT_LIC_CONTAINER_TAG_ID);
-    // Signature - level 1
-    add_tag_id(STRUCT_SIGNATURE_LEVEL, ALGORITHM_ID_FIELD, FIT_ALGORITHM_TAG_ID);
-    add_tag_id(STRUCT_SIGNATURE_LEVEL, RSA_SIGNATURE_FIELD, FIT_RSA_SIG_TAG_ID);
-
-    // Header - level 2
-    add_tag_id(STRUCT_HEADER_LEVEL, LICGEN_VERSION_FIELD, FIT_LICGEN_VERSION_TAG_ID);
-    add_tag_id(STRUCT_HEADER_LEVEL, LM_VERSION_FIELD, FIT_LM_VERSION_TAG_ID);
-    add_tag_id(STRUCT_HEADER_LEVEL, UID_FIELD, FIT_UID_TAG_ID);
-    add_tag_id(STRUCT_HEADER_LEVEL, FINGERPRINT_FIELD, FIT_FP_TAG_ID);
-    // LicenseContainer - level 2
-    add_tag_id(STRUCT_LICENSE_CONTAINER_LEVEL, ID_LC_FIELD, FIT_ID_LC_TAG_ID);
-    add_tag_id(STRUCT_LICENSE_CONTAINER_LEVEL, VENDOR_FIELD, FIT_VENDOR_ARRAY_TAG_ID);
-
-    // Vendor - level 3
-    add_tag_id(STRUCT_VENDOR_LEVEL, ID_VENDOR_FIELD, FIT_VENDOR_ID_TAG_ID);
-    add_tag_id(STRUCT_VENDOR_LEVEL, PRODUCT_FIELD, FIT_PRODUCT_TAG_ID);
-
-    // Product - level 4
-    add_tag_id(STRUCT_PRODUCT_LEVEL, ID_PRODUCT_FIELD, FIT_PRODUCT_ID_TAG_ID);
-    add_tag_id(STRUCT_PRODUCT_LEVEL, VERSION_REGEX_FIELD, FIT_VERSION_REGEX_TAG_ID);
-    add_tag_id(STRUCT_PRODUCT_LEVEL, PRODUCT_PART_FIELD, FIT_PRODUCT_PART_ARRAY_TAG_ID);
-
-    // Product Part- level 5
-    add_tag_id(STRUCT_PRODUCT_PART_FIELD, PRODUCT_PART_FIELD_ID, FIT_PRODUCT_PART_ID_TAG_ID);
-    add_tag_id(STRUCT_PRODUCT_PART_FIELD, LIC_PROP_FIELD, FIT_LIC_PROP_TAG_ID);
-
-    // LicenseProperties - level 6
-    add_tag_id(STRUCT_LIC_PROP_LEVEL, FEATURE_FIELD, FIT_FEATURE_ARRAY_TAG_ID);
-    add_tag_id(STRUCT_LIC_PROP_LEVEL, PERPETUAL_FIELD, FIT_PERPETUAL_TAG_ID);
-    add_tag_id(STRUCT_LIC_PROP_LEVEL, START_DATE_FIELD, FIT_START_DATE_TAG_ID);
-    add_tag_id(STRUCT_LIC_PROP_LEVEL, END_DATE_FIELD, FIT_END_DATE_TAG_ID);
-    add_tag_id(STRUCT_LIC_PROP_LEVEL, COUNTER_FIELD, FIT_COUNTER_ARRAY_TAG_ID);
-    add_tag_id(STRUCT_LIC_PROP_LEVEL, DURATION_FROM_FIRST_USE_FIELD, FIT_DURATION_FROM_FIRST_USE_TAG_ID);
-
-    // Feature - level 7
-    add_tag_id(STRUCT_FEATURE_LEVEL, ID_FEATURE_FIELD, FIT_FEATURE_TAG_ID);
-
-    // Counter - level 7
-    add_tag_id(STRUCT_COUNTER_LEVEL, ID_COUNTER_FIELD, FIT_COUNTER_TAG_ID);
-    add_tag_id(STRUCT_COUNTER_LEVEL, LIMIT_FIELD, FIT_LIMIT_TAG_ID);
-    add_tag_id(STRUCT_COUNTER_LEVEL, SOFT_LIMIT_FIELD, FIT_SOFT_LIMIT_TAG_ID);
-    add_tag_id(STRUCT_COUNTER_LEVEL, IS_FIELD, FIT_IS_FIELD_TAG_ID);
-
-    DBG(FIT_TRACE_INFO, "[register_tag_id]: Exit.\n");
-}
-
-/**
- *
- * register_field_types
- *
- * This function will register all wire types corresponding to.particular level and
- * index i.e. hard-coded the wire types corresponding to level and index.
- *
- */
-static void register_field_types(void)
-{
-    DBG(FIT_TRACE_INFO, "[register_field_types]: Entry.\n");
-
-    // V2C - level 0
-    add_field_type(STRUCT_V2C_LEVEL, LICENSE_FIELD, (uint8_t)FIT_OBJECT);
-    add_field_type(STRUCT_V2C_LEVEL, SIGNATURE_FIELD, (uint8_t)FIT_ARRAY);
-
-    // License - Level 1
-    add_field_type(STRUCT_LICENSE, HEADER_FIELD, (uint8_t)FIT_OBJECT);
-    add_field_type(STRUCT_LICENSE, LICENSE_CONTAINER_FIELD, (uint8_t)FIT_ARRAY);
-    // Signature - level 1
-    add_field_type(STRUCT_SIGNATURE_LEVEL, ALGORITHM_ID_FIELD, (uint8_t)FIT_INTEGER);
-    add_field_type(STRUCT_SIGNATURE_LEVEL, RSA_SIGNATURE_FIELD, (uint8_t)FIT_STRING);
-
-    // Header - level 2
-    add_field_type(STRUCT_HEADER_LEVEL, LICGEN_VERSION_FIELD, (uint8_t)FIT_INTEGER);
-    add_field_type(STRUCT_HEADER_LEVEL, LM_VERSION_FIELD, (uint8_t)FIT_INTEGER);
-    add_field_type(STRUCT_HEADER_LEVEL, UID_FIELD, (uint8_t)FIT_STRING);
-    add_field_type(STRUCT_HEADER_LEVEL, FINGERPRINT_FIELD, (uint8_t)FIT_STRING);
-    // LicenseContainer - level 2
-    add_field_type(STRUCT_LICENSE_CONTAINER_LEVEL, ID_LC_FIELD, (uint8_t)FIT_INTEGER);
-    add_field_type(STRUCT_LICENSE_CONTAINER_LEVEL, VENDOR_FIELD, (uint8_t)FIT_ARRAY);
-
-    // Vendor - level 3
-    add_field_type(STRUCT_VENDOR_LEVEL, ID_VENDOR_FIELD, (uint8_t)FIT_INTEGER);
-    add_field_type(STRUCT_VENDOR_LEVEL, PRODUCT_FIELD, (uint8_t)FIT_OBJECT);
-
-    // Product - level 4
-    add_field_type(STRUCT_PRODUCT_LEVEL, ID_PRODUCT_FIELD, (uint8_t)FIT_INTEGER);
-    add_field_type(STRUCT_PRODUCT_LEVEL, VERSION_REGEX_FIELD, (uint8_t)FIT_STRING);
-    add_field_type(STRUCT_PRODUCT_LEVEL, PRODUCT_PART_FIELD, (uint8_t)FIT_ARRAY);
-
-    // Product Part- level 5
-    add_field_type(STRUCT_PRODUCT_PART_FIELD, PRODUCT_PART_FIELD_ID, (uint8_t)FIT_INTEGER);
-    add_field_type(STRUCT_PRODUCT_PART_FIELD, LIC_PROP_FIELD, (uint8_t)FIT_OBJECT);
-
-    // LicenseProperties - level 6
-    add_field_type(STRUCT_LIC_PROP_LEVEL, FEATURE_FIELD, (uint8_t)FIT_ARRAY);
-    add_field_type(STRUCT_LIC_PROP_LEVEL, PERPETUAL_FIELD, (uint8_t)FIT_INTEGER);
-    add_field_type(STRUCT_LIC_PROP_LEVEL, START_DATE_FIELD, (uint8_t)FIT_INTEGER);
-    add_field_type(STRUCT_LIC_PROP_LEVEL, END_DATE_FIELD, (uint8_t)FIT_INTEGER);
-    add_field_type(STRUCT_LIC_PROP_LEVEL, COUNTER_FIELD, (uint8_t)FIT_ARRAY);
-    add_field_type(STRUCT_LIC_PROP_LEVEL, DURATION_FROM_FIRST_USE_FIELD, (uint8_t)FIT_INTEGER);
-
-    // Feature - level 7
-    add_field_type(STRUCT_FEATURE_LEVEL, ID_FEATURE_FIELD, (uint8_t)FIT_INTEGER);
-
-    // Counter - level 7
-    add_field_type(STRUCT_COUNTER_LEVEL, ID_COUNTER_FIELD, (uint8_t)FIT_INTEGER);
-    add_field_type(STRUCT_COUNTER_LEVEL, LIMIT_FIELD, (uint8_t)FIT_INTEGER);
-    add_field_type(STRUCT_COUNTER_LEVEL, SOFT_LIMIT_FIELD, (uint8_t)FIT_INTEGER);
-    add_field_type(STRUCT_COUNTER_LEVEL, IS_FIELD, (uint8_t)FIT_INTEGER);
-
-    DBG(FIT_TRACE_INFO, "[register_field_types]: Exit.\n");
-}
 
 
 
@@ -0,0 +1,86 @@
+/****************************************************************************\
+**
+** test_batch.c
+**
+** Defines test of batch license validation (FIT_USE_BATCH_VALIDATE) of licenses
+** kept next to each other in one buffer and read by FIT_READ_BYTE_BOUNDED. Empty
+** and truncated licenses must fail, even though license that follows them in
+** buffer is valid.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#if defined(FIT_USE_UNIT_TESTS) && defined(FIT_USE_BATCH_VALIDATE)
+
+/* Required Includes ********************************************************/
+#include <stdlib.h>
+#include "unittest/unit_test.h"
+#include "internal.h"
+#include "fit_debug.h"
+#include "fit_batch.h"
+#include "mem_read.h"
+
+/* Constants ****************************************************************/
+
+// Licenses validated by test: valid, empty and truncated by one byte.
+#define FIT_UNIT_TEST_BATCH_LICENSES    3
+
+/* Functions ****************************************************************/
+
+/**
+ *
+ * fit_unit_test_batch_bounds
+ *
+ * This function will put two copies of license passed in one after another into
+ * buffer and validate first copy, empty license at start of second copy and first
+ * copy without its last byte. Fails unless only the first one is valid.
+ *
+ * @param   license --> Valid license.
+ * @param   key --> Public key of the license.
+ *
+ */
+fit_status_t fit_unit_test_batch_bounds(fit_pointer_t *license, fit_pointer_t *key)
+{
+    fit_pointer_t licenses[FIT_UNIT_TEST_BATCH_LICENSES];
+    fit_status_t results[FIT_UNIT_TEST_BATCH_LICENSES];
+    fit_status_t status = FIT_UNIT_TEST_PASSED;
+    uint8_t *buf        = NULL;
+    uint16_t cntr       = 0;
+
+    if (license->length < 2)
+        return FIT_UNIT_TEST_FAILED;
+    buf = (uint8_t *)malloc(2 * (size_t)license->length);
+    if (buf == NULL)
+        return FIT_UNIT_TEST_FAILED;
+    fit_memset((uint8_t *)results, 0, sizeof(results));
+    for (cntr = 0; cntr < license->length; cntr++)
+    {
+        buf[cntr] = read_byte(license->data + cntr, license->read_byte);
+        buf[license->length + cntr] = buf[cntr];
+    }
+
+    for (cntr = 0; cntr < FIT_UNIT_TEST_BATCH_LICENSES; cntr++)
+    {
+        licenses[cntr].read_byte = (fit_read_byte_callback_t)FIT_READ_BYTE_BOUNDED;
+        licenses[cntr].data = buf;
+        licenses[cntr].length = license->length;
+    }
+    licenses[1].data = buf + license->length;
+    licenses[1].length = 0;
+    licenses[2].length = license->length - 1;
+
+    if (fit_batch_validate(licenses, FIT_UNIT_TEST_BATCH_LICENSES, key, 2, results, NULL) != FIT_STATUS_OK ||
+        results[0] != FIT_STATUS_OK || results[1] != FIT_INVALID_V2C || results[2] == FIT_STATUS_OK)
+    {
+        DBG(FIT_TRACE_ERROR, "[fit_unit_test_batch_bounds]: results %d %d %d\n",
+            results[0], results[1], results[2]);
+        status = FIT_UNIT_TEST_FAILED;
+    }
+
+    free(buf);
+
+    return status;
+}
+
+#endif // #if defined(FIT_USE_UNIT_TESTS) && defined(FIT_USE_BATCH_VALIDATE)
@@ -0,0 +1,583 @@
+/****************************************************************************\
+**
+** test_crypto.c
+**
+** Defines known answer tests for cryptographic primitives of Sentinel fit core.
+** AES is tested with whichever cipher is compiled in (byte oriented, table
+** based FIT_USE_AES_TTABLE or AES-NI FIT_USE_AESNI) against FIPS-197
+** vectors, and against textbook reference AES (S-box computed from GF(2^8)
+** inverse, no tables shared with fit core) for pseudo random keys and blocks
+** (differential test). Davies Meyer and Abreast DM hash vectors were generated
+** by the original byte oriented implementation. SHA-256 license digest
+** (FIT_USE_SHA256_DIGEST) is tested against FIPS 180-2 vectors.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#ifdef FIT_USE_UNIT_TESTS
+
+/* Required Includes ********************************************************/
+#include "unittest/unit_test.h"
+#include "internal.h"
+#include "mem_read.h"
+#include "fit_debug.h"
+#include "fit_aes.h"
+#include "fit_aesni.h"
+#include "dm_hash.h"
+#include "abreast_dm.h"
+#include "fit_sha256.h"
+#include "fit_ed25519.h"
+
+/* Constants ****************************************************************/
+
+// Number of pseudo random key/block pairs compared with reference AES.
+#ifndef FIT_UNIT_TEST_AES_ROUNDS
+#define FIT_UNIT_TEST_AES_ROUNDS        2000
+#endif
+
+// FIPS-197 appendix C: key 000102..1f (first 16 bytes for AES-128), plain text
+// 00112233..ff.
+static const uint8_t fips197_pt[16] = {
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+    0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff };
+static const uint8_t fips197_ct128[16] = {
+    0x69, 0xc4, 0xe0, 0xd8, 0x6a, 0x7b, 0x04, 0x30,
+    0xd8, 0xcd, 0xb7, 0x80, 0x70, 0xb4, 0xc5, 0x5a };
+static const uint8_t fips197_ct256[16] = {
+    0x8e, 0xa2, 0xb7, 0xca, 0x51, 0x67, 0x45, 0xbf,
+    0xea, 0xfc, 0x49, 0x90, 0x4b, 0x49, 0x60, 0x89 };
+
+// Hash vectors; message i is test_message_lens[i] bytes of "abc" (first one) or
+// (n*7 + 1) & 0xFF for byte n.
+static const uint16_t test_message_lens[4] = { 3, 16, 64, 100 };
+
+static const uint8_t dm_vectors[4][FIT_DM_HASH_SIZE] = {
+    { 0xef, 0x2c, 0x2a, 0xc1, 0x25, 0x20, 0x2d, 0x63,
+      0x14, 0x8d, 0xce, 0xff, 0xb1, 0xda, 0xb2, 0x3e },
+    { 0x81, 0x11, 0xda, 0x1d, 0xab, 0xe1, 0x39, 0x0e,
+      0xa1, 0xf4, 0x2b, 0x61, 0x55, 0x50, 0x59, 0xf0 },
+    { 0xd1, 0x0c, 0x4d, 0x6a, 0xc0, 0xa3, 0xf5, 0xbe,
+      0x53, 0xd6, 0x3e, 0x4d, 0xd1, 0x0f, 0x1e, 0x11 },
+    { 0x05, 0x7f, 0x77, 0x29, 0xb0, 0x9d, 0x7b, 0xcd,
+      0xd8, 0x85, 0x54, 0x6b, 0x40, 0x5d, 0xc5, 0xcf },
+};
+
+static const uint8_t abreast_dm_vectors[4][ABREAST_DM_HASH_SIZE] = {
+    { 0xde, 0xf4, 0x20, 0x2f, 0xaa, 0xe1, 0x3c, 0x66,
+      0x79, 0x6b, 0xc3, 0xc2, 0x18, 0x0c, 0xd4, 0xba,
+      0xe1, 0xec, 0x90, 0x48, 0x45, 0x35, 0x83, 0x59,
+      0x89, 0x45, 0xd2, 0xa1, 0x75, 0x98, 0x20, 0x57 },
+    { 0x0a, 0xe3, 0xa1, 0x70, 0xcc, 0x0e, 0x01, 0xa7,
+      0xba, 0xbf, 0x0a, 0x8a, 0x52, 0x3c, 0xc7, 0x5a,
+      0xea, 0x87, 0xdd, 0x28, 0xae, 0x82, 0xe2, 0x89,
+      0x7d, 0x27, 0xc2, 0x7e, 0x77, 0x75, 0x7c, 0x68 },
+    { 0x83, 0x04, 0xb7, 0x09, 0xbe, 0x1a, 0xb7, 0xfd,
+      0x3d, 0x1c, 0x6b, 0x61, 0xbe, 0x0b, 0xf3, 0xd4,
+      0x34, 0x24, 0xb2, 0x93, 0x1e, 0x60, 0x51, 0xd0,
+      0x72, 0xcf, 0x5e, 0xd2, 0x8a, 0x5a, 0x91, 0x0a },
+    { 0x63, 0x96, 0x81, 0x22, 0xf1, 0x40, 0xe7, 0x58,
+      0x79, 0xa3, 0x89, 0x75, 0x2b, 0x3d, 0xe0, 0xe1,
+      0xd8, 0xf7, 0x65, 0x17, 0xad, 0x99, 0xbd, 0xab,
+      0x7b, 0x5b, 0x82, 0x72, 0xf4, 0xb7, 0x05, 0x95 },
+};
+
+#ifdef FIT_USE_SHA256_DIGEST
+// FIPS 180-2 appendix B messages and digests.
+static const char *sha256_messages[4] = {
+    "",
+    "abc",
+    "abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+    "abcdefghbcdefghicdefghijdefghijkefghijklfghijklmghijklmn"
+    "hijklmnoijklmnopjklmnopqklmnopqrlmnopqrsmnopqrstnopqrstu",
+};
+
+static const uint8_t sha256_vectors[4][FIT_SHA256_HASH_SIZE] = {
+    { 0xe3, 0xb0, 0xc4, 0x42, 0x98, 0xfc, 0x1c, 0x14,
+      0x9a, 0xfb, 0xf4, 0xc8, 0x99, 0x6f, 0xb9, 0x24,
+      0x27, 0xae, 0x41, 0xe4, 0x64, 0x9b, 0x93, 0x4c,
+      0xa4, 0x95, 0x99, 0x1b, 0x78, 0x52, 0xb8, 0x55 },
+    { 0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea,
+      0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+      0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c,
+      0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad },
+    { 0x24, 0x8d, 0x6a, 0x61, 0xd2, 0x06, 0x38, 0xb8,
+      0xe5, 0xc0, 0x26, 0x93, 0x0c, 0x3e, 0x60, 0x39,
+      0xa3, 0x3c, 0xe4, 0x59, 0x64, 0xff, 0x21, 0x67,
+      0xf6, 0xec, 0xed, 0xd4, 0x19, 0xdb, 0x06, 0xc1 },
+    { 0xcf, 0x5b, 0x16, 0xa7, 0x78, 0xaf, 0x83, 0x80,
+      0x03, 0x6c, 0xe5, 0x9e, 0x7b, 0x04, 0x92, 0x37,
+      0x0b, 0x24, 0x9b, 0x11, 0xe8, 0xf0, 0x7a, 0x51,
+      0xaf, 0xac, 0x45, 0x03, 0x7a, 0xfe, 0xe9, 0xd1 },
+};
+#endif // #ifdef FIT_USE_SHA256_DIGEST
+
+#ifdef FIT_USE_ED25519
+// RFC 8032 section 7.1 tests 1 and 2: public keys, messages and signatures.
+// Message of test 1 is empty and of test 2 is one byte, so message length is
+// same as vector index.
+static const uint8_t ed25519_keys[2][FIT_ED25519_KEY_SIZE] = {
+    { 0xd7, 0x5a, 0x98, 0x01, 0x82, 0xb1, 0x0a, 0xb7, 0xd5, 0x4b, 0xfe, 0xd3,
+      0xc9, 0x64, 0x07, 0x3a, 0x0e, 0xe1, 0x72, 0xf3, 0xda, 0xa6, 0x23, 0x25,
+      0xaf, 0x02, 0x1a, 0x68, 0xf7, 0x07, 0x51, 0x1a },
+    { 0x3d, 0x40, 0x17, 0xc3, 0xe8, 0x43, 0x89, 0x5a, 0x92, 0xb7, 0x0a, 0xa7,
+      0x4d, 0x1b, 0x7e, 0xbc, 0x9c, 0x98, 0x2c, 0xcf, 0x2e, 0xc4, 0x96, 0x8c,
+      0xc0, 0xcd, 0x55, 0xf1, 0x2a, 0xf4, 0x66, 0x0c },
+};
+static const uint8_t ed25519_message[1] = { 0x72 };
+static const uint8_t ed25519_sigs[2][FIT_ED25519_SIG_SIZE] = {
+    { 0xe5, 0x56, 0x43, 0x00, 0xc3, 0x60, 0xac, 0x72, 0x90, 0x86, 0xe2, 0xcc,
+      0x80, 0x6e, 0x82, 0x8a, 0x84, 0x87, 0x7f, 0x1e, 0xb8, 0xe5, 0xd9, 0x74,
+      0xd8, 0x73, 0xe0, 0x65, 0x22, 0x49, 0x01, 0x55, 0x5f, 0xb8, 0x82, 0x15,
+      0x90, 0xa3, 0x3b, 0xac, 0xc6, 0x1e, 0x39, 0x70, 0x1c, 0xf9, 0xb4, 0x6b,
+      0xd2, 0x5b, 0xf5, 0xf0, 0x59, 0x5b, 0xbe, 0x24, 0x65, 0x51, 0x41, 0x43,
+      0x8e, 0x7a, 0x10, 0x0b },
+    { 0x92, 0xa0, 0x09, 0xa9, 0xf0, 0xd4, 0xca, 0xb8, 0x72, 0x0e, 0x82, 0x0b,
+      0x5f, 0x64, 0x25, 0x40, 0xa2, 0xb2, 0x7b, 0x54, 0x16, 0x50, 0x3f, 0x8f,
+      0xb3, 0x76, 0x22, 0x23, 0xeb, 0xdb, 0x69, 0xda, 0x08, 0x5a, 0xc1, 0xe4,
+      0x3e, 0x15, 0x99, 0x6e, 0x45, 0x8f, 0x36, 0x13, 0xd0, 0xf1, 0x1d, 0x8c,
+      0x38, 0x7b, 0x2e, 0xae, 0xb4, 0x30, 0x2a, 0xee, 0xb0, 0x0d, 0x29, 0x16,
+      0x12, 0xbb, 0x0c, 0x00 },
+};
+#endif // #ifdef FIT_USE_ED25519
+
+/* Functions ****************************************************************/
+
+/**
+ *
+ * fit_unit_test_random
+ *
+ * This function will fill buffer with pseudo random bytes (linear congruential
+ * generator), so differential tests are repeatable.
+ *
+ * @param   seed <--> Generator state.
+ * @param   buf <-- Buffer to be filled.
+ * @param   len --> Length of buffer.
+ *
+ */
+static void fit_unit_test_random(uint32_t *seed, uint8_t *buf, uint16_t len)
+{
+    uint16_t cntr = 0;
+
+    for (cntr = 0; cntr < len; cntr++)
+    {
+        *seed = *seed * 1103515245UL + 12345UL;
+        buf[cntr] = (uint8_t)(*seed >> 16);
+    }
+}
+
+/**
+ *
+ * fit_unit_test_gf_mul
+ *
+ * This function will multiply two elements of GF(2^8) modulo AES polynomial.
+ *
+ */
+static uint8_t fit_unit_test_gf_mul(uint8_t a, uint8_t b)
+{
+    uint8_t res = 0;
+
+    while (b != 0)
+    {
+        if (b & 1)
+            res ^= a;
+        a = (uint8_t)((a << 1) ^ ((a & 0x80) ? 0x1B : 0));
+        b >>= 1;
+    }
+
+    return res;
+}
+
+/**
+ *
+ * fit_unit_test_sbox
+ *
+ * This function will compute AES S-box entry i.e. affine transform of inverse
+ * of x in GF(2^8) (FIPS-197 section 5.1.1).
+ *
+ */
+static uint8_t fit_unit_test_sbox(uint8_t x)
+{
+    uint8_t inv = 0;
+    uint8_t res = 0;
+    uint16_t cntr = 0;
+
+    // Inverse is x^254; 0 maps to 0.
+    inv = 1;
+    for (cntr = 0; cntr < 254; cntr++)
+        inv = fit_unit_test_gf_mul(inv, x);
+    res = inv;
+    for (cntr = 1; cntr < 5; cntr++)
+        res ^= (uint8_t)((inv << cntr) | (inv >> (8 - cntr)));
+
+    return (uint8_t)(res ^ 0x63);
+}
+
+/**
+ *
+ * fit_unit_test_aes_ref
+ *
+ * This function will encrypt one block by straightforward AES implementation
+ * (FIPS-197 pseudo code), used as reference for differential test.
+ *
+ * @param   key --> AES key.
+ * @param   keylen --> Key length (AES_128_KEY_LENGTH or AES_256_KEY_LENGTH).
+ * @param   input --> Plain text block.
+ * @param   output <-- Cipher text block.
+ *
+ */
+static void fit_unit_test_aes_ref(const uint8_t *key,
+                                  uint16_t keylen,
+                                  const uint8_t *input,
+                                  uint8_t *output)
+{
+    uint8_t sbox[256]               = {0};
+    uint8_t w[240]                  = {0};
+    uint8_t state[16]               = {0};
+    uint8_t tmp[16]                 = {0};
+    uint8_t rcon                    = 1;
+    uint16_t nk                     = keylen / 4;
+    uint16_t rounds                 = nk + 6;
+    uint16_t cntr                   = 0;
+    uint16_t round                  = 0;
+    uint16_t col                    = 0;
+
+    for (cntr = 0; cntr < 256; cntr++)
+        sbox[cntr] = fit_unit_test_sbox((uint8_t)cntr);
+
+    // Key expansion.
+    fit_memcpy(w, (uint8_t *)key, keylen);
+    for (cntr = nk; cntr < 4*(rounds + 1); cntr++)
+    {
+        uint8_t t[4];
+
+        t[0] = w[4*cntr - 4]; t[1] = w[4*cntr - 3];
+        t[2] = w[4*cntr - 2]; t[3] = w[4*cntr - 1];
+        if (cntr % nk == 0)
+        {
+            uint8_t t0 = t[0];
+
+            t[0] = (uint8_t)(sbox[t[1]] ^ rcon);
+            t[1] = sbox[t[2]];
+            t[2] = sbox[t[3]];
+            t[3] = sbox[t0];
+            rcon = fit_unit_test_gf_mul(rcon, 2);
+        }
+        else if (nk > 6 && cntr % nk == 4)
+        {
+            for (col = 0; col < 4; col++)
+                t[col] = sbox[t[col]];
+        }
+        for (col = 0; col < 4; col++)
+            w[4*cntr + col] = (uint8_t)(w[4*(cntr - nk) + col] ^ t[col]);
+    }
+
+    for (cntr = 0; cntr < 16; cntr++)
+        state[cntr] = (uint8_t)(input[cntr] ^ w[cntr]);
+    for (round = 1; round <= rounds; round++)
+    {
+        // SubBytes and ShiftRows; state is column major.
+        for (cntr = 0; cntr < 16; cntr++)
+            tmp[cntr] = sbox[state[(cntr + 4*(cntr % 4)) % 16]];
+        // MixColumns except in last round.
+        for (col = 0; col < 4; col++)
+        {
+            uint8_t *c = tmp + 4*col;
+
+            if (round == rounds)
+            {
+                fit_memcpy(state + 4*col, c, 4);
+                continue;
+            }
+            state[4*col]     = (uint8_t)(fit_unit_test_gf_mul(c[0], 2) ^ fit_unit_test_gf_mul(c[1], 3) ^ c[2] ^ c[3]);
+            state[4*col + 1] = (uint8_t)(c[0] ^ fit_unit_test_gf_mul(c[1], 2) ^ fit_unit_test_gf_mul(c[2], 3) ^ c[3]);
+            state[4*col + 2] = (uint8_t)(c[0] ^ c[1] ^ fit_unit_test_gf_mul(c[2], 2) ^ fit_unit_test_gf_mul(c[3], 3));
+            state[4*col + 3] = (uint8_t)(fit_unit_test_gf_mul(c[0], 3) ^ c[1] ^ c[2] ^ fit_unit_test_gf_mul(c[3], 2));
+        }
+        for (cntr = 0; cntr < 16; cntr++)
+            state[cntr] ^= w[16*round + cntr];
+    }
+    fit_memcpy(output, state, 16);
+}
+
+/**
+ *
+ * fit_unit_test_aes_key
+ *
+ * This function will encrypt one block by both AES interfaces (expanded key and
+ * on the fly round keys) and compare results with expected cipher text.
+ *
+ * @param   key --> AES key.
+ * @param   keylen --> Key length (AES_128_KEY_LENGTH or AES_256_KEY_LENGTH).
+ * @param   input --> Plain text block.
+ * @param   expected --> Expected cipher text block.
+ *
+ */
+static fit_status_t fit_unit_test_aes_key(const uint8_t *key,
+                                          uint16_t keylen,
+                                          const uint8_t *input,
+                                          const uint8_t *expected)
+{
+    aes_state_t aes                         = {0};
+    uint8_t skey[240]                       = {0};
+    uint8_t block[AES_OUTPUT_DATA_SIZE]     = {0};
+    uint8_t output[AES_OUTPUT_DATA_SIZE]    = {0};
+
+    fit_memcpy(block, (uint8_t *)input, AES_OUTPUT_DATA_SIZE);
+    if (aes_setup(&aes, key, keylen, skey) != FIT_STATUS_OK)
+        return FIT_UNIT_TEST_FAILED;
+    aes_encrypt(&aes, block, output, skey, NULL);
+    if (fit_memcmp(output, (uint8_t *)expected, AES_OUTPUT_DATA_SIZE) != 0)
+        return FIT_UNIT_TEST_FAILED;
+
+    if (aes_encrypt_key(key, keylen, input, output) != FIT_STATUS_OK ||
+        fit_memcmp(output, (uint8_t *)expected, AES_OUTPUT_DATA_SIZE) != 0)
+    {
+        return FIT_UNIT_TEST_FAILED;
+    }
+
+    return FIT_UNIT_TEST_PASSED;
+}
+
+/**
+ *
+ * fit_unit_test_aes_algorithm
+ *
+ * This function will test AES-128 and AES-256 cipher compiled into fit core with
+ * FIPS-197 vectors, and then compare it with reference AES for pseudo random keys
+ * and blocks. If AES-NI is used, interleaved lanes (fit_aesni_encrypt_lanes) are
+ * compared as well.
+ *
+ */
+fit_status_t fit_unit_test_aes_algorithm(void)
+{
+    uint8_t key[AES_256_KEY_LENGTH]         = {0};
+    uint8_t block[AES_OUTPUT_DATA_SIZE]     = {0};
+    uint8_t expected[AES_OUTPUT_DATA_SIZE]  = {0};
+    uint16_t keylen                         = 0;
+    uint32_t seed                           = 1;
+    uint16_t cntr                           = 0;
+    fit_status_t status                     = FIT_UNIT_TEST_PASSED;
+
+    for (cntr = 0; cntr < AES_256_KEY_LENGTH; cntr++)
+        key[cntr] = (uint8_t)cntr;
+    if (fit_unit_test_aes_key(key, AES_128_KEY_LENGTH, fips197_pt, fips197_ct128) != FIT_UNIT_TEST_PASSED ||
+        fit_unit_test_aes_key(key, AES_256_KEY_LENGTH, fips197_pt, fips197_ct256) != FIT_UNIT_TEST_PASSED)
+    {
+        DBG(FIT_TRACE_ERROR, "[fit_unit_test_aes_algorithm]: FIPS-197 vector failed\n");
+        return FIT_UNIT_TEST_FAILED;
+    }
+
+    for (cntr = 0; cntr < FIT_UNIT_TEST_AES_ROUNDS && status == FIT_UNIT_TEST_PASSED; cntr++)
+    {
+        keylen = (cntr & 1) ? AES_256_KEY_LENGTH : AES_128_KEY_LENGTH;
+        fit_unit_test_random(&seed, key, keylen);
+        fit_unit_test_random(&seed, block, AES_OUTPUT_DATA_SIZE);
+
+        fit_unit_test_aes_ref(key, keylen, block, expected);
+        status = fit_unit_test_aes_key(key, keylen, block, expected);
+    }
+    if (status != FIT_UNIT_TEST_PASSED)
+    {
+        DBG(FIT_TRACE_ERROR, "[fit_unit_test_aes_algorithm]: differs from reference at %d\n", cntr - 1);
+        return status;
+    }
+
+#ifdef FIT_AESNI_AVAILABLE
+    if (fit_aesni_supported())
+    {
+        uint8_t keys[FIT_AESNI_MAX_LANES*AES_256_KEY_LENGTH]      = {0};
+        uint8_t input[FIT_AESNI_MAX_LANES*AES_OUTPUT_DATA_SIZE]   = {0};
+        uint8_t output[FIT_AESNI_MAX_LANES*AES_OUTPUT_DATA_SIZE]  = {0};
+        uint8_t lanes                                           = 0;
+        uint8_t lane                                            = 0;
+
+        for (lanes = 1; lanes <= FIT_AESNI_MAX_LANES; lanes++)
+        {
+            keylen = (lanes & 1) ? AES_256_KEY_LENGTH : AES_128_KEY_LENGTH;
+            fit_unit_test_random(&seed, keys, sizeof(keys));
+            fit_unit_test_random(&seed, input, sizeof(input));
+            fit_aesni_encrypt_lanes(keylen, lanes, keys, input, output);
+            for (lane = 0; lane < lanes; lane++)
+            {
+                if (aes_encrypt_key(keys + lane*AES_256_KEY_LENGTH, keylen,
+                        input + lane*AES_OUTPUT_DATA_SIZE, expected) != FIT_STATUS_OK ||
+                    fit_memcmp(output + lane*AES_OUTPUT_DATA_SIZE, expected, AES_OUTPUT_DATA_SIZE) != 0)
+                {
+                    DBG(FIT_TRACE_ERROR, "[fit_unit_test_aes_algorithm]: lane %d of %d failed\n", lane, lanes);
+                    return FIT_UNIT_TEST_FAILED;
+                }
+            }
+        }
+    }
+#endif // #ifdef FIT_AESNI_AVAILABLE
+
+    return FIT_UNIT_TEST_PASSED;
+}
+
+/**
+ *
+ * fit_unit_test_dm_algorithm
+ *
+ * This function will test Davies Meyer hash (one shot and streaming, with data
+ * passed in pieces of different length) and Abreast DM hash with known vectors.
+ *
+ */
+fit_status_t fit_unit_test_dm_algorithm(void)
+{
+    uint8_t message[128]                    = {0};
+    uint8_t hash[ABREAST_DM_HASH_SIZE]      = {0};
+    fit_dm_hash_ctx_t ctx;
+    fit_pointer_t fitptr                    = {0};
+    fit_pointer_t piece                     = {0};
+    uint16_t offset                         = 0;
+    uint16_t cntr                           = 0;
+    uint8_t vector                          = 0;
+
+    fitptr.read_byte = (fit_read_byte_callback_t)FIT_READ_BYTE_RAM;
+    fitptr.data = message;
+    piece.read_byte = fitptr.read_byte;
+
+    for (vector = 0; vector < 4; vector++)
+    {
+        fitptr.length = test_message_lens[vector];
+        for (cntr = 0; cntr < fitptr.length; cntr++)
+            message[cntr] = (vector == 0) ? (uint8_t)"abc"[cntr] : (uint8_t)(cntr*7 + 1);
+
+        if (fit_davies_meyer_hash(&fitptr, hash) != FIT_STATUS_OK ||
+            fit_memcmp(hash, (uint8_t *)dm_vectors[vector], FIT_DM_HASH_SIZE) != 0)
+        {
+            DBG(FIT_TRACE_ERROR, "[fit_unit_test_dm_algorithm]: dm vector %d failed\n", vector);
+            return FIT_UNIT_TEST_FAILED;
+        }
+
+        // Streaming hash; pieces of 1, 2, 3... bytes cross block boundaries.
+        fit_dm_hash_start(&ctx);
+        for (offset = 0, cntr = 1; offset < fitptr.length; offset += piece.length, cntr++)
+        {
+            piece.data = message + offset;
+            piece.length = (uint16_t)(fitptr.length - offset < cntr ? fitptr.length - offset : cntr);
+            fit_dm_hash_update(&ctx, &piece);
+        }
+        if (fit_dm_hash_final(&ctx, hash) != FIT_STATUS_OK ||
+            fit_memcmp(hash, (uint8_t *)dm_vectors[vector], FIT_DM_HASH_SIZE) != 0)
+        {
+            DBG(FIT_TRACE_ERROR, "[fit_unit_test_dm_algorithm]: streaming dm vector %d failed\n", vector);
+            return FIT_UNIT_TEST_FAILED;
+        }
+
+        if (fit_get_AbreastDM_Hash(&fitptr, hash) != FIT_STATUS_OK ||
+            fit_memcmp(hash, (uint8_t *)abreast_dm_vectors[vector], ABREAST_DM_HASH_SIZE) != 0)
+        {
+            DBG(FIT_TRACE_ERROR, "[fit_unit_test_dm_algorithm]: abreast dm vector %d failed\n", vector);
+            return FIT_UNIT_TEST_FAILED;
+        }
+    }
+
+    return FIT_UNIT_TEST_PASSED;
+}
+
+#ifdef FIT_USE_SHA256_DIGEST
+/**
+ *
+ * fit_unit_test_sha256_algorithm
+ *
+ * This function will test SHA-256 license digest (portable or SHA-NI compression,
+ * whichever is selected at run time) with FIPS 180-2 vectors.
+ *
+ */
+fit_status_t fit_unit_test_sha256_algorithm(void)
+{
+    uint8_t hash[FIT_SHA256_HASH_SIZE]  = {0};
+    fit_pointer_t fitptr                = {0};
+    uint8_t vector                      = 0;
+
+    fitptr.read_byte = (fit_read_byte_callback_t)FIT_READ_BYTE_RAM;
+    for (vector = 0; vector < 4; vector++)
+    {
+        fitptr.data = (uint8_t *)sha256_messages[vector];
+        for (fitptr.length = 0; sha256_messages[vector][fitptr.length] != 0; fitptr.length++)
+            ;
+
+        if (fit_sha256_digest(&fitptr, hash) != FIT_STATUS_OK ||
+            fit_memcmp(hash, (uint8_t *)sha256_vectors[vector], FIT_SHA256_HASH_SIZE) != 0)
+        {
+            DBG(FIT_TRACE_ERROR, "[fit_unit_test_sha256_algorithm]: vector %d failed\n", vector);
+            return FIT_UNIT_TEST_FAILED;
+        }
+    }
+
+    return FIT_UNIT_TEST_PASSED;
+}
+#endif // #ifdef FIT_USE_SHA256_DIGEST
+
+#ifdef FIT_USE_ED25519
+/**
+ *
+ * fit_unit_test_ed25519_algorithm
+ *
+ * This function will verify RFC 8032 test vectors in one step and in steps of one
+ * operation, and check that modified signature and small order public key or R
+ * (neutral point with S = 0, which would verify any message) are rejected.
+ *
+ */
+fit_status_t fit_unit_test_ed25519_algorithm(void)
+{
+    fit_ed25519_ctx_t ctx;
+    uint8_t sig[FIT_ED25519_SIG_SIZE]   = {0};
+    uint8_t key[FIT_ED25519_KEY_SIZE]   = {0};
+    fit_status_t status                 = FIT_STATUS_OK;
+    uint16_t budget                     = 0;
+    uint8_t vector                      = 0;
+
+    for (vector = 0; vector < 2; vector++)
+    {
+        if (fit_ed25519_verify(ed25519_sigs[vector], ed25519_keys[vector],
+                               ed25519_message, vector) != FIT_STATUS_OK)
+        {
+            DBG(FIT_TRACE_ERROR, "[fit_unit_test_ed25519_algorithm]: vector %d failed\n", vector);
+            return FIT_UNIT_TEST_FAILED;
+        }
+
+        status = fit_ed25519_verify_start(&ctx, ed25519_sigs[vector], ed25519_keys[vector],
+                                          ed25519_message, vector);
+        if (status == FIT_STATUS_OK)
+        {
+            do
+            {
+                budget = 1;
+                status = fit_ed25519_verify_step(&ctx, &budget);
+            } while (status == FIT_VERIFY_IN_PROGRESS);
+        }
+        if (status != FIT_STATUS_OK)
+        {
+            DBG(FIT_TRACE_ERROR, "[fit_unit_test_ed25519_algorithm]: vector %d failed in steps\n", vector);
+            return FIT_UNIT_TEST_FAILED;
+        }
+
+        fit_memcpy(sig, (uint8_t *)ed25519_sigs[vector], FIT_ED25519_SIG_SIZE);
+        sig[40] ^= 1;
+        if (fit_ed25519_verify(sig, ed25519_keys[vector], ed25519_message, vector) == FIT_STATUS_OK)
+        {
+            DBG(FIT_TRACE_ERROR, "[fit_unit_test_ed25519_algorithm]: vector %d modified passed\n", vector);
+            return FIT_UNIT_TEST_FAILED;
+        }
+    }
+
+    // Neutral point as public key and R, S = 0.
+    key[0] = 1;
+    sig[0] = 1;
+    for (vector = 1; vector < FIT_ED25519_SIG_SIZE; vector++)
+        sig[vector] = 0;
+    if (fit_ed25519_verify(sig, key, ed25519_message, 1) == FIT_STATUS_OK ||
+        fit_ed25519_verify(sig, ed25519_keys[0], ed25519_message, 1) == FIT_STATUS_OK)
+    {
+        DBG(FIT_TRACE_ERROR, "[fit_unit_test_ed25519_algorithm]: small order point passed\n");
+        return FIT_UNIT_TEST_FAILED;
+    }
+
+    return FIT_UNIT_TEST_PASSED;
+}
+#endif // #ifdef FIT_USE_ED25519
+
+#endif // #ifdef FIT_USE_UNIT_TESTS
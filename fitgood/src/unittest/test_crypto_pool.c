@@ -0,0 +1,217 @@
+/****************************************************************************\
+**
+** test_crypto_pool.c
+**
+** Defines test of asynchronous crypto provider (FIT_USE_CRYPTO_PROVIDER) using
+** thread pool stand-in provider (FIT_USE_CRYPTO_POOL). License data is read from
+** simulated slow storage in chunks and hashed by provider jobs, once serially
+** (read, hash, wait) and once overlapped (next chunk is read while provider hashes
+** previous one). Both hashes are checked against software hash, and time of both
+** runs is reported, so overlap of hashing with storage reads can be measured
+** without crypto hardware.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#if defined(FIT_USE_UNIT_TESTS) && defined(FIT_USE_CRYPTO_PROVIDER) && defined(FIT_USE_CRYPTO_POOL)
+
+/* Required Includes ********************************************************/
+#include <time.h>
+#include <unistd.h>
+#include "unittest/unit_test.h"
+#include "internal.h"
+#include "mem_read.h"
+#include "fit_debug.h"
+#include "fit_ctx.h"
+#include "fit_crypto_pool.h"
+#include "abreast_dm.h"
+
+/* Constants ****************************************************************/
+
+// Number and size of chunks read from simulated storage.
+#define FIT_UNIT_TEST_CHUNKS            16
+#define FIT_UNIT_TEST_CHUNK_SIZE        1024
+
+// Simulated latency (microseconds) of one chunk read and of one provider job.
+#ifndef FIT_UNIT_TEST_READ_LATENCY
+#define FIT_UNIT_TEST_READ_LATENCY      500
+#endif
+#ifndef FIT_UNIT_TEST_JOB_LATENCY
+#define FIT_UNIT_TEST_JOB_LATENCY       500
+#endif
+
+/* Global Data **************************************************************/
+
+// Data on simulated storage.
+static uint8_t fit_test_storage[FIT_UNIT_TEST_CHUNKS*FIT_UNIT_TEST_CHUNK_SIZE];
+
+/* Functions ****************************************************************/
+
+/**
+ *
+ * fit_unit_test_usec
+ *
+ * This function will return monotonic time in microseconds.
+ *
+ */
+static uint32_t fit_unit_test_usec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint32_t)(ts.tv_sec*1000000UL + ts.tv_nsec/1000);
+}
+
+/**
+ *
+ * fit_unit_test_read_chunk
+ *
+ * This function will read one chunk from simulated storage.
+ *
+ * @param   chunk --> Index of chunk.
+ * @param   buf <-- Buffer for chunk data.
+ *
+ */
+static void fit_unit_test_read_chunk(uint16_t chunk, uint8_t *buf)
+{
+    usleep(FIT_UNIT_TEST_READ_LATENCY);
+    fit_memcpy(buf, fit_test_storage + chunk*FIT_UNIT_TEST_CHUNK_SIZE, FIT_UNIT_TEST_CHUNK_SIZE);
+}
+
+/**
+ *
+ * fit_unit_test_hash_chunks
+ *
+ * This function will hash data of simulated storage by Abreast DM jobs of passed in
+ * context provider, one update job per chunk and final job for last block. If
+ * overlap is TRUE, next chunk is read while job for previous one is pending.
+ *
+ * @param   ctx --> FIT core context with crypto provider.
+ * @param   overlap --> TRUE to read next chunk while job is pending.
+ * @param   hash <-- On return it will contain the hash value.
+ *
+ */
+static fit_status_t fit_unit_test_hash_chunks(fit_ctx_t *ctx, uint8_t overlap, uint8_t *hash)
+{
+    uint8_t buf[2][FIT_UNIT_TEST_CHUNK_SIZE];
+    fit_crypto_job_t job    = {0};
+    fit_status_t status     = FIT_STATUS_OK;
+    uint16_t chunk          = 0;
+    uint8_t *data           = NULL;
+
+    fit_memset(hash, 0xFF, ABREAST_DM_HASH_SIZE);
+    if (overlap == TRUE)
+        fit_unit_test_read_chunk(0, buf[0]);
+
+    for (chunk = 0; chunk < FIT_UNIT_TEST_CHUNKS && status == FIT_STATUS_OK; chunk++)
+    {
+        data = buf[chunk & 1];
+        if (overlap != TRUE)
+            fit_unit_test_read_chunk(chunk, data);
+
+        fit_memset((uint8_t *)&job, 0, sizeof(fit_crypto_job_t));
+        job.m_provider = ctx->m_crypto;
+        job.m_op = FIT_CRYPTO_OP_HASH_UPDATE;
+        job.m_alg = FIT_CRYPTO_HASH_ABREAST_DM;
+        job.m_input = data;
+        job.m_output = hash;
+        // Last block is hashed by final job.
+        job.m_length = FIT_UNIT_TEST_CHUNK_SIZE;
+        if (chunk == FIT_UNIT_TEST_CHUNKS - 1)
+            job.m_length -= ABREAST_DM_CIPHER_BLOCK_SIZE;
+        status = fit_crypto_submit(&job);
+
+        if (overlap == TRUE && chunk + 1 < FIT_UNIT_TEST_CHUNKS)
+            fit_unit_test_read_chunk(chunk + 1, buf[(chunk + 1) & 1]);
+        if (status == FIT_STATUS_OK)
+            status = fit_crypto_wait(&job);
+    }
+    if (status != FIT_STATUS_OK)
+        return status;
+
+    fit_memset((uint8_t *)&job, 0, sizeof(fit_crypto_job_t));
+    job.m_provider = ctx->m_crypto;
+    job.m_op = FIT_CRYPTO_OP_HASH_FINAL;
+    job.m_alg = FIT_CRYPTO_HASH_ABREAST_DM;
+    job.m_input = data + FIT_UNIT_TEST_CHUNK_SIZE - ABREAST_DM_CIPHER_BLOCK_SIZE;
+    job.m_length = ABREAST_DM_CIPHER_BLOCK_SIZE;
+    job.m_total = sizeof(fit_test_storage);
+    job.m_output = hash;
+    status = fit_crypto_submit(&job);
+    if (status == FIT_STATUS_OK)
+        status = fit_crypto_wait(&job);
+
+    return status;
+}
+
+/**
+ *
+ * fit_unit_test_crypto_overlap
+ *
+ * This function will hash simulated storage serially and with storage reads
+ * overlapped with provider jobs, check both hashes against software hash and
+ * return time of both runs.
+ *
+ * @param   serial_us <-- Time of serial run in microseconds.
+ * @param   overlap_us <-- Time of overlapped run in microseconds.
+ *
+ */
+fit_status_t fit_unit_test_crypto_overlap(uint32_t *serial_us, uint32_t *overlap_us)
+{
+    fit_crypto_pool_t pool;
+    fit_ctx_t ctx;
+    uint8_t expected[ABREAST_DM_HASH_SIZE]  = {0};
+    uint8_t hash[ABREAST_DM_HASH_SIZE]      = {0};
+    fit_pointer_t fitptr                    = {0};
+    fit_status_t status                     = FIT_STATUS_OK;
+    uint32_t start                          = 0;
+    uint32_t cntr                           = 0;
+
+    for (cntr = 0; cntr < sizeof(fit_test_storage); cntr++)
+        fit_test_storage[cntr] = (uint8_t)(cntr*13 + 5);
+
+    // Reference hash by software provider (no provider selected).
+    fitptr.read_byte = (fit_read_byte_callback_t)FIT_READ_BYTE_RAM;
+    fitptr.data = fit_test_storage;
+    fitptr.length = sizeof(fit_test_storage);
+    if (fit_get_AbreastDM_Hash(&fitptr, expected) != FIT_STATUS_OK)
+        return FIT_UNIT_TEST_FAILED;
+
+    if (fit_crypto_pool_init(&pool, 1, FIT_UNIT_TEST_JOB_LATENCY) != FIT_STATUS_OK)
+        return FIT_UNIT_TEST_FAILED;
+    fit_ctx_init(&ctx);
+    fit_ctx_set_crypto_provider(&ctx, &pool.m_provider);
+
+    start = fit_unit_test_usec();
+    status = fit_unit_test_hash_chunks(&ctx, FALSE, hash);
+    *serial_us = fit_unit_test_usec() - start;
+    if (status != FIT_STATUS_OK || fit_memcmp(hash, expected, ABREAST_DM_HASH_SIZE) != 0)
+    {
+        DBG(FIT_TRACE_ERROR, "[fit_unit_test_crypto_overlap]: serial hash failed, status %d\n", status);
+        status = FIT_UNIT_TEST_FAILED;
+    }
+    else
+    {
+        start = fit_unit_test_usec();
+        status = fit_unit_test_hash_chunks(&ctx, TRUE, hash);
+        *overlap_us = fit_unit_test_usec() - start;
+        if (status != FIT_STATUS_OK || fit_memcmp(hash, expected, ABREAST_DM_HASH_SIZE) != 0)
+        {
+            DBG(FIT_TRACE_ERROR, "[fit_unit_test_crypto_overlap]: overlapped hash failed, status %d\n", status);
+            status = FIT_UNIT_TEST_FAILED;
+        }
+        else
+        {
+            status = FIT_UNIT_TEST_PASSED;
+        }
+    }
+
+    fit_ctx_free(&ctx);
+    fit_crypto_pool_free(&pool);
+
+    return status;
+}
+
+#endif // #if defined(FIT_USE_UNIT_TESTS) && defined(FIT_USE_CRYPTO_PROVIDER) && defined(FIT_USE_CRYPTO_POOL)
@@ -0,0 +1,121 @@
+/****************************************************************************\
+**
+** test_licdb.c
+**
+** Defines test of packed license database (FIT_USE_LICENSE_DB). Licenses kept
+** next to each other in one buffer are appended to new database; empty and
+** truncated licenses must be rejected, even though license that follows them in
+** buffer is valid.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#if defined(FIT_USE_UNIT_TESTS) && defined(FIT_USE_LICENSE_DB)
+
+/* Required Includes ********************************************************/
+#include <stdlib.h>
+#include <unistd.h>
+#include "unittest/unit_test.h"
+#include "internal.h"
+#include "fit_debug.h"
+#include "fit_licdb.h"
+#include "mem_read.h"
+
+/* Constants ****************************************************************/
+
+// Licenses appended by test: empty, truncated by one byte and valid.
+#define FIT_UNIT_TEST_LICDB_LICENSES    3
+
+/* Functions ****************************************************************/
+
+/**
+ *
+ * fit_unit_test_licdb_append
+ *
+ * This function will put two copies of license passed in one after another into
+ * buffer and append empty license at start of second copy, first copy without its
+ * last byte and first copy to new database. Fails unless only the last one is
+ * added.
+ *
+ * @param   license --> License that can be parsed.
+ *
+ */
+fit_status_t fit_unit_test_licdb_append(fit_pointer_t *license)
+{
+    fit_pointer_t licenses[FIT_UNIT_TEST_LICDB_LICENSES];
+    fit_status_t results[FIT_UNIT_TEST_LICDB_LICENSES];
+    fit_licdb_t db;
+    fit_pointer_t stored        = {0};
+    fit_status_t status         = FIT_UNIT_TEST_PASSED;
+    char path[]                 = "/tmp/fit_unit_test_licdb.XXXXXX";
+    uint8_t *buf                = NULL;
+    uint64_t pos                = 0;
+    uint32_t found              = 0;
+    uint16_t cntr               = 0;
+    int fd                      = -1;
+
+    if (license->length < 2)
+        return FIT_UNIT_TEST_FAILED;
+    buf = (uint8_t *)malloc(2 * (size_t)license->length);
+    fd = mkstemp(path);
+    if (buf == NULL || fd < 0)
+    {
+        free(buf);
+        return FIT_UNIT_TEST_FAILED;
+    }
+    close(fd);
+    fit_memset((uint8_t *)results, 0, sizeof(results));
+    for (cntr = 0; cntr < license->length; cntr++)
+    {
+        buf[cntr] = read_byte(license->data + cntr, license->read_byte);
+        buf[license->length + cntr] = buf[cntr];
+    }
+
+    for (cntr = 0; cntr < FIT_UNIT_TEST_LICDB_LICENSES; cntr++)
+    {
+        licenses[cntr].read_byte = (fit_read_byte_callback_t)FIT_READ_BYTE_BOUNDED;
+        licenses[cntr].data = buf;
+        licenses[cntr].length = license->length;
+    }
+    licenses[0].data = buf + license->length;
+    licenses[0].length = 0;
+    licenses[1].length = license->length - 1;
+
+    if (fit_licdb_append(path, licenses, FIT_UNIT_TEST_LICDB_LICENSES, results) != FIT_STATUS_OK ||
+        results[0] != FIT_INVALID_V2C || results[1] != FIT_INVALID_V2C || results[2] != FIT_STATUS_OK)
+    {
+        DBG(FIT_TRACE_ERROR, "[fit_unit_test_licdb_append]: results %d %d %d\n",
+            results[0], results[1], results[2]);
+        status = FIT_UNIT_TEST_FAILED;
+    }
+    else if (fit_licdb_open(&db, path, FIT_LICDB_SCAN) != FIT_STATUS_OK)
+    {
+        status = FIT_UNIT_TEST_FAILED;
+    }
+    else
+    {
+        while (fit_licdb_next(&db, &pos, &stored, NULL) == FIT_STATUS_OK)
+        {
+            if (stored.length != license->length ||
+                fit_memcmp((uint8_t *)stored.data, buf, license->length) != 0)
+            {
+                status = FIT_UNIT_TEST_FAILED;
+            }
+            found++;
+        }
+        fit_licdb_close(&db);
+        if (found != 1)
+        {
+            DBG(FIT_TRACE_ERROR, "[fit_unit_test_licdb_append]: %ld licenses stored\n", found);
+            status = FIT_UNIT_TEST_FAILED;
+        }
+    }
+
+    unlink(path);
+    free(buf);
+
+    return status;
+}
+
+#endif // #if defined(FIT_USE_UNIT_TESTS) && defined(FIT_USE_LICENSE_DB)
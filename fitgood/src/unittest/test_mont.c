@@ -0,0 +1,198 @@
+/****************************************************************************\
+**
+** test_mont.c
+**
+** Defines test and benchmark of fixed size Montgomery arithmetic used by rsa
+** public operation with small public exponent (FIT_USE_RSA_SMALL_EXP). RSA-2048
+** public operations with public key of fit_pubkey_raw.h are done by mbedtls
+** (mbedtls_mpi_exp_mod), by portable kernel and by tuned kernel (FIT_USE_MONT_ASM,
+** if supported by processor). Results are compared and number of operations
+** per second is reported for each.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#if defined(FIT_USE_UNIT_TESTS) && defined(FIT_USE_RSA_SMALL_EXP)
+
+/* Required Includes ********************************************************/
+#include <time.h>
+#include "unittest/unit_test.h"
+#include "internal.h"
+#include "fit_debug.h"
+#include "fit_mont.h"
+#include "fit_pubkey_raw.h"
+
+#ifdef FIT_MONT_AVAILABLE
+
+/* Constants ****************************************************************/
+
+// Number of different inputs, and number of operations timed per implementation.
+#define FIT_UNIT_TEST_MONT_INPUTS       16
+#ifndef FIT_UNIT_TEST_MONT_OPS
+#define FIT_UNIT_TEST_MONT_OPS          2000
+#endif
+
+/* Global Data **************************************************************/
+
+// Inputs and results of mbedtls public operation.
+static uint8_t fit_test_input[FIT_UNIT_TEST_MONT_INPUTS][RSA_SIG_SIZE];
+static uint8_t fit_test_expected[FIT_UNIT_TEST_MONT_INPUTS][RSA_SIG_SIZE];
+
+/* Functions ****************************************************************/
+
+/**
+ *
+ * fit_unit_test_mont_usec
+ *
+ * This function will return monotonic time in microseconds.
+ *
+ */
+static uint32_t fit_unit_test_mont_usec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint32_t)(ts.tv_sec*1000000UL + ts.tv_nsec/1000);
+}
+
+/**
+ *
+ * fit_unit_test_mont_rate
+ *
+ * This function will convert time of FIT_UNIT_TEST_MONT_OPS operations to number
+ * of operations per second.
+ *
+ * @param   usec --> Time in microseconds.
+ *
+ */
+static uint32_t fit_unit_test_mont_rate(uint32_t usec)
+{
+    if (usec == 0)
+        usec = 1;
+
+    return (uint32_t)((uint64_t)FIT_UNIT_TEST_MONT_OPS * 1000000UL / usec);
+}
+
+/**
+ *
+ * fit_unit_test_mont_run
+ *
+ * This function will check results of fit_mont_exp_small with currently selected
+ * kernel against mbedtls results and return number of operations per second.
+ *
+ * @param   ctx --> Montgomery context of public key.
+ * @param   ops <-- Number of operations per second.
+ *
+ */
+static fit_status_t fit_unit_test_mont_run(const fit_mont_ctx_t *ctx, uint32_t *ops)
+{
+    uint8_t output[RSA_SIG_SIZE];
+    uint32_t start  = 0;
+    uint16_t cntr   = 0;
+
+    for (cntr = 0; cntr < FIT_UNIT_TEST_MONT_INPUTS; cntr++)
+    {
+        if (fit_mont_exp_small(ctx, fit_test_input[cntr], output) != FIT_STATUS_OK ||
+            fit_memcmp(output, fit_test_expected[cntr], RSA_SIG_SIZE) != 0)
+        {
+            DBG(FIT_TRACE_ERROR, "[fit_unit_test_mont_run]: wrong result for input %d\n", cntr);
+            return FIT_UNIT_TEST_FAILED;
+        }
+    }
+
+    start = fit_unit_test_mont_usec();
+    for (cntr = 0; cntr < FIT_UNIT_TEST_MONT_OPS; cntr++)
+        fit_mont_exp_small(ctx, fit_test_input[cntr % FIT_UNIT_TEST_MONT_INPUTS], output);
+    *ops = fit_unit_test_mont_rate(fit_unit_test_mont_usec() - start);
+
+    return FIT_UNIT_TEST_PASSED;
+}
+
+/**
+ *
+ * fit_unit_test_mont_bench
+ *
+ * This function will do RSA-2048 public operations by mbedtls, portable kernel and
+ * tuned kernel, check that results are same and return number of operations per
+ * second of each. Number for tuned kernel is 0 if it is not built in or not
+ * supported by processor.
+ *
+ * @param   mpi_ops <-- Operations per second of mbedtls_mpi_exp_mod.
+ * @param   portable_ops <-- Operations per second of portable kernel.
+ * @param   asm_ops <-- Operations per second of tuned kernel.
+ *
+ */
+fit_status_t fit_unit_test_mont_bench(uint32_t *mpi_ops, uint32_t *portable_ops, uint32_t *asm_ops)
+{
+    fit_mont_ctx_t ctx;
+    mbedtls_mpi N, E, RR, X, Y;
+    fit_status_t status = FIT_UNIT_TEST_PASSED;
+    uint32_t seed       = 0x4D4F4E54;
+    uint32_t start      = 0;
+    uint16_t cntr       = 0;
+    uint16_t i          = 0;
+
+    *mpi_ops = 0;
+    *portable_ops = 0;
+    *asm_ops = 0;
+    mbedtls_mpi_init(&N);
+    mbedtls_mpi_init(&E);
+    mbedtls_mpi_init(&RR);
+    mbedtls_mpi_init(&X);
+    mbedtls_mpi_init(&Y);
+
+    if (mbedtls_mpi_read_binary(&N, fit_pubkey_raw.m_n, RSA_SIG_SIZE) != 0 ||
+        mbedtls_mpi_read_binary(&E, fit_pubkey_raw.m_e, FIT_RSA_RAW_E_SIZE) != 0 ||
+        fit_mont_setup(&ctx, &N, &E, NULL, 0) != FIT_STATUS_OK)
+    {
+        status = FIT_UNIT_TEST_FAILED;
+        goto bail;
+    }
+
+    // Pseudo random inputs less than N (top byte of N is not zero).
+    for (cntr = 0; cntr < FIT_UNIT_TEST_MONT_INPUTS && status == FIT_UNIT_TEST_PASSED; cntr++)
+    {
+        for (i = 0; i < RSA_SIG_SIZE; i++)
+        {
+            seed = seed * 1103515245UL + 12345UL;
+            fit_test_input[cntr][i] = (uint8_t)(seed >> 16);
+        }
+        fit_test_input[cntr][0] = 0;
+        if (mbedtls_mpi_read_binary(&X, fit_test_input[cntr], RSA_SIG_SIZE) != 0 ||
+            mbedtls_mpi_exp_mod(&Y, &X, &E, &N, &RR) != 0 ||
+            mbedtls_mpi_write_binary(&Y, fit_test_expected[cntr], RSA_SIG_SIZE) != 0)
+        {
+            status = FIT_UNIT_TEST_FAILED;
+        }
+    }
+    if (status != FIT_UNIT_TEST_PASSED)
+        goto bail;
+
+    start = fit_unit_test_mont_usec();
+    for (cntr = 0; cntr < FIT_UNIT_TEST_MONT_OPS; cntr++)
+    {
+        mbedtls_mpi_read_binary(&X, fit_test_input[cntr % FIT_UNIT_TEST_MONT_INPUTS], RSA_SIG_SIZE);
+        mbedtls_mpi_exp_mod(&Y, &X, &E, &N, &RR);
+    }
+    *mpi_ops = fit_unit_test_mont_rate(fit_unit_test_mont_usec() - start);
+
+    fit_mont_use_asm(FALSE);
+    status = fit_unit_test_mont_run(&ctx, portable_ops);
+    if (fit_mont_use_asm(TRUE) == TRUE && status == FIT_UNIT_TEST_PASSED)
+        status = fit_unit_test_mont_run(&ctx, asm_ops);
+
+bail:
+    mbedtls_mpi_free(&N);
+    mbedtls_mpi_free(&E);
+    mbedtls_mpi_free(&RR);
+    mbedtls_mpi_free(&X);
+    mbedtls_mpi_free(&Y);
+
+    return status;
+}
+
+#endif // #ifdef FIT_MONT_AVAILABLE
+
+#endif // #if defined(FIT_USE_UNIT_TESTS) && defined(FIT_USE_RSA_SMALL_EXP)
@@ -0,0 +1,215 @@
+/****************************************************************************\
+**
+** test_shared_cache.c
+**
+** Defines multithreaded throughput benchmark of shared license validation cache
+** (FIT_USE_SHARED_CACHE). Worker threads consume the same license, once through
+** default context serialized by mutex (single global cache) and once through own
+** context per thread attached to one shared cache. Number of consumes per second
+** of both runs and number of rsa signature checks with shared cache are reported.
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+#if defined(FIT_USE_UNIT_TESTS) && defined(FIT_USE_SHARED_CACHE)
+
+/* Required Includes ********************************************************/
+#include <time.h>
+#include <pthread.h>
+#include "unittest/unit_test.h"
+#include "internal.h"
+#include "fit_debug.h"
+#include "fit_ctx.h"
+
+/* Constants ****************************************************************/
+
+// Number of consumes done by every thread.
+#ifndef FIT_UNIT_TEST_CONSUMES
+#define FIT_UNIT_TEST_CONSUMES          2000
+#endif
+
+/* Types ********************************************************************/
+
+// State of one worker thread.
+typedef struct fit_unit_test_worker {
+    pthread_t           m_thread;
+    fit_ctx_t           m_ctx;
+    // TRUE to consume through default context under mutex.
+    uint8_t             m_locked;
+    // Number of failed consumes.
+    uint32_t            m_failures;
+} fit_unit_test_worker_t;
+
+/* Global Data **************************************************************/
+
+// License and key consumed by worker threads.
+static fit_pointer_t *fit_test_license  = NULL;
+static fit_pointer_t *fit_test_key      = NULL;
+
+// Mutex serializing use of default context.
+static pthread_mutex_t fit_test_lock    = PTHREAD_MUTEX_INITIALIZER;
+
+// Shared cache of per thread contexts.
+static fit_shared_cache_t fit_test_shared;
+
+/* Functions ****************************************************************/
+
+/**
+ *
+ * fit_unit_test_shared_usec
+ *
+ * This function will return monotonic time in microseconds.
+ *
+ */
+static uint32_t fit_unit_test_shared_usec(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint32_t)(ts.tv_sec*1000000UL + ts.tv_nsec/1000);
+}
+
+/**
+ *
+ * fit_unit_test_shared_worker
+ *
+ * Worker thread. Consumes license FIT_UNIT_TEST_CONSUMES times.
+ *
+ * @param   arg --> Pointer to worker state.
+ *
+ */
+static void *fit_unit_test_shared_worker(void *arg)
+{
+    fit_unit_test_worker_t *worker  = (fit_unit_test_worker_t *)arg;
+    fit_status_t status             = FIT_STATUS_OK;
+    uint32_t cntr                   = 0;
+
+    for (cntr = 0; cntr < FIT_UNIT_TEST_CONSUMES; cntr++)
+    {
+        if (worker->m_locked == TRUE)
+        {
+            pthread_mutex_lock(&fit_test_lock);
+            status = fit_licenf_consume_license(fit_test_license, 1, NULL, fit_test_key);
+            pthread_mutex_unlock(&fit_test_lock);
+        }
+        else
+        {
+            status = fit_licenf_consume_license_ctx(&worker->m_ctx, fit_test_license, 1, NULL, fit_test_key);
+        }
+        if (status != FIT_STATUS_OK)
+            worker->m_failures++;
+    }
+
+    return NULL;
+}
+
+/**
+ *
+ * fit_unit_test_shared_run
+ *
+ * This function will run worker threads and return number of consumes per second
+ * and number of rsa signature checks done by per thread contexts.
+ *
+ * @param   threads --> Number of worker threads.
+ * @param   locked --> TRUE to consume through default context under mutex.
+ * @param   rate <-- Number of consumes per second.
+ * @param   rsa_checks <-- Number of rsa signature checks.
+ *
+ */
+static fit_status_t fit_unit_test_shared_run(uint8_t threads,
+                                             uint8_t locked,
+                                             uint32_t *rate,
+                                             uint32_t *rsa_checks)
+{
+    fit_unit_test_worker_t workers[FIT_UNIT_TEST_MAX_THREADS];
+    fit_status_t status     = FIT_UNIT_TEST_PASSED;
+    uint32_t start          = 0;
+    uint32_t usec           = 0;
+    uint8_t started         = 0;
+    uint8_t cntr            = 0;
+
+    // Both runs start with empty caches.
+    *rsa_checks = 0;
+    fit_shared_cache_init(&fit_test_shared);
+    fit_ctx_free(fit_ctx_default());
+
+    start = fit_unit_test_shared_usec();
+    for (started = 0; started < threads; started++)
+    {
+        fit_memset((uint8_t *)&workers[started], 0, sizeof(fit_unit_test_worker_t));
+        workers[started].m_locked = locked;
+        fit_ctx_init(&workers[started].m_ctx);
+        fit_ctx_set_shared_cache(&workers[started].m_ctx, &fit_test_shared);
+        if (pthread_create(&workers[started].m_thread, NULL,
+                           fit_unit_test_shared_worker, &workers[started]) != 0)
+        {
+            status = FIT_UNIT_TEST_FAILED;
+            break;
+        }
+    }
+    for (cntr = 0; cntr < started; cntr++)
+    {
+        pthread_join(workers[cntr].m_thread, NULL);
+        if (workers[cntr].m_failures != 0)
+        {
+            DBG(FIT_TRACE_ERROR, "[fit_unit_test_shared_run]: %ld consumes failed\n", workers[cntr].m_failures);
+            status = FIT_UNIT_TEST_FAILED;
+        }
+        *rsa_checks += workers[cntr].m_ctx.m_cache.m_stats.m_rsa_checks;
+        fit_ctx_free(&workers[cntr].m_ctx);
+    }
+    usec = fit_unit_test_shared_usec() - start;
+    if (usec == 0)
+        usec = 1;
+    *rate = (uint32_t)((uint64_t)threads * FIT_UNIT_TEST_CONSUMES * 1000000UL / usec);
+
+    return status;
+}
+
+/**
+ *
+ * fit_unit_test_shared_cache_bench
+ *
+ * This function will consume license passed in by number of threads, through
+ * default context under mutex and through per thread contexts attached to shared
+ * cache, and return throughput of both. Fails if any consume fails, or if threads
+ * with shared cache did more than one rsa signature check each.
+ *
+ * @param   license --> License to be consumed (feature 1).
+ * @param   key --> Public key of the license.
+ * @param   threads --> Number of threads (1 to FIT_UNIT_TEST_MAX_THREADS).
+ * @param   locked_rate <-- Consumes per second through default context.
+ * @param   shared_rate <-- Consumes per second through shared cache.
+ * @param   shared_rsa <-- Number of rsa signature checks with shared cache.
+ *
+ */
+fit_status_t fit_unit_test_shared_cache_bench(fit_pointer_t *license,
+                                              fit_pointer_t *key,
+                                              uint8_t threads,
+                                              uint32_t *locked_rate,
+                                              uint32_t *shared_rate,
+                                              uint32_t *shared_rsa)
+{
+    fit_status_t status = FIT_UNIT_TEST_PASSED;
+    uint32_t rsa_checks = 0;
+
+    if (threads == 0 || threads > FIT_UNIT_TEST_MAX_THREADS)
+        return FIT_UNIT_TEST_FAILED;
+    fit_test_license = license;
+    fit_test_key = key;
+
+    status = fit_unit_test_shared_run(threads, TRUE, locked_rate, &rsa_checks);
+    if (status == FIT_UNIT_TEST_PASSED)
+        status = fit_unit_test_shared_run(threads, FALSE, shared_rate, shared_rsa);
+    if (status == FIT_UNIT_TEST_PASSED && *shared_rsa > threads)
+    {
+        DBG(FIT_TRACE_ERROR, "[fit_unit_test_shared_cache_bench]: %ld rsa checks\n", *shared_rsa);
+        status = FIT_UNIT_TEST_FAILED;
+    }
+
+    return status;
+}
+
+#endif // #if defined(FIT_USE_UNIT_TESTS) && defined(FIT_USE_SHARED_CACHE)
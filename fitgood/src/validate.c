@@ -29,22 +29,229 @@
  *                  fit_pointer_t will describe, from what type of
  *                  memory to read the key through function pointer.
  *
+ * Uses default context (see fit_ctx_default).
+ *
  */
 fit_status_t fit_licenf_validate_license(fit_pointer_t *license,
                                          fit_pointer_t *key)
+{
+    return fit_licenf_validate_license_ctx(fit_ctx_default(), license, key);
+}
+
+/**
+ *
+ * fit_licenf_validate_license_ctx
+ *
+ * Same as fit_licenf_validate_license; license validation cache and rsa key of
+ * passed in context are used.
+ *
+ * @param   ctx <--> FIT core context initialized by fit_ctx_init.
+ * @param   license --> Start address of the license of type fit_pointer_t.
+ * @param   key --> Start address of the key of type fit_pointer_t.
+ *
+ */
+fit_status_t fit_licenf_validate_license_ctx(fit_ctx_t *ctx,
+                                             fit_pointer_t *license,
+                                             fit_pointer_t *key)
 {
     fit_status_t status = FIT_STATUS_OK;
 
     DBG(FIT_TRACE_INFO, "[fit_validate_license]: pdata=0x%p \n", license->data);
 
+    if (ctx == NULL)
+        return FIT_INVALID_PARAM;
+
     if (license->read_byte == NULL)
         return FIT_INVALID_PARAM_1;
 
     if (key->read_byte == NULL)
         return FIT_INVALID_PARAM_2;
 
-    status = fit_verify_license(license, key, FALSE);
+    // Key is kept in context, so its bytes are not hashed again for next validation
+    // against same key.
+    status = fit_verify_license(ctx, license, fit_ctx_get_key(ctx, key), FALSE);
+    fit_ctx_release_key(ctx);
+
+    return status;
+}
+
+
+/**
+ *
+ * fit_licenf_prepare_key
+ *
+ * This function will parse the rsa public key once, so it can be used to validate
+ * any number of licenses by fit_licenf_validate_licenses without parsing it again.
+ * Key bytes are hashed here as well, so validations only read the prepared handle.
+ * Caller should call fit_licenf_release_key once prepared key is no longer required.
+ *
+ * @param   handle <-- Caller owned storage that will contain parsed rsa public key.
+ * @param   key --> Start address of the key of type fit_pointer_t. Key data should
+ *                  remain available till handle is released.
+ *
+ */
+fit_status_t fit_licenf_prepare_key(fit_rsa_key_handle_t *handle,
+                                    fit_pointer_t *key)
+{
+    fit_status_t status                 = FIT_STATUS_OK;
+    uint8_t keyhash[FIT_DM_HASH_SIZE]   = {0};
+
+    if (handle == NULL)
+        return FIT_INVALID_PARAM_1;
+
+    if (key == NULL || key->read_byte == NULL)
+        return FIT_INVALID_PARAM_2;
+
+    fit_rsa_key_init(FIT_RSA_KEY(handle), key);
+    status = fit_rsa_key_prepare(FIT_RSA_KEY(handle));
+    if (status == FIT_STATUS_OK)
+        status = fit_rsa_key_hash(FIT_RSA_KEY(handle), keyhash);
+
+    DBG(FIT_TRACE_INFO, "[fit_licenf_prepare_key]: status=%d \n", status);
+
+    return status;
+}
+
+/**
+ *
+ * fit_licenf_release_key
+ *
+ * This function will release memory allocated by fit_licenf_prepare_key.
+ *
+ * @param   handle <--> Prepared key handle.
+ *
+ */
+void fit_licenf_release_key(fit_rsa_key_handle_t *handle)
+{
+    if (handle != NULL)
+        fit_rsa_key_free(FIT_RSA_KEY(handle));
+}
+
+/**
+ *
+ * fit_licenf_validate_licenses
+ *
+ * This function is used to validate number of licenses against same rsa public key.
+ * Each license is validated as per fit_licenf_validate_license, but key is parsed
+ * only once for all of them. Returns FIT_STATUS_OK if all licenses are valid, else
+ * status of first license that failed validation.
+ *
+ * @param   licenses --> Array of licenses of type fit_pointer_t.
+ * @param   count --> Number of licenses in above array.
+ * @param   handle --> Key prepared by fit_licenf_prepare_key.
+ * @param   results <-- Array of count elements that will contain validation status
+ *                      of each license.
+ *
+ * Uses default context (see fit_ctx_default).
+ *
+ */
+fit_status_t fit_licenf_validate_licenses(fit_pointer_t *licenses,
+                                          uint16_t count,
+                                          fit_rsa_key_handle_t *handle,
+                                          fit_status_t *results)
+{
+    return fit_licenf_validate_licenses_ctx(fit_ctx_default(), licenses, count,
+        handle, results);
+}
+
+/**
+ *
+ * fit_licenf_validate_licenses_ctx
+ *
+ * Same as fit_licenf_validate_licenses, using license validation cache of passed in
+ * context. Prepared key handle is only read, so same handle can be shared by tasks
+ * validating with different contexts.
+ *
+ * @param   ctx <--> FIT core context initialized by fit_ctx_init.
+ * @param   licenses --> Array of licenses of type fit_pointer_t.
+ * @param   count --> Number of licenses in above array.
+ * @param   handle --> Key prepared by fit_licenf_prepare_key.
+ * @param   results <-- Array of count elements that will contain validation status
+ *                      of each license.
+ *
+ */
+fit_status_t fit_licenf_validate_licenses_ctx(fit_ctx_t *ctx,
+                                              fit_pointer_t *licenses,
+                                              uint16_t count,
+                                              fit_rsa_key_handle_t *handle,
+                                              fit_status_t *results)
+{
+    fit_status_t status = FIT_STATUS_OK;
+    uint16_t cntr       = 0;
+
+    DBG(FIT_TRACE_INFO, "[fit_licenf_validate_licenses]: count=%hd \n", count);
+
+    if (ctx == NULL)
+        return FIT_INVALID_PARAM;
+
+    if (licenses == NULL)
+        return FIT_INVALID_PARAM_1;
+
+    if (handle == NULL || FIT_RSA_KEY(handle)->m_key.read_byte == NULL)
+        return FIT_INVALID_PARAM_3;
+
+    if (results == NULL)
+        return FIT_INVALID_PARAM_4;
+
+    for (cntr = 0; cntr < count; cntr++)
+    {
+        if (licenses[cntr].read_byte == NULL)
+            results[cntr] = FIT_INVALID_PARAM_1;
+        else
+            results[cntr] = fit_verify_license(ctx, &licenses[cntr], FIT_RSA_KEY(handle), FALSE);
+
+        if (status == FIT_STATUS_OK && results[cntr] != FIT_STATUS_OK)
+            status = results[cntr];
+    }
 
     return status;
 }
 
+/**
+ *
+ * fit_licenf_get_cache_stats
+ *
+ * This function will get the statistics of license validation cache i.e. how many
+ * validations needed rsa signature check and how many were answered by negative
+ * cache (license that already failed validation).
+ *
+ * @param   stats <-- On return it will contain cache statistics.
+ * @param   reset --> If TRUE then statistics are reset after they are returned.
+ *
+ * Returns statistics of default context (see fit_ctx_default).
+ *
+ */
+fit_status_t fit_licenf_get_cache_stats(fit_cache_stats_t *stats,
+                                        uint8_t reset)
+{
+    return fit_licenf_get_cache_stats_ctx(fit_ctx_default(), stats, reset);
+}
+
+/**
+ *
+ * fit_licenf_get_cache_stats_ctx
+ *
+ * Same as fit_licenf_get_cache_stats, for license validation cache of passed in
+ * context.
+ *
+ * @param   ctx <--> FIT core context.
+ * @param   stats <-- On return it will contain cache statistics.
+ * @param   reset --> If TRUE then statistics are reset after they are returned.
+ *
+ */
+fit_status_t fit_licenf_get_cache_stats_ctx(fit_ctx_t *ctx,
+                                            fit_cache_stats_t *stats,
+                                            uint8_t reset)
+{
+    if (ctx == NULL)
+        return FIT_INVALID_PARAM;
+
+    if (stats == NULL)
+        return FIT_INVALID_PARAM_1;
+
+    fit_memcpy((uint8_t *)stats, (uint8_t *)&ctx->m_cache.m_stats, sizeof(fit_cache_stats_t));
+    if (reset == TRUE)
+        fit_memset((uint8_t *)&ctx->m_cache.m_stats, 0, sizeof(fit_cache_stats_t));
+
+    return FIT_STATUS_OK;
+}
@@ -0,0 +1,667 @@
+/****************************************************************************\
+**
+** fit_batch_validate.c
+**
+** Host tool that validates issued licenses (V2C binaries) against vendor rsa
+** public key, e.g. after key rotation audit. Licenses are validated by pool of
+** worker threads (see fit_batch_validate); one line with validation status is
+** printed per license, followed by summary with throughput (licenses/sec).
+**
+** Licenses are read either from directory (every regular file is one license) or
+** from stream of records, each record being 4 byte little endian length followed
+** by license binary. Licenses are processed in blocks of FIT_BATCH_TOOL_BLOCK, so
+** memory use does not depend on number of licenses.
+**
+** If built with FIT_USE_LICENSE_DB, licenses can also be read from packed license
+** database (see fit_licdb.h). Database is mapped and scanned in file order; licenses
+** are validated in place, without copying, and named by UID and container ID.
+**
+** Licenses of block are kept in one buffer (or database mapping) and read by
+** FIT_READ_BYTE_BOUNDED, which workers bound to license being validated, so
+** malformed (e.g. truncated) license can not make parser read outside of it. Empty
+** license reports FIT_INVALID_V2C.
+**
+** Node locked licenses report FIT_NODE_LOCKING_NOT_SUPP once their signature is
+** verified, as there is no device to check them against.
+**
+** If built with FIT_USE_MULTI_BUFFER_HASH (add -DFIT_USE_AESNI for interleaved
+** lanes), -b measures hashing of every block both one license at a time and by
+** multi-buffer hash engine, and prints time per license and speedup.
+**
+** Build (from fitgood directory):
+**   gcc -O2 -DFIT_USE_BATCH_VALIDATE -pthread -I inc -I mbedtls-2.2.1/include \
+**       tools/fit_batch_validate.c src/<all sources> \
+**       mbedtls-2.2.1/library/<all sources> -o fit_batch_validate
+**
+** Usage:
+**   fit_batch_validate [-t threads] [-q] [-b] <public key PEM file>
+**                      <license dir | license database | ->
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+/* Required Includes ********************************************************/
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "fit_api.h"
+#include "fit_batch.h"
+#include "fit_debug.h"
+#include "mem_read.h"
+#ifdef FIT_USE_MULTI_BUFFER_HASH
+#include "fit_mbhash.h"
+#include "abreast_dm.h"
+#include "dm_hash.h"
+#endif
+#ifdef FIT_USE_LICENSE_DB
+#include "fit_licdb.h"
+#endif
+
+/* Constants ****************************************************************/
+
+// Number of licenses validated by one fit_batch_validate call.
+#define FIT_BATCH_TOOL_BLOCK        16384
+
+// Maximum size of public key file.
+#define FIT_BATCH_TOOL_MAX_KEY      4096
+
+// Input argument in usage message.
+#ifdef FIT_USE_LICENSE_DB
+#define FIT_BATCH_TOOL_INPUT        "<license dir | license database | ->"
+#else
+#define FIT_BATCH_TOOL_INPUT        "<license dir | ->"
+#endif
+
+/* Types ********************************************************************/
+
+// Block of licenses read from input.
+typedef struct fit_batch_block {
+    uint32_t        m_count;
+    // Data of all licenses of block.
+    uint8_t         *m_data;
+    size_t          m_size;
+    size_t          m_capacity;
+    fit_pointer_t   m_licenses[FIT_BATCH_TOOL_BLOCK];
+    fit_status_t    m_results[FIT_BATCH_TOOL_BLOCK];
+    char            *m_names[FIT_BATCH_TOOL_BLOCK];
+} fit_batch_block_t;
+
+// Input and totals of the run.
+typedef struct fit_batch_run {
+    // Directory entries (sorted) or NULL for stream input.
+    char            **m_files;
+    uint32_t        m_nfiles;
+    uint32_t        m_pos;
+    const char      *m_dir;
+    FILE            *m_stream;
+#ifdef FIT_USE_LICENSE_DB
+    // Mapped database (m_map is NULL for other input) and position of scan.
+    fit_licdb_t     m_db;
+    uint64_t        m_dbpos;
+#endif
+    // Totals.
+    uint32_t        m_total;
+    uint32_t        m_valid;
+    uint32_t        m_unreadable;
+    uint32_t        m_steals;
+    double          m_seconds;
+    // Most worker threads used by a block (fewer than requested for small blocks).
+    uint16_t        m_threads;
+#ifdef FIT_USE_MULTI_BUFFER_HASH
+    // Hashing benchmark (-b): licenses hashed, time of one at a time and of
+    // multi-buffer hashing, and number of licenses whose hashes differ.
+    int             m_bench;
+    uint32_t        m_hashed;
+    double          m_single;
+    double          m_multi;
+    uint32_t        m_mismatch;
+#endif
+} fit_batch_run_t;
+
+/* Functions ****************************************************************/
+
+// Hardware dependent functions used by FIT core and bundled mbedtls on target.
+void UARTprintf(const char *pcString, ...)
+{
+    va_list args;
+
+    va_start(args, pcString);
+    vfprintf(stderr, pcString, args);
+    va_end(args);
+}
+
+void fit_uart_putc(unsigned char data)
+{
+    fputc(data, stderr);
+}
+
+/**
+ *
+ * read_file
+ *
+ * This function will read whole file into newly allocated buffer. One zero byte
+ * is appended (PEM key is parsed as string). Returns NULL on error.
+ *
+ * @param   path --> File path.
+ * @param   size <-- On return it will contain file size.
+ *
+ */
+static uint8_t *read_file(const char *path, size_t *size)
+{
+    FILE *in        = fopen(path, "rb");
+    uint8_t *data   = NULL;
+    long length     = 0;
+
+    if (in == NULL)
+        return NULL;
+    if (fseek(in, 0, SEEK_END) == 0 && (length = ftell(in)) >= 0 &&
+        fseek(in, 0, SEEK_SET) == 0)
+    {
+        data = (uint8_t *)calloc(1, (size_t)length + 1);
+        if (data != NULL && fread(data, 1, (size_t)length, in) != (size_t)length)
+        {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(in);
+
+    *size = (size_t)length;
+    return data;
+}
+
+/**
+ *
+ * add_to_block
+ *
+ * This function will move license data read from input into data buffer of block.
+ * License offset is kept in place of its address till whole block is read, as
+ * buffer may move. Returns 0 on success.
+ *
+ * @param   block <--> Block.
+ * @param   license <--> License read by read_license.
+ *
+ */
+static int add_to_block(fit_batch_block_t *block, fit_pointer_t *license)
+{
+    uint8_t *data = NULL;
+
+    if (block->m_size + license->length > block->m_capacity)
+    {
+        size_t capacity = block->m_capacity ? block->m_capacity * 2 : 0x100000;
+
+        while (capacity < block->m_size + license->length)
+            capacity *= 2;
+        data = (uint8_t *)realloc(block->m_data, capacity);
+        if (data == NULL)
+            return -1;
+        block->m_data = data;
+        block->m_capacity = capacity;
+    }
+
+    memcpy(block->m_data + block->m_size, license->data, license->length);
+    free(license->data);
+    license->data = (uint8_t *)(uintptr_t)block->m_size;
+    license->read_byte = (fit_read_byte_callback_t)FIT_READ_BYTE_BOUNDED;
+    block->m_size += license->length;
+
+    return 0;
+}
+
+static int compare_names(const void *a, const void *b)
+{
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+/**
+ *
+ * list_dir
+ *
+ * This function will list regular files of directory, sorted by name, so output
+ * order does not depend on file system. Returns 0 on success.
+ *
+ * @param   run <--> Run; m_files and m_nfiles are set on return.
+ * @param   dir --> Directory path.
+ *
+ */
+static int list_dir(fit_batch_run_t *run, const char *dir)
+{
+    DIR *d                  = opendir(dir);
+    struct dirent *entry    = NULL;
+    struct stat st;
+    char path[4096];
+    uint32_t capacity       = 0;
+    char **files            = NULL;
+
+    if (d == NULL)
+        return -1;
+
+    while ((entry = readdir(d)) != NULL)
+    {
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        if (stat(path, &st) != 0 || !S_ISREG(st.st_mode))
+            continue;
+        if (run->m_nfiles == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 1024;
+            files = (char **)realloc(run->m_files, capacity * sizeof(char *));
+            if (files == NULL)
+                break;
+            run->m_files = files;
+        }
+        run->m_files[run->m_nfiles++] = strdup(entry->d_name);
+    }
+    closedir(d);
+
+    qsort(run->m_files, run->m_nfiles, sizeof(char *), compare_names);
+    run->m_dir = dir;
+
+    return 0;
+}
+
+/**
+ *
+ * read_license
+ *
+ * This function will read next license from directory, stream or database. Returns
+ * 1 if license was read, 0 at end of input, -1 if license could not be read (name
+ * is still set).
+ *
+ * @param   run <--> Run.
+ * @param   license <-- On return it will describe license data (RAM, or database
+ *                      mapping read by FIT_READ_BYTE_BOUNDED).
+ * @param   name <-- On return it will contain license name (file name, record
+ *                   number or UID/container ID); caller frees it unless input is
+ *                   directory.
+ *
+ */
+static int read_license(fit_batch_run_t *run, fit_pointer_t *license, char **name)
+{
+    char path[4096];
+    uint8_t hdr[4];
+    uint8_t *data   = NULL;
+    size_t size     = 0;
+
+#ifdef FIT_USE_LICENSE_DB
+    if (run->m_db.m_map != NULL)
+    {
+        const fit_licdb_entry_t *entry  = NULL;
+        fit_status_t status             = FIT_STATUS_OK;
+        uint32_t cntr                   = 0;
+
+        status = fit_licdb_next(&run->m_db, &run->m_dbpos, license, &entry);
+        if (status != FIT_STATUS_OK)
+        {
+            if (status != FIT_LICDB_NOT_FOUND)
+                fprintf(stderr, "license database is corrupt: %d %s\n", status,
+                    fit_get_error_str(status));
+            return 0;
+        }
+        for (cntr = 0; cntr < FIT_UID_LEN; cntr++)
+            snprintf(path + 2 * cntr, 3, "%02X", entry->m_uid[cntr]);
+        snprintf(path + 2 * FIT_UID_LEN, sizeof(path) - 2 * FIT_UID_LEN, "/%lu",
+            (unsigned long)entry->m_container_id);
+        *name = strdup(path);
+        license->read_byte = (fit_read_byte_callback_t)FIT_READ_BYTE_BOUNDED;
+        run->m_total++;
+
+        return 1;
+    }
+#endif // #ifdef FIT_USE_LICENSE_DB
+
+    if (run->m_stream != NULL)
+    {
+        if (fread(hdr, 1, sizeof(hdr), run->m_stream) != sizeof(hdr))
+            return 0;
+        size = (size_t)hdr[0] | ((size_t)hdr[1] << 8) | ((size_t)hdr[2] << 16) |
+            ((size_t)hdr[3] << 24);
+        snprintf(path, sizeof(path), "#%lu", (unsigned long)run->m_total + 1);
+        *name = strdup(path);
+        data = (size <= 0xFFFF) ? (uint8_t *)malloc(size + 1) : NULL;
+        if (data != NULL && fread(data, 1, size, run->m_stream) != size)
+        {
+            free(data);
+            free(*name);
+            return 0;
+        }
+        // Skip records that can not be validated (stream need not be seekable).
+        while (data == NULL && size > 0)
+        {
+            size_t chunk = (size < sizeof(path)) ? size : sizeof(path);
+
+            if (fread(path, 1, chunk, run->m_stream) != chunk)
+            {
+                free(*name);
+                return 0;
+            }
+            size -= chunk;
+        }
+    }
+    else
+    {
+        if (run->m_pos == run->m_nfiles)
+            return 0;
+        *name = run->m_files[run->m_pos++];
+        snprintf(path, sizeof(path), "%s/%s", run->m_dir, *name);
+        data = read_file(path, &size);
+        if (data != NULL && size > 0xFFFF)
+        {
+            free(data);
+            data = NULL;
+        }
+    }
+
+    run->m_total++;
+    if (data == NULL)
+        return -1;
+
+    license->data = data;
+    license->length = (uint16_t)size;
+    license->read_byte = (fit_read_byte_callback_t)FIT_READ_BYTE_RAM;
+
+    return 1;
+}
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+#ifdef FIT_USE_MULTI_BUFFER_HASH
+/**
+ *
+ * bench_hashing
+ *
+ * This function will hash licenses of block (parts hashed during validation, see
+ * fit_mb_hash_licenses) one at a time and by multi-buffer hash engine, and add
+ * times to totals of run. Reads are bounded to block (parts lie within their
+ * license). Returns 0 on success.
+ *
+ * @param   run <--> Run.
+ * @param   block --> Block of licenses.
+ *
+ */
+static int bench_hashing(fit_batch_run_t *run, fit_batch_block_t *block)
+{
+    fit_mb_license_hashes_t *hashes = NULL;
+    fit_pointer_t *msgs             = NULL;
+    uint8_t *multi                  = NULL;
+    uint8_t *single                 = NULL;
+    size_t size                     = (size_t)block->m_count * (FIT_MB_HASH_SIZE + FIT_DM_HASH_SIZE);
+    uint32_t count                  = block->m_count;
+    uint32_t cntr                   = 0;
+    double start                    = 0;
+    int ret                         = -1;
+
+    if (count > 0)
+        fit_read_set_bounds(block->m_licenses[0].data, (uint32_t)(block->m_licenses[count - 1].data +
+            block->m_licenses[count - 1].length - block->m_licenses[0].data));
+
+    // Abreast DM hashes of signed parts first, then davies meyer hashes of licenses.
+    hashes = (fit_mb_license_hashes_t *)calloc(count + 1, sizeof(fit_mb_license_hashes_t));
+    msgs = (fit_pointer_t *)calloc(2 * count + 1, sizeof(fit_pointer_t));
+    multi = (uint8_t *)calloc(size + 1, 1);
+    single = (uint8_t *)calloc(size + 1, 1);
+    if (hashes == NULL || msgs == NULL || multi == NULL || single == NULL ||
+        fit_mb_hash_licenses(block->m_licenses, count, hashes) != FIT_STATUS_OK)
+    {
+        goto bail;
+    }
+    for (cntr = 0; cntr < count; cntr++)
+    {
+        msgs[cntr] = hashes[cntr].m_signed;
+        msgs[count + cntr] = hashes[cntr].m_license;
+    }
+
+    start = now();
+    for (cntr = 0; cntr < count; cntr++)
+    {
+        if (msgs[cntr].read_byte != NULL)
+            fit_get_AbreastDM_Hash(&msgs[cntr], single + cntr * FIT_MB_HASH_SIZE);
+        if (msgs[count + cntr].read_byte != NULL)
+            fit_davies_meyer_hash(&msgs[count + cntr],
+                single + count * FIT_MB_HASH_SIZE + cntr * FIT_DM_HASH_SIZE);
+    }
+    run->m_single += now() - start;
+
+    start = now();
+    if (fit_mb_hash(FIT_MB_HASH_ABREAST_DM, msgs, count, multi) != FIT_STATUS_OK ||
+        fit_mb_hash(FIT_MB_HASH_DM, msgs + count, count, multi + count * FIT_MB_HASH_SIZE) != FIT_STATUS_OK)
+    {
+        goto bail;
+    }
+    run->m_multi += now() - start;
+
+    // Hashes not calculated (unparsable licenses) are zero in both buffers.
+    for (cntr = 0; cntr < count; cntr++)
+    {
+        if (memcmp(single + cntr * FIT_MB_HASH_SIZE, multi + cntr * FIT_MB_HASH_SIZE,
+                FIT_MB_HASH_SIZE) != 0 ||
+            memcmp(single + count * FIT_MB_HASH_SIZE + cntr * FIT_DM_HASH_SIZE,
+                multi + count * FIT_MB_HASH_SIZE + cntr * FIT_DM_HASH_SIZE, FIT_DM_HASH_SIZE) != 0)
+        {
+            run->m_mismatch++;
+        }
+    }
+    run->m_hashed += count;
+    ret = 0;
+
+bail:
+    free(hashes);
+    free(msgs);
+    free(multi);
+    free(single);
+
+    return ret;
+}
+#endif // #ifdef FIT_USE_MULTI_BUFFER_HASH
+
+/**
+ *
+ * run_batches
+ *
+ * This function will read licenses block by block, validate each block and print
+ * status of every license. Returns 0 on success.
+ *
+ * @param   run <--> Run.
+ * @param   key --> Public key.
+ * @param   threads --> Number of worker threads.
+ * @param   quiet --> If non zero then only licenses that failed are printed.
+ *
+ */
+static int run_batches(fit_batch_run_t *run, fit_pointer_t *key, uint16_t threads, int quiet)
+{
+    static fit_batch_block_t block;
+    fit_batch_stats_t stats;
+    fit_status_t status = FIT_STATUS_OK;
+    uint32_t cntr       = 0;
+    int ret             = 0;
+    // Licenses of database are validated in mapping, others are moved into block.
+    int in_place        = 0;
+    double start        = 0;
+
+#ifdef FIT_USE_LICENSE_DB
+    in_place = (run->m_db.m_map != NULL);
+#endif
+
+    do
+    {
+        // Read block; unreadable licenses are reported without validation.
+        block.m_count = 0;
+        block.m_size = 0;
+        while (block.m_count < FIT_BATCH_TOOL_BLOCK)
+        {
+            fit_pointer_t *license = &block.m_licenses[block.m_count];
+
+            ret = read_license(run, license, &block.m_names[block.m_count]);
+            if (ret == 0)
+                break;
+            if (ret > 0 && !in_place && add_to_block(&block, license) != 0)
+            {
+                free(license->data);
+                ret = -1;
+            }
+            if (ret < 0)
+            {
+                printf("%s\tunreadable\n", block.m_names[block.m_count]);
+                run->m_unreadable++;
+                if (run->m_files == NULL)
+                    free(block.m_names[block.m_count]);
+                continue;
+            }
+            block.m_count++;
+        }
+
+        if (!in_place)
+        {
+            for (cntr = 0; cntr < block.m_count; cntr++)
+                block.m_licenses[cntr].data = block.m_data + (uintptr_t)block.m_licenses[cntr].data;
+        }
+
+        start = now();
+        status = fit_batch_validate(block.m_licenses, block.m_count, key, threads,
+            block.m_results, &stats);
+        run->m_seconds += now() - start;
+        if (status != FIT_STATUS_OK)
+        {
+            fprintf(stderr, "batch validation failed: %d %s\n", status, fit_get_error_str(status));
+            return -1;
+        }
+        run->m_valid += stats.m_valid;
+        run->m_steals += stats.m_steals;
+        if (stats.m_threads > run->m_threads)
+            run->m_threads = stats.m_threads;
+#ifdef FIT_USE_MULTI_BUFFER_HASH
+        if (run->m_bench && bench_hashing(run, &block) != 0)
+        {
+            fprintf(stderr, "hashing benchmark failed\n");
+            return -1;
+        }
+#endif
+
+        for (cntr = 0; cntr < block.m_count; cntr++)
+        {
+            if (!quiet || block.m_results[cntr] != FIT_STATUS_OK)
+                printf("%s\t%d\t%s\n", block.m_names[cntr], block.m_results[cntr],
+                    fit_get_error_str(block.m_results[cntr]));
+            if (run->m_files == NULL)
+                free(block.m_names[cntr]);
+        }
+    } while (block.m_count == FIT_BATCH_TOOL_BLOCK);
+
+    free(block.m_data);
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    fit_batch_run_t run;
+    fit_pointer_t key   = {0};
+    uint8_t *keydata    = NULL;
+    size_t keysize      = 0;
+    long threads        = sysconf(_SC_NPROCESSORS_ONLN);
+    int quiet           = 0;
+    int opt             = 0;
+    int ret             = 2;
+    uint32_t cntr       = 0;
+#ifdef FIT_USE_LICENSE_DB
+    fit_status_t status = FIT_STATUS_OK;
+    struct stat st;
+#endif
+
+    memset(&run, 0, sizeof(run));
+    while ((opt = getopt(argc, argv, "t:qb")) != -1)
+    {
+        if (opt == 't')
+            threads = strtol(optarg, NULL, 10);
+        else if (opt == 'q')
+            quiet = 1;
+#ifdef FIT_USE_MULTI_BUFFER_HASH
+        else if (opt == 'b')
+            run.m_bench = 1;
+#endif
+        else
+            optind = argc + 1;
+    }
+    if (optind + 2 != argc || threads < 1 || threads > FIT_BATCH_MAX_THREADS)
+    {
+        fprintf(stderr, "usage: %s [-t threads] [-q] [-b] <public key PEM file> %s\n",
+            argv[0], FIT_BATCH_TOOL_INPUT);
+        return 2;
+    }
+
+    keydata = read_file(argv[optind], &keysize);
+    if (keydata == NULL || keysize >= FIT_BATCH_TOOL_MAX_KEY)
+    {
+        fprintf(stderr, "cannot read public key %s\n", argv[optind]);
+        goto end;
+    }
+    key.data = keydata;
+    key.length = (uint16_t)keysize;
+    key.read_byte = (fit_read_byte_callback_t)FIT_READ_BYTE_RAM;
+
+    if (strcmp(argv[optind + 1], "-") == 0)
+        run.m_stream = stdin;
+#ifdef FIT_USE_LICENSE_DB
+    else if (stat(argv[optind + 1], &st) == 0 && S_ISREG(st.st_mode))
+    {
+        status = fit_licdb_open(&run.m_db, argv[optind + 1], FIT_LICDB_SCAN);
+        if (status != FIT_STATUS_OK)
+        {
+            fprintf(stderr, "cannot open license database %s: %d %s\n", argv[optind + 1],
+                status, fit_get_error_str(status));
+            goto end;
+        }
+    }
+#endif // #ifdef FIT_USE_LICENSE_DB
+    else if (list_dir(&run, argv[optind + 1]) != 0)
+    {
+        fprintf(stderr, "cannot read directory %s\n", argv[optind + 1]);
+        goto end;
+    }
+
+    if (run_batches(&run, &key, (uint16_t)threads, quiet) != 0)
+        goto end;
+
+    fprintf(stderr, "%lu licenses: %lu valid, %lu failed, %lu unreadable\n",
+        (unsigned long)run.m_total, (unsigned long)run.m_valid,
+        (unsigned long)(run.m_total - run.m_valid - run.m_unreadable),
+        (unsigned long)run.m_unreadable);
+    fprintf(stderr, "%u threads, %.3f s, %.0f licenses/sec (%lu steals)\n", run.m_threads,
+        run.m_seconds, run.m_seconds > 0 ? (run.m_total - run.m_unreadable) / run.m_seconds : 0.0,
+        (unsigned long)run.m_steals);
+#ifdef FIT_USE_MULTI_BUFFER_HASH
+    if (run.m_bench && run.m_hashed > 0)
+    {
+        fprintf(stderr, "hashing: %.2f us/license one at a time, %.2f us/license multi-buffer "
+            "(%d lanes), speedup %.2fx\n", run.m_single * 1e6 / run.m_hashed,
+            run.m_multi * 1e6 / run.m_hashed, FIT_MB_LANES,
+            run.m_multi > 0 ? run.m_single / run.m_multi : 0.0);
+        if (run.m_mismatch > 0)
+            fprintf(stderr, "hashing: %lu licenses hashed differently\n", (unsigned long)run.m_mismatch);
+    }
+#endif
+    ret = (run.m_valid == run.m_total) ? 0 : 1;
+
+end:
+#ifdef FIT_USE_LICENSE_DB
+    fit_licdb_close(&run.m_db);
+#endif
+    for (cntr = 0; cntr < run.m_nfiles; cntr++)
+        free(run.m_files[cntr]);
+    free(run.m_files);
+    free(keydata);
+
+    return ret;
+}
@@ -0,0 +1,195 @@
+/****************************************************************************\
+**
+** fit_info_dec.c
+**
+** Host tool that decodes license information written by fit_licenf_get_info_tlv
+** (binary TLV format, see FIT_INFO_TLV_VERSION) and prints it as text, one field
+** per line in same form as text get info output (e.g. "VID=37515").
+**
+** Build (from fitgood directory):
+**   gcc -DFIT_USE_INFO_TLV -I inc tools/fit_info_dec.c -o fit_info_dec
+**
+** Usage:
+**   fit_info_dec [binary get info file]    (reads stdin if no file given)
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+/* Required Includes ********************************************************/
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include "fit_api.h"
+
+/* Constants ****************************************************************/
+
+// Maximum size of get info data.
+#define FIT_INFO_DEC_MAX_SIZE       0x10000
+
+/* Global Data **************************************************************/
+
+// Field names indexed by tag id; NULL for objects and arrays (never written).
+static const char *fit_info_dec_names[FIT_END_TAG_ID] = {
+    NULL,               // FIT_BASE_TAG_ID_VALUE
+    NULL,               // FIT_LICENSE_TAG_ID
+    NULL,               // FIT_SIGNATURE_TAG_ID
+    NULL,               // FIT_HEADER_TAG_ID
+    NULL,               // FIT_LIC_CONTAINER_TAG_ID
+    "AlgID",            // FIT_ALGORITHM_TAG_ID
+    "Signature",        // FIT_RSA_SIG_TAG_ID
+    "Licver",           // FIT_LICGEN_VERSION_TAG_ID
+    "LMver",            // FIT_LM_VERSION_TAG_ID
+    "UID",              // FIT_UID_TAG_ID
+    "FP",               // FIT_FP_TAG_ID
+    "CID",              // FIT_ID_LC_TAG_ID
+    NULL,               // FIT_VENDOR_ARRAY_TAG_ID
+    "VID",              // FIT_VENDOR_ID_TAG_ID
+    NULL,               // FIT_PRODUCT_TAG_ID
+    "PID",              // FIT_PRODUCT_ID_TAG_ID
+    "Ver_regex",        // FIT_VERSION_REGEX_TAG_ID
+    NULL,               // FIT_PRODUCT_PART_ARRAY_TAG_ID
+    "PPID",             // FIT_PRODUCT_PART_ID_TAG_ID
+    NULL,               // FIT_LIC_PROP_TAG_ID
+    NULL,               // FIT_FEATURE_ARRAY_TAG_ID
+    "Perpetual",        // FIT_PERPETUAL_TAG_ID
+    "Start date",       // FIT_START_DATE_TAG_ID
+    "End date",         // FIT_END_DATE_TAG_ID
+    NULL,               // FIT_COUNTER_ARRAY_TAG_ID
+    "Duration",         // FIT_DURATION_FROM_FIRST_USE_TAG_ID
+    "FID",              // FIT_FEATURE_TAG_ID
+    "Counter",          // FIT_COUNTER_TAG_ID
+    "Limit",            // FIT_LIMIT_TAG_ID
+    "Soft limit",       // FIT_SOFT_LIMIT_TAG_ID
+    "IsField",          // FIT_IS_FIELD_TAG_ID
+    "Segment hash",     // FIT_SEGMENT_HASH_TAG_ID
+};
+
+/* Functions ****************************************************************/
+
+/**
+ *
+ * read_varint
+ *
+ * This function will read varint (7 bits per byte, low bits first) at passed in
+ * position and move the position past it.
+ *
+ * @param   data --> Get info data.
+ * @param   size --> Size of get info data.
+ * @param   pos <--> Position in data.
+ * @param   value <-- On return it will contain value read.
+ *
+ */
+static int read_varint(const uint8_t *data, size_t size, size_t *pos, uint32_t *value)
+{
+    unsigned int shift = 0;
+
+    *value = 0;
+    while (*pos < size && shift < 35)
+    {
+        *value |= (uint32_t)(data[*pos] & 0x7F) << shift;
+        if ((data[(*pos)++] & 0x80) == 0)
+            return 0;
+        shift += 7;
+    }
+
+    return -1;
+}
+
+/**
+ *
+ * fit_info_decode
+ *
+ * This function will decode get info data and print its fields. Returns 0 on
+ * success, -1 if data is truncated or malformed.
+ *
+ * @param   data --> Get info data.
+ * @param   size --> Size of get info data.
+ * @param   out --> Output file.
+ *
+ */
+static int fit_info_decode(const uint8_t *data, size_t size, FILE *out)
+{
+    size_t pos      = 0;
+    uint32_t value  = 0;
+    uint32_t cntr   = 0;
+    uint8_t tagid   = 0;
+    uint8_t type    = 0;
+    const char *name = NULL;
+
+    if (size == 0 || data[pos++] != FIT_INFO_TLV_VERSION)
+    {
+        fprintf(stderr, "unsupported get info format\n");
+        return -1;
+    }
+
+    while (pos < size)
+    {
+        if (data[pos] == FIT_INFO_TLV_END)
+            return 0;
+
+        tagid = data[pos] & FIT_INFO_TLV_TAG_MASK;
+        type = data[pos++] >> FIT_INFO_TLV_TYPE_SHIFT;
+        if (read_varint(data, size, &pos, &value) != 0)
+            break;
+
+        name = (tagid < FIT_END_TAG_ID) ? fit_info_dec_names[tagid] : NULL;
+        if (name == NULL)
+            name = "Tag";
+
+        if (type == FIT_INFO_TLV_UINT)
+        {
+            fprintf(out, "%s=%lu\n", name, (unsigned long)value);
+        }
+        else if (type == FIT_INFO_TLV_BYTES)
+        {
+            if (value > size - pos)
+                break;
+            fprintf(out, "%s=", name);
+            if (tagid == FIT_VERSION_REGEX_TAG_ID)
+                fwrite(data + pos, 1, value, out);
+            else
+                for (cntr = 0; cntr < value; cntr++)
+                    fprintf(out, "%02X", data[pos + cntr]);
+            fprintf(out, "\n");
+            pos += value;
+        }
+        else
+        {
+            fprintf(stderr, "unknown record type %d at offset %lu\n", type,
+                (unsigned long)pos);
+            return -1;
+        }
+    }
+
+    fprintf(stderr, "truncated get info data\n");
+    return -1;
+}
+
+int main(int argc, char *argv[])
+{
+    static uint8_t data[FIT_INFO_DEC_MAX_SIZE];
+    FILE *in    = stdin;
+    size_t size = 0;
+
+    if (argc > 2)
+    {
+        fprintf(stderr, "usage: %s [binary get info file]\n", argv[0]);
+        return 1;
+    }
+    if (argc == 2)
+    {
+        in = fopen(argv[1], "rb");
+        if (in == NULL)
+        {
+            fprintf(stderr, "cannot open %s\n", argv[1]);
+            return 1;
+        }
+    }
+
+    size = fread(data, 1, sizeof(data), in);
+    if (in != stdin)
+        fclose(in);
+
+    return (fit_info_decode(data, size, stdout) == 0) ? 0 : 1;
+}
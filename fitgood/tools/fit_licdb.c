@@ -0,0 +1,568 @@
+/****************************************************************************\
+**
+** fit_licdb.c
+**
+** Host tool that maintains packed license database (see fit_licdb.h) in place of
+** directory with one file per license, and looks licenses up in it.
+**
+**   add    appends licenses of directories (every regular file is one license)
+**          and files; licenses already in database or not parsable are reported
+**          and skipped
+**   list   prints UID, container ID, length and file offset of every license in
+**          order licenses were added (one sequential pass over database)
+**   find   prints licenses of UID (and container ID) found in index
+**   get    writes license binary of UID (and container ID) to stdout
+**   compact copies licenses of database into new database, without index records
+**          replaced by appends
+**
+** Licenses of block are kept in one buffer and read by FIT_READ_BYTE_BOUNDED, which
+** fit_licdb_append bounds to license being added, so malformed license can not make
+** parser read outside of it. Empty and truncated licenses are rejected.
+**
+** UID is given as hex string, in same form as UID field of get info output.
+** Database can also be validated by fit_batch_validate built with
+** FIT_USE_LICENSE_DB.
+**
+** Build (from fitgood directory):
+**   gcc -O2 -DFIT_USE_LICENSE_DB -I inc -I mbedtls-2.2.1/include \
+**       tools/fit_licdb.c src/<all sources> \
+**       mbedtls-2.2.1/library/<all sources> -o fit_licdb
+**
+** Usage:
+**   fit_licdb add <database> <license dir | license file>...
+**   fit_licdb list <database>
+**   fit_licdb find <database> <UID> [container id]
+**   fit_licdb get <database> <UID> [container id] > license
+**   fit_licdb compact <database> <new database>
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+/* Required Includes ********************************************************/
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include "fit_api.h"
+#include "fit_licdb.h"
+#include "fit_debug.h"
+#include "mem_read.h"
+
+/* Constants ****************************************************************/
+
+// Number of licenses appended by one fit_licdb_append call.
+#define FIT_LICDB_TOOL_BLOCK        65536
+
+/* Types ********************************************************************/
+
+// Licenses read for one fit_licdb_append call.
+typedef struct fit_licdb_block {
+    uint32_t        m_count;
+    // Data of all licenses of block.
+    uint8_t         *m_data;
+    size_t          m_size;
+    size_t          m_capacity;
+    fit_pointer_t   m_licenses[FIT_LICDB_TOOL_BLOCK];
+    fit_status_t    m_results[FIT_LICDB_TOOL_BLOCK];
+    char            *m_names[FIT_LICDB_TOOL_BLOCK];
+} fit_licdb_block_t;
+
+// Totals of add command.
+typedef struct fit_licdb_totals {
+    uint32_t        m_added;
+    uint32_t        m_duplicate;
+    uint32_t        m_rejected;
+} fit_licdb_totals_t;
+
+/* Functions ****************************************************************/
+
+// Hardware dependent functions used by FIT core and bundled mbedtls on target.
+void UARTprintf(const char *pcString, ...)
+{
+    va_list args;
+
+    va_start(args, pcString);
+    vfprintf(stderr, pcString, args);
+    va_end(args);
+}
+
+void fit_uart_putc(unsigned char data)
+{
+    fputc(data, stderr);
+}
+
+/**
+ *
+ * read_file
+ *
+ * This function will read whole file into newly allocated buffer. Returns NULL on
+ * error or if file is too large to be license.
+ *
+ * @param   path --> File path.
+ * @param   size <-- On return it will contain file size.
+ *
+ */
+static uint8_t *read_file(const char *path, size_t *size)
+{
+    FILE *in        = fopen(path, "rb");
+    uint8_t *data   = NULL;
+    long length     = 0;
+
+    if (in == NULL)
+        return NULL;
+    if (fseek(in, 0, SEEK_END) == 0 && (length = ftell(in)) >= 0 && length <= 0xFFFF &&
+        fseek(in, 0, SEEK_SET) == 0)
+    {
+        data = (uint8_t *)malloc((size_t)length + 1);
+        if (data != NULL && fread(data, 1, (size_t)length, in) != (size_t)length)
+        {
+            free(data);
+            data = NULL;
+        }
+    }
+    fclose(in);
+
+    *size = (size_t)length;
+    return data;
+}
+
+/**
+ *
+ * flush_block
+ *
+ * This function will append licenses of block to database and report licenses
+ * not added. Returns 0 on success.
+ *
+ * @param   db --> Path of database file.
+ * @param   block <--> Block; it is empty on return.
+ * @param   totals <--> Totals of add command.
+ *
+ */
+static int flush_block(const char *db, fit_licdb_block_t *block, fit_licdb_totals_t *totals)
+{
+    fit_status_t status = FIT_STATUS_OK;
+    uint32_t cntr       = 0;
+
+    // License offsets are kept in place of addresses till block is full.
+    for (cntr = 0; cntr < block->m_count; cntr++)
+        block->m_licenses[cntr].data = block->m_data + (uintptr_t)block->m_licenses[cntr].data;
+
+    status = fit_licdb_append(db, block->m_licenses, block->m_count, block->m_results);
+    if (status != FIT_STATUS_OK)
+        fprintf(stderr, "cannot append to %s: %d %s\n", db, status, fit_get_error_str(status));
+
+    for (cntr = 0; cntr < block->m_count; cntr++)
+    {
+        if (status == FIT_STATUS_OK)
+        {
+            if (block->m_results[cntr] == FIT_STATUS_OK)
+                totals->m_added++;
+            else if (block->m_results[cntr] == FIT_LICDB_DUPLICATE)
+                totals->m_duplicate++;
+            else
+                totals->m_rejected++;
+            if (block->m_results[cntr] != FIT_STATUS_OK)
+                printf("%s\t%d\t%s\n", block->m_names[cntr], block->m_results[cntr],
+                    fit_get_error_str(block->m_results[cntr]));
+        }
+        free(block->m_names[cntr]);
+    }
+    block->m_count = 0;
+    block->m_size = 0;
+
+    return (status == FIT_STATUS_OK) ? 0 : -1;
+}
+
+/**
+ *
+ * add_file
+ *
+ * This function will read license file into data buffer of block; block is
+ * appended to database once full. Returns 0 on success.
+ *
+ * @param   db --> Path of database file.
+ * @param   block <--> Block.
+ * @param   path --> Path of license file.
+ * @param   totals <--> Totals of add command.
+ *
+ */
+static int add_file(const char *db, fit_licdb_block_t *block, const char *path,
+                    fit_licdb_totals_t *totals)
+{
+    fit_pointer_t *license  = &block->m_licenses[block->m_count];
+    uint8_t *data           = NULL;
+    uint8_t *grown          = NULL;
+    size_t size             = 0;
+
+    data = read_file(path, &size);
+    if (data != NULL && block->m_size + size > block->m_capacity)
+    {
+        size_t capacity = block->m_capacity ? block->m_capacity * 2 : 0x100000;
+
+        while (capacity < block->m_size + size)
+            capacity *= 2;
+        grown = (uint8_t *)realloc(block->m_data, capacity);
+        if (grown == NULL)
+        {
+            free(data);
+            data = NULL;
+        }
+        else
+        {
+            block->m_data = grown;
+            block->m_capacity = capacity;
+        }
+    }
+    if (data == NULL)
+    {
+        printf("%s\tunreadable\n", path);
+        totals->m_rejected++;
+        return 0;
+    }
+
+    memcpy(block->m_data + block->m_size, data, size);
+    free(data);
+    license->data = (uint8_t *)(uintptr_t)block->m_size;
+    license->length = (uint16_t)size;
+    license->read_byte = (fit_read_byte_callback_t)FIT_READ_BYTE_BOUNDED;
+    block->m_size += size;
+    block->m_names[block->m_count++] = strdup(path);
+
+    if (block->m_count == FIT_LICDB_TOOL_BLOCK)
+        return flush_block(db, block, totals);
+
+    return 0;
+}
+
+static int compare_names(const void *a, const void *b)
+{
+    return strcmp(*(char * const *)a, *(char * const *)b);
+}
+
+/**
+ *
+ * add_dir
+ *
+ * This function will add regular files of directory, sorted by name, so order of
+ * licenses in database does not depend on file system. Unreadable directory is
+ * reported like unreadable license file. Returns 0 on success.
+ *
+ * @param   db --> Path of database file.
+ * @param   block <--> Block.
+ * @param   dir --> Directory path.
+ * @param   totals <--> Totals of add command.
+ *
+ */
+static int add_dir(const char *db, fit_licdb_block_t *block, const char *dir,
+                   fit_licdb_totals_t *totals)
+{
+    DIR *d                  = opendir(dir);
+    struct dirent *entry    = NULL;
+    struct stat st;
+    char path[4096];
+    char **files            = NULL;
+    char **grown            = NULL;
+    uint32_t nfiles         = 0;
+    uint32_t capacity       = 0;
+    uint32_t cntr           = 0;
+    int ret                 = 0;
+
+    if (d == NULL)
+    {
+        printf("%s\tunreadable\n", dir);
+        totals->m_rejected++;
+        return 0;
+    }
+
+    while ((entry = readdir(d)) != NULL)
+    {
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        if (stat(path, &st) != 0 || !S_ISREG(st.st_mode))
+            continue;
+        if (nfiles == capacity)
+        {
+            capacity = capacity ? capacity * 2 : 1024;
+            grown = (char **)realloc(files, capacity * sizeof(char *));
+            if (grown == NULL)
+                break;
+            files = grown;
+        }
+        files[nfiles++] = strdup(path);
+    }
+    closedir(d);
+
+    qsort(files, nfiles, sizeof(char *), compare_names);
+    for (cntr = 0; cntr < nfiles; cntr++)
+    {
+        if (ret == 0)
+            ret = add_file(db, block, files[cntr], totals);
+        free(files[cntr]);
+    }
+    free(files);
+
+    return ret;
+}
+
+/**
+ *
+ * parse_uid
+ *
+ * This function will convert UID from hex string. Returns 0 on success.
+ *
+ * @param   text --> UID as hex string (2 * FIT_UID_LEN digits).
+ * @param   uid <-- On return it will contain UID.
+ *
+ */
+static int parse_uid(const char *text, uint8_t *uid)
+{
+    unsigned int byte   = 0;
+    uint32_t cntr       = 0;
+
+    if (strlen(text) != 2 * FIT_UID_LEN)
+        return -1;
+    for (cntr = 0; cntr < FIT_UID_LEN; cntr++)
+    {
+        if (sscanf(text + 2 * cntr, "%2x", &byte) != 1)
+            return -1;
+        uid[cntr] = (uint8_t)byte;
+    }
+
+    return 0;
+}
+
+static void print_entry(const fit_licdb_entry_t *entry)
+{
+    uint32_t cntr = 0;
+
+    for (cntr = 0; cntr < FIT_UID_LEN; cntr++)
+        printf("%02X", entry->m_uid[cntr]);
+    printf("\t%lu\t%lu\t%llu\n", (unsigned long)entry->m_container_id,
+        (unsigned long)entry->m_length, (unsigned long long)entry->m_offset);
+}
+
+/**
+ *
+ * cmd_add
+ *
+ * This function will append licenses of directories and files to database.
+ * Returns 0 on success.
+ *
+ * @param   db --> Path of database file.
+ * @param   paths --> License directories and files.
+ * @param   count --> Number of paths.
+ *
+ */
+static int cmd_add(const char *db, char **paths, int count)
+{
+    static fit_licdb_block_t block;
+    fit_licdb_totals_t totals;
+    struct stat st;
+    int cntr    = 0;
+    int ret     = 0;
+
+    memset(&totals, 0, sizeof(totals));
+    for (cntr = 0; cntr < count && ret == 0; cntr++)
+    {
+        if (stat(paths[cntr], &st) == 0 && S_ISDIR(st.st_mode))
+            ret = add_dir(db, &block, paths[cntr], &totals);
+        else
+            ret = add_file(db, &block, paths[cntr], &totals);
+    }
+    // Remaining licenses (even none, so that empty database is created).
+    if (ret == 0)
+        ret = flush_block(db, &block, &totals);
+    free(block.m_data);
+
+    fprintf(stderr, "%lu licenses added, %lu already in database, %lu rejected\n",
+        (unsigned long)totals.m_added, (unsigned long)totals.m_duplicate,
+        (unsigned long)totals.m_rejected);
+
+    return (ret == 0) ? 0 : 2;
+}
+
+/**
+ *
+ * cmd_list
+ *
+ * This function will print all licenses of database in order they were added.
+ * Returns 0 on success.
+ *
+ * @param   db --> Path of database file.
+ *
+ */
+static int cmd_list(const char *db)
+{
+    fit_licdb_t licdb;
+    const fit_licdb_entry_t *entry  = NULL;
+    fit_pointer_t license;
+    fit_status_t status             = FIT_STATUS_OK;
+    uint64_t pos                    = 0;
+
+    status = fit_licdb_open(&licdb, db, FIT_LICDB_SCAN);
+    if (status != FIT_STATUS_OK)
+    {
+        fprintf(stderr, "cannot open %s: %d %s\n", db, status, fit_get_error_str(status));
+        return 2;
+    }
+
+    while ((status = fit_licdb_next(&licdb, &pos, &license, &entry)) == FIT_STATUS_OK)
+        print_entry(entry);
+    if (status != FIT_LICDB_NOT_FOUND)
+        fprintf(stderr, "cannot read %s: %d %s\n", db, status, fit_get_error_str(status));
+    fit_licdb_close(&licdb);
+
+    return (status == FIT_LICDB_NOT_FOUND) ? 0 : 2;
+}
+
+/**
+ *
+ * cmd_find
+ *
+ * This function will print licenses of UID (and container ID), or write license
+ * binary of first of them to stdout. Returns 0 if license was found, 1 if not.
+ *
+ * @param   db --> Path of database file.
+ * @param   uid --> UID as hex string.
+ * @param   container --> Container ID as string or NULL for any container.
+ * @param   get --> If non zero then license binary is written.
+ *
+ */
+static int cmd_find(const char *db, const char *uid, const char *container, int get)
+{
+    fit_licdb_t licdb;
+    const fit_licdb_entry_t *entry  = NULL;
+    fit_pointer_t license;
+    fit_status_t status             = FIT_STATUS_OK;
+    uint8_t key[FIT_UID_LEN];
+    uint32_t container_id           = FIT_LICDB_ANY_CONTAINER;
+    uint32_t index                  = 0;
+
+    if (parse_uid(uid, key) != 0)
+    {
+        fprintf(stderr, "invalid UID %s\n", uid);
+        return 2;
+    }
+    if (container != NULL)
+        container_id = (uint32_t)strtoul(container, NULL, 0);
+
+    status = fit_licdb_open(&licdb, db, FIT_LICDB_LOOKUP);
+    if (status != FIT_STATUS_OK)
+    {
+        fprintf(stderr, "cannot open %s: %d %s\n", db, status, fit_get_error_str(status));
+        return 2;
+    }
+
+    status = fit_licdb_find(&licdb, key, container_id, &index);
+    for (; status == FIT_STATUS_OK && index < licdb.m_count; index++)
+    {
+        status = fit_licdb_get(&licdb, index, &license, &entry);
+        if (status != FIT_STATUS_OK || memcmp(entry->m_uid, key, FIT_UID_LEN) != 0 ||
+            (container != NULL && entry->m_container_id != container_id))
+        {
+            break;
+        }
+        if (get)
+        {
+            if (fwrite(license.data, 1, license.length, stdout) != license.length)
+                status = FIT_LICDB_IO_ERROR;
+            break;
+        }
+        print_entry(entry);
+    }
+    if (status != FIT_STATUS_OK)
+        fprintf(stderr, "%s: %d %s\n", uid, status, fit_get_error_str(status));
+    fit_licdb_close(&licdb);
+
+    return (status == FIT_STATUS_OK) ? 0 : (status == FIT_LICDB_NOT_FOUND) ? 1 : 2;
+}
+
+/**
+ *
+ * cmd_compact
+ *
+ * This function will copy licenses of database into new database, in order they
+ * were added. Licenses are appended from mapping of database, FIT_LICDB_TOOL_BLOCK
+ * at a time. Returns 0 on success.
+ *
+ * @param   db --> Path of database file.
+ * @param   out --> Path of new database file (must not exist).
+ *
+ */
+static int cmd_compact(const char *db, const char *out)
+{
+    static fit_licdb_block_t block;
+    fit_licdb_t licdb;
+    struct stat st;
+    fit_status_t status = FIT_STATUS_OK;
+    uint64_t pos        = 0;
+    uint32_t copied     = 0;
+    uint32_t cntr       = 0;
+
+    if (stat(out, &st) == 0)
+    {
+        fprintf(stderr, "%s already exists\n", out);
+        return 2;
+    }
+    status = fit_licdb_open(&licdb, db, FIT_LICDB_SCAN);
+    if (status != FIT_STATUS_OK)
+    {
+        fprintf(stderr, "cannot open %s: %d %s\n", db, status, fit_get_error_str(status));
+        return 2;
+    }
+    do
+    {
+        for (block.m_count = 0; block.m_count < FIT_LICDB_TOOL_BLOCK; block.m_count++)
+        {
+            fit_pointer_t *license = &block.m_licenses[block.m_count];
+
+            status = fit_licdb_next(&licdb, &pos, license, NULL);
+            if (status != FIT_STATUS_OK)
+                break;
+            license->read_byte = (fit_read_byte_callback_t)FIT_READ_BYTE_BOUNDED;
+        }
+        if (status != FIT_STATUS_OK && status != FIT_LICDB_NOT_FOUND)
+            break;
+
+        // Licenses were added once already; only duplicates can be skipped again.
+        status = fit_licdb_append(out, block.m_licenses, block.m_count, block.m_results);
+        for (cntr = 0; cntr < block.m_count && status == FIT_STATUS_OK; cntr++)
+            copied += (block.m_results[cntr] == FIT_STATUS_OK) ? 1 : 0;
+    } while (status == FIT_STATUS_OK && block.m_count == FIT_LICDB_TOOL_BLOCK);
+    fit_licdb_close(&licdb);
+
+    if (status != FIT_STATUS_OK)
+    {
+        fprintf(stderr, "cannot compact %s: %d %s\n", db, status, fit_get_error_str(status));
+        return 2;
+    }
+    fprintf(stderr, "%lu licenses copied\n", (unsigned long)copied);
+
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc >= 4 && strcmp(argv[1], "add") == 0)
+        return cmd_add(argv[2], argv + 3, argc - 3);
+    if (argc == 3 && strcmp(argv[1], "list") == 0)
+        return cmd_list(argv[2]);
+    if ((argc == 4 || argc == 5) && strcmp(argv[1], "find") == 0)
+        return cmd_find(argv[2], argv[3], (argc == 5) ? argv[4] : NULL, 0);
+    if ((argc == 4 || argc == 5) && strcmp(argv[1], "get") == 0)
+        return cmd_find(argv[2], argv[3], (argc == 5) ? argv[4] : NULL, 1);
+    if (argc == 4 && strcmp(argv[1], "compact") == 0)
+        return cmd_compact(argv[2], argv[3]);
+
+    fprintf(stderr, "usage: %s add <database> <license dir | license file>...\n"
+        "       %s list <database>\n"
+        "       %s find <database> <UID> [container id]\n"
+        "       %s get <database> <UID> [container id] > license\n"
+        "       %s compact <database> <new database>\n",
+        argv[0], argv[0], argv[0], argv[0], argv[0]);
+
+    return 2;
+}
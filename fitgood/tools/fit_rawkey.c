@@ -0,0 +1,203 @@
+/****************************************************************************\
+**
+** fit_rawkey.c
+**
+** Host tool that converts RSA public key in PEM format to raw (pre-parsed)
+** format (see fit_rsa_raw_key_t). Output is C header defining raw key structure
+** (static const, as modulus, public exponent and Montgomery constants are stored
+** in it as big endian bytes), so key can be used by FIT core without PEM/ASN.1
+** parsing (see FIT_USE_RAW_PUBKEY_ONLY). Montgomery constants (R^2 mod N and
+** -N^-1) are precomputed as well, so no key setup is done on target.
+**
+** Build (from fitgood directory):
+**   gcc -I inc -I mbedtls-2.2.1/include tools/fit_rawkey.c \
+**       mbedtls-2.2.1/library/<all sources> -o fit_rawkey
+**
+** Usage:
+**   fit_rawkey <public key PEM file> [output header]
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+/* Required Includes ********************************************************/
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <string.h>
+#include "mbedtls/pk.h"
+#include "mbedtls/rsa.h"
+
+/* Constants ****************************************************************/
+
+// Size of modulus and (maximum) size of public exponent in bytes; same as
+// RSA_SIG_SIZE and FIT_RSA_RAW_E_SIZE of fit_rsa.h.
+#define FIT_RAWKEY_N_SIZE           256
+#define FIT_RAWKEY_E_SIZE           8
+
+// Maximum size of modulus in bytes.
+#define FIT_RAWKEY_MAX_SIZE         512
+
+// Maximum size of PEM file.
+#define FIT_RAWKEY_MAX_PEM          4096
+
+/* Functions ****************************************************************/
+
+// Bundled mbedtls prints by UARTprintf of target (see mbedtls/platform.h).
+void UARTprintf(const char *pcString, ...)
+{
+    va_list args;
+
+    va_start(args, pcString);
+    vfprintf(stderr, pcString, args);
+    va_end(args);
+}
+
+/**
+ *
+ * write_bytes
+ *
+ * This function will write field of raw key i.e. big endian bytes of number as
+ * array initializer.
+ *
+ * @param   out --> Output file.
+ * @param   comment --> Description of field.
+ * @param   buf --> Big endian number.
+ * @param   len --> Length of number in bytes.
+ * @param   last --> Non zero for last field of raw key.
+ *
+ */
+static void write_bytes(FILE *out, const char *comment, const unsigned char *buf, size_t len, int last)
+{
+    size_t cntr = 0;
+
+    fprintf(out, "    // %s\n    {", comment);
+    for (cntr = 0; cntr < len; cntr++)
+    {
+        fprintf(out, "%s0x%02X%s", (cntr % 12 == 0) ? "\n        " : " ",
+            buf[cntr], (cntr + 1 < len) ? "," : "");
+    }
+    fprintf(out, "\n    }%s\n", last ? "" : ",");
+}
+
+/**
+ *
+ * mont_constant
+ *
+ * This function will calculate -N^-1 mod 2^64 from least significant 64 bits of
+ * modulus (Newton iteration, as mpi_montg_init of mbedtls).
+ *
+ * @param   n --> Modulus (odd).
+ *
+ */
+static uint64_t mont_constant(const mbedtls_mpi *n)
+{
+    unsigned char buf[FIT_RAWKEY_MAX_SIZE];
+    size_t len = mbedtls_mpi_size(n);
+    uint64_t n0 = 0, x = 0;
+    unsigned int cntr = 0;
+
+    mbedtls_mpi_write_binary(n, buf, len);
+    for (cntr = 0; cntr < 8 && cntr < len; cntr++)
+        n0 |= (uint64_t)buf[len - 1 - cntr] << (8 * cntr);
+
+    x = n0;
+    x += ((n0 + 2) & 4) << 1;
+    for (cntr = 64; cntr >= 8; cntr /= 2)
+        x *= (2 - (n0 * x));
+
+    return ~x + 1;
+}
+
+int main(int argc, char *argv[])
+{
+    mbedtls_pk_context pk;
+    mbedtls_rsa_context *rsa = NULL;
+    mbedtls_mpi rr;
+    uint64_t mm = 0;
+    unsigned char n[FIT_RAWKEY_N_SIZE];
+    unsigned char e[FIT_RAWKEY_E_SIZE];
+    unsigned char r2[FIT_RAWKEY_N_SIZE];
+    unsigned char mmbuf[8];
+    unsigned char pem[FIT_RAWKEY_MAX_PEM];
+    size_t len = 0;
+    FILE *in = NULL;
+    FILE *out = stdout;
+    int ret = 1;
+
+    if (argc < 2 || argc > 3)
+    {
+        fprintf(stderr, "usage: %s <public key PEM file> [output header]\n", argv[0]);
+        return 1;
+    }
+
+    mbedtls_pk_init(&pk);
+    mbedtls_mpi_init(&rr);
+    // mbedtls is built without file system support (MBEDTLS_FS_IO).
+    if ((in = fopen(argv[1], "rb")) == NULL)
+    {
+        fprintf(stderr, "%s: cannot open file\n", argv[1]);
+        goto exit;
+    }
+    len = fread(pem, 1, sizeof(pem) - 1, in);
+    fclose(in);
+    pem[len] = '\0';
+
+    if (mbedtls_pk_parse_public_key(&pk, pem, len + 1) != 0 ||
+        mbedtls_pk_get_type(&pk) != MBEDTLS_PK_RSA)
+    {
+        fprintf(stderr, "%s: not a rsa public key\n", argv[1]);
+        goto exit;
+    }
+    rsa = mbedtls_pk_rsa(pk);
+
+    // R is 2 to the power of bit size of modulus, so same constants are valid for
+    // 32 and 64 bit limbs.
+    if (mbedtls_mpi_size(&rsa->N) != FIT_RAWKEY_N_SIZE ||
+        mbedtls_mpi_size(&rsa->E) > FIT_RAWKEY_E_SIZE ||
+        mbedtls_mpi_get_bit(&rsa->N, 0) == 0 ||
+        mbedtls_mpi_lset(&rr, 1) != 0 ||
+        mbedtls_mpi_shift_l(&rr, 2 * 8 * FIT_RAWKEY_N_SIZE) != 0 ||
+        mbedtls_mpi_mod_mpi(&rr, &rr, &rsa->N) != 0 ||
+        mbedtls_mpi_write_binary(&rsa->N, n, sizeof(n)) != 0 ||
+        mbedtls_mpi_write_binary(&rsa->E, e, sizeof(e)) != 0 ||
+        mbedtls_mpi_write_binary(&rr, r2, sizeof(r2)) != 0)
+    {
+        fprintf(stderr, "%s: unsupported key size\n", argv[1]);
+        goto exit;
+    }
+    mm = mont_constant(&rsa->N);
+    for (len = 0; len < sizeof(mmbuf); len++)
+        mmbuf[len] = (unsigned char)(mm >> (8 * (sizeof(mmbuf) - 1 - len)));
+
+    if (argc == 3 && (out = fopen(argv[2], "w")) == NULL)
+    {
+        fprintf(stderr, "%s: cannot create file\n", argv[2]);
+        goto exit;
+    }
+
+    fprintf(out, "/**\n* Sentinel Fit RSA Public Key (raw format)\n*\n"
+        "* Generated by tools/fit_rawkey from %s; do not edit.\n*\n"
+        "* Copyright (C) 2016, SafeNet, Inc. All rights reserved.\n*\n*/\n", argv[1]);
+    fprintf(out, "#ifndef __FIT_PUBKEY_RAW_H__\n#define __FIT_PUBKEY_RAW_H__\n\n"
+        "#include \"fit_rsa.h\"\n\n");
+
+    fprintf(out, "static const fit_rsa_raw_key_t fit_pubkey_raw = {\n"
+        "    FIT_RSA_RAW_KEY_MAGIC,\n"
+        "    FIT_RSA_RAW_KEY_RR,\n"
+        "    { 0 },\n");
+    write_bytes(out, "-N^-1 mod 2^64", mmbuf, sizeof(mmbuf), 0);
+    write_bytes(out, "Public exponent", e, sizeof(e), 0);
+    write_bytes(out, "Modulus", n, sizeof(n), 0);
+    write_bytes(out, "R^2 mod N", r2, sizeof(r2), 1);
+    fprintf(out, "};\n\n#endif // __FIT_PUBKEY_RAW_H__\n");
+    ret = 0;
+
+exit:
+    if (out != stdout)
+        fclose(out);
+    mbedtls_mpi_free(&rr);
+    mbedtls_pk_free(&pk);
+
+    return ret;
+}
@@ -0,0 +1,222 @@
+/****************************************************************************\
+**
+** fit_unit_test.c
+**
+** Host tool that runs unit tests of FIT core (src/unittest, FIT_USE_UNIT_TESTS)
+** and prints result of each. Returns non zero if any test failed.
+**
+** Core is built without FIT_USE_UNIT_TESTS (parser test hooks are not part of
+** this tree) and tests with it; both with same FIT_USE_* options, e.g.
+** -DFIT_USE_AES_TTABLE, -DFIT_USE_AESNI or -DFIT_USE_SHA256_DIGEST. With
+** -DFIT_USE_CRYPTO_PROVIDER -DFIT_USE_CRYPTO_POOL (and -pthread) overlap of
+** provider hashing with storage reads is measured as well. With
+** -DFIT_USE_RSA_SMALL_EXP (and -DFIT_USE_MONT_ASM) RSA-2048 public operations
+** per second of mbedtls and of Montgomery kernels are reported. With
+** -DFIT_USE_SHARED_CACHE (and -pthread) license and public key passed on command
+** line are consumed by 1 to FIT_UNIT_TEST_MAX_THREADS threads, through default
+** context under mutex and through contexts attached to shared cache. With
+** -DFIT_USE_BATCH_VALIDATE (and -pthread) batch validation of that license, of
+** empty license and of license truncated by one byte is checked. With
+** -DFIT_USE_LICENSE_DB the same licenses are appended to license database.
+**
+** Build (from fitgood directory):
+**   gcc -c -O2 <options> -I inc -I mbedtls-2.2.1/include src/<all sources> \
+**       mbedtls-2.2.1/library/<all sources>
+**   gcc -O2 -DFIT_USE_UNIT_TESTS <options> -I inc -I mbedtls-2.2.1/include \
+**       tools/fit_unit_test.c src/unittest/<all sources> <objects above> \
+**       -o fit_unit_test
+**
+** Usage:
+**   fit_unit_test [<valid license file> <public key file>]
+**
+** Copyright (C) 2016, SafeNet, Inc. All rights reserved.
+**
+\****************************************************************************/
+
+/* Required Includes ********************************************************/
+#include <stdio.h>
+#include <stdarg.h>
+#include "unittest/unit_test.h"
+#include "fit_mont.h"
+#include "mem_read.h"
+
+/* Constants ****************************************************************/
+
+// Tests that take license and public key from command line.
+#if defined(FIT_USE_SHARED_CACHE) || defined(FIT_USE_BATCH_VALIDATE) || defined(FIT_USE_LICENSE_DB)
+#define FIT_UNIT_TEST_LICENSE_ARGS
+#endif
+
+/* Types ********************************************************************/
+
+// Unit test run by the tool.
+typedef struct fit_unit_test_case {
+    const char      *m_name;
+    fit_status_t    (*m_test)(void);
+} fit_unit_test_case_t;
+
+/* Global Data **************************************************************/
+
+static const fit_unit_test_case_t fit_test_cases[] = {
+    { "aes",        fit_unit_test_aes_algorithm },
+    { "dm hash",    fit_unit_test_dm_algorithm },
+#ifdef FIT_USE_SHA256_DIGEST
+    { "sha256",     fit_unit_test_sha256_algorithm },
+#endif
+#ifdef FIT_USE_ED25519
+    { "ed25519",    fit_unit_test_ed25519_algorithm },
+#endif
+};
+
+/* Global Data **************************************************************/
+
+#ifdef FIT_UNIT_TEST_LICENSE_ARGS
+// License and public key (PEM with terminating zero, or raw) read from files.
+static uint8_t fit_test_license[0x4000];
+static uint8_t fit_test_key[0x1000];
+#endif
+
+/* Functions ****************************************************************/
+
+// Hardware dependent functions used by FIT core and bundled mbedtls on target.
+void UARTprintf(const char *pcString, ...)
+{
+    va_list args;
+
+    va_start(args, pcString);
+    vfprintf(stderr, pcString, args);
+    va_end(args);
+}
+
+void fit_uart_putc(unsigned char data)
+{
+    fputc(data, stderr);
+}
+
+#ifdef FIT_UNIT_TEST_LICENSE_ARGS
+/**
+ *
+ * fit_unit_test_load
+ *
+ * This function will read file into buffer and describe it by fit_pointer. One
+ * zero byte is appended (and counted), as PEM keys are passed with it.
+ *
+ * @param   name --> Name of file.
+ * @param   buf <-- Buffer for file contents.
+ * @param   size --> Size of buffer.
+ * @param   fitptr <-- fit_pointer to file contents.
+ *
+ */
+static int fit_unit_test_load(const char *name, uint8_t *buf, size_t size, fit_pointer_t *fitptr)
+{
+    FILE *file = fopen(name, "rb");
+    size_t len = 0;
+
+    if (file == NULL)
+        return 0;
+    len = fread(buf, 1, size - 1, file);
+    fclose(file);
+    buf[len] = 0;
+
+    fitptr->read_byte = (fit_read_byte_callback_t)FIT_READ_BYTE_RAM;
+    fitptr->data = buf;
+    fitptr->length = (uint16_t)len;
+    if (len > 0 && buf[0] == '-')
+        fitptr->length++;
+
+    return (len > 0);
+}
+#endif // #ifdef FIT_UNIT_TEST_LICENSE_ARGS
+
+int main(int argc, char *argv[])
+{
+    fit_status_t status = FIT_STATUS_OK;
+    unsigned int failed = 0;
+    unsigned int cntr   = 0;
+
+    for (cntr = 0; cntr < sizeof(fit_test_cases)/sizeof(fit_test_cases[0]); cntr++)
+    {
+        status = fit_test_cases[cntr].m_test();
+        printf("%-12s %s\n", fit_test_cases[cntr].m_name,
+            (status == FIT_UNIT_TEST_PASSED) ? "PASSED" : "FAILED");
+        if (status != FIT_UNIT_TEST_PASSED)
+            failed++;
+    }
+#if defined(FIT_USE_CRYPTO_PROVIDER) && defined(FIT_USE_CRYPTO_POOL)
+    {
+        uint32_t serial_us  = 0;
+        uint32_t overlap_us = 0;
+
+        status = fit_unit_test_crypto_overlap(&serial_us, &overlap_us);
+        printf("%-12s %s (serial %u us, overlapped %u us)\n", "crypto pool",
+            (status == FIT_UNIT_TEST_PASSED) ? "PASSED" : "FAILED", serial_us, overlap_us);
+        if (status != FIT_UNIT_TEST_PASSED)
+            failed++;
+        cntr++;
+    }
+#endif
+#ifdef FIT_MONT_AVAILABLE
+    {
+        uint32_t mpi_ops        = 0;
+        uint32_t portable_ops   = 0;
+        uint32_t asm_ops        = 0;
+
+        status = fit_unit_test_mont_bench(&mpi_ops, &portable_ops, &asm_ops);
+        printf("%-12s %s (rsa-2048 public ops/s: mbedtls %u, portable %u, asm %u)\n", "montgomery",
+            (status == FIT_UNIT_TEST_PASSED) ? "PASSED" : "FAILED", mpi_ops, portable_ops, asm_ops);
+        if (status != FIT_UNIT_TEST_PASSED)
+            failed++;
+        cntr++;
+    }
+#endif
+#ifdef FIT_UNIT_TEST_LICENSE_ARGS
+    if (argc == 3)
+    {
+        fit_pointer_t license   = {0};
+        fit_pointer_t key       = {0};
+#ifdef FIT_USE_SHARED_CACHE
+        uint32_t locked_rate    = 0;
+        uint32_t shared_rate    = 0;
+        uint32_t shared_rsa     = 0;
+        uint8_t threads         = 0;
+#endif
+
+        if (!fit_unit_test_load(argv[1], fit_test_license, sizeof(fit_test_license), &license) ||
+            !fit_unit_test_load(argv[2], fit_test_key, sizeof(fit_test_key), &key))
+        {
+            fprintf(stderr, "cannot read %s or %s\n", argv[1], argv[2]);
+            return 2;
+        }
+#ifdef FIT_USE_BATCH_VALIDATE
+        status = fit_unit_test_batch_bounds(&license, &key);
+        printf("%-12s %s\n", "batch bounds", (status == FIT_UNIT_TEST_PASSED) ? "PASSED" : "FAILED");
+        if (status != FIT_UNIT_TEST_PASSED)
+            failed++;
+        cntr++;
+#endif
+#ifdef FIT_USE_LICENSE_DB
+        status = fit_unit_test_licdb_append(&license);
+        printf("%-12s %s\n", "licdb append", (status == FIT_UNIT_TEST_PASSED) ? "PASSED" : "FAILED");
+        if (status != FIT_UNIT_TEST_PASSED)
+            failed++;
+        cntr++;
+#endif
+#ifdef FIT_USE_SHARED_CACHE
+        for (threads = 1; threads <= FIT_UNIT_TEST_MAX_THREADS; threads *= 2)
+        {
+            status = fit_unit_test_shared_cache_bench(&license, &key, threads,
+                &locked_rate, &shared_rate, &shared_rsa);
+            printf("%-12s %s (%u threads consumes/s: mutex %u, shared %u, rsa checks %u)\n",
+                "shared cache", (status == FIT_UNIT_TEST_PASSED) ? "PASSED" : "FAILED",
+                threads, locked_rate, shared_rate, shared_rsa);
+            if (status != FIT_UNIT_TEST_PASSED)
+                failed++;
+            cntr++;
+        }
+#endif
+    }
+#endif // #ifdef FIT_UNIT_TEST_LICENSE_ARGS
+    printf("%u of %u tests failed\n", failed, cntr);
+
+    return (failed == 0) ? 0 : 1;
+}